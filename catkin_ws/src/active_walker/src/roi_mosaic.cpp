@@ -0,0 +1,86 @@
+#include "roi_mosaic.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+RoiMosaic::RoiMosaic(): gap_(8) {
+}
+
+
+void RoiMosaic::merge_rois(std::vector<cv::Rect> &rois) {
+    bool merged = true;
+    while(merged) {
+        merged = false;
+        for(int i = 0; i < rois.size() && !merged; i++) {
+            for(int j = i + 1; j < rois.size(); j++) {
+                if((rois[i] & rois[j]).area() > 0) {
+                    rois[i] |= rois[j];
+                    rois.erase(rois.begin() + j);
+                    merged = true;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+
+bool RoiMosaic::build(const cv::Mat &image, const std::vector<cv::Rect> &rois) {
+    tiles_.clear();
+    order_.clear();
+    cv::Rect image_rect(0, 0, image.cols, image.rows);
+    double total_area = 0.0;
+    int max_width = 0;
+    for(int i = 0; i < rois.size(); i++) {
+        Tile tile;
+        tile.src = rois[i] & image_rect;
+        if(tile.src.area() <= 0)
+            continue;
+        tiles_.push_back(tile);
+        order_.push_back(order_.size());
+        total_area += (tile.src.width + gap_) * (tile.src.height + gap_);
+        max_width = std::max(max_width, tile.src.width);
+    }
+    if(tiles_.empty())
+        return false;
+
+    // Tallest tiles first, fill shelves from left to right
+    std::vector<Tile> &tiles = tiles_;
+    std::sort(order_.begin(), order_.end(), [&tiles](int a, int b) { return tiles[a].src.height > tiles[b].src.height; });
+    int shelf_width = std::max(max_width, static_cast<int>(std::ceil(std::sqrt(total_area))));
+    int x = 0, y = 0, shelf_height = 0, mosaic_width = 0;
+    for(int k = 0; k < order_.size(); k++) {
+        Tile &tile = tiles_[order_[k]];
+        if(x > 0 && x + tile.src.width > shelf_width) {
+            x = 0;
+            y += shelf_height + gap_;
+            shelf_height = 0;
+        }
+        tile.dst = cv::Rect(x, y, tile.src.width, tile.src.height);
+        x += tile.src.width + gap_;
+        shelf_height = std::max(shelf_height, tile.src.height);
+        mosaic_width = std::max(mosaic_width, tile.dst.x + tile.dst.width);
+    }
+
+    mosaic_.create(y + shelf_height, mosaic_width, image.type());
+    mosaic_.setTo(cv::Scalar::all(127));
+    for(int i = 0; i < tiles_.size(); i++)
+        image(tiles_[i].src).copyTo(mosaic_(tiles_[i].dst));
+    return true;
+}
+
+
+bool RoiMosaic::map_to_image(const cv::Rect2d &box_in_mosaic, cv::Rect2d &box_in_image) const {
+    cv::Point2d center(box_in_mosaic.x + box_in_mosaic.width / 2, box_in_mosaic.y + box_in_mosaic.height / 2);
+    for(int i = 0; i < tiles_.size(); i++) {
+        cv::Rect2d dst(tiles_[i].dst);
+        if(!dst.contains(center))
+            continue;
+        cv::Rect2d clipped = box_in_mosaic & dst;
+        box_in_image = cv::Rect2d(clipped.x - dst.x + tiles_[i].src.x, clipped.y - dst.y + tiles_[i].src.y,
+                                  clipped.width, clipped.height);
+        return true;
+    }
+    return false;
+}
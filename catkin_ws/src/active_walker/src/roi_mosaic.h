@@ -0,0 +1,43 @@
+#ifndef ROI_MOSAIC_H
+#define ROI_MOSAIC_H
+
+#include <vector>
+
+// OpenCV
+#include <opencv2/core/core.hpp>
+
+
+// Pack image regions of interest into one small mosaic image, so a detector only
+// sees the candidate regions, and map the detected boxes back to the full image.
+// Tiles are separated by a gray gap to avoid boxes across two tiles.
+class RoiMosaic {
+public:
+    struct Tile {
+        cv::Rect src;       // Region in the full image
+        cv::Rect dst;       // Region in the mosaic
+    };
+
+    RoiMosaic();
+
+    // Merge overlapping regions so a person is never cut into two tiles
+    static void merge_rois(std::vector<cv::Rect> &rois);
+
+    // Shelf packing into a roughly square mosaic, false if there is nothing to pack
+    bool build(const cv::Mat &image, const std::vector<cv::Rect> &rois);
+
+    // Box (top-left x, y, width, height) in the mosaic --> full image, false if the
+    // box center is not inside any tile
+    bool map_to_image(const cv::Rect2d &box_in_mosaic, cv::Rect2d &box_in_image) const;
+
+    const cv::Mat &mosaic() const { return mosaic_; }
+    const std::vector<Tile> &tiles() const { return tiles_; }
+
+    int gap_;
+
+private:
+    cv::Mat mosaic_;
+    std::vector<Tile> tiles_;
+    std::vector<int> order_;
+};
+
+#endif
@@ -0,0 +1,15 @@
+#include "scan_image_combine_node.h"
+
+
+
+//            
+//   |\/|  /\  | |\ | 
+//   |  | /~~\ | | \| 
+//  
+int main(int argc, char **argv) {
+    ros::init(argc, argv, "scan_clustering_node");
+    ros::NodeHandle nh, pnh("~");
+    ScanImageCombineNode node(nh, pnh);
+    ros::spin();
+    return 0;
+}
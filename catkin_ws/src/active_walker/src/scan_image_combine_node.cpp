@@ -1,185 +1,31 @@
-#include <iostream>
-#include <time.h>
-#include <math.h>
-#include <string.h>
-#include <stdlib.h>
-
-// ROS
-#include <ros/ros.h>
-#include <sensor_msgs/LaserScan.h>
-#include <sensor_msgs/Image.h>
-#include <sensor_msgs/CameraInfo.h>
-#include <sensor_msgs/image_encodings.h>
-#include <sensor_msgs/PointCloud2.h>
-#include <geometry_msgs/Point.h>
-#include <laser_geometry/laser_geometry.h>
-#include <cv_bridge/cv_bridge.h>
-#include <visualization_msgs/Marker.h>
-#include <visualization_msgs/MarkerArray.h>
-// Custom msg & srv
-#include <walker_msgs/Detection2DTrigger.h>
-#include <walker_msgs/Det3D.h>
-#include <walker_msgs/Det3DArray.h>
-
-// Message filter
-#include <message_filters/subscriber.h>
-#include <message_filters/synchronizer.h>
-#include <message_filters/sync_policies/approximate_time.h>
-#include <message_filters/time_synchronizer.h>
-
-// Eigen
-#include <Eigen/Dense>
-
-// OpenCV
-#include <opencv2/imgproc/imgproc.hpp>
-#include <opencv2/core/core.hpp>
-#include <opencv2/highgui/highgui.hpp>
-#include <opencv2/calib3d/calib3d.hpp>
-
-// TF
-#include <tf/transform_listener.h>
-#include <tf/transform_datatypes.h>
-
-// PCL
-#include <pcl/point_types.h>
-#include <pcl/point_cloud.h>
-#include <pcl/common/common.h>
-#include <pcl/common/centroid.h> // Centroid
-#include <pcl/kdtree/kdtree.h>
-#include <pcl/segmentation/extract_clusters.h>
-#include <pcl/filters/extract_indices.h>
-#include <pcl_conversions/pcl_conversions.h> // ros2pcl
-#include <pcl/filters/radius_outlier_removal.h> // RemoveOutlier
-#include <pcl/filters/statistical_outlier_removal.h>
-#include <pcl_ros/transforms.h>
-
-// Linear assignment library
-#include "Hungarian.h"
-
-
-typedef message_filters::sync_policies::ApproximateTime<cv_bridge::CvImage, sensor_msgs::LaserScan> MySyncPolicy;
-typedef message_filters::Synchronizer<MySyncPolicy> MySynchronizer;
-
-typedef pcl::PointCloud<pcl::PointXYZ> PointCloudXYZ;
-typedef pcl::PointCloud<pcl::PointXYZ>::Ptr PointCloudXYZPtr;
-typedef pcl::PointCloud<pcl::PointXYZRGB> PointCloudXYZRGB;
-typedef pcl::PointCloud<pcl::PointXYZRGB>::Ptr PointCloudXYZRGBPtr;
-
-// Just for color words display
-static const std::string COLOR_RED = "\e[0;31m";
-static const std::string COLOR_GREEN = "\e[0;32m";
-static const std::string COLOR_YELLOW = "\e[0;33m"; 
-static const std::string COLOR_NC = "\e[0m";
-
-static const int kNumOfInterestClass = 1;
-static const std::string kInterestClassNames[kNumOfInterestClass] = {"person"};
-static const double kMaxDimOfLaserCluster = 1.2;   // Consider the cluster would be merged if two people are too close
-static const double kThresholdOfSimilarity = 0.95;
-static const double kThresholdOfUnreasonableHeight = 3.0;
-static const double kLifetimeOfMarker = 0.1;
-static const double kMinLaserClusterTolerance = 0.3;
-
-template <typename T, typename A>
-int arg_max(std::vector<T, A> const& vec) {
-    return static_cast<int>(std::distance(vec.begin(), max_element(vec.begin(), vec.end())));
-}
-
-template <typename T, typename A>
-int arg_min(std::vector<T, A> const& vec) {
-    return static_cast<int>(std::distance(vec.begin(), min_element(vec.begin(), vec.end())));
-}
+#include "scan_image_combine_node.h"
 
-class ObjInfo {
-public:
-    ObjInfo(){
-        cloud = PointCloudXYZPtr(new PointCloudXYZ);
-        radius = 0.0;
-    }
-    walker_msgs::BBox2D box;        // id, class_name, score, center, size_x, size_y
-    PointCloudXYZPtr cloud;
-
-    geometry_msgs::Point location;
-    geometry_msgs::Vector3 key_vector;
-    double radius;
-};
-
-
-class LaserClusterInfo {
-public:
-    LaserClusterInfo(){
-        cloud = PointCloudXYZPtr(new PointCloudXYZ);
-        is_in_fov = false;
-    }
-    PointCloudXYZPtr cloud;
-    bool is_in_fov;
-    double dimension_2d;                        // sqrt(W^2 + L^2)
-    geometry_msgs::Point location;              // Center of cluster
-    geometry_msgs::Vector3 key_vec_imgspace;
-    // geometry_msgs::Vector3 key_vec_laserspace;       // deprecated
-};
-
-
-class ScanImageCombineNode {
-public:
-    ScanImageCombineNode(ros::NodeHandle nh, ros::NodeHandle pnh);
-    void img_scan_cb(const cv_bridge::CvImage::ConstPtr &cv_ptr, const sensor_msgs::LaserScan::ConstPtr &laser_msg_ptr);
-    void separate_outlier_points(PointCloudXYZPtr cloud_in, PointCloudXYZPtr cloud_out, bool is_far);
-    bool is_interest_class(std::string class_name);
-    double cosine_similarity_2d(geometry_msgs::Vector3 vec_a, geometry_msgs::Vector3 vec_b);
-    double calculate_distance_cost(geometry_msgs::Point location);
-    tf::Vector3 point_pixel2laser(double pixel_x, double pixel_y, double depth_from_laser);
-    cv::Point2d point_laser2pixel(double x_from_laser, double y_from_laser, double z_from_laser);
-
-    // Transformation
-    tf::Matrix3x3 rot_laser2cam_;
-    tf::Vector3 tras_laser2cam_;
-    tf::Matrix3x3 rot_cam2laser_;
-    tf::Vector3 tras_cam2laser_;
-
-    // Elevation angle for object height recovering
-    double camera_mount_elevation_angle_;
-
-    // Camera distortion coefficients
-    cv::Mat K_;
-    cv::Mat D_;
-
-    // ROS related
-    ros::NodeHandle nh_, pnh_;
-    tf::TransformListener tf_listener_;
-    laser_geometry::LaserProjection projector_;
-    ros::Publisher pub_combined_image_;
-    ros::Publisher pub_detection_image_;
-    ros::Publisher pub_marker_array_;
-    // ros::Publisher pub_debug_mrk_array_;
-    ros::Publisher pub_colored_pc_;
-    ros::Publisher pub_detection3d_;
-    ros::ServiceClient yolov4_detect_;  // ROS Service client
-    // Message filters
-    message_filters::Subscriber<sensor_msgs::LaserScan> scan_sub_;
-    message_filters::Subscriber<cv_bridge::CvImage> image_sub_;
-    boost::shared_ptr<MySynchronizer> sync_;
-
-    // Object list
-    std::vector<ObjInfo> obj_list_;
-
-    bool flag_det_vis_;
-};
 
 
 //    __   __        __  ___  __        __  ___  __   __  
 //   /  ` /  \ |\ | /__`  |  |__) |  | /  `  |  /  \ |__) 
 //   \__, \__/ | \| .__/  |  |  \ \__/ \__,  |  \__/ |  \ 
 //  
-ScanImageCombineNode::ScanImageCombineNode(ros::NodeHandle nh, ros::NodeHandle pnh): nh_(nh), pnh_(pnh) {
+ScanImageCombineNode::ScanImageCombineNode(ros::NodeHandle nh, ros::NodeHandle pnh, const std::string &log_name):
+    nh_(nh), pnh_(pnh), flag_setup_done_(false), log_name_(log_name) {
     // ROS parameters
     std::string scan_topic;
     std::string img_topic;
     std::string caminfo_topic;
-    std::string yolo_srv_name = "yolov4_node/yolo_detect";
-    ros::param::param<std::string>("~scan_topic", scan_topic, "scan");
-    ros::param::param<std::string>("~img_topic", img_topic, "usb_cam/image_raw"); 
-    ros::param::param<std::string>("~caminfo_topic", caminfo_topic, "usb_cam/camera_info");
-    ros::param::param<bool>("~flag_det_vis", flag_det_vis_, false);
+    std::string detection_topic;
+    pnh_.param<std::string>("scan_topic", scan_topic, "scan");
+    pnh_.param<std::string>("img_topic", img_topic, "usb_cam/image_raw"); 
+    pnh_.param<std::string>("caminfo_topic", caminfo_topic, "usb_cam/camera_info");
+    pnh_.param<std::string>("detection_topic", detection_topic, "");   // e.g. "yolov4_node/det2d_result"
+    pnh_.param<bool>("flag_det_vis", flag_det_vis_, false);
+    pnh_.param<bool>("roi_detection", flag_roi_detection_, false);      // Only detect in laser proposed regions
+    pnh_.param<bool>("roi_compare_full_frame", flag_roi_compare_, false);
+    pnh_.param<double>("roi_padding", roi_padding_, 0.2);
+    pnh_.param<double>("roi_z_min", roi_z_min_, -0.6);      // Laser is about 0.5m above the floor
+    pnh_.param<double>("roi_z_max", roi_z_max_, 1.4);
+    pnh_.param<bool>("appearance_descriptor", flag_appearance_, true);  // For the re-identification of the tracker
+    cmp_frames_ = cmp_full_boxes_ = cmp_matched_boxes_ = 0;
+    cmp_roi_latency_ = cmp_full_latency_ = 0.0;
 
     // ROS publisher & subscriber & message filter
     pub_combined_image_ = nh_.advertise<sensor_msgs::Image>("debug_reprojection", 1);
@@ -191,45 +37,88 @@ ScanImageCombineNode::ScanImageCombineNode(ros::NodeHandle nh, ros::NodeHandle p
     }
     pub_detection3d_ = nh.advertise<walker_msgs::Det3DArray>("det3d_result", 1);
     scan_sub_.subscribe(nh_, scan_topic, 1);
-    image_sub_.subscribe(nh_, img_topic, 1);
-    sync_.reset(new MySynchronizer(MySyncPolicy(10), image_sub_, scan_sub_));
-    sync_->registerCallback(boost::bind(&ScanImageCombineNode::img_scan_cb, this, _1, _2));
-
-    // ROS service client
-    ROS_INFO_STREAM("Wait for yolo detection service in 20 seconds...");
-    if(!ros::service::waitForService(yolo_srv_name, ros::Duration(20.0))) {
-        ROS_ERROR("Cannot get the detection service: %s. Aborting...", yolo_srv_name.c_str());
-        exit(-1);
+    if(detection_topic.empty()) {
+        image_sub_.subscribe(nh_, img_topic, 1);
+        sync_.reset(new MySynchronizer(MySyncPolicy(10), image_sub_, scan_sub_));
+        sync_->registerCallback(boost::bind(&ScanImageCombineNode::img_scan_cb, this, _1, _2));
+
+        // ROS service client, waited for by setup_timer_cb
+        yolo_srv_name_ = "yolov4_node/yolo_detect";
+        yolov4_detect_ = nh_.serviceClient<walker_msgs::Detection2DTrigger>(yolo_srv_name_);
     }
-    yolov4_detect_ = nh_.serviceClient<walker_msgs::Detection2DTrigger>(yolo_srv_name);
-
-    // To get the image frame_id from an image topic
-    std::string image_frame;
-    boost::shared_ptr<sensor_msgs::Image const> tmp_img_ptr;
-    ROS_INFO_STREAM("[" << ros::this_node::getName() << "] Wait for a image message in 5 seconds");
-    tmp_img_ptr = ros::topic::waitForMessage<sensor_msgs::Image>(img_topic, ros::Duration(5.0));
-    if(tmp_img_ptr != NULL){
-        image_frame = tmp_img_ptr->header.frame_id;
-        ROS_INFO("Image topic frame_id: %s", image_frame.c_str());
+    else {
+        // Detection results already carry the image, no service round trip
+        detection_sub_.subscribe(nh_, detection_topic, 1);
+        det_sync_.reset(new DetSynchronizer(DetSyncPolicy(10), detection_sub_, scan_sub_));
+        det_sync_->registerCallback(boost::bind(&ScanImageCombineNode::det_scan_cb, this, _1, _2));
+        ROS_INFO_STREAM("Use detection topic: " << detection_topic);
+        if(flag_roi_detection_)
+            ROS_WARN("roi_detection needs the detection service, ignored with detection topic");
     }
-    else{
-        image_frame = "camera_link";
-        ROS_WARN("Cannot get any image topic, set default image frame_id: %s", image_frame.c_str());
+
+    // Image frame_id and camera_info from their first message, then the TF from laser to camera
+    image_frame_sub_ = nh_.subscribe(img_topic, 1, &ScanImageCombineNode::image_frame_cb, this);
+    caminfo_sub_ = nh_.subscribe(caminfo_topic, 1, &ScanImageCombineNode::caminfo_cb, this);
+    setup_start_ = ros::Time::now();
+    setup_timer_ = nh_.createTimer(ros::Duration(0.5), &ScanImageCombineNode::setup_timer_cb, this);
+}
+
+
+void ScanImageCombineNode::image_frame_cb(const sensor_msgs::Image::ConstPtr &img_msg_ptr) {
+    std::lock_guard<std::mutex> lock(setup_mutex_);
+    image_frame_ = img_msg_ptr->header.frame_id;
+    ROS_INFO_NAMED(log_name_, "Image topic frame_id: %s", image_frame_.c_str());
+    image_frame_sub_.shutdown();
+}
+
+
+void ScanImageCombineNode::caminfo_cb(const sensor_msgs::CameraInfo::ConstPtr &caminfo_msg_ptr) {
+    std::lock_guard<std::mutex> lock(setup_mutex_);
+    caminfo_ptr_ = caminfo_msg_ptr;
+    caminfo_sub_.shutdown();
+}
+
+
+// Retried until everything is there, with the same fallbacks as before: camera_link after 5 s
+// without image, the default intrinsics after 10 s without camera_info
+void ScanImageCombineNode::setup_timer_cb(const ros::TimerEvent &event) {
+    std::lock_guard<std::mutex> lock(setup_mutex_);
+    if(flag_setup_done_)
+        return;
+    const double waited = (ros::Time::now() - setup_start_).toSec();
+
+    if(!yolo_srv_name_.empty() && !yolov4_detect_.exists()) {
+        ROS_ERROR_THROTTLE_NAMED(10.0, log_name_, "Cannot get the detection service: %s, retrying...", yolo_srv_name_.c_str());
+        return;
+    }
+
+    if(image_frame_.empty()) {
+        if(waited < 5.0)
+            return;
+        image_frame_ = "camera_link";
+        image_frame_sub_.shutdown();
+        ROS_WARN_NAMED(log_name_, "Cannot get any image topic, set default image frame_id: %s", image_frame_.c_str());
     }
-    tmp_img_ptr.reset();
 
     // Prepare extrinsic matrix
+    std::string error;
+    if(!tf_listener_.canTransform(image_frame_, "laser_link", ros::Time(0), &error)) {
+        if(waited >= 10.0)
+            ROS_ERROR_THROTTLE_NAMED(10.0, log_name_, "Cannot get TF from camera to laserscan: %s, retrying...", error.c_str());
+        return;
+    }
     tf::StampedTransform stamped_transform;
     try{
-        tf_listener_.waitForTransform(image_frame, "laser_link",
-                                    ros::Time(0), ros::Duration(10.0));
-        tf_listener_.lookupTransform(image_frame, "laser_link", 
-                                    ros::Time(0), stamped_transform);
+        tf_listener_.lookupTransform(image_frame_, "laser_link", ros::Time(0), stamped_transform);
     }
     catch (tf::TransformException ex){
-        ROS_ERROR("Cannot get TF from camera to laserscan: %s. Aborting...", ex.what());
-        exit(-1);
+        ROS_ERROR_THROTTLE_NAMED(10.0, log_name_, "Cannot get TF from camera to laserscan: %s, retrying...", ex.what());
+        return;
     }
+
+    if(!caminfo_ptr_ && waited < 10.0)
+        return;
+
     rot_laser2cam_ = tf::Matrix3x3(stamped_transform.getRotation());
     tras_laser2cam_ = stamped_transform.getOrigin();
     
@@ -242,12 +131,19 @@ ScanImageCombineNode::ScanImageCombineNode(ros::NodeHandle nh, ros::NodeHandle p
     rot_laser2cam_.getRPY(tmp_roll, tmp_pitch, tmp_yaw);
     camera_mount_elevation_angle_ = 90.0 - std::fabs(tmp_pitch);
 
-    // Prepare intrinsic matrix
-    boost::shared_ptr<sensor_msgs::CameraInfo const> caminfo_ptr;
+    set_intrinsics(caminfo_ptr_);
+    caminfo_sub_.shutdown();
+    setup_timer_.stop();
+    // Published after the calibration above, which the data callbacks read once they see it
+    flag_setup_done_ = true;
+    ROS_INFO_STREAM_NAMED(log_name_, COLOR_GREEN << ros::this_node::getName() << " is ready." << COLOR_NC);
+}
+
+
+// Prepare intrinsic matrix, the default values without camera_info
+void ScanImageCombineNode::set_intrinsics(const sensor_msgs::CameraInfo::ConstPtr &caminfo_ptr) {
     double fx, fy, cx, cy;
     double k1, k2, p1, p2;
-    ROS_INFO_STREAM("[" << ros::this_node::getName() << "] Wait for a camera_info message in 10 seconds");
-    caminfo_ptr = ros::topic::waitForMessage<sensor_msgs::CameraInfo>(caminfo_topic, ros::Duration(10.0));
     if(caminfo_ptr != NULL){       
         fx = caminfo_ptr->P[0];
         fy = caminfo_ptr->P[5];
@@ -259,7 +155,7 @@ ScanImageCombineNode::ScanImageCombineNode(ros::NodeHandle nh, ros::NodeHandle p
         p1 = caminfo_ptr->D[2];
         p2 = caminfo_ptr->D[3];
     }else {
-        ROS_WARN_STREAM("[" << ros::this_node::getName() << "] No camera_info received, use default values");
+        ROS_WARN_STREAM_NAMED(log_name_, "[" << ros::this_node::getName() << "] No camera_info received, use default values");
         fx = 518.34283;
         fy = 522.27271;
         cx = 305.42936;
@@ -274,8 +170,6 @@ ScanImageCombineNode::ScanImageCombineNode(ros::NodeHandle nh, ros::NodeHandle p
     D_ = (cv::Mat_<double>(5, 1) << k1, k2, p1, p2, 0.0);
     // cout << "K:\n" << K_ << endl;
     // cout << "D:\n" << D_ << endl;
-
-    ROS_INFO_STREAM(COLOR_GREEN << ros::this_node::getName() << " is ready." << COLOR_NC);
 }
 
 
@@ -398,6 +292,183 @@ cv::Point2d ScanImageCombineNode::point_laser2pixel(double x_from_laser, double
 
 
 void ScanImageCombineNode::img_scan_cb(const cv_bridge::CvImage::ConstPtr &cv_ptr, const sensor_msgs::LaserScan::ConstPtr &laser_msg_ptr){
+    if(!flag_setup_done_)
+        return;
+    // Call 2D bounding box detection service
+    walker_msgs::Detection2D det_result;
+    if(flag_roi_detection_) {
+        ros::WallTime start = ros::WallTime::now();
+        if(!detect_in_rois(cv_ptr, laser_msg_ptr, det_result))
+            return;
+        if(flag_roi_compare_)
+            compare_with_full_frame(cv_ptr, det_result, (ros::WallTime::now() - start).toSec());
+    }
+    else if(!call_detection(*cv_ptr, det_result)) {
+        return;
+    }
+    fuse_detection(cv_ptr->header, cv_ptr->image.size(), det_result, laser_msg_ptr);
+}
+
+
+bool ScanImageCombineNode::call_detection(const cv_bridge::CvImage &cv_image, walker_msgs::Detection2D &det_result) {
+    walker_msgs::Detection2DTrigger srv;
+    cv_image.toImageMsg(srv.request.image);
+    if(!yolov4_detect_.call(srv)){
+        ROS_ERROR("Failed to call service");
+        return false;
+    }
+    det_result = srv.response.result;
+    return true;
+}
+
+
+void ScanImageCombineNode::propose_rois(const sensor_msgs::LaserScan::ConstPtr &laser_msg_ptr, const cv::Size &img_size,
+                                        std::vector<cv::Rect> &rois) {
+    rois.clear();
+    sensor_msgs::PointCloud2 cloud_msg;
+    PointCloudXYZPtr cloud_raw(new PointCloudXYZ);
+    projector_.projectLaser(*laser_msg_ptr, cloud_msg);
+    pcl::fromROSMsg(cloud_msg, *cloud_raw);
+    if(cloud_raw->points.size() == 0)
+        return;
+
+    // Same clustering as the fusion step
+    pcl::search::KdTree<pcl::PointXYZ>::Ptr tree(new pcl::search::KdTree<pcl::PointXYZ>);
+    tree->setInputCloud(cloud_raw);
+    std::vector<pcl::PointIndices> cluster_indices;
+    pcl::EuclideanClusterExtraction<pcl::PointXYZ> extractor;
+    extractor.setClusterTolerance(kMinLaserClusterTolerance);
+    extractor.setMinClusterSize(2);
+    extractor.setMaxClusterSize(1000);
+    extractor.setSearchMethod(tree);
+    extractor.setInputCloud(cloud_raw);
+    extractor.extract(cluster_indices);
+
+    cv::Rect image_rect(0, 0, img_size.width, img_size.height);
+    for(int i = 0; i < cluster_indices.size(); i++) {
+        Eigen::Vector4f min_point, max_point;
+        pcl::getMinMax3D(*cloud_raw, cluster_indices[i].indices, min_point, max_point);
+        double dimension_2d = std::hypot(min_point[0] - max_point[0], min_point[1] - max_point[1]);
+        if(dimension_2d < kMinDimOfRoiCluster || dimension_2d > kMaxDimOfRoiCluster)
+            continue;
+
+        // Project the box of a standing person on the cluster to the image
+        std::vector<cv::Point2f> corners;
+        double xs[2] = {min_point[0], max_point[0]};
+        double ys[2] = {min_point[1], max_point[1]};
+        double zs[2] = {roi_z_min_, roi_z_max_};
+        for(int a = 0; a < 2; a++)
+            for(int b = 0; b < 2; b++)
+                for(int c = 0; c < 2; c++) {
+                    cv::Point2d pt_uv = point_laser2pixel(xs[a], ys[b], zs[c]);
+                    if(pt_uv.x != -1 || pt_uv.y != -1)
+                        corners.push_back(pt_uv);
+                }
+        if(corners.size() < 8)
+            continue;       // Partly behind the camera
+
+        cv::Rect roi = cv::boundingRect(corners);
+        int pad_x = roi.width * roi_padding_;
+        int pad_y = roi.height * roi_padding_;
+        roi = cv::Rect(roi.x - pad_x, roi.y - pad_y, roi.width + 2 * pad_x, roi.height + 2 * pad_y) & image_rect;
+        if(roi.area() > 0)
+            rois.push_back(roi);
+    }
+    RoiMosaic::merge_rois(rois);
+}
+
+
+bool ScanImageCombineNode::detect_in_rois(const cv_bridge::CvImage::ConstPtr &cv_ptr, const sensor_msgs::LaserScan::ConstPtr &laser_msg_ptr,
+                                          walker_msgs::Detection2D &det_result) {
+    std::vector<cv::Rect> rois;
+    propose_rois(laser_msg_ptr, cv_ptr->image.size(), rois);
+
+    // No person-sized cluster in the camera FOV, skip the detector
+    det_result.header = cv_ptr->header;
+    if(!roi_mosaic_.build(cv_ptr->image, rois)) {
+        cv_ptr->toImageMsg(det_result.result_image);
+        return true;
+    }
+    if(roi_mosaic_.mosaic().total() > kMaxMosaicAreaRatio * cv_ptr->image.total())
+        return call_detection(*cv_ptr, det_result);
+
+    cv_bridge::CvImage mosaic_image(cv_ptr->header, cv_ptr->encoding, roi_mosaic_.mosaic());
+    walker_msgs::Detection2D mosaic_result;
+    if(!call_detection(mosaic_image, mosaic_result))
+        return false;
+
+    // Boxes back to the full image
+    cv::Mat result_image = (pub_detection_image_.getNumSubscribers() > 0) ? cv_ptr->image.clone() : cv_ptr->image;
+    for(int i = 0; i < mosaic_result.boxes.size(); i++) {
+        walker_msgs::BBox2D bbox = mosaic_result.boxes[i];
+        cv::Rect2d box_in_image;
+        cv::Rect2d box_in_mosaic(bbox.center.x - bbox.size_x / 2, bbox.center.y - bbox.size_y / 2, bbox.size_x, bbox.size_y);
+        if(!roi_mosaic_.map_to_image(box_in_mosaic, box_in_image))
+            continue;
+        bbox.center.x = std::floor(box_in_image.x + box_in_image.width / 2);
+        bbox.center.y = std::floor(box_in_image.y + box_in_image.height / 2);
+        bbox.size_x = std::floor(box_in_image.width);
+        bbox.size_y = std::floor(box_in_image.height);
+        det_result.boxes.push_back(bbox);
+        if(result_image.data != cv_ptr->image.data)
+            cv::rectangle(result_image, box_in_image, cv::Scalar(255, 0, 0), 1);
+    }
+    cv_bridge::CvImage(cv_ptr->header, cv_ptr->encoding, result_image).toImageMsg(det_result.result_image);
+    return true;
+}
+
+
+static double box_iou(const walker_msgs::BBox2D &a, const walker_msgs::BBox2D &b) {
+    cv::Rect2d rect_a(a.center.x - a.size_x / 2, a.center.y - a.size_y / 2, a.size_x, a.size_y);
+    cv::Rect2d rect_b(b.center.x - b.size_x / 2, b.center.y - b.size_y / 2, b.size_x, b.size_y);
+    double inter = (rect_a & rect_b).area();
+    double uni = rect_a.area() + rect_b.area() - inter;
+    return (uni > 0) ? inter / uni : 0.0;
+}
+
+
+void ScanImageCombineNode::compare_with_full_frame(const cv_bridge::CvImage::ConstPtr &cv_ptr, const walker_msgs::Detection2D &roi_result,
+                                                   double roi_latency) {
+    ros::WallTime start = ros::WallTime::now();
+    walker_msgs::Detection2D full_result;
+    if(!call_detection(*cv_ptr, full_result))
+        return;
+    cmp_full_latency_ += (ros::WallTime::now() - start).toSec();
+    cmp_roi_latency_ += roi_latency;
+    cmp_frames_++;
+
+    // Recall of the ROI mode, taking the full frame persons used by the fusion as reference
+    std::vector<bool> used(roi_result.boxes.size(), false);
+    for(int i = 0; i < full_result.boxes.size(); i++) {
+        const walker_msgs::BBox2D &ref = full_result.boxes[i];
+        if(!is_interest_class(ref.class_name) || ref.size_y < 80)
+            continue;
+        cmp_full_boxes_++;
+        for(int j = 0; j < roi_result.boxes.size(); j++) {
+            if(!used[j] && box_iou(ref, roi_result.boxes[j]) >= kMatchIoU) {
+                used[j] = true;
+                cmp_matched_boxes_++;
+                break;
+            }
+        }
+    }
+    ROS_INFO_THROTTLE(5.0, "[ROI vs full frame] frames: %d, recall: %.3f (%d/%d), latency: %.1f ms vs %.1f ms",
+                      cmp_frames_, cmp_full_boxes_ ? (double)cmp_matched_boxes_ / cmp_full_boxes_ : 1.0,
+                      cmp_matched_boxes_, cmp_full_boxes_,
+                      cmp_roi_latency_ * 1000.0 / cmp_frames_, cmp_full_latency_ * 1000.0 / cmp_frames_);
+}
+
+
+void ScanImageCombineNode::det_scan_cb(const walker_msgs::Detection2D::ConstPtr &det_msg_ptr, const sensor_msgs::LaserScan::ConstPtr &laser_msg_ptr){
+    if(!flag_setup_done_)
+        return;
+    const sensor_msgs::Image &img = det_msg_ptr->result_image;
+    fuse_detection(img.header, cv::Size(img.width, img.height), *det_msg_ptr, laser_msg_ptr);
+}
+
+
+void ScanImageCombineNode::fuse_detection(const std_msgs::Header &img_header, const cv::Size &img_size,
+                                          const walker_msgs::Detection2D &det_result, const sensor_msgs::LaserScan::ConstPtr &laser_msg_ptr){
     // Object list init
     obj_list_.clear();
     // Visualization msg
@@ -406,20 +477,12 @@ void ScanImageCombineNode::img_scan_cb(const cv_bridge::CvImage::ConstPtr &cv_pt
     // Detection result message
     walker_msgs::Det3DArray detection_array;
 
-    // Call 2D bounding box detection service
-    walker_msgs::Detection2DTrigger srv;
-    srv.request.image = *(cv_ptr->toImageMsg());
-    if(!yolov4_detect_.call(srv)){
-        ROS_ERROR("Failed to call service");
-        return;
-    }
-    
-    double kImageWidth = cv_ptr->image.cols;
-    double kImageHeight = cv_ptr->image.rows;
+    double kImageWidth = img_size.width;
+    double kImageHeight = img_size.height;
 
     // Collect all interest classes to obj_list_
     // char det_str[200] = {0};
-    std::vector<walker_msgs::BBox2D> boxes = srv.response.result.boxes;
+    const std::vector<walker_msgs::BBox2D> &boxes = det_result.boxes;
     for(int i = 0; i < boxes.size(); i++) {
         if(is_interest_class(boxes[i].class_name)) {
             // Skip the box which is too small
@@ -441,8 +504,18 @@ void ScanImageCombineNode::img_scan_cb(const cv_bridge::CvImage::ConstPtr &cv_pt
 
     // Reconstruct undistorted cvimage from detection result image
     cv::Mat cvimage;
-    cv_bridge::CvImagePtr detected_cv_ptr = cv_bridge::toCvCopy(srv.response.result.result_image);
+    cv_bridge::CvImageConstPtr detected_cv_ptr = cv_bridge::toCvShare(det_result.result_image, boost::shared_ptr<void const>());
     cv::undistort(detected_cv_ptr->image, cvimage, K_, D_);
+    // Appearance descriptors on the image the boxes were detected in. The shared image is the
+    // buffer of the message, a BGR image is converted into a new one.
+    cv::Mat rgb_image;
+    if(flag_appearance_) {
+        if(detected_cv_ptr->encoding == sensor_msgs::image_encodings::BGR8)
+            cv::cvtColor(detected_cv_ptr->image, rgb_image, cv::COLOR_BGR2RGB);
+        else
+            rgb_image = detected_cv_ptr->image;
+    }
+    bool flag_appearance = flag_appearance_ && rgb_image.type() == CV_8UC3;
     
     // Convert laserscan to pointcloud:  laserscan --> ROS PointCloud2 --> PCL PointCloudXYZ
     sensor_msgs::PointCloud2 cloud_msg;
@@ -661,6 +734,13 @@ void ScanImageCombineNode::img_scan_cb(const cv_bridge::CvImage::ConstPtr &cv_pt
                     det_msg.confidence = obj_list_[i].box.score;
                     det_msg.class_name = obj_list_[i].box.class_name;
                     det_msg.class_id = obj_list_[i].box.id;
+                    reid::Descriptor descriptor;
+                    const reid::Box box = {obj_list_[i].box.center.x - obj_list_[i].box.size_x / 2,
+                                           obj_list_[i].box.center.y - obj_list_[i].box.size_y / 2,
+                                           obj_list_[i].box.size_x, obj_list_[i].box.size_y};
+                    if(flag_appearance && reid::compute_descriptor(rgb_image.data, rgb_image.cols, rgb_image.rows,
+                                                                   rgb_image.step, box, descriptor))
+                        det_msg.appearance.assign(descriptor.begin(), descriptor.end());
                     detection_array.dets_list.push_back(det_msg);
 
                     // Visualization
@@ -705,7 +785,7 @@ void ScanImageCombineNode::img_scan_cb(const cv_bridge::CvImage::ConstPtr &cv_pt
     }
 
     if(pub_detection_image_.getNumSubscribers() > 0){
-        cv_bridge::CvImage result_image(cv_ptr->header, "rgb8", cvimage);
+        cv_bridge::CvImage result_image(img_header, "rgb8", cvimage);
         pub_detection_image_.publish(result_image.toImageMsg());
     }
 
@@ -736,7 +816,7 @@ void ScanImageCombineNode::img_scan_cb(const cv_bridge::CvImage::ConstPtr &cv_pt
         // for (int j = 0; j < pts_uv2_list.size(); ++j)
         //     cv::circle(cvimage, pts_uv2_list[j], 5, cv::Scalar(255, 0, 0), -1);
 
-        cv_bridge::CvImage result_image(cv_ptr->header, "rgb8", cvimage);
+        cv_bridge::CvImage result_image(img_header, "rgb8", cvimage);
         pub_combined_image_.publish(result_image.toImageMsg());
     }
 
@@ -757,17 +837,3 @@ void ScanImageCombineNode::img_scan_cb(const cv_bridge::CvImage::ConstPtr &cv_pt
     //     std::cout << "\n===================" << std::endl;
     // }
 }
-
-
-
-//            
-//   |\/|  /\  | |\ | 
-//   |  | /~~\ | | \| 
-//  
-int main(int argc, char **argv) {
-    ros::init(argc, argv, "scan_clustering_node");
-    ros::NodeHandle nh, pnh("~");
-    ScanImageCombineNode node(nh, pnh);
-    ros::spin();
-    return 0;
-}
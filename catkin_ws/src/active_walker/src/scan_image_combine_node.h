@@ -0,0 +1,229 @@
+#ifndef SCAN_IMAGE_COMBINE_NODE_H
+#define SCAN_IMAGE_COMBINE_NODE_H
+
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <time.h>
+#include <math.h>
+#include <string.h>
+#include <stdlib.h>
+
+// ROS
+#include <ros/ros.h>
+#include <sensor_msgs/LaserScan.h>
+#include <sensor_msgs/Image.h>
+#include <sensor_msgs/CameraInfo.h>
+#include <sensor_msgs/image_encodings.h>
+#include <sensor_msgs/PointCloud2.h>
+#include <geometry_msgs/Point.h>
+#include <laser_geometry/laser_geometry.h>
+#include <cv_bridge/cv_bridge.h>
+#include <visualization_msgs/Marker.h>
+#include <visualization_msgs/MarkerArray.h>
+// Custom msg & srv
+#include <walker_msgs/Detection2D.h>
+#include <walker_msgs/Detection2DTrigger.h>
+#include <walker_msgs/Det3D.h>
+#include <walker_msgs/Det3DArray.h>
+
+// Message filter
+#include <message_filters/subscriber.h>
+#include <message_filters/synchronizer.h>
+#include <message_filters/sync_policies/approximate_time.h>
+#include <message_filters/time_synchronizer.h>
+
+// Eigen
+#include <Eigen/Dense>
+
+// OpenCV
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include <opencv2/calib3d/calib3d.hpp>
+
+// TF
+#include <tf/transform_listener.h>
+#include <tf/transform_datatypes.h>
+
+// PCL
+#include <pcl/point_types.h>
+#include <pcl/point_cloud.h>
+#include <pcl/common/common.h>
+#include <pcl/common/centroid.h> // Centroid
+#include <pcl/kdtree/kdtree.h>
+#include <pcl/segmentation/extract_clusters.h>
+#include <pcl/filters/extract_indices.h>
+#include <pcl_conversions/pcl_conversions.h> // ros2pcl
+#include <pcl/filters/radius_outlier_removal.h> // RemoveOutlier
+#include <pcl/filters/statistical_outlier_removal.h>
+#include <pcl_ros/transforms.h>
+
+// Linear assignment library
+#include "Hungarian.h"
+// Laser proposed regions for detection
+#include "roi_mosaic.h"
+// Appearance descriptor for re-identification, from multi_object_tracking
+#include "reid.hpp"
+
+
+typedef message_filters::sync_policies::ApproximateTime<cv_bridge::CvImage, sensor_msgs::LaserScan> MySyncPolicy;
+typedef message_filters::Synchronizer<MySyncPolicy> MySynchronizer;
+typedef message_filters::sync_policies::ApproximateTime<walker_msgs::Detection2D, sensor_msgs::LaserScan> DetSyncPolicy;
+typedef message_filters::Synchronizer<DetSyncPolicy> DetSynchronizer;
+
+typedef pcl::PointCloud<pcl::PointXYZ> PointCloudXYZ;
+typedef pcl::PointCloud<pcl::PointXYZ>::Ptr PointCloudXYZPtr;
+typedef pcl::PointCloud<pcl::PointXYZRGB> PointCloudXYZRGB;
+typedef pcl::PointCloud<pcl::PointXYZRGB>::Ptr PointCloudXYZRGBPtr;
+
+// Just for color words display
+static const std::string COLOR_RED = "\e[0;31m";
+static const std::string COLOR_GREEN = "\e[0;32m";
+static const std::string COLOR_YELLOW = "\e[0;33m"; 
+static const std::string COLOR_NC = "\e[0m";
+
+static const int kNumOfInterestClass = 1;
+static const std::string kInterestClassNames[kNumOfInterestClass] = {"person"};
+static const double kMaxDimOfLaserCluster = 1.2;   // Consider the cluster would be merged if two people are too close
+static const double kThresholdOfSimilarity = 0.95;
+static const double kThresholdOfUnreasonableHeight = 3.0;
+static const double kLifetimeOfMarker = 0.1;
+static const double kMinLaserClusterTolerance = 0.3;
+static const double kMinDimOfRoiCluster = 0.2;      // Person-sized laser clusters for ROI proposal
+static const double kMaxDimOfRoiCluster = 1.0;
+static const double kMaxMosaicAreaRatio = 0.7;      // Use the full image if the mosaic is not much smaller
+static const double kMatchIoU = 0.5;
+
+template <typename T, typename A>
+int arg_max(std::vector<T, A> const& vec) {
+    return static_cast<int>(std::distance(vec.begin(), max_element(vec.begin(), vec.end())));
+}
+
+template <typename T, typename A>
+int arg_min(std::vector<T, A> const& vec) {
+    return static_cast<int>(std::distance(vec.begin(), min_element(vec.begin(), vec.end())));
+}
+
+class ObjInfo {
+public:
+    ObjInfo(){
+        cloud = PointCloudXYZPtr(new PointCloudXYZ);
+        radius = 0.0;
+    }
+    walker_msgs::BBox2D box;        // id, class_name, score, center, size_x, size_y
+    PointCloudXYZPtr cloud;
+
+    geometry_msgs::Point location;
+    geometry_msgs::Vector3 key_vector;
+    double radius;
+};
+
+
+class LaserClusterInfo {
+public:
+    LaserClusterInfo(){
+        cloud = PointCloudXYZPtr(new PointCloudXYZ);
+        is_in_fov = false;
+    }
+    PointCloudXYZPtr cloud;
+    bool is_in_fov;
+    double dimension_2d;                        // sqrt(W^2 + L^2)
+    geometry_msgs::Point location;              // Center of cluster
+    geometry_msgs::Vector3 key_vec_imgspace;
+    // geometry_msgs::Vector3 key_vec_laserspace;       // deprecated
+};
+
+
+class ScanImageCombineNode {
+public:
+    ScanImageCombineNode(ros::NodeHandle nh, ros::NodeHandle pnh, const std::string &log_name = "scan_image_combine");
+    bool is_ready() const { return flag_setup_done_; }
+    void setup_timer_cb(const ros::TimerEvent &event);
+    void image_frame_cb(const sensor_msgs::Image::ConstPtr &img_msg_ptr);
+    void caminfo_cb(const sensor_msgs::CameraInfo::ConstPtr &caminfo_msg_ptr);
+    void set_intrinsics(const sensor_msgs::CameraInfo::ConstPtr &caminfo_ptr);
+    void img_scan_cb(const cv_bridge::CvImage::ConstPtr &cv_ptr, const sensor_msgs::LaserScan::ConstPtr &laser_msg_ptr);
+    bool call_detection(const cv_bridge::CvImage &cv_image, walker_msgs::Detection2D &det_result);
+    bool detect_in_rois(const cv_bridge::CvImage::ConstPtr &cv_ptr, const sensor_msgs::LaserScan::ConstPtr &laser_msg_ptr,
+                        walker_msgs::Detection2D &det_result);
+    void propose_rois(const sensor_msgs::LaserScan::ConstPtr &laser_msg_ptr, const cv::Size &img_size, std::vector<cv::Rect> &rois);
+    void compare_with_full_frame(const cv_bridge::CvImage::ConstPtr &cv_ptr, const walker_msgs::Detection2D &roi_result, double roi_latency);
+    void det_scan_cb(const walker_msgs::Detection2D::ConstPtr &det_msg_ptr, const sensor_msgs::LaserScan::ConstPtr &laser_msg_ptr);
+    void fuse_detection(const std_msgs::Header &img_header, const cv::Size &img_size,
+                        const walker_msgs::Detection2D &det_result, const sensor_msgs::LaserScan::ConstPtr &laser_msg_ptr);
+    void separate_outlier_points(PointCloudXYZPtr cloud_in, PointCloudXYZPtr cloud_out, bool is_far);
+    bool is_interest_class(std::string class_name);
+    double cosine_similarity_2d(geometry_msgs::Vector3 vec_a, geometry_msgs::Vector3 vec_b);
+    double calculate_distance_cost(geometry_msgs::Point location);
+    tf::Vector3 point_pixel2laser(double pixel_x, double pixel_y, double depth_from_laser);
+    cv::Point2d point_laser2pixel(double x_from_laser, double y_from_laser, double z_from_laser);
+
+    // Transformation
+    tf::Matrix3x3 rot_laser2cam_;
+    tf::Vector3 tras_laser2cam_;
+    tf::Matrix3x3 rot_cam2laser_;
+    tf::Vector3 tras_cam2laser_;
+
+    // Elevation angle for object height recovering
+    double camera_mount_elevation_angle_;
+
+    // Camera distortion coefficients
+    cv::Mat K_;
+    cv::Mat D_;
+
+    // ROS related
+    ros::NodeHandle nh_, pnh_;
+    tf::TransformListener tf_listener_;
+    laser_geometry::LaserProjection projector_;
+    ros::Publisher pub_combined_image_;
+    ros::Publisher pub_detection_image_;
+    ros::Publisher pub_marker_array_;
+    // ros::Publisher pub_debug_mrk_array_;
+    ros::Publisher pub_colored_pc_;
+    ros::Publisher pub_detection3d_;
+    ros::ServiceClient yolov4_detect_;  // ROS Service client
+    // Message filters
+    message_filters::Subscriber<sensor_msgs::LaserScan> scan_sub_;
+    message_filters::Subscriber<cv_bridge::CvImage> image_sub_;
+    boost::shared_ptr<MySynchronizer> sync_;
+    // Detection topic from YoloDetectorNodelet instead of the service
+    message_filters::Subscriber<walker_msgs::Detection2D> detection_sub_;
+    boost::shared_ptr<DetSynchronizer> det_sync_;
+
+    // Object list
+    std::vector<ObjInfo> obj_list_;
+
+    bool flag_det_vis_;
+
+    // Laser proposed ROI detection
+    bool flag_roi_detection_;
+    bool flag_roi_compare_;         // Also run on the full image and report recall & latency
+    double roi_padding_;            // Ratio of ROI width & height
+    double roi_z_min_;              // Height range of a person in laser frame
+    double roi_z_max_;
+    RoiMosaic roi_mosaic_;
+    int cmp_frames_, cmp_full_boxes_, cmp_matched_boxes_;
+    double cmp_roi_latency_, cmp_full_latency_;
+
+    // Appearance descriptor of each detection, for the re-identification of the tracker
+    bool flag_appearance_;
+
+    // Camera extrinsics & intrinsics and the detection service, set up by setup_timer_ without
+    // blocking the constructor (it runs in the onInit of the nodelet). Frames are dropped until then.
+    // The flag is set once K_, D_ and the extrinsics are written, the data callbacks of the nodelet
+    // run on other threads. setup_mutex_ guards the inputs of the setup below.
+    std::atomic<bool> flag_setup_done_;
+    std::mutex setup_mutex_;
+    std::string log_name_;              // logger name, the nodelet name in a nodelet manager
+    std::string yolo_srv_name_;
+    std::string image_frame_;
+    sensor_msgs::CameraInfo::ConstPtr caminfo_ptr_;
+    ros::Time setup_start_;
+    ros::Timer setup_timer_;
+    ros::Subscriber image_frame_sub_;
+    ros::Subscriber caminfo_sub_;
+};
+
+
+#endif
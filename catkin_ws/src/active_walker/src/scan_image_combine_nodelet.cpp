@@ -0,0 +1,25 @@
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+
+#include "scan_image_combine_node.h"
+
+
+namespace active_walker {
+
+// ScanImageCombineNode in a nodelet manager, so detection results from
+// YoloDetectorNodelet arrive through an in-process topic. The node returns right away and sets
+// up the camera calibration from a timer, onInit must not block the manager.
+class ScanImageCombineNodelet : public nodelet::Nodelet {
+public:
+    virtual void onInit() {
+        node_.reset(new ScanImageCombineNode(getNodeHandle(), getPrivateNodeHandle(), getName()));
+        NODELET_INFO("Waiting for the image frame, camera_info and TF from laser to camera");
+    }
+
+private:
+    boost::shared_ptr<ScanImageCombineNode> node_;
+};
+
+} // namespace active_walker
+
+PLUGINLIB_EXPORT_CLASS(active_walker::ScanImageCombineNodelet, nodelet::Nodelet);
@@ -0,0 +1,509 @@
+#include "walker_log.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+
+namespace walker_log {
+
+static const char kMagic[4] = {'W', 'L', 'O', 'G'};
+static const char kFooterMagic[4] = {'W', 'L', 'I', 'X'};
+static const int kHeaderSize = 8;
+static const int kRecordHeaderSize = 5;
+static const int kFooterSize = 12;
+static const int kChunkHeaderSize = 22;     // topic, start, end, count
+// Quantized values are clamped to that, far from any overflow of the deltas
+static const double kMaxQuantized = 4.0e18;
+
+
+void Encoder::put_uint(uint64_t value, int num_bytes) {
+    for(int i = 0; i < num_bytes; i++)
+        data_.push_back((char)((value >> (8 * i)) & 0xff));
+}
+
+
+void Encoder::put_varint(uint64_t value) {
+    while(value >= 0x80) {
+        data_.push_back((char)((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    data_.push_back((char)value);
+}
+
+
+void Encoder::put_signed(int64_t value) {
+    put_varint(((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+}
+
+
+void Encoder::put_float(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    put_uint(bits, 4);
+}
+
+
+void Encoder::put_string(const std::string &value) {
+    put_varint(value.size());
+    data_.append(value);
+}
+
+
+void Encoder::put_column(const std::vector<int64_t> &values) {
+    // Wrapping unsigned differences, exact over the whole int64 range
+    uint64_t previous = 0;
+    for(int i = 0; i < values.size(); i++) {
+        put_signed((int64_t)((uint64_t)values[i] - previous));
+        previous = values[i];
+    }
+}
+
+
+void Encoder::put_column(const std::vector<double> &values, double resolution) {
+    std::vector<int64_t> quantized(values.size());
+    for(int i = 0; i < values.size(); i++) {
+        const double q = values[i] / resolution;
+        quantized[i] = std::isfinite(q) ? std::llround(std::max(-kMaxQuantized, std::min(kMaxQuantized, q))) : 0;
+    }
+    put_column(quantized);
+}
+
+
+void Encoder::put_strings(const std::vector<std::string> &values) {
+    std::map<std::string, int> dictionary;
+    std::vector<const std::string *> words;
+    std::vector<int> indices(values.size());
+    for(int i = 0; i < values.size(); i++) {
+        std::map<std::string, int>::iterator it = dictionary.find(values[i]);
+        if(it == dictionary.end()) {
+            it = dictionary.insert(std::make_pair(values[i], (int)words.size())).first;
+            words.push_back(&values[i]);
+        }
+        indices[i] = it->second;
+    }
+    put_varint(words.size());
+    for(int i = 0; i < words.size(); i++)
+        put_string(*words[i]);
+    for(int i = 0; i < indices.size(); i++)
+        put_varint(indices[i]);
+}
+
+
+void Encoder::put_runs(const std::vector<int8_t> &values) {
+    for(size_t i = 0; i < values.size();) {
+        size_t j = i + 1;
+        while(j < values.size() && values[j] == values[i])
+            j++;
+        put_varint(j - i);
+        put_byte((uint8_t)values[i]);
+        i = j;
+    }
+}
+
+
+uint8_t Decoder::get_byte() {
+    if(position_ >= size_) {
+        fail();
+        return 0;
+    }
+    return (uint8_t)data_[position_++];
+}
+
+
+uint64_t Decoder::get_uint(int num_bytes) {
+    if(position_ + num_bytes > size_) {
+        fail();
+        return 0;
+    }
+    uint64_t value = 0;
+    for(int i = 0; i < num_bytes; i++)
+        value |= (uint64_t)(uint8_t)data_[position_++] << (8 * i);
+    return value;
+}
+
+
+uint64_t Decoder::get_varint() {
+    uint64_t value = 0;
+    for(int shift = 0; shift < 64; shift += 7) {
+        if(position_ >= size_)
+            break;
+        const uint8_t byte = (uint8_t)data_[position_++];
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        if(!(byte & 0x80))
+            return value;
+    }
+    fail();
+    return 0;
+}
+
+
+int64_t Decoder::get_signed() {
+    const uint64_t value = get_varint();
+    return (int64_t)((value >> 1) ^ (~(value & 1) + 1));
+}
+
+
+float Decoder::get_float() {
+    const uint32_t bits = get_uint(4);
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+
+std::string Decoder::get_string() {
+    const uint64_t length = get_varint();
+    if(length > size_ - position_) {
+        fail();
+        return std::string();
+    }
+    std::string value(data_ + position_, length);
+    position_ += length;
+    return value;
+}
+
+
+bool Decoder::get_column(size_t count, std::vector<int64_t> &values) {
+    values.resize(count);
+    uint64_t previous = 0;
+    for(size_t i = 0; i < count; i++) {
+        previous += (uint64_t)get_signed();
+        values[i] = (int64_t)previous;
+    }
+    return ok_;
+}
+
+
+bool Decoder::get_column(size_t count, double resolution, std::vector<double> &values) {
+    std::vector<int64_t> quantized;
+    get_column(count, quantized);
+    values.resize(count);
+    for(size_t i = 0; i < count; i++)
+        values[i] = quantized[i] * resolution;
+    return ok_;
+}
+
+
+bool Decoder::get_strings(size_t count, std::vector<std::string> &values) {
+    const uint64_t num_words = get_varint();
+    if(num_words > size_ - position_ || (num_words == 0 && count > 0))
+        return fail();
+    std::vector<std::string> words(num_words);
+    for(size_t i = 0; i < num_words; i++)
+        words[i] = get_string();
+    values.resize(count);
+    for(size_t i = 0; i < count; i++) {
+        const uint64_t index = get_varint();
+        if(index >= num_words)
+            return fail();
+        values[i] = words[index];
+    }
+    return ok_;
+}
+
+
+bool Decoder::get_runs(size_t count, std::vector<int8_t> &values) {
+    values.resize(count);
+    for(size_t i = 0; i < count;) {
+        const uint64_t length = get_varint();
+        const int8_t value = (int8_t)get_byte();
+        if(!ok_ || length == 0 || length > count - i)
+            return fail();
+        std::fill(values.begin() + i, values.begin() + i + length, value);
+        i += length;
+    }
+    return ok_;
+}
+
+
+static void put_topic(const Topic &topic, Encoder &encoder) {
+    encoder.put_uint(topic.id, 2);
+    encoder.put_uint(topic.type, 2);
+    encoder.put_uint(topic.codec_version, 2);
+    encoder.put_string(topic.name);
+}
+
+
+static Topic get_topic(Decoder &decoder) {
+    Topic topic;
+    topic.id = decoder.get_uint(2);
+    topic.type = decoder.get_uint(2);
+    topic.codec_version = decoder.get_uint(2);
+    topic.name = decoder.get_string();
+    return topic;
+}
+
+
+static void put_chunk_header(const ChunkInfo &chunk, Encoder &encoder) {
+    encoder.put_uint(chunk.topic, 2);
+    encoder.put_uint(chunk.start_time, 8);
+    encoder.put_uint(chunk.end_time, 8);
+    encoder.put_uint(chunk.num_messages, 4);
+}
+
+
+static ChunkInfo get_chunk_header(Decoder &decoder) {
+    ChunkInfo chunk;
+    chunk.topic = decoder.get_uint(2);
+    chunk.start_time = decoder.get_uint(8);
+    chunk.end_time = decoder.get_uint(8);
+    chunk.num_messages = decoder.get_uint(4);
+    chunk.offset = 0;
+    chunk.size = 0;
+    return chunk;
+}
+
+
+static bool chunk_before(const ChunkInfo &a, const ChunkInfo &b) {
+    return a.start_time < b.start_time;
+}
+
+
+bool Writer::open(const std::string &file_name) {
+    close();
+    file_ = std::fopen(file_name.c_str(), "wb");
+    if(file_ == NULL)
+        return false;
+    Encoder header;
+    for(int i = 0; i < 4; i++)
+        header.put_byte(kMagic[i]);
+    header.put_uint(kFormatVersion, 2);
+    header.put_uint(0, 2);
+    offset_ = 0;
+    topics_.clear();
+    chunks_.clear();
+    if(std::fwrite(header.data().data(), 1, header.data().size(), file_) != kHeaderSize) {
+        close();
+        return false;
+    }
+    offset_ = kHeaderSize;
+    return true;
+}
+
+
+bool Writer::write_record(uint8_t kind, const std::string &payload) {
+    if(file_ == NULL)
+        return false;
+    Encoder header;
+    header.put_byte(kind);
+    header.put_uint(payload.size(), 4);
+    if(std::fwrite(header.data().data(), 1, kRecordHeaderSize, file_) != kRecordHeaderSize ||
+       std::fwrite(payload.data(), 1, payload.size(), file_) != payload.size())
+        return false;
+    offset_ += kRecordHeaderSize + payload.size();
+    return true;
+}
+
+
+int Writer::add_topic(const std::string &name, uint16_t type, uint16_t codec_version) {
+    Topic topic = {(uint16_t)topics_.size(), type, codec_version, name};
+    Encoder encoder;
+    put_topic(topic, encoder);
+    if(!write_record(kTopicRecord, encoder.data()))
+        return -1;
+    topics_.push_back(topic);
+    return topic.id;
+}
+
+
+bool Writer::write_chunk(int topic, int64_t start_time, int64_t end_time, uint32_t num_messages,
+                         const std::string &columns) {
+    if(topic < 0 || topic >= topics_.size())
+        return false;
+    ChunkInfo chunk = {(uint16_t)topic, start_time, end_time, num_messages, offset_, 0};
+    Encoder encoder;
+    put_chunk_header(chunk, encoder);
+    std::string payload = encoder.data();
+    payload.append(columns);
+    chunk.size = payload.size();
+    if(!write_record(kChunkRecord, payload))
+        return false;
+    chunks_.push_back(chunk);
+    std::fflush(file_);
+    return true;
+}
+
+
+void Writer::close() {
+    if(file_ == NULL)
+        return;
+    Encoder index;
+    index.put_varint(topics_.size());
+    for(int i = 0; i < topics_.size(); i++)
+        put_topic(topics_[i], index);
+    index.put_varint(chunks_.size());
+    for(int i = 0; i < chunks_.size(); i++) {
+        put_chunk_header(chunks_[i], index);
+        index.put_uint(chunks_[i].offset, 8);
+        index.put_uint(chunks_[i].size, 4);
+    }
+    const uint64_t index_offset = offset_;
+    if(write_record(kIndexRecord, index.data())) {
+        Encoder footer;
+        footer.put_uint(index_offset, 8);
+        for(int i = 0; i < 4; i++)
+            footer.put_byte(kFooterMagic[i]);
+        std::fwrite(footer.data().data(), 1, footer.data().size(), file_);
+    }
+    std::fclose(file_);
+    file_ = NULL;
+}
+
+
+bool Reader::open(const std::string &file_name) {
+    close();
+    file_ = std::fopen(file_name.c_str(), "rb");
+    if(file_ == NULL)
+        return false;
+    std::fseek(file_, 0, SEEK_END);
+    file_size_ = std::ftell(file_);
+    char header[kHeaderSize];
+    std::fseek(file_, 0, SEEK_SET);
+    if(file_size_ < kHeaderSize || std::fread(header, 1, kHeaderSize, file_) != kHeaderSize ||
+       std::memcmp(header, kMagic, 4) != 0) {
+        close();
+        return false;
+    }
+    Decoder decoder(header + 4, 2);
+    version_ = decoder.get_uint(2);
+    if(version_ == 0 || version_ > kFormatVersion) {
+        close();
+        return false;
+    }
+    indexed_ = read_index();
+    if(!indexed_)
+        scan_records();
+    std::stable_sort(chunks_.begin(), chunks_.end(), chunk_before);
+    return true;
+}
+
+
+void Reader::close() {
+    if(file_ != NULL)
+        std::fclose(file_);
+    file_ = NULL;
+    topics_.clear();
+    chunks_.clear();
+    indexed_ = false;
+}
+
+
+bool Reader::read_record(uint64_t offset, uint8_t &kind, std::string &payload) {
+    char header[kRecordHeaderSize];
+    if(offset + kRecordHeaderSize > file_size_ || std::fseek(file_, offset, SEEK_SET) != 0 ||
+       std::fread(header, 1, kRecordHeaderSize, file_) != kRecordHeaderSize)
+        return false;
+    Decoder decoder(header, kRecordHeaderSize);
+    kind = decoder.get_byte();
+    const uint64_t size = decoder.get_uint(4);
+    if(offset + kRecordHeaderSize + size > file_size_)
+        return false;
+    payload.resize(size);
+    return size == 0 || std::fread(&payload[0], 1, size, file_) == size;
+}
+
+
+bool Reader::read_index() {
+    char footer[kFooterSize];
+    if(file_size_ < kHeaderSize + kFooterSize || std::fseek(file_, file_size_ - kFooterSize, SEEK_SET) != 0 ||
+       std::fread(footer, 1, kFooterSize, file_) != kFooterSize || std::memcmp(footer + 8, kFooterMagic, 4) != 0)
+        return false;
+    Decoder footer_decoder(footer, 8);
+    uint8_t kind;
+    std::string payload;
+    if(!read_record(footer_decoder.get_uint(8), kind, payload) || kind != kIndexRecord)
+        return false;
+
+    Decoder decoder(payload);
+    const uint64_t num_topics = decoder.get_varint();
+    for(uint64_t i = 0; i < num_topics && decoder.ok(); i++)
+        topics_.push_back(get_topic(decoder));
+    const uint64_t num_chunks = decoder.get_varint();
+    for(uint64_t i = 0; i < num_chunks && decoder.ok(); i++) {
+        ChunkInfo chunk = get_chunk_header(decoder);
+        chunk.offset = decoder.get_uint(8);
+        chunk.size = decoder.get_uint(4);
+        chunks_.push_back(chunk);
+    }
+    if(!decoder.ok()) {
+        topics_.clear();
+        chunks_.clear();
+        return false;
+    }
+    return true;
+}
+
+
+// Log that was not closed: every complete record up to the first truncated one
+void Reader::scan_records() {
+    uint64_t offset = kHeaderSize;
+    char header[kRecordHeaderSize + kChunkHeaderSize];
+    while(offset + kRecordHeaderSize <= file_size_) {
+        std::fseek(file_, offset, SEEK_SET);
+        const size_t num_read = std::fread(header, 1, sizeof(header), file_);
+        Decoder decoder(header, num_read);
+        const uint8_t kind = decoder.get_byte();
+        const uint64_t size = decoder.get_uint(4);
+        if(!decoder.ok() || offset + kRecordHeaderSize + size > file_size_)
+            break;
+        if(kind == kTopicRecord) {
+            uint8_t topic_kind;
+            std::string payload;
+            if(!read_record(offset, topic_kind, payload))
+                break;
+            Decoder topic_decoder(payload);
+            const Topic topic = get_topic(topic_decoder);
+            if(!topic_decoder.ok())
+                break;
+            topics_.push_back(topic);
+        }
+        else if(kind == kChunkRecord) {
+            ChunkInfo chunk = get_chunk_header(decoder);
+            if(!decoder.ok())
+                break;
+            chunk.offset = offset;
+            chunk.size = size;
+            chunks_.push_back(chunk);
+        }
+        else
+            break;
+        offset += kRecordHeaderSize + size;
+    }
+}
+
+
+int Reader::find_topic(const std::string &name) const {
+    for(int i = 0; i < topics_.size(); i++) {
+        if(topics_[i].name == name)
+            return topics_[i].id;
+    }
+    return -1;
+}
+
+
+std::vector<int> Reader::find_chunks(int64_t start_time, int64_t end_time, int topic) const {
+    // The chunks are sorted by start time, the ones after end_time are skipped at once
+    const ChunkInfo last = {0, end_time, end_time, 0, 0, 0};
+    const int end = std::upper_bound(chunks_.begin(), chunks_.end(), last, chunk_before) - chunks_.begin();
+    std::vector<int> found;
+    for(int i = 0; i < end; i++) {
+        if(chunks_[i].end_time >= start_time && (topic < 0 || chunks_[i].topic == topic))
+            found.push_back(i);
+    }
+    return found;
+}
+
+
+bool Reader::read_chunk(int chunk, std::string &columns) {
+    if(file_ == NULL || chunk < 0 || chunk >= chunks_.size())
+        return false;
+    uint8_t kind;
+    std::string payload;
+    if(!read_record(chunks_[chunk].offset, kind, payload) || kind != kChunkRecord || payload.size() < kChunkHeaderSize)
+        return false;
+    columns.assign(payload, kChunkHeaderSize, std::string::npos);
+    return true;
+}
+
+}
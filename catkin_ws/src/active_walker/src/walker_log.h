@@ -0,0 +1,174 @@
+#ifndef WALKER_LOG_H
+#define WALKER_LOG_H
+
+#include <cstdio>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+
+// Compact binary log of the walker topics, for full sessions on the robot disk.
+//
+// File layout, little endian:
+//   "WLOG" uint16 format version, uint16 0
+//   records       uint8 kind, uint32 payload size, payload
+//     topic       uint16 topic, uint16 message type, uint16 codec version, string name
+//     chunk       uint16 topic, int64 start, int64 end (ns), uint32 count, columns
+//     index       varint topics, topic records..., varint chunks, (uint16 topic, int64 start,
+//                 int64 end, uint32 count, uint64 offset, uint32 size)...
+//   footer        uint64 offset of the index record, "WLIX"
+// A chunk holds the messages of one topic over a few seconds, stored column by column: each
+// field is quantized to integers, delta encoded from one message to the next and written as
+// zigzag varints. The index gives random access by time; a log that was never closed (power
+// loss) has no index and is read by scanning its records.
+namespace walker_log {
+
+const uint16_t kFormatVersion = 1;
+
+enum RecordKind {
+    kTopicRecord = 1,
+    kChunkRecord = 2,
+    kIndexRecord = 3,
+};
+
+
+// Writes the columns of a chunk
+class Encoder {
+public:
+    void put_byte(uint8_t value) { data_.push_back((char)value); }
+    void put_uint(uint64_t value, int num_bytes);       // fixed size
+    void put_varint(uint64_t value);
+    void put_signed(int64_t value);                     // zigzag varint
+    void put_float(float value);
+    void put_string(const std::string &value);
+
+    // Delta encoded integers
+    void put_column(const std::vector<int64_t> &values);
+    // Values rounded to multiples of the resolution, then delta encoded. The rounding error is
+    // at most resolution / 2 and does not accumulate.
+    void put_column(const std::vector<double> &values, double resolution);
+    // Dictionary of the distinct strings, then one index per value
+    void put_strings(const std::vector<std::string> &values);
+    // Runs of equal bytes, as (run length, byte) pairs
+    void put_runs(const std::vector<int8_t> &values);
+
+    const std::string &data() const { return data_; }
+    void clear() { data_.clear(); }
+
+private:
+    std::string data_;
+};
+
+
+// Reads back what the Encoder wrote. Reading past the end or a malformed value sets the failed
+// state, after which every value reads as zero; check ok() once the whole chunk is decoded.
+class Decoder {
+public:
+    Decoder(const char *data, size_t size): data_(data), size_(size), position_(0), ok_(true) {}
+    explicit Decoder(const std::string &data): data_(data.data()), size_(data.size()), position_(0), ok_(true) {}
+
+    uint8_t get_byte();
+    uint64_t get_uint(int num_bytes);
+    uint64_t get_varint();
+    int64_t get_signed();
+    float get_float();
+    std::string get_string();
+
+    bool get_column(size_t count, std::vector<int64_t> &values);
+    bool get_column(size_t count, double resolution, std::vector<double> &values);
+    bool get_strings(size_t count, std::vector<std::string> &values);
+    bool get_runs(size_t count, std::vector<int8_t> &values);
+
+    bool ok() const { return ok_; }
+    bool at_end() const { return position_ == size_; }
+    size_t remaining() const { return size_ - position_; }
+
+private:
+    bool fail() { ok_ = false; position_ = size_; return false; }
+
+    const char *data_;
+    size_t size_, position_;
+    bool ok_;
+};
+
+
+struct Topic {
+    uint16_t id;
+    uint16_t type;              // message type, see walker_log_codecs.h
+    uint16_t codec_version;     // of the columns of that message type
+    std::string name;
+};
+
+struct ChunkInfo {
+    uint16_t topic;
+    int64_t start_time, end_time;   // ns, of the first and last message
+    uint32_t num_messages;
+    uint64_t offset;                // of the chunk record in the file
+    uint32_t size;                  // of its payload
+};
+
+
+class Writer {
+public:
+    Writer(): file_(NULL) {}
+    ~Writer() { close(); }
+
+    bool open(const std::string &file_name);
+    bool is_open() const { return file_ != NULL; }
+    // Topic id for the next chunks, the record goes to the file right away
+    int add_topic(const std::string &name, uint16_t type, uint16_t codec_version);
+    // Messages start_time to end_time of the topic, columns from an Encoder. The file is flushed
+    // after each chunk, a crash loses at most the chunks being filled.
+    bool write_chunk(int topic, int64_t start_time, int64_t end_time, uint32_t num_messages,
+                     const std::string &columns);
+    // Writes the index and the footer
+    void close();
+
+    uint64_t size() const { return offset_; }
+
+private:
+    bool write_record(uint8_t kind, const std::string &payload);
+
+    FILE *file_;
+    uint64_t offset_;
+    std::vector<Topic> topics_;
+    std::vector<ChunkInfo> chunks_;
+};
+
+
+class Reader {
+public:
+    Reader(): file_(NULL), version_(0), indexed_(false) {}
+    ~Reader() { close(); }
+
+    // False if the file is not a walker log or of a newer format version
+    bool open(const std::string &file_name);
+    void close();
+
+    uint16_t version() const { return version_; }
+    bool indexed() const { return indexed_; }    // false for a log that was not closed
+    const std::vector<Topic> &topics() const { return topics_; }
+    const std::vector<ChunkInfo> &chunks() const { return chunks_; }    // by start time
+    int find_topic(const std::string &name) const;    // -1 if none
+
+    // Chunks of the topic (-1 for all) with messages between start_time and end_time
+    std::vector<int> find_chunks(int64_t start_time, int64_t end_time, int topic = -1) const;
+    // Columns of the chunk, for a Decoder
+    bool read_chunk(int chunk, std::string &columns);
+
+private:
+    bool read_record(uint64_t offset, uint8_t &kind, std::string &payload);
+    bool read_index();
+    void scan_records();
+
+    FILE *file_;
+    uint64_t file_size_;
+    uint16_t version_;
+    bool indexed_;
+    std::vector<Topic> topics_;
+    std::vector<ChunkInfo> chunks_;
+};
+
+}
+
+#endif
@@ -0,0 +1,358 @@
+#include "walker_log_codecs.h"
+
+namespace walker_log {
+
+// Guard against corrupted sizes before allocating
+static const uint64_t kMaxCells = 1 << 28;
+
+
+const char *message_type_name(uint16_t type) {
+    switch(type) {
+        case kTracks: return "walker_msgs/Trk3DArray";
+        case kOccupancyGrid: return "nav_msgs/OccupancyGrid";
+        case kPath: return "nav_msgs/Path";
+        case kTwist: return "geometry_msgs/Twist";
+        case kWrench: return "geometry_msgs/WrenchStamped";
+        case kFloat32: return "std_msgs/Float32";
+    }
+    return "";
+}
+
+
+// One quantized column of a field of the items
+template<class Item, class Get>
+static void put_values(const std::vector<Item> &items, double resolution, Encoder &encoder, Get get) {
+    std::vector<double> values(items.size());
+    for(int i = 0; i < items.size(); i++)
+        values[i] = get(items[i]);
+    encoder.put_column(values, resolution);
+}
+
+
+template<class Item, class Set>
+static void get_values(Decoder &decoder, std::vector<Item> &items, double resolution, Set set) {
+    std::vector<double> values;
+    decoder.get_column(items.size(), resolution, values);
+    for(int i = 0; i < items.size(); i++)
+        set(items[i], values[i]);
+}
+
+
+template<class Item, class Get>
+static void put_integers(const std::vector<Item> &items, Encoder &encoder, Get get) {
+    std::vector<int64_t> values(items.size());
+    for(int i = 0; i < items.size(); i++)
+        values[i] = get(items[i]);
+    encoder.put_column(values);
+}
+
+
+template<class Item, class Set>
+static void get_integers(Decoder &decoder, std::vector<Item> &items, Set set) {
+    std::vector<int64_t> values;
+    decoder.get_column(items.size(), values);
+    for(int i = 0; i < items.size(); i++)
+        set(items[i], values[i]);
+}
+
+
+static void put_headers(const std::vector<const std_msgs::Header *> &headers, Encoder &encoder) {
+    std::vector<int64_t> seqs(headers.size()), stamps(headers.size());
+    std::vector<std::string> frames(headers.size());
+    for(int i = 0; i < headers.size(); i++) {
+        seqs[i] = headers[i]->seq;
+        stamps[i] = headers[i]->stamp.toNSec();
+        frames[i] = headers[i]->frame_id;
+    }
+    encoder.put_column(seqs);
+    encoder.put_column(stamps);
+    encoder.put_strings(frames);
+}
+
+
+static void get_headers(Decoder &decoder, const std::vector<std_msgs::Header *> &headers) {
+    std::vector<int64_t> seqs, stamps;
+    std::vector<std::string> frames;
+    decoder.get_column(headers.size(), seqs);
+    decoder.get_column(headers.size(), stamps);
+    decoder.get_strings(headers.size(), frames);
+    if(!decoder.ok())
+        return;
+    for(int i = 0; i < headers.size(); i++) {
+        headers[i]->seq = seqs[i];
+        headers[i]->stamp.fromNSec(stamps[i]);
+        headers[i]->frame_id = frames[i];
+    }
+}
+
+
+template<class Msg>
+static std::vector<const std_msgs::Header *> headers_of(const std::vector<Msg> &msgs) {
+    std::vector<const std_msgs::Header *> headers(msgs.size());
+    for(int i = 0; i < msgs.size(); i++)
+        headers[i] = &msgs[i].header;
+    return headers;
+}
+
+
+template<class Msg>
+static std::vector<std_msgs::Header *> headers_of(std::vector<Msg> &msgs) {
+    std::vector<std_msgs::Header *> headers(msgs.size());
+    for(int i = 0; i < msgs.size(); i++)
+        headers[i] = &msgs[i].header;
+    return headers;
+}
+
+
+// Number of items of each message, false if they cannot all be in the rest of the chunk
+static bool get_counts(Decoder &decoder, size_t count, std::vector<int64_t> &counts, size_t &total) {
+    total = 0;
+    if(!decoder.get_column(count, counts))
+        return false;
+    for(int i = 0; i < counts.size(); i++) {
+        if(counts[i] < 0 || counts[i] > decoder.remaining())
+            return false;
+        total += counts[i];
+    }
+    return total <= decoder.remaining();
+}
+
+
+void encode_messages(const std::vector<walker_msgs::Trk3DArray> &msgs, Encoder &encoder) {
+    typedef walker_msgs::Trk3D T;
+    put_headers(headers_of(msgs), encoder);
+    std::vector<int64_t> counts(msgs.size());
+    std::vector<T> trks;
+    for(int i = 0; i < msgs.size(); i++) {
+        counts[i] = msgs[i].trks_list.size();
+        trks.insert(trks.end(), msgs[i].trks_list.begin(), msgs[i].trks_list.end());
+    }
+    encoder.put_column(counts);
+    put_integers(trks, encoder, [](const T &t) { return t.id; });
+    put_integers(trks, encoder, [](const T &t) { return t.class_id; });
+    put_values(trks, kPositionResolution, encoder, [](const T &t) { return t.x; });
+    put_values(trks, kPositionResolution, encoder, [](const T &t) { return t.y; });
+    put_values(trks, kVelocityResolution, encoder, [](const T &t) { return t.vx; });
+    put_values(trks, kVelocityResolution, encoder, [](const T &t) { return t.vy; });
+    put_values(trks, kAngleResolution, encoder, [](const T &t) { return t.yaw; });
+    put_values(trks, kPositionResolution, encoder, [](const T &t) { return t.radius; });
+    put_values(trks, kRatioResolution, encoder, [](const T &t) { return t.confidence; });
+    put_values(trks, kRatioResolution, encoder, [](const T &t) { return t.dangerous; });
+    put_values(trks, kPositionResolution, encoder, [](const T &t) { return t.x_based; });
+    put_values(trks, kPositionResolution, encoder, [](const T &t) { return t.y_based; });
+    put_values(trks, kPositionResolution, encoder, [](const T &t) { return t.z_based; });
+    for(int k = 0; k < 3; k++)
+        put_values(trks, kRatioResolution, encoder, [k](const T &t) { return t.mode_probabilities[k]; });
+}
+
+
+bool decode_messages(Decoder &decoder, size_t count, std::vector<walker_msgs::Trk3DArray> &msgs) {
+    typedef walker_msgs::Trk3D T;
+    msgs.assign(count, walker_msgs::Trk3DArray());
+    get_headers(decoder, headers_of(msgs));
+    std::vector<int64_t> counts;
+    size_t total;
+    if(!get_counts(decoder, count, counts, total))
+        return false;
+    std::vector<T> trks(total);
+    get_integers(decoder, trks, [](T &t, int64_t v) { t.id = v; });
+    get_integers(decoder, trks, [](T &t, int64_t v) { t.class_id = v; });
+    get_values(decoder, trks, kPositionResolution, [](T &t, double v) { t.x = v; });
+    get_values(decoder, trks, kPositionResolution, [](T &t, double v) { t.y = v; });
+    get_values(decoder, trks, kVelocityResolution, [](T &t, double v) { t.vx = v; });
+    get_values(decoder, trks, kVelocityResolution, [](T &t, double v) { t.vy = v; });
+    get_values(decoder, trks, kAngleResolution, [](T &t, double v) { t.yaw = v; });
+    get_values(decoder, trks, kPositionResolution, [](T &t, double v) { t.radius = v; });
+    get_values(decoder, trks, kRatioResolution, [](T &t, double v) { t.confidence = v; });
+    get_values(decoder, trks, kRatioResolution, [](T &t, double v) { t.dangerous = v; });
+    get_values(decoder, trks, kPositionResolution, [](T &t, double v) { t.x_based = v; });
+    get_values(decoder, trks, kPositionResolution, [](T &t, double v) { t.y_based = v; });
+    get_values(decoder, trks, kPositionResolution, [](T &t, double v) { t.z_based = v; });
+    for(int k = 0; k < 3; k++)
+        get_values(decoder, trks, kRatioResolution, [k](T &t, double v) { t.mode_probabilities[k] = v; });
+    if(!decoder.ok())
+        return false;
+    for(int i = 0, j = 0; i < count; j += counts[i], i++)
+        msgs[i].trks_list.assign(trks.begin() + j, trks.begin() + j + counts[i]);
+    return true;
+}
+
+
+void encode_messages(const std::vector<nav_msgs::OccupancyGrid> &msgs, Encoder &encoder) {
+    typedef nav_msgs::OccupancyGrid M;
+    put_headers(headers_of(msgs), encoder);
+    put_integers(msgs, encoder, [](const M &m) { return (int64_t)m.info.map_load_time.toNSec(); });
+    put_integers(msgs, encoder, [](const M &m) { return m.info.width; });
+    put_integers(msgs, encoder, [](const M &m) { return m.info.height; });
+    for(int i = 0; i < msgs.size(); i++)
+        encoder.put_float(msgs[i].info.resolution);
+    put_values(msgs, kPositionResolution, encoder, [](const M &m) { return m.info.origin.position.x; });
+    put_values(msgs, kPositionResolution, encoder, [](const M &m) { return m.info.origin.position.y; });
+    put_values(msgs, kPositionResolution, encoder, [](const M &m) { return m.info.origin.position.z; });
+    put_values(msgs, kQuaternionResolution, encoder, [](const M &m) { return m.info.origin.orientation.x; });
+    put_values(msgs, kQuaternionResolution, encoder, [](const M &m) { return m.info.origin.orientation.y; });
+    put_values(msgs, kQuaternionResolution, encoder, [](const M &m) { return m.info.origin.orientation.z; });
+    put_values(msgs, kQuaternionResolution, encoder, [](const M &m) { return m.info.origin.orientation.w; });
+
+    // Consecutive local maps mostly differ in a few cells, their difference is long runs of 0
+    for(int i = 0; i < msgs.size(); i++) {
+        const std::vector<int8_t> &data = msgs[i].data;
+        const bool delta = i > 0 && msgs[i - 1].data.size() == data.size();
+        encoder.put_varint(data.size());
+        encoder.put_byte(delta);
+        if(!delta) {
+            encoder.put_runs(data);
+            continue;
+        }
+        std::vector<int8_t> difference(data.size());
+        for(int j = 0; j < data.size(); j++)
+            difference[j] = (int8_t)(uint8_t)(data[j] - msgs[i - 1].data[j]);
+        encoder.put_runs(difference);
+    }
+}
+
+
+bool decode_messages(Decoder &decoder, size_t count, std::vector<nav_msgs::OccupancyGrid> &msgs) {
+    typedef nav_msgs::OccupancyGrid M;
+    msgs.assign(count, M());
+    get_headers(decoder, headers_of(msgs));
+    get_integers(decoder, msgs, [](M &m, int64_t v) { m.info.map_load_time.fromNSec(v); });
+    get_integers(decoder, msgs, [](M &m, int64_t v) { m.info.width = v; });
+    get_integers(decoder, msgs, [](M &m, int64_t v) { m.info.height = v; });
+    for(int i = 0; i < count; i++)
+        msgs[i].info.resolution = decoder.get_float();
+    get_values(decoder, msgs, kPositionResolution, [](M &m, double v) { m.info.origin.position.x = v; });
+    get_values(decoder, msgs, kPositionResolution, [](M &m, double v) { m.info.origin.position.y = v; });
+    get_values(decoder, msgs, kPositionResolution, [](M &m, double v) { m.info.origin.position.z = v; });
+    get_values(decoder, msgs, kQuaternionResolution, [](M &m, double v) { m.info.origin.orientation.x = v; });
+    get_values(decoder, msgs, kQuaternionResolution, [](M &m, double v) { m.info.origin.orientation.y = v; });
+    get_values(decoder, msgs, kQuaternionResolution, [](M &m, double v) { m.info.origin.orientation.z = v; });
+    get_values(decoder, msgs, kQuaternionResolution, [](M &m, double v) { m.info.origin.orientation.w = v; });
+
+    for(int i = 0; i < count; i++) {
+        const uint64_t size = decoder.get_varint();
+        const bool delta = decoder.get_byte();
+        std::vector<int8_t> &data = msgs[i].data;
+        if(!decoder.ok() || size > kMaxCells || (delta && (i == 0 || msgs[i - 1].data.size() != size)) ||
+           !decoder.get_runs(size, data))
+            return false;
+        if(delta) {
+            for(int j = 0; j < data.size(); j++)
+                data[j] = (int8_t)(uint8_t)(data[j] + msgs[i - 1].data[j]);
+        }
+    }
+    return decoder.ok();
+}
+
+
+void encode_messages(const std::vector<nav_msgs::Path> &msgs, Encoder &encoder) {
+    typedef geometry_msgs::PoseStamped P;
+    put_headers(headers_of(msgs), encoder);
+    std::vector<int64_t> counts(msgs.size());
+    std::vector<P> poses;
+    for(int i = 0; i < msgs.size(); i++) {
+        counts[i] = msgs[i].poses.size();
+        poses.insert(poses.end(), msgs[i].poses.begin(), msgs[i].poses.end());
+    }
+    encoder.put_column(counts);
+    put_values(poses, kPositionResolution, encoder, [](const P &p) { return p.pose.position.x; });
+    put_values(poses, kPositionResolution, encoder, [](const P &p) { return p.pose.position.y; });
+    put_values(poses, kPositionResolution, encoder, [](const P &p) { return p.pose.position.z; });
+    put_values(poses, kQuaternionResolution, encoder, [](const P &p) { return p.pose.orientation.x; });
+    put_values(poses, kQuaternionResolution, encoder, [](const P &p) { return p.pose.orientation.y; });
+    put_values(poses, kQuaternionResolution, encoder, [](const P &p) { return p.pose.orientation.z; });
+    put_values(poses, kQuaternionResolution, encoder, [](const P &p) { return p.pose.orientation.w; });
+}
+
+
+bool decode_messages(Decoder &decoder, size_t count, std::vector<nav_msgs::Path> &msgs) {
+    typedef geometry_msgs::PoseStamped P;
+    msgs.assign(count, nav_msgs::Path());
+    get_headers(decoder, headers_of(msgs));
+    std::vector<int64_t> counts;
+    size_t total;
+    if(!get_counts(decoder, count, counts, total))
+        return false;
+    std::vector<P> poses(total);
+    get_values(decoder, poses, kPositionResolution, [](P &p, double v) { p.pose.position.x = v; });
+    get_values(decoder, poses, kPositionResolution, [](P &p, double v) { p.pose.position.y = v; });
+    get_values(decoder, poses, kPositionResolution, [](P &p, double v) { p.pose.position.z = v; });
+    get_values(decoder, poses, kQuaternionResolution, [](P &p, double v) { p.pose.orientation.x = v; });
+    get_values(decoder, poses, kQuaternionResolution, [](P &p, double v) { p.pose.orientation.y = v; });
+    get_values(decoder, poses, kQuaternionResolution, [](P &p, double v) { p.pose.orientation.z = v; });
+    get_values(decoder, poses, kQuaternionResolution, [](P &p, double v) { p.pose.orientation.w = v; });
+    if(!decoder.ok())
+        return false;
+    for(int i = 0, j = 0; i < count; j += counts[i], i++) {
+        msgs[i].poses.assign(poses.begin() + j, poses.begin() + j + counts[i]);
+        for(int k = 0; k < msgs[i].poses.size(); k++)
+            msgs[i].poses[k].header = msgs[i].header;
+    }
+    return true;
+}
+
+
+void encode_messages(const std::vector<geometry_msgs::Twist> &msgs, Encoder &encoder) {
+    typedef geometry_msgs::Twist M;
+    put_values(msgs, kVelocityResolution, encoder, [](const M &m) { return m.linear.x; });
+    put_values(msgs, kVelocityResolution, encoder, [](const M &m) { return m.linear.y; });
+    put_values(msgs, kVelocityResolution, encoder, [](const M &m) { return m.linear.z; });
+    put_values(msgs, kAngleResolution, encoder, [](const M &m) { return m.angular.x; });
+    put_values(msgs, kAngleResolution, encoder, [](const M &m) { return m.angular.y; });
+    put_values(msgs, kAngleResolution, encoder, [](const M &m) { return m.angular.z; });
+}
+
+
+bool decode_messages(Decoder &decoder, size_t count, std::vector<geometry_msgs::Twist> &msgs) {
+    typedef geometry_msgs::Twist M;
+    msgs.assign(count, M());
+    get_values(decoder, msgs, kVelocityResolution, [](M &m, double v) { m.linear.x = v; });
+    get_values(decoder, msgs, kVelocityResolution, [](M &m, double v) { m.linear.y = v; });
+    get_values(decoder, msgs, kVelocityResolution, [](M &m, double v) { m.linear.z = v; });
+    get_values(decoder, msgs, kAngleResolution, [](M &m, double v) { m.angular.x = v; });
+    get_values(decoder, msgs, kAngleResolution, [](M &m, double v) { m.angular.y = v; });
+    get_values(decoder, msgs, kAngleResolution, [](M &m, double v) { m.angular.z = v; });
+    return decoder.ok();
+}
+
+
+void encode_messages(const std::vector<geometry_msgs::WrenchStamped> &msgs, Encoder &encoder) {
+    typedef geometry_msgs::WrenchStamped M;
+    put_headers(headers_of(msgs), encoder);
+    put_values(msgs, kForceResolution, encoder, [](const M &m) { return m.wrench.force.x; });
+    put_values(msgs, kForceResolution, encoder, [](const M &m) { return m.wrench.force.y; });
+    put_values(msgs, kForceResolution, encoder, [](const M &m) { return m.wrench.force.z; });
+    put_values(msgs, kForceResolution, encoder, [](const M &m) { return m.wrench.torque.x; });
+    put_values(msgs, kForceResolution, encoder, [](const M &m) { return m.wrench.torque.y; });
+    put_values(msgs, kForceResolution, encoder, [](const M &m) { return m.wrench.torque.z; });
+}
+
+
+bool decode_messages(Decoder &decoder, size_t count, std::vector<geometry_msgs::WrenchStamped> &msgs) {
+    typedef geometry_msgs::WrenchStamped M;
+    msgs.assign(count, M());
+    get_headers(decoder, headers_of(msgs));
+    get_values(decoder, msgs, kForceResolution, [](M &m, double v) { m.wrench.force.x = v; });
+    get_values(decoder, msgs, kForceResolution, [](M &m, double v) { m.wrench.force.y = v; });
+    get_values(decoder, msgs, kForceResolution, [](M &m, double v) { m.wrench.force.z = v; });
+    get_values(decoder, msgs, kForceResolution, [](M &m, double v) { m.wrench.torque.x = v; });
+    get_values(decoder, msgs, kForceResolution, [](M &m, double v) { m.wrench.torque.y = v; });
+    get_values(decoder, msgs, kForceResolution, [](M &m, double v) { m.wrench.torque.z = v; });
+    return decoder.ok();
+}
+
+
+void encode_messages(const std::vector<std_msgs::Float32> &msgs, Encoder &encoder) {
+    for(int i = 0; i < msgs.size(); i++)
+        encoder.put_float(msgs[i].data);
+}
+
+
+bool decode_messages(Decoder &decoder, size_t count, std::vector<std_msgs::Float32> &msgs) {
+    msgs.assign(count, std_msgs::Float32());
+    for(int i = 0; i < count; i++)
+        msgs[i].data = decoder.get_float();
+    return decoder.ok();
+}
+
+}
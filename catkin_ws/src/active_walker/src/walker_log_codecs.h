@@ -0,0 +1,177 @@
+#ifndef WALKER_LOG_CODECS_H
+#define WALKER_LOG_CODECS_H
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <geometry_msgs/Twist.h>
+#include <geometry_msgs/WrenchStamped.h>
+#include <nav_msgs/OccupancyGrid.h>
+#include <nav_msgs/Path.h>
+#include <std_msgs/Float32.h>
+#include <walker_msgs/Trk3DArray.h>
+
+#include "walker_log.h"
+
+
+// Columnar codecs of the walker topics for the walker log (walker_log.h). The fields are
+// quantized to the resolutions below; what is not logged reads back empty:
+//   walker_msgs/Trk3DArray       the tracks only, not the embedded scan and point cloud
+//   nav_msgs/OccupancyGrid       cells as runs of the difference to the previous map of the chunk
+//   nav_msgs/Path                the poses take the header of the path
+//   geometry_msgs/Twist          stamped with the reception time
+//   geometry_msgs/WrenchStamped
+//   std_msgs/Float32             exact
+namespace walker_log {
+
+enum MessageType {
+    kTracks = 1,
+    kOccupancyGrid = 2,
+    kPath = 3,
+    kTwist = 4,
+    kWrench = 5,
+    kFloat32 = 6,
+};
+
+const double kPositionResolution = 0.001;       // m
+const double kVelocityResolution = 0.001;       // m/s
+const double kAngleResolution = 0.0001;         // rad, and rad/s
+const double kQuaternionResolution = 0.00001;
+const double kForceResolution = 0.001;          // N, and Nm
+const double kRatioResolution = 0.001;          // confidences and probabilities
+
+
+// Message type and version of its columns, bumped on any change of the columns
+template<class Msg> struct MessageTraits;
+template<> struct MessageTraits<walker_msgs::Trk3DArray> { enum { type = kTracks, codec_version = 1 }; };
+template<> struct MessageTraits<nav_msgs::OccupancyGrid> { enum { type = kOccupancyGrid, codec_version = 1 }; };
+template<> struct MessageTraits<nav_msgs::Path> { enum { type = kPath, codec_version = 1 }; };
+template<> struct MessageTraits<geometry_msgs::Twist> { enum { type = kTwist, codec_version = 1 }; };
+template<> struct MessageTraits<geometry_msgs::WrenchStamped> { enum { type = kWrench, codec_version = 1 }; };
+template<> struct MessageTraits<std_msgs::Float32> { enum { type = kFloat32, codec_version = 1 }; };
+
+const char *message_type_name(uint16_t type);     // ROS data type, "" if unknown
+
+
+// Columns of the messages of a chunk
+void encode_messages(const std::vector<walker_msgs::Trk3DArray> &msgs, Encoder &encoder);
+void encode_messages(const std::vector<nav_msgs::OccupancyGrid> &msgs, Encoder &encoder);
+void encode_messages(const std::vector<nav_msgs::Path> &msgs, Encoder &encoder);
+void encode_messages(const std::vector<geometry_msgs::Twist> &msgs, Encoder &encoder);
+void encode_messages(const std::vector<geometry_msgs::WrenchStamped> &msgs, Encoder &encoder);
+void encode_messages(const std::vector<std_msgs::Float32> &msgs, Encoder &encoder);
+
+bool decode_messages(Decoder &decoder, size_t count, std::vector<walker_msgs::Trk3DArray> &msgs);
+bool decode_messages(Decoder &decoder, size_t count, std::vector<nav_msgs::OccupancyGrid> &msgs);
+bool decode_messages(Decoder &decoder, size_t count, std::vector<nav_msgs::Path> &msgs);
+bool decode_messages(Decoder &decoder, size_t count, std::vector<geometry_msgs::Twist> &msgs);
+bool decode_messages(Decoder &decoder, size_t count, std::vector<geometry_msgs::WrenchStamped> &msgs);
+bool decode_messages(Decoder &decoder, size_t count, std::vector<std_msgs::Float32> &msgs);
+
+
+// A chunk is the column of the log stamps (ns) followed by the columns of the messages
+template<class Msg>
+std::string encode_chunk(const std::vector<int64_t> &stamps, const std::vector<Msg> &msgs) {
+    Encoder encoder;
+    encoder.put_column(stamps);
+    encode_messages(msgs, encoder);
+    return encoder.data();
+}
+
+
+template<class Msg>
+bool decode_chunk(const std::string &columns, size_t count, std::vector<int64_t> &stamps, std::vector<Msg> &msgs) {
+    // Every message takes at least a byte of the stamp column
+    if(count > columns.size())
+        return false;
+    Decoder decoder(columns);
+    decoder.get_column(count, stamps);
+    return decode_messages(decoder, count, msgs) && decoder.ok() && decoder.at_end();
+}
+
+
+// Messages of the topic logged between start_time and end_time (ns), in log order. False if the
+// topic has another message type or codec version, or a chunk is corrupted.
+template<class Msg>
+bool read_messages(Reader &reader, int topic, int64_t start_time, int64_t end_time,
+                   std::vector<int64_t> &stamps, std::vector<Msg> &msgs) {
+    stamps.clear();
+    msgs.clear();
+    if(topic < 0 || topic >= reader.topics().size() ||
+       reader.topics()[topic].type != MessageTraits<Msg>::type ||
+       reader.topics()[topic].codec_version != MessageTraits<Msg>::codec_version)
+        return false;
+    const std::vector<int> chunks = reader.find_chunks(start_time, end_time, topic);
+    for(int i = 0; i < chunks.size(); i++) {
+        std::string columns;
+        std::vector<int64_t> chunk_stamps;
+        std::vector<Msg> chunk_msgs;
+        if(!reader.read_chunk(chunks[i], columns) ||
+           !decode_chunk(columns, reader.chunks()[chunks[i]].num_messages, chunk_stamps, chunk_msgs))
+            return false;
+        for(int j = 0; j < chunk_stamps.size(); j++) {
+            if(chunk_stamps[j] >= start_time && chunk_stamps[j] <= end_time) {
+                stamps.push_back(chunk_stamps[j]);
+                msgs.push_back(chunk_msgs[j]);
+            }
+        }
+    }
+    return true;
+}
+
+
+// Buffers the messages of one topic and writes them as a chunk every max_messages or every
+// max_duration (ns)
+class TopicRecorderBase {
+public:
+    virtual ~TopicRecorderBase() {}
+    virtual void flush() = 0;
+    virtual bool empty() const = 0;
+    virtual int64_t first_stamp() const = 0;
+};
+
+
+template<class Msg>
+class TopicRecorder: public TopicRecorderBase {
+public:
+    TopicRecorder(Writer &writer, const std::string &name, int max_messages, int64_t max_duration):
+        writer_(writer), max_messages_(max_messages), max_duration_(max_duration) {
+        topic_ = writer_.add_topic(name, MessageTraits<Msg>::type, MessageTraits<Msg>::codec_version);
+    }
+
+    void add(int64_t stamp, const Msg &msg) {
+        if(!stamps_.empty() && stamp - stamps_.front() >= max_duration_)
+            flush();
+        stamps_.push_back(stamp);
+        msgs_.push_back(msg);
+        if(stamps_.size() >= max_messages_)
+            flush();
+    }
+
+    void flush() {
+        if(stamps_.empty())
+            return;
+        writer_.write_chunk(topic_, *std::min_element(stamps_.begin(), stamps_.end()),
+                            *std::max_element(stamps_.begin(), stamps_.end()), stamps_.size(),
+                            encode_chunk(stamps_, msgs_));
+        stamps_.clear();
+        msgs_.clear();
+    }
+
+    bool empty() const { return stamps_.empty(); }
+    int64_t first_stamp() const { return stamps_.empty() ? 0 : stamps_.front(); }
+    int topic() const { return topic_; }
+
+private:
+    Writer &writer_;
+    int topic_;
+    int max_messages_;
+    int64_t max_duration_;
+    std::vector<int64_t> stamps_;
+    std::vector<Msg> msgs_;
+};
+
+}
+
+#endif
@@ -0,0 +1,166 @@
+// Summary and rosbag export of a walker log (walker_log.h), no ROS master needed.
+//   rosrun active_walker walker_log_export [options] session.wlog [out.bag]
+//     --start SEC      only the messages from that many seconds after the start of the log
+//     --duration SEC   and for that long
+//     --topics A,B     only these topics
+// Without out.bag, prints the topics with their message count, rate and bytes per message.
+// The bag has the messages at their log stamps, with the fields the codecs keep.
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <rosbag/bag.h>
+
+#include "walker_log_codecs.h"
+
+struct Options {
+    double start = 0.0;
+    double duration = -1.0;
+    std::set<std::string> topics;
+    std::string log_file, bag_file;
+};
+
+
+static bool parse_options(int argc, char **argv, Options &options) {
+    std::vector<std::string> files;
+    for(int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if(arg.compare(0, 2, "--") != 0) {
+            files.push_back(arg);
+            continue;
+        }
+        if(i + 1 >= argc) {
+            std::fprintf(stderr, "Missing value of %s\n", arg.c_str());
+            return false;
+        }
+        const std::string value = argv[++i];
+        if(arg == "--start") options.start = std::atof(value.c_str());
+        else if(arg == "--duration") options.duration = std::atof(value.c_str());
+        else if(arg == "--topics") {
+            std::istringstream names(value);
+            std::string name;
+            while(std::getline(names, name, ','))
+                options.topics.insert(name);
+        }
+        else {
+            std::fprintf(stderr, "Unknown option %s\n", arg.c_str());
+            return false;
+        }
+    }
+    if(files.empty() || files.size() > 2)
+        return false;
+    options.log_file = files[0];
+    if(files.size() > 1)
+        options.bag_file = files[1];
+    return true;
+}
+
+
+template<class Msg>
+static bool export_topic(walker_log::Reader &reader, const walker_log::Topic &topic, int64_t start_time,
+                         int64_t end_time, rosbag::Bag &bag, int &num_messages) {
+    std::vector<int64_t> stamps;
+    std::vector<Msg> msgs;
+    if(!walker_log::read_messages(reader, topic.id, start_time, end_time, stamps, msgs))
+        return false;
+    for(int i = 0; i < msgs.size(); i++) {
+        ros::Time stamp;
+        stamp.fromNSec(stamps[i]);
+        bag.write(topic.name, stamp, msgs[i]);
+    }
+    num_messages += msgs.size();
+    return true;
+}
+
+
+int main(int argc, char **argv) {
+    Options options;
+    if(!parse_options(argc, argv, options)) {
+        std::fprintf(stderr, "Usage: walker_log_export [--start SEC] [--duration SEC] [--topics A,B] session.wlog [out.bag]\n");
+        return 1;
+    }
+    walker_log::Reader reader;
+    if(!reader.open(options.log_file)) {
+        std::fprintf(stderr, "%s is not a walker log of version %d or older\n", options.log_file.c_str(),
+                     walker_log::kFormatVersion);
+        return 1;
+    }
+    if(!reader.indexed())
+        std::fprintf(stderr, "%s was not closed, recovered %d chunks\n", options.log_file.c_str(),
+                     (int)reader.chunks().size());
+
+    int64_t log_start = std::numeric_limits<int64_t>::max(), log_end = std::numeric_limits<int64_t>::min();
+    for(int i = 0; i < reader.chunks().size(); i++) {
+        log_start = std::min(log_start, reader.chunks()[i].start_time);
+        log_end = std::max(log_end, reader.chunks()[i].end_time);
+    }
+    const int64_t start_time = reader.chunks().empty() ? 0 : log_start + (int64_t)(options.start * 1e9);
+    const int64_t end_time = options.duration < 0.0 ? std::numeric_limits<int64_t>::max() :
+                                                      start_time + (int64_t)(options.duration * 1e9);
+
+    std::vector<walker_log::Topic> topics;
+    for(int i = 0; i < reader.topics().size(); i++) {
+        if(options.topics.empty() || options.topics.count(reader.topics()[i].name))
+            topics.push_back(reader.topics()[i]);
+    }
+
+    if(options.bag_file.empty()) {
+        std::printf("%s: format version %d, %.1f s\n", options.log_file.c_str(), reader.version(),
+                    reader.chunks().empty() ? 0.0 : (log_end - log_start) * 1e-9);
+        std::printf("%-32s %-28s %9s %8s %8s %10s\n", "topic", "type", "messages", "chunks", "Hz", "bytes/msg");
+        for(int t = 0; t < topics.size(); t++) {
+            const std::vector<int> chunks = reader.find_chunks(start_time, end_time, topics[t].id);
+            long num_messages = 0, num_bytes = 0;
+            int64_t first = 0, last = 0;
+            for(int i = 0; i < chunks.size(); i++) {
+                const walker_log::ChunkInfo &chunk = reader.chunks()[chunks[i]];
+                first = i == 0 ? chunk.start_time : std::min(first, chunk.start_time);
+                last = i == 0 ? chunk.end_time : std::max(last, chunk.end_time);
+                num_messages += chunk.num_messages;
+                num_bytes += chunk.size;
+            }
+            std::printf("%-32s %-28s %9ld %8d %8.1f %10.1f\n", topics[t].name.c_str(),
+                        walker_log::message_type_name(topics[t].type), num_messages, (int)chunks.size(),
+                        last > first ? (num_messages - 1) / ((last - first) * 1e-9) : 0.0,
+                        num_messages > 0 ? (double)num_bytes / num_messages : 0.0);
+        }
+        return 0;
+    }
+
+    rosbag::Bag bag;
+    bag.open(options.bag_file, rosbag::bagmode::Write);
+    int num_messages = 0;
+    for(int t = 0; t < topics.size(); t++) {
+        bool ok = false;
+        switch(topics[t].type) {
+            case walker_log::kTracks:
+                ok = export_topic<walker_msgs::Trk3DArray>(reader, topics[t], start_time, end_time, bag, num_messages);
+                break;
+            case walker_log::kOccupancyGrid:
+                ok = export_topic<nav_msgs::OccupancyGrid>(reader, topics[t], start_time, end_time, bag, num_messages);
+                break;
+            case walker_log::kPath:
+                ok = export_topic<nav_msgs::Path>(reader, topics[t], start_time, end_time, bag, num_messages);
+                break;
+            case walker_log::kTwist:
+                ok = export_topic<geometry_msgs::Twist>(reader, topics[t], start_time, end_time, bag, num_messages);
+                break;
+            case walker_log::kWrench:
+                ok = export_topic<geometry_msgs::WrenchStamped>(reader, topics[t], start_time, end_time, bag, num_messages);
+                break;
+            case walker_log::kFloat32:
+                ok = export_topic<std_msgs::Float32>(reader, topics[t], start_time, end_time, bag, num_messages);
+                break;
+        }
+        if(!ok)
+            std::fprintf(stderr, "Skip %s: type %d version %d not readable or corrupted\n", topics[t].name.c_str(),
+                         topics[t].type, topics[t].codec_version);
+    }
+    bag.close();
+    std::printf("Wrote %d messages of %d topics to %s\n", num_messages, (int)topics.size(), options.bag_file.c_str());
+    return 0;
+}
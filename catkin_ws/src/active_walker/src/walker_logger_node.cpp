@@ -0,0 +1,124 @@
+// Records the walker topics into a compact walker log (walker_log.h), a fraction of the size of
+// a bag: the tracks without their embedded scan, the local maps as differences, quantized
+// plans, commands and forces. Read it back with walker_log_export.
+//   ~file                  log file (walker_YYYY-MM-DD-HH-MM-SS.wlog in the working directory)
+//   ~chunk_messages        messages per chunk (256)
+//   ~chunk_duration        seconds per chunk at most (5.0)
+//   ~tracks_topics         walker_msgs/Trk3DArray      ([trk3d_result])
+//   ~map_topics            nav_msgs/OccupancyGrid      ([local_map])
+//   ~path_topics           nav_msgs/Path               ([walkable_path, smooth_path])
+//   ~twist_topics          geometry_msgs/Twist         ([cmd_vel])
+//   ~wrench_topics         geometry_msgs/WrenchStamped ([force, force_filtered])
+//   ~float32_topics        std_msgs/Float32            ([inhibition_force, system_torque])
+// The messages are stamped with their reception time, as in a bag.
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+#include <ros/ros.h>
+
+#include "walker_log_codecs.h"
+
+
+class WalkerLoggerNode {
+public:
+    WalkerLoggerNode(ros::NodeHandle nh, ros::NodeHandle pnh);
+    ~WalkerLoggerNode() { close(); }
+    void close();
+
+private:
+    template<class Msg>
+    void record(const std::string &param, const std::vector<std::string> &default_topics);
+    template<class Msg>
+    void msg_cb(const boost::shared_ptr<const Msg> &msg_ptr, walker_log::TopicRecorder<Msg> *recorder);
+    void timer_cb(const ros::TimerEvent &event);
+
+    ros::NodeHandle nh_, pnh_;
+    ros::Timer timer_;
+    std::vector<ros::Subscriber> subs_;
+    std::vector<boost::shared_ptr<walker_log::TopicRecorderBase> > recorders_;
+    walker_log::Writer writer_;
+    int chunk_messages_;
+    double chunk_duration_;
+};
+
+
+WalkerLoggerNode::WalkerLoggerNode(ros::NodeHandle nh, ros::NodeHandle pnh): nh_(nh), pnh_(pnh) {
+    // ROS parameters
+    char default_file[64];
+    const std::time_t now = std::time(NULL);
+    std::strftime(default_file, sizeof(default_file), "walker_%Y-%m-%d-%H-%M-%S.wlog", std::localtime(&now));
+    std::string file_name;
+    pnh_.param<std::string>("file", file_name, default_file);
+    pnh_.param<int>("chunk_messages", chunk_messages_, 256);
+    pnh_.param<double>("chunk_duration", chunk_duration_, 5.0);
+
+    if(!writer_.open(file_name)) {
+        ROS_ERROR("Cannot open %s. Aborting...", file_name.c_str());
+        exit(-1);
+    }
+
+    // ROS subscribers
+    record<walker_msgs::Trk3DArray>("tracks_topics", {"trk3d_result"});
+    record<nav_msgs::OccupancyGrid>("map_topics", {"local_map"});
+    record<nav_msgs::Path>("path_topics", {"walkable_path", "smooth_path"});
+    record<geometry_msgs::Twist>("twist_topics", {"cmd_vel"});
+    record<geometry_msgs::WrenchStamped>("wrench_topics", {"force", "force_filtered"});
+    record<std_msgs::Float32>("float32_topics", {"inhibition_force", "system_torque"});
+
+    // Topics that stopped publishing still get their chunk written
+    timer_ = nh_.createTimer(ros::Duration(1.0), &WalkerLoggerNode::timer_cb, this);
+
+    ROS_INFO("Logging %d topics to %s", (int)subs_.size(), file_name.c_str());
+    ROS_INFO_STREAM(ros::this_node::getName() + " is ready.");
+}
+
+
+template<class Msg>
+void WalkerLoggerNode::record(const std::string &param, const std::vector<std::string> &default_topics) {
+    std::vector<std::string> topics;
+    pnh_.param<std::vector<std::string> >(param, topics, default_topics);
+    for(int i = 0; i < topics.size(); i++) {
+        walker_log::TopicRecorder<Msg> *recorder = new walker_log::TopicRecorder<Msg>(
+            writer_, nh_.resolveName(topics[i]), chunk_messages_, (int64_t)(chunk_duration_ * 1e9));
+        recorders_.push_back(boost::shared_ptr<walker_log::TopicRecorderBase>(recorder));
+        subs_.push_back(nh_.subscribe<Msg>(topics[i], 10, boost::bind(&WalkerLoggerNode::msg_cb<Msg>, this, _1, recorder)));
+    }
+}
+
+
+template<class Msg>
+void WalkerLoggerNode::msg_cb(const boost::shared_ptr<const Msg> &msg_ptr, walker_log::TopicRecorder<Msg> *recorder) {
+    recorder->add(ros::Time::now().toNSec(), *msg_ptr);
+}
+
+
+void WalkerLoggerNode::timer_cb(const ros::TimerEvent &event) {
+    const int64_t now = ros::Time::now().toNSec();
+    for(int i = 0; i < recorders_.size(); i++) {
+        if(!recorders_[i]->empty() && now - recorders_[i]->first_stamp() >= 2 * chunk_duration_ * 1e9)
+            recorders_[i]->flush();
+    }
+}
+
+
+void WalkerLoggerNode::close() {
+    if(!writer_.is_open())
+        return;
+    for(int i = 0; i < recorders_.size(); i++)
+        recorders_[i]->flush();
+    ROS_INFO("Closing the walker log, %.1f MB", writer_.size() / 1e6);
+    writer_.close();
+}
+
+
+int main(int argc, char **argv) {
+    ros::init(argc, argv, "walker_logger_node");
+    ros::NodeHandle nh, pnh("~");
+    WalkerLoggerNode node(nh, pnh);
+    ros::spin();
+    node.close();
+    return 0;
+}
@@ -0,0 +1,145 @@
+#include "yolo_detector.h"
+
+#include <opencv2/imgproc/imgproc.hpp>
+
+
+// View the rows of one batch entry of a network output as a 2D matrix.
+// Darknet region outputs are (N * rows) x cols or N x rows x cols, ONNX outputs are N x rows x ... x cols.
+static cv::Mat batch_rows(const cv::Mat &out, int batch_size, int batch_index) {
+    int cols = out.size[out.dims - 1];
+    int rows = static_cast<int>(out.total() / cols / batch_size);
+    float *data = const_cast<float *>(out.ptr<float>()) + static_cast<size_t>(batch_index) * rows * cols;
+    return cv::Mat(rows, cols, CV_32F, data);
+}
+
+
+YoloDetector::YoloDetector(): conf_threshold_(0.5), nms_threshold_(0.2), num_classes_(80), person_class_id_(0),
+                              input_width_(416), input_height_(416) {
+}
+
+
+bool YoloDetector::load(const std::string &cfg, const std::string &weights, int input_width, int input_height) {
+    try {
+        if(weights.size() > 5 && weights.compare(weights.size() - 5, 5, ".onnx") == 0)
+            net_ = cv::dnn::readNetFromONNX(weights);
+        else
+            net_ = cv::dnn::readNetFromDarknet(cfg, weights);
+    }
+    catch(const cv::Exception &ex) {
+        net_ = cv::dnn::Net();
+        return false;
+    }
+    if(net_.empty())
+        return false;
+
+    net_.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
+    net_.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
+    out_names_ = net_.getUnconnectedOutLayersNames();
+
+    input_width_ = input_width;
+    input_height_ = input_height;
+    canvas_.create(input_height_, input_width_, CV_8UC3);
+    canvas_float_.create(input_height_, input_width_, CV_32FC3);
+    prepare_blob(1);
+    return true;
+}
+
+
+void YoloDetector::prepare_blob(int batch_size) {
+    if(!blob_.empty() && blob_.size[0] == batch_size)
+        return;
+    int blob_size[] = {batch_size, 3, input_height_, input_width_};
+    blob_.create(4, blob_size, CV_32F);
+    letterboxes_.resize(batch_size);
+}
+
+
+void YoloDetector::preprocess(const cv::Mat &image, int batch_index, Letterbox &letterbox) {
+    // Keep aspect ratio, pad the borders with gray like darknet does
+    letterbox.scale = std::min(static_cast<float>(input_width_) / image.cols,
+                               static_cast<float>(input_height_) / image.rows);
+    int resized_w = std::max(1, static_cast<int>(image.cols * letterbox.scale));
+    int resized_h = std::max(1, static_cast<int>(image.rows * letterbox.scale));
+    letterbox.pad_x = (input_width_ - resized_w) / 2;
+    letterbox.pad_y = (input_height_ - resized_h) / 2;
+
+    canvas_.setTo(cv::Scalar::all(127));
+    cv::Mat resized = canvas_(cv::Rect(letterbox.pad_x, letterbox.pad_y, resized_w, resized_h));
+    cv::resize(image, resized, resized.size(), 0, 0, cv::INTER_LINEAR);
+    canvas_.convertTo(canvas_float_, CV_32F, 1.0 / 255.0);
+
+    // HWC --> CHW directly into the blob memory
+    float *dst = blob_.ptr<float>(batch_index);
+    size_t plane = static_cast<size_t>(input_width_) * input_height_;
+    std::vector<cv::Mat> planes;
+    for(int c = 0; c < 3; c++)
+        planes.push_back(cv::Mat(input_height_, input_width_, CV_32F, dst + c * plane));
+    cv::split(canvas_float_, planes);
+}
+
+
+void YoloDetector::detect(const cv::Mat &image, std::vector<Detection> &result) {
+    std::vector< std::vector<Detection> > results;
+    detect(std::vector<cv::Mat>(1, image), results);
+    result.swap(results[0]);
+}
+
+
+void YoloDetector::detect(const std::vector<cv::Mat> &images, std::vector< std::vector<Detection> > &results) {
+    results.resize(images.size());
+    if(images.empty() || net_.empty())
+        return;
+
+    prepare_blob(images.size());
+    for(int i = 0; i < images.size(); i++)
+        preprocess(images[i], i, letterboxes_[i]);
+
+    net_.setInput(blob_);
+    net_.forward(outs_, out_names_);
+
+    for(int i = 0; i < images.size(); i++)
+        decode(letterboxes_[i], images[i].size(), i, results[i]);
+}
+
+
+void YoloDetector::decode(const Letterbox &letterbox, const cv::Size &image_size, int batch_index,
+                          std::vector<Detection> &result) {
+    nms_boxes_.clear();
+    nms_scores_.clear();
+    result.clear();
+    int batch_size = blob_.size[0];
+
+    // Collect person boxes only, normalized (cx, cy, w, h) of the network input
+    bool split_layout = outs_.size() == 2 && outs_[0].size[outs_[0].dims - 1] == 4;
+    int num_outputs = split_layout ? 1 : outs_.size();
+    for(int k = 0; k < num_outputs; k++) {
+        cv::Mat rows = batch_rows(outs_[k], batch_size, batch_index);
+        cv::Mat confs = split_layout ? batch_rows(outs_[1], batch_size, batch_index) : rows;
+        // Region layer: [cx, cy, w, h, objectness, class scores], ONNX export: [cx, cy, w, h] + [class scores]
+        int score_col = (split_layout ? 0 : (confs.cols == 4 + num_classes_ ? 4 : 5)) + person_class_id_;
+        for(int r = 0; r < rows.rows; r++) {
+            float score = confs.at<float>(r, score_col);
+            if(score < conf_threshold_)
+                continue;
+            const float *row = rows.ptr<float>(r);
+            float w = row[2] * input_width_;
+            float h = row[3] * input_height_;
+            float x = row[0] * input_width_ - w / 2 - letterbox.pad_x;
+            float y = row[1] * input_height_ - h / 2 - letterbox.pad_y;
+            nms_boxes_.push_back(cv::Rect(cvRound(x / letterbox.scale), cvRound(y / letterbox.scale),
+                                          cvRound(w / letterbox.scale), cvRound(h / letterbox.scale)));
+            nms_scores_.push_back(score);
+        }
+    }
+
+    cv::dnn::NMSBoxes(nms_boxes_, nms_scores_, conf_threshold_, nms_threshold_, nms_indices_);
+    cv::Rect2f image_rect(0, 0, image_size.width, image_size.height);
+    for(int i = 0; i < nms_indices_.size(); i++) {
+        Detection det;
+        det.box = cv::Rect2f(nms_boxes_[nms_indices_[i]]) & image_rect;
+        det.score = nms_scores_[nms_indices_[i]];
+        det.class_id = person_class_id_;
+        if(det.box.area() > 0)
+            result.push_back(det);
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef YOLO_DETECTOR_H
+#define YOLO_DETECTOR_H
+
+#include <string>
+#include <vector>
+
+// OpenCV
+#include <opencv2/core/core.hpp>
+#include <opencv2/dnn/dnn.hpp>
+
+
+// Person detector on OpenCV DNN, CPU backend only.
+// Loads either Darknet cfg/weights (same files as yolov4_pytorch) or an ONNX export of
+// the pytorch model. The input blob and letterbox canvas are allocated once and reused
+// for every call, and only the "person" class score is decoded before NMS.
+class YoloDetector {
+public:
+    struct Detection {
+        cv::Rect2f box;         // Pixel coordinates in the original image
+        float score;
+        int class_id;
+    };
+
+    YoloDetector();
+
+    // weights ending with ".onnx" are loaded with readNetFromONNX and cfg is ignored
+    bool load(const std::string &cfg, const std::string &weights, int input_width, int input_height);
+
+    // Run the network once on a batch of RGB images (letterboxed to the input size)
+    void detect(const std::vector<cv::Mat> &images, std::vector< std::vector<Detection> > &results);
+    void detect(const cv::Mat &image, std::vector<Detection> &result);
+
+    bool is_loaded() const { return !net_.empty(); }
+    int input_width() const { return input_width_; }
+    int input_height() const { return input_height_; }
+
+    float conf_threshold_;
+    float nms_threshold_;
+    int num_classes_;
+    int person_class_id_;
+
+private:
+    struct Letterbox {
+        float scale;
+        float pad_x;
+        float pad_y;
+    };
+
+    void prepare_blob(int batch_size);
+    void preprocess(const cv::Mat &image, int batch_index, Letterbox &letterbox);
+    void decode(const Letterbox &letterbox, const cv::Size &image_size, int batch_index,
+                std::vector<Detection> &result);
+
+    cv::dnn::Net net_;
+    std::vector<cv::String> out_names_;
+    std::vector<cv::Mat> outs_;
+    int input_width_;
+    int input_height_;
+
+    // Persistent buffers
+    cv::Mat blob_;                      // N x 3 x H x W, CV_32F
+    cv::Mat canvas_;                    // Letterboxed RGB image, CV_8UC3
+    cv::Mat canvas_float_;              // Letterboxed RGB image, CV_32FC3
+    std::vector<Letterbox> letterboxes_;
+    std::vector<cv::Rect> nms_boxes_;
+    std::vector<float> nms_scores_;
+    std::vector<int> nms_indices_;
+};
+
+#endif
@@ -0,0 +1,147 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <string>
+#include <vector>
+
+// OpenCV
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+#include "yolo_detector.h"
+
+
+// Compare YoloDetector against reference detections recorded from yolov4_pytorch
+// (see yolov4_pytorch/src/dump_reference.py) and report frames per second on CPU.
+//
+// Usage: yolo_detector_benchmark <cfg> <weights> <reference.csv> [input_size] [batch_size]
+// reference.csv: image_path,score,center_x,center_y,size_x,size_y (pixels, person boxes only)
+
+static const double kMatchIoU = 0.5;
+
+struct RefBox {
+    cv::Rect2f box;
+    float score;
+};
+
+static bool load_reference(const std::string &path, std::vector<std::string> &images,
+                           std::map< std::string, std::vector<RefBox> > &refs) {
+    std::ifstream file(path.c_str());
+    if(!file.is_open())
+        return false;
+    std::string line;
+    while(std::getline(file, line)) {
+        if(line.empty() || line[0] == '#')
+            continue;
+        std::stringstream ss(line);
+        std::string image_path, field;
+        std::getline(ss, image_path, ',');
+        if(refs.find(image_path) == refs.end()) {
+            images.push_back(image_path);
+            refs[image_path];
+        }
+        std::vector<float> values;
+        while(std::getline(ss, field, ','))
+            if(!field.empty()) values.push_back(std::atof(field.c_str()));
+        if(values.size() < 5)
+            continue;   // Image without any detection
+        RefBox ref;
+        ref.score = values[0];
+        ref.box = cv::Rect2f(values[1] - values[3] / 2, values[2] - values[4] / 2, values[3], values[4]);
+        refs[image_path].push_back(ref);
+    }
+    return true;
+}
+
+static double iou(const cv::Rect2f &a, const cv::Rect2f &b) {
+    double inter = (a & b).area();
+    double uni = a.area() + b.area() - inter;
+    return (uni > 0) ? inter / uni : 0.0;
+}
+
+
+int main(int argc, char **argv) {
+    if(argc < 4) {
+        std::cerr << "Usage: " << argv[0] << " <cfg> <weights> <reference.csv> [input_size] [batch_size]" << std::endl;
+        return -1;
+    }
+    int input_size = (argc > 4) ? std::atoi(argv[4]) : 416;
+    int batch_size = (argc > 5) ? std::atoi(argv[5]) : 1;
+
+    YoloDetector detector;
+    if(!detector.load(argv[1], argv[2], input_size, input_size)) {
+        std::cerr << "Cannot load the detection model: " << argv[2] << std::endl;
+        return -1;
+    }
+
+    std::vector<std::string> image_paths;
+    std::map< std::string, std::vector<RefBox> > refs;
+    if(!load_reference(argv[3], image_paths, refs) || image_paths.empty()) {
+        std::cerr << "Cannot read reference file: " << argv[3] << std::endl;
+        return -1;
+    }
+
+    // Decode all images first, only inference is timed
+    std::vector<cv::Mat> images;
+    for(int i = 0; i < image_paths.size(); i++) {
+        cv::Mat bgr = cv::imread(image_paths[i]);
+        if(bgr.empty()) {
+            std::cerr << "Cannot read image: " << image_paths[i] << std::endl;
+            return -1;
+        }
+        cv::Mat rgb;
+        cv::cvtColor(bgr, rgb, cv::COLOR_BGR2RGB);
+        images.push_back(rgb);
+    }
+
+    // Warm up
+    std::vector<YoloDetector::Detection> warmup;
+    detector.detect(images[0], warmup);
+
+    int true_positive = 0, num_detections = 0, num_references = 0;
+    double sum_iou = 0.0;
+    int64 ticks = 0;
+    for(int start = 0; start < images.size(); start += batch_size) {
+        std::vector<cv::Mat> batch(images.begin() + start, images.begin() + std::min<int>(start + batch_size, images.size()));
+        std::vector< std::vector<YoloDetector::Detection> > results;
+        int64 t0 = cv::getTickCount();
+        detector.detect(batch, results);
+        ticks += cv::getTickCount() - t0;
+
+        // Greedy matching in descending score order
+        for(int b = 0; b < results.size(); b++) {
+            const std::vector<RefBox> &ref = refs[image_paths[start + b]];
+            std::vector<bool> used(ref.size(), false);
+            num_references += ref.size();
+            num_detections += results[b].size();
+            for(int i = 0; i < results[b].size(); i++) {
+                int best = -1;
+                double best_iou = kMatchIoU;
+                for(int j = 0; j < ref.size(); j++) {
+                    double v = iou(results[b][i].box, ref[j].box);
+                    if(!used[j] && v >= best_iou) {
+                        best = j;
+                        best_iou = v;
+                    }
+                }
+                if(best >= 0) {
+                    used[best] = true;
+                    true_positive++;
+                    sum_iou += best_iou;
+                }
+            }
+        }
+    }
+
+    double seconds = ticks / cv::getTickFrequency();
+    std::cout << "Images: " << images.size() << ", input " << input_size << "x" << input_size
+              << ", batch " << batch_size << std::endl;
+    std::cout << "FPS (CPU): " << images.size() / seconds
+              << ", latency per image: " << seconds * 1000.0 / images.size() << " ms" << std::endl;
+    std::cout << "Precision vs reference: " << (num_detections ? (double)true_positive / num_detections : 1.0)
+              << ", recall vs reference: " << (num_references ? (double)true_positive / num_references : 1.0)
+              << ", mean IoU: " << (true_positive ? sum_iou / true_positive : 0.0) << std::endl;
+    return 0;
+}
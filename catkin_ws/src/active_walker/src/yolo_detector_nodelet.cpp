@@ -0,0 +1,152 @@
+#include <string>
+#include <vector>
+
+// ROS
+#include <ros/ros.h>
+#include <ros/package.h>
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+#include <sensor_msgs/Image.h>
+#include <sensor_msgs/image_encodings.h>
+#include <cv_bridge/cv_bridge.h>
+// Custom msg & srv
+#include <walker_msgs/Detection2D.h>
+#include <walker_msgs/Detection2DTrigger.h>
+
+// OpenCV
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include <boost/thread/mutex.hpp>
+
+#include "yolo_detector.h"
+
+
+namespace active_walker {
+
+// Drop-in replacement of yolov4_pytorch/detection_node.py on CPU.
+// Same interface: "~image_input" --> "~det2d_result" and the "~yolo_detect" service, so
+// ScanImageCombineNode works with either. Loaded in the same manager as the fusion
+// nodelet, the Detection2D result is passed by pointer without serialization.
+class YoloDetectorNodelet : public nodelet::Nodelet {
+public:
+    virtual void onInit();
+
+private:
+    void image_cb(const sensor_msgs::Image::ConstPtr &msg);
+    bool srv_cb(walker_msgs::Detection2DTrigger::Request &req, walker_msgs::Detection2DTrigger::Response &res);
+    bool run_detection(const sensor_msgs::Image &msg, const cv_bridge::CvImageConstPtr &cv_ptr,
+                       walker_msgs::Detection2D &result);
+
+    YoloDetector detector_;
+    boost::mutex detector_mutex_;
+    bool flag_draw_result_;
+
+    ros::Subscriber sub_image_;
+    ros::Publisher pub_detection_;
+    ros::ServiceServer detection_srv_;
+};
+
+
+void YoloDetectorNodelet::onInit() {
+    ros::NodeHandle &pnh = getPrivateNodeHandle();
+
+    // ROS parameters
+    std::string weights_dir = ros::package::getPath("yolov4_pytorch");
+    std::string cfg_file, weights_file;
+    bool use_tiny_model;
+    int input_width, input_height;
+    double conf_threshold, nms_threshold;
+    pnh.param<bool>("use_tiny_model", use_tiny_model, true);
+    pnh.param<std::string>("cfg_file", cfg_file, weights_dir + (use_tiny_model ? "/cfg/yolov4-tiny.cfg" : "/cfg/yolov4.cfg"));
+    pnh.param<std::string>("weights_file", weights_file, weights_dir + (use_tiny_model ? "/weights/yolov4-tiny.weights" : "/weights/yolov4.weights"));
+    pnh.param<int>("input_width", input_width, 416);
+    pnh.param<int>("input_height", input_height, 416);
+    pnh.param<double>("conf_threshold", conf_threshold, 0.5);
+    pnh.param<double>("nms_threshold", nms_threshold, 0.2);
+    pnh.param<bool>("draw_result", flag_draw_result_, true);
+
+    if(!detector_.load(cfg_file, weights_file, input_width, input_height)) {
+        NODELET_ERROR("Cannot load the detection model: %s. Aborting...", weights_file.c_str());
+        return;
+    }
+    detector_.conf_threshold_ = conf_threshold;
+    detector_.nms_threshold_ = nms_threshold;
+    NODELET_INFO("Loading weights from %s... Done!", weights_file.c_str());
+
+    // ROS publisher & subscriber & service
+    pub_detection_ = pnh.advertise<walker_msgs::Detection2D>("det2d_result", 1);
+    sub_image_ = pnh.subscribe("image_input", 1, &YoloDetectorNodelet::image_cb, this);
+    detection_srv_ = pnh.advertiseService("yolo_detect", &YoloDetectorNodelet::srv_cb, this);
+    NODELET_INFO("%s is ready.", getName().c_str());
+}
+
+
+bool YoloDetectorNodelet::run_detection(const sensor_msgs::Image &msg, const cv_bridge::CvImageConstPtr &cv_ptr,
+                                        walker_msgs::Detection2D &result) {
+    std::vector<YoloDetector::Detection> detections;
+    {
+        boost::mutex::scoped_lock lock(detector_mutex_);
+        detector_.detect(cv_ptr->image, detections);
+    }
+
+    // Keep the image stamp so the result can be synchronized with the laser scan
+    result.header.stamp = msg.header.stamp;
+    result.header.frame_id = msg.header.frame_id;
+    for(int i = 0; i < detections.size(); i++) {
+        const cv::Rect2f &box = detections[i].box;
+        walker_msgs::BBox2D bbox_msg;
+        bbox_msg.center.x = std::floor(box.x + box.width / 2);
+        bbox_msg.center.y = std::floor(box.y + box.height / 2);
+        bbox_msg.size_x = std::floor(box.width);
+        bbox_msg.size_y = std::floor(box.height);
+        bbox_msg.id = detections[i].class_id;
+        bbox_msg.score = detections[i].score;
+        bbox_msg.class_name = "person";
+        result.boxes.push_back(bbox_msg);
+    }
+
+    if(flag_draw_result_) {
+        cv_bridge::CvImage result_image(msg.header, sensor_msgs::image_encodings::RGB8, cv_ptr->image.clone());
+        for(int i = 0; i < detections.size(); i++)
+            cv::rectangle(result_image.image, detections[i].box, cv::Scalar(255, 0, 0), 1);
+        result_image.toImageMsg(result.result_image);
+    }
+    else {
+        result.result_image = msg;
+    }
+    return true;
+}
+
+
+void YoloDetectorNodelet::image_cb(const sensor_msgs::Image::ConstPtr &msg) {
+    cv_bridge::CvImageConstPtr cv_ptr;
+    try {
+        cv_ptr = cv_bridge::toCvShare(msg, sensor_msgs::image_encodings::RGB8);
+    }
+    catch(cv_bridge::Exception &e) {
+        NODELET_ERROR("cv_bridge exception: %s", e.what());
+        return;
+    }
+
+    walker_msgs::Detection2DPtr detection_msg(new walker_msgs::Detection2D);
+    run_detection(*msg, cv_ptr, *detection_msg);
+    pub_detection_.publish(detection_msg);
+}
+
+
+bool YoloDetectorNodelet::srv_cb(walker_msgs::Detection2DTrigger::Request &req, walker_msgs::Detection2DTrigger::Response &res) {
+    cv_bridge::CvImageConstPtr cv_ptr;
+    try {
+        // The request owns the image, no need to copy it
+        cv_ptr = cv_bridge::toCvShare(req.image, boost::shared_ptr<void const>(), sensor_msgs::image_encodings::RGB8);
+    }
+    catch(cv_bridge::Exception &e) {
+        NODELET_ERROR("cv_bridge exception: %s", e.what());
+        return false;
+    }
+    return run_detection(req.image, cv_ptr, res.result);
+}
+
+} // namespace active_walker
+
+PLUGINLIB_EXPORT_CLASS(active_walker::YoloDetectorNodelet, nodelet::Nodelet);
@@ -0,0 +1,358 @@
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include "walker_log.h"
+#include "walker_log_codecs.h"
+
+using namespace walker_log;
+
+
+static std::string temp_file(const std::string &name) {
+    return "/tmp/test_walker_log_" + std::to_string(getpid()) + "_" + name;
+}
+
+
+static std::string read_file(const std::string &file_name) {
+    std::ifstream in(file_name.c_str(), std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+
+static void write_file(const std::string &file_name, const std::string &data) {
+    std::ofstream out(file_name.c_str(), std::ios::binary);
+    out.write(data.data(), data.size());
+}
+
+
+// Float32 messages stamped every 100 ms from 1 s, chunks of 10 messages, and a second topic of
+// twists in chunks of 5 interleaved with them
+static void write_log(const std::string &file_name, uint64_t *size_before_index = NULL) {
+    Writer writer;
+    ASSERT_TRUE(writer.open(file_name));
+    TopicRecorder<std_msgs::Float32> forces(writer, "/walker/force", 10, 1000000000000LL);
+    TopicRecorder<geometry_msgs::Twist> twists(writer, "/walker/cmd_vel", 5, 1000000000000LL);
+    for(int i = 0; i < 50; i++) {
+        const int64_t stamp = 1000000000LL + i * 100000000LL;
+        std_msgs::Float32 force;
+        force.data = 0.25f * i;
+        forces.add(stamp, force);
+        geometry_msgs::Twist twist;
+        twist.linear.x = 0.01 * i;
+        twist.angular.z = -0.002 * i;
+        twists.add(stamp, twist);
+    }
+    forces.flush();
+    twists.flush();
+    if(size_before_index != NULL)
+        *size_before_index = writer.size();
+    writer.close();
+}
+
+
+TEST(WalkerLogCodecs, SignedColumnRoundTrip) {
+    std::mt19937_64 rng(1);
+    for(int it = 0; it < 200; it++) {
+        std::vector<int64_t> values(rng() % 100);
+        for(int i = 0; i < values.size(); i++)
+            values[i] = (int64_t)rng() >> (rng() % 64);
+        if(it == 0) {
+            values.push_back(std::numeric_limits<int64_t>::min());
+            values.push_back(std::numeric_limits<int64_t>::max());
+            values.push_back(std::numeric_limits<int64_t>::min());
+        }
+        Encoder encoder;
+        encoder.put_column(values);
+        Decoder decoder(encoder.data());
+        std::vector<int64_t> decoded;
+        decoder.get_column(values.size(), decoded);
+        EXPECT_TRUE(decoder.ok());
+        EXPECT_TRUE(decoder.at_end());
+        EXPECT_EQ(decoded, values);
+    }
+
+    // Small deltas of either sign take a byte each
+    Encoder encoder;
+    encoder.put_column(std::vector<int64_t>({0, 1, -1, 2, 2, -60}));
+    EXPECT_EQ(encoder.data().size(), 6);
+}
+
+
+TEST(WalkerLogCodecs, QuantizedColumnWithinHalfResolution) {
+    std::mt19937_64 rng(2);
+    std::uniform_real_distribution<double> step(-0.02, 0.02);
+    for(double resolution : {0.001, 0.0001, 0.1}) {
+        // A slow random walk, the rounding error must not accumulate along the deltas
+        std::vector<double> values(10000);
+        double value = -3.0;
+        for(int i = 0; i < values.size(); i++) {
+            value += step(rng);
+            values[i] = value;
+        }
+        Encoder encoder;
+        encoder.put_column(values, resolution);
+        Decoder decoder(encoder.data());
+        std::vector<double> decoded;
+        decoder.get_column(values.size(), resolution, decoded);
+        ASSERT_TRUE(decoder.ok());
+        ASSERT_EQ(decoded.size(), values.size());
+        for(int i = 0; i < values.size(); i++)
+            ASSERT_LE(std::fabs(decoded[i] - values[i]), 0.5 * resolution + 1e-9) << "value " << i;
+    }
+}
+
+
+TEST(WalkerLogCodecs, RunsRoundTrip) {
+    std::mt19937_64 rng(3);
+    for(int it = 0; it < 100; it++) {
+        std::vector<int8_t> values(rng() % 1000);
+        for(int i = 0; i < values.size(); i++)
+            values[i] = rng() % 5 == 0 ? (int8_t)rng() : 0;
+        Encoder encoder;
+        encoder.put_runs(values);
+        Decoder decoder(encoder.data());
+        std::vector<int8_t> decoded;
+        decoder.get_runs(values.size(), decoded);
+        EXPECT_TRUE(decoder.ok());
+        EXPECT_TRUE(decoder.at_end());
+        EXPECT_EQ(decoded, values);
+    }
+
+    // Runs longer than the count are rejected
+    Encoder encoder;
+    encoder.put_runs(std::vector<int8_t>(100, 7));
+    Decoder decoder(encoder.data());
+    std::vector<int8_t> decoded;
+    EXPECT_FALSE(decoder.get_runs(50, decoded));
+}
+
+
+// Local maps of 200 x 200 cells, a person moving across an otherwise static map
+TEST(WalkerLogCodecs, OccupancyGridDifferences) {
+    std::vector<nav_msgs::OccupancyGrid> maps(20);
+    for(int i = 0; i < maps.size(); i++) {
+        nav_msgs::OccupancyGrid &map = maps[i];
+        map.header.seq = i;
+        map.header.frame_id = "base_link";
+        map.header.stamp.fromNSec(1000000000LL + i * 125000000LL);
+        map.info.resolution = 0.1;
+        map.info.width = 200;
+        map.info.height = 200;
+        map.info.origin.position.x = -10.0;
+        map.info.origin.position.y = -10.0;
+        map.info.origin.orientation.w = 1.0;
+        map.data.assign(200 * 200, 0);
+        for(int x = 0; x < 200; x++)
+            map.data[150 * 200 + x] = 100;
+        for(int y = 0; y < 5; y++) {
+            for(int x = 0; x < 5; x++)
+                map.data[(80 + y) * 200 + 20 + 5 * i + x] = 50 + i;
+        }
+    }
+    // A map of another size is stored whole
+    maps[12].info.width = 100;
+    maps[12].data.assign(100 * 200, -1);
+
+    std::vector<int64_t> stamps;
+    for(int i = 0; i < maps.size(); i++)
+        stamps.push_back(maps[i].header.stamp.toNSec());
+    const std::string columns = encode_chunk(stamps, maps);
+    EXPECT_LT(columns.size(), maps.size() * 200 * 200 / 100);
+
+    std::vector<int64_t> decoded_stamps;
+    std::vector<nav_msgs::OccupancyGrid> decoded;
+    ASSERT_TRUE(decode_chunk(columns, maps.size(), decoded_stamps, decoded));
+    EXPECT_EQ(decoded_stamps, stamps);
+    ASSERT_EQ(decoded.size(), maps.size());
+    for(int i = 0; i < maps.size(); i++) {
+        EXPECT_EQ(decoded[i].header.seq, maps[i].header.seq);
+        EXPECT_EQ(decoded[i].header.frame_id, maps[i].header.frame_id);
+        EXPECT_EQ(decoded[i].info.width, maps[i].info.width);
+        EXPECT_FLOAT_EQ(decoded[i].info.resolution, maps[i].info.resolution);
+        EXPECT_NEAR(decoded[i].info.origin.position.x, maps[i].info.origin.position.x, 0.5 * kPositionResolution);
+        EXPECT_TRUE(decoded[i].data == maps[i].data) << "map " << i;
+    }
+}
+
+
+TEST(WalkerLogCodecs, TracksRoundTrip) {
+    std::mt19937_64 rng(4);
+    std::uniform_real_distribution<double> uniform(-5.0, 5.0);
+    std::vector<walker_msgs::Trk3DArray> msgs(30);
+    std::vector<int64_t> stamps;
+    for(int i = 0; i < msgs.size(); i++) {
+        msgs[i].header.stamp.fromNSec(2000000000LL + i * 100000000LL);
+        msgs[i].header.frame_id = "odom";
+        for(int k = 0; k < i % 4; k++) {
+            walker_msgs::Trk3D trk;
+            trk.id = 10 + k;
+            trk.x = uniform(rng);
+            trk.y = uniform(rng);
+            trk.vx = 0.1 * uniform(rng);
+            trk.yaw = 0.6 * uniform(rng);
+            trk.confidence = 0.9;
+            trk.mode_probabilities[1] = 0.7;
+            msgs[i].trks_list.push_back(trk);
+        }
+        stamps.push_back(msgs[i].header.stamp.toNSec());
+    }
+
+    std::vector<int64_t> decoded_stamps;
+    std::vector<walker_msgs::Trk3DArray> decoded;
+    ASSERT_TRUE(decode_chunk(encode_chunk(stamps, msgs), msgs.size(), decoded_stamps, decoded));
+    ASSERT_EQ(decoded.size(), msgs.size());
+    for(int i = 0; i < msgs.size(); i++) {
+        EXPECT_EQ(decoded[i].header.stamp.toNSec(), msgs[i].header.stamp.toNSec());
+        EXPECT_EQ(decoded[i].header.frame_id, "odom");
+        ASSERT_EQ(decoded[i].trks_list.size(), msgs[i].trks_list.size());
+        for(int k = 0; k < msgs[i].trks_list.size(); k++) {
+            const walker_msgs::Trk3D &a = decoded[i].trks_list[k], &b = msgs[i].trks_list[k];
+            EXPECT_EQ(a.id, b.id);
+            // float fields, half a resolution plus the float rounding
+            EXPECT_NEAR(a.x, b.x, 0.5 * kPositionResolution + 1e-6);
+            EXPECT_NEAR(a.y, b.y, 0.5 * kPositionResolution + 1e-6);
+            EXPECT_NEAR(a.vx, b.vx, 0.5 * kVelocityResolution + 1e-6);
+            EXPECT_NEAR(a.yaw, b.yaw, 0.5 * kAngleResolution + 1e-6);
+            EXPECT_NEAR(a.mode_probabilities[1], b.mode_probabilities[1], 0.5 * kRatioResolution + 1e-6);
+        }
+    }
+
+    // A chunk with a byte missing is rejected
+    const std::string columns = encode_chunk(stamps, msgs);
+    EXPECT_FALSE(decode_chunk(columns.substr(0, columns.size() - 1), msgs.size(), decoded_stamps, decoded));
+}
+
+
+TEST(WalkerLog, FooterIndex) {
+    const std::string file_name = temp_file("index.wlog");
+    write_log(file_name);
+
+    Reader reader;
+    ASSERT_TRUE(reader.open(file_name));
+    EXPECT_TRUE(reader.indexed());
+    EXPECT_EQ(reader.version(), kFormatVersion);
+    ASSERT_EQ(reader.topics().size(), 2);
+    const int forces = reader.find_topic("/walker/force");
+    const int twists = reader.find_topic("/walker/cmd_vel");
+    ASSERT_GE(forces, 0);
+    ASSERT_GE(twists, 0);
+    EXPECT_EQ(reader.find_topic("/walker/scan"), -1);
+    ASSERT_EQ(reader.chunks().size(), 5 + 10);
+    for(int i = 1; i < reader.chunks().size(); i++)
+        EXPECT_LE(reader.chunks()[i - 1].start_time, reader.chunks()[i].start_time);
+
+    // 2.45 s to 3.0 s: the force chunk of 2.0 s to 2.9 s and the one from 3.0 s, the boundaries
+    // are inclusive
+    const std::vector<int> chunks = reader.find_chunks(2450000000LL, 3000000000LL, forces);
+    ASSERT_EQ(chunks.size(), 2);
+    EXPECT_EQ(reader.chunks()[chunks[0]].start_time, 2000000000LL);
+    EXPECT_EQ(reader.chunks()[chunks[1]].start_time, 3000000000LL);
+    // and the twist chunks of 2.5 s to 2.9 s and from 3.0 s
+    EXPECT_EQ(reader.find_chunks(2450000000LL, 3000000000LL).size(), 2 + 2);
+    EXPECT_TRUE(reader.find_chunks(0, 999999999LL).empty());
+
+    std::vector<int64_t> stamps;
+    std::vector<std_msgs::Float32> msgs;
+    ASSERT_TRUE(read_messages(reader, forces, 2450000000LL, 3000000000LL, stamps, msgs));
+    ASSERT_EQ(msgs.size(), 6);
+    EXPECT_EQ(stamps.front(), 2500000000LL);
+    EXPECT_EQ(stamps.back(), 3000000000LL);
+    EXPECT_FLOAT_EQ(msgs.front().data, 0.25f * 15);
+
+    std::vector<geometry_msgs::Twist> twist_msgs;
+    ASSERT_TRUE(read_messages(reader, twists, 0, 10000000000LL, stamps, twist_msgs));
+    ASSERT_EQ(twist_msgs.size(), 50);
+    EXPECT_NEAR(twist_msgs[49].linear.x, 0.49, 0.5 * kVelocityResolution + 1e-9);
+    // Another message type on the topic
+    EXPECT_FALSE(read_messages(reader, twists, 0, 10000000000LL, stamps, msgs));
+    std::remove(file_name.c_str());
+}
+
+
+// A log left unclosed has no index, a power loss can also cut its last record
+TEST(WalkerLog, Recovery) {
+    const std::string file_name = temp_file("complete.wlog");
+    const std::string cut_name = temp_file("cut.wlog");
+    uint64_t size_before_index;
+    write_log(file_name, &size_before_index);
+    const std::string data = read_file(file_name);
+    ASSERT_GT(data.size(), size_before_index);
+
+    // Unclosed: every chunk is found by scanning the records
+    write_file(cut_name, data.substr(0, size_before_index));
+    Reader reader;
+    ASSERT_TRUE(reader.open(cut_name));
+    EXPECT_FALSE(reader.indexed());
+    EXPECT_EQ(reader.topics().size(), 2);
+    EXPECT_EQ(reader.chunks().size(), 15);
+    std::vector<int64_t> stamps;
+    std::vector<std_msgs::Float32> msgs;
+    EXPECT_TRUE(read_messages(reader, reader.find_topic("/walker/force"), 0, 10000000000LL, stamps, msgs));
+    EXPECT_EQ(msgs.size(), 50);
+
+    // Cut in the last chunk: the complete ones are kept
+    write_file(cut_name, data.substr(0, size_before_index - 3));
+    ASSERT_TRUE(reader.open(cut_name));
+    EXPECT_FALSE(reader.indexed());
+    EXPECT_EQ(reader.chunks().size(), 14);
+    for(int i = 0; i < reader.chunks().size(); i++) {
+        std::string columns;
+        EXPECT_TRUE(reader.read_chunk(i, columns));
+    }
+
+    // Cut in the footer, the index is not trusted
+    write_file(cut_name, data.substr(0, data.size() - 2));
+    ASSERT_TRUE(reader.open(cut_name));
+    EXPECT_FALSE(reader.indexed());
+    EXPECT_EQ(reader.chunks().size(), 15);
+
+    // Cut in the file header: not a walker log
+    write_file(cut_name, data.substr(0, 5));
+    EXPECT_FALSE(reader.open(cut_name));
+    std::remove(file_name.c_str());
+    std::remove(cut_name.c_str());
+}
+
+
+TEST(WalkerLog, UnknownVersions) {
+    const std::string file_name = temp_file("version.wlog");
+    write_log(file_name);
+    std::string data = read_file(file_name);
+
+    // Newer format, the version follows the magic
+    data[4] = (char)((kFormatVersion + 1) & 0xff);
+    data[5] = (char)((kFormatVersion + 1) >> 8);
+    write_file(file_name, data);
+    Reader reader;
+    EXPECT_FALSE(reader.open(file_name));
+
+    // Newer codec of a known message type
+    {
+        Writer writer;
+        ASSERT_TRUE(writer.open(file_name));
+        const int topic = writer.add_topic("/walker/force", kFloat32, MessageTraits<std_msgs::Float32>::codec_version + 1);
+        std::vector<int64_t> stamps(1, 1000000000LL);
+        std::vector<std_msgs::Float32> msgs(1);
+        writer.write_chunk(topic, stamps[0], stamps[0], 1, encode_chunk(stamps, msgs));
+    }
+    ASSERT_TRUE(reader.open(file_name));
+    std::vector<int64_t> stamps;
+    std::vector<std_msgs::Float32> msgs;
+    EXPECT_FALSE(read_messages(reader, 0, 0, 10000000000LL, stamps, msgs));
+    EXPECT_TRUE(msgs.empty());
+    std::remove(file_name.c_str());
+}
+
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
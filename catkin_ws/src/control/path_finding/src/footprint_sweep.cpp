@@ -0,0 +1,224 @@
+#include "footprint_sweep.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <limits>
+
+namespace footprint_sweep {
+
+static bool IsPointInPolygon(double x, double y, const std::vector<std::pair<double, double> >& polygon) {
+  bool inside = false;
+  for(int i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++) {
+    const std::pair<double, double>& a = polygon[i];
+    const std::pair<double, double>& b = polygon[j];
+    if((a.second > y) != (b.second > y) &&
+       x < (b.first - a.first) * (y - a.second) / (b.second - a.second) + a.first)
+      inside = !inside;
+  }
+  return inside;
+}
+
+
+// Liang-Barsky clipping of the segment a-b to the box
+static bool IsSegmentInBox(double ax, double ay, double bx, double by,
+                           double min_x, double min_y, double max_x, double max_y) {
+  const double p[4] = {ax - bx, bx - ax, ay - by, by - ay};
+  const double q[4] = {ax - min_x, max_x - ax, ay - min_y, max_y - ay};
+  double t0 = 0.0, t1 = 1.0;
+  for(int i = 0; i < 4; i++) {
+    if(p[i] == 0.0) {
+      if(q[i] < 0.0)
+        return false;
+      continue;
+    }
+    const double t = q[i] / p[i];
+    if(p[i] < 0.0)
+      t0 = std::max(t0, t);
+    else
+      t1 = std::min(t1, t);
+    if(t0 > t1)
+      return false;
+  }
+  return true;
+}
+
+
+static bool IsSquareOnPolygon(double x, double y, double half_size,
+                              const std::vector<std::pair<double, double> >& polygon) {
+  if(IsPointInPolygon(x, y, polygon))
+    return true;
+  for(int i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++) {
+    if(IsSegmentInBox(polygon[j].first, polygon[j].second, polygon[i].first, polygon[i].second,
+                      x - half_size, y - half_size, x + half_size, y + half_size))
+      return true;
+  }
+  return false;
+}
+
+
+const double SweptFootprint::kFirstSegmentYaw = std::numeric_limits<double>::quiet_NaN();
+
+
+SweptFootprint::SweptFootprint(): resolution_(0.0), margin_(0.0) {}
+
+
+void SweptFootprint::SetFootprint(const geometry_msgs::Polygon& footprint, double map_resolution, int num_headings) {
+  masks_.clear();
+  mask_bounds_.clear();
+  resolution_ = map_resolution;
+  if(footprint.points.size() < 3 || map_resolution <= 0.0 || num_headings < 1)
+    return;
+
+  double max_radius = 0.0;
+  for(int i = 0; i < footprint.points.size(); i++)
+    max_radius = std::max(max_radius, (double)std::hypot(footprint.points[i].x, footprint.points[i].y));
+
+  // A footprint point is at most half a sample step from a sample of the sweep, and at most
+  // 2 r sin(bin / 4) from where the center heading of its bin puts it. The robot is anywhere in
+  // its cell, half a cell from the cell center.
+  const double bin_size = 2.0 * M_PI / num_headings;
+  margin_ = 0.5 * resolution_ + 0.25 * resolution_ + 2.0 * max_radius * std::sin(bin_size / 4.0);
+  // An obstacle cell is touched when its square is within the margin of the footprint
+  const double half_size = 0.5 * resolution_ + margin_;
+  const int bound = std::ceil((max_radius + half_size) / resolution_);
+
+  masks_.resize(num_headings);
+  mask_bounds_.assign(num_headings, 0);
+  std::vector<std::pair<double, double> > polygon(footprint.points.size());
+  for(int b = 0; b < num_headings; b++) {
+    const double c = std::cos(b * bin_size), s = std::sin(b * bin_size);
+    for(int i = 0; i < footprint.points.size(); i++) {
+      polygon[i].first = c * footprint.points[i].x - s * footprint.points[i].y;
+      polygon[i].second = s * footprint.points[i].x + c * footprint.points[i].y;
+    }
+    for(int y = -bound; y <= bound; y++) {
+      for(int x = -bound; x <= bound; x++) {
+        if(IsSquareOnPolygon(x * resolution_, y * resolution_, half_size, polygon)) {
+          masks_[b].push_back(std::make_pair(x, y));
+          mask_bounds_[b] = std::max(mask_bounds_[b], std::max(std::abs(x), std::abs(y)));
+        }
+      }
+    }
+  }
+}
+
+
+int SweptFootprint::GetHeadingBin(double yaw) const {
+  const int num_headings = masks_.size();
+  const int bin = std::lround(yaw / (2.0 * M_PI / num_headings)) % num_headings;
+  return bin < 0 ? bin + num_headings : bin;
+}
+
+
+bool SweptFootprint::IsPoseSafe(const nav_msgs::OccupancyGrid& map, int cell_x, int cell_y, int heading_bin,
+                                int max_danger_cost) const {
+  const int map_width = map.info.width;
+  const int map_height = map.info.height;
+  const std::vector<std::pair<int, int> >& mask = masks_[heading_bin];
+  const int bound = mask_bounds_[heading_bin];
+
+  if(cell_x >= 0 && cell_x < map_width && cell_y >= 0 && cell_y < map_height &&
+     map.data[cell_y * map_width + cell_x] < 0)
+    return false;
+
+  if(cell_x - bound >= 0 && cell_x + bound < map_width && cell_y - bound >= 0 && cell_y + bound < map_height) {
+    const int8_t* center = &map.data[cell_y * map_width + cell_x];
+    for(int i = 0; i < mask.size(); i++) {
+      if(center[mask[i].second * map_width + mask[i].first] >= max_danger_cost)
+        return false;
+    }
+    return true;
+  }
+
+  // Near the map border
+  for(int i = 0; i < mask.size(); i++) {
+    const int x = cell_x + mask[i].first;
+    const int y = cell_y + mask[i].second;
+    if(x < 0 || x >= map_width || y < 0 || y >= map_height)
+      continue;
+    if(map.data[y * map_width + x] >= max_danger_cost)
+      return false;
+  }
+  return true;
+}
+
+
+int SweptFootprint::FindFirstCollision(const nav_msgs::OccupancyGrid& map,
+                                       const std::vector<geometry_msgs::Point>& path,
+                                       int max_danger_cost,
+                                       double start_yaw) const {
+  if(path.empty())
+    return -1;
+  if(!IsReady())
+    return 0;
+
+  const int num_headings = masks_.size();
+  const double map_resolution = map.info.resolution;
+  const double map_origin_x = map.info.origin.position.x;
+  const double map_origin_y = map.info.origin.position.y;
+  // Samples every half cell, as the margin of the masks assumes
+  const double step = 0.5 * map_resolution;
+
+  // Cells of the local map cover [origin + i * resolution, origin + (i + 1) * resolution), as
+  // scan2localmap_node fills them. Poses that repeat the last cell and heading are skipped.
+  int last_x = INT_MIN, last_y = INT_MIN, last_bin = -1;
+  auto is_safe = [&](double x, double y, int bin) {
+    const int cell_x = std::floor((x - map_origin_x) / map_resolution);
+    const int cell_y = std::floor((y - map_origin_y) / map_resolution);
+    if(cell_x == last_x && cell_y == last_y && bin == last_bin)
+      return true;
+    last_x = cell_x;
+    last_y = cell_y;
+    last_bin = bin;
+    return IsPoseSafe(map, cell_x, cell_y, bin, max_danger_cost);
+  };
+
+  // The turn from start_yaw to the first segment is swept like the others
+  int heading_bin = 0;
+  if(!std::isnan(start_yaw)) {
+    heading_bin = GetHeadingBin(start_yaw);
+  }
+  else {
+    for(int i = 0; i + 1 < path.size(); i++) {
+      if(path[i + 1].x != path[i].x || path[i + 1].y != path[i].y) {
+        heading_bin = GetHeadingBin(std::atan2(path[i + 1].y - path[i].y, path[i + 1].x - path[i].x));
+        break;
+      }
+    }
+  }
+
+  for(int i = 0; i + 1 < path.size(); i++) {
+    const geometry_msgs::Point& p0 = path[i];
+    const geometry_msgs::Point& p1 = path[i + 1];
+    const double length = std::hypot(p1.x - p0.x, p1.y - p0.y);
+    if(length == 0.0)
+      continue;
+
+    // Turn in place at p0, through every bin on the shorter side
+    const int segment_bin = GetHeadingBin(std::atan2(p1.y - p0.y, p1.x - p0.x));
+    int turn = (segment_bin - heading_bin + num_headings) % num_headings;
+    const int direction = turn <= num_headings / 2 ? 1 : -1;
+    if(direction < 0)
+      turn = num_headings - turn;
+    for(int k = 0; k < turn; k++) {
+      heading_bin = (heading_bin + direction + num_headings) % num_headings;
+      if(!is_safe(p0.x, p0.y, heading_bin))
+        return i;
+    }
+
+    const int num_steps = std::ceil(length / step);
+    for(int k = 0; k <= num_steps; k++) {
+      const double t = (double)k / num_steps;
+      if(!is_safe(p0.x + t * (p1.x - p0.x), p0.y + t * (p1.y - p0.y), heading_bin))
+        return i;
+    }
+  }
+
+  // Single pose, or all the poses at the same place
+  if(last_bin < 0 && !is_safe(path[0].x, path[0].y, heading_bin))
+    return 0;
+  return -1;
+}
+
+}
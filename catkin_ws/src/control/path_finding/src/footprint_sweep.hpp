@@ -0,0 +1,66 @@
+#ifndef FOOTPRINT_SWEEP_HPP
+#define FOOTPRINT_SWEEP_HPP
+
+#include <utility>
+#include <vector>
+
+#include <geometry_msgs/Point.h>
+#include <geometry_msgs/Polygon.h>
+#include <nav_msgs/OccupancyGrid.h>
+
+
+namespace footprint_sweep {
+
+// Continuous collision check of a path on the local map: the oriented footprint polygon is swept
+// along every segment of the path, heading along the segment and turning in place at the poses.
+//
+// The footprint is rasterized once per heading bin into a mask of cell offsets from the robot
+// cell. A mask holds every cell that the footprint can touch from anywhere in the robot cell, at
+// any heading of its bin and anywhere between two samples of the sweep (samples every half cell),
+// so the check never misses an obstacle the swept footprint overlaps. The price is a margin of
+// about one cell plus a few cm around the footprint.
+class SweptFootprint {
+  public:
+  SweptFootprint();
+  // Footprint in the robot frame (base_link), masks for maps of that resolution
+  void SetFootprint(const geometry_msgs::Polygon& footprint, double map_resolution, int num_headings = 64);
+  bool IsReady() const { return !masks_.empty(); }
+  double GetResolution() const { return resolution_; }
+  int GetNumHeadings() const { return masks_.size(); }
+  double GetMargin() const { return margin_; }
+  // Cell offsets (x, y) of the mask of the heading bin
+  const std::vector<std::pair<int, int> >& GetMask(int heading_bin) const { return masks_[heading_bin]; }
+  int GetHeadingBin(double yaw) const;
+
+  // Index of the first segment (from point i to i + 1) where the footprint meets a cell of cost
+  // max_danger_cost or more, or a pose falls on an unknown cell; -1 if the whole path is safe.
+  // The points are in the map frame. The footprint starts at start_yaw and turns to the first
+  // segment, segment 0 includes that turn: 0 for a new path from base_link. By default it starts
+  // along the first segment, for a path already followed whose first pose is behind the robot.
+  // A path of one point checks start_yaw, or heading 0. Cells outside of the map are free, as in
+  // the discrete check.
+  static const double kFirstSegmentYaw;
+  int FindFirstCollision(const nav_msgs::OccupancyGrid& map,
+                         const std::vector<geometry_msgs::Point>& path,
+                         int max_danger_cost,
+                         double start_yaw = kFirstSegmentYaw) const;
+  bool IsPathSafe(const nav_msgs::OccupancyGrid& map,
+                  const std::vector<geometry_msgs::Point>& path,
+                  int max_danger_cost,
+                  double start_yaw = kFirstSegmentYaw) const {
+    return FindFirstCollision(map, path, max_danger_cost, start_yaw) < 0;
+  }
+
+  private:
+  bool IsPoseSafe(const nav_msgs::OccupancyGrid& map, int cell_x, int cell_y, int heading_bin,
+                  int max_danger_cost) const;
+
+  std::vector<std::vector<std::pair<int, int> > > masks_;
+  std::vector<int> mask_bounds_;    // largest |offset| of each mask
+  double resolution_;
+  double margin_;
+};
+
+}
+
+#endif
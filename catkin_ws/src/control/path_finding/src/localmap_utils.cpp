@@ -445,3 +445,33 @@ void localmap_utils::GetFillCells(std::vector<std::pair<int, int> >& pts){
   // printf("};\n");
   // exit(-1);
 }
+
+
+localmap_utils::TfFilterCounter::TfFilterCounter(const std::string& input_name, double late_threshold):
+  input_name_(input_name), late_threshold_(late_threshold), released_(0), late_(0), dropped_(0) {}
+
+
+void localmap_utils::TfFilterCounter::count_released(const ros::Time& stamp, const ros::Time& now) {
+  released_++;
+  if(!stamp.isZero() && (now - stamp).toSec() > late_threshold_)
+    late_++;
+  ROS_INFO_THROTTLE(10.0, "%s input: %d released (%d late), %d dropped waiting for TF",
+                    input_name_.c_str(), released_, late_, dropped_);
+}
+
+
+void localmap_utils::TfFilterCounter::count_dropped(const std_msgs::Header& header,
+                                                    const std::string& target_frame,
+                                                    const std::string& reason) {
+  dropped_++;
+  ROS_WARN_THROTTLE(1.0, "Drop %s message at %.3f, no TF from %s to %s (%s, %d dropped so far)",
+                    input_name_.c_str(), header.stamp.toSec(), header.frame_id.c_str(), target_frame.c_str(),
+                    reason.c_str(), dropped_);
+}
+
+
+void localmap_utils::TfFilterCounter::count_dropped(const std_msgs::Header& header,
+                                                    const std::string& target_frame,
+                                                    tf2_ros::FilterFailureReason reason) {
+  count_dropped(header, target_frame, "reason " + std::to_string((int)reason));
+}
@@ -18,6 +18,7 @@
 #include <nav_msgs/OccupancyGrid.h>
 #include <nav_msgs/Odometry.h>
 #include <nav_msgs/Path.h>
+#include <tf2_ros/message_filter.h>
 
 
 namespace localmap_utils {
@@ -31,4 +32,27 @@ namespace localmap_utils {
   void GetFillCells(std::vector<std::pair<int, int> >& pts);
   std::vector<std::pair<int, int> > GetFootprintCells(geometry_msgs::PolygonStamped::ConstPtr &footprint_ptr,
                                                       const nav_msgs::OccupancyGrid::ConstPtr &map_msg_ptr);
+
+  // Counts of an input behind a tf2_ros::MessageFilter: messages released to the callback, the
+  // ones released later than late_threshold after their stamp, and the ones dropped for missing TF.
+  // The counts are logged with a throttle.
+  class TfFilterCounter {
+    public:
+    TfFilterCounter(const std::string& input_name, double late_threshold = 0.1);
+    void set_late_threshold(double late_threshold) { late_threshold_ = late_threshold; }
+    void count_released(const ros::Time& stamp, const ros::Time& now);
+    void count_dropped(const std_msgs::Header& header, const std::string& target_frame, const std::string& reason);
+    void count_dropped(const std_msgs::Header& header, const std::string& target_frame,
+                       tf2_ros::FilterFailureReason reason);
+    int get_released() const { return released_; }
+    int get_late() const { return late_; }
+    int get_dropped() const { return dropped_; }
+
+    private:
+    std::string input_name_;
+    double late_threshold_;
+    int released_;
+    int late_;
+    int dropped_;
+  };
 }
\ No newline at end of file
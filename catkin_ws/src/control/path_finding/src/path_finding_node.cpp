@@ -21,6 +21,7 @@
 
 // Custom library
 #include "a_star.hpp"
+#include "footprint_sweep.hpp"
 #include "localmap_utils.hpp"
 
 
@@ -40,6 +41,16 @@ inline size_t argmax(ForwardIterator first, ForwardIterator last) {
   return std::distance(first, std::max_element(first, last));
 }
 
+inline bool is_same_polygon(const geometry_msgs::Polygon &polygon1, const geometry_msgs::Polygon &polygon2) {
+  if(polygon1.points.size() != polygon2.points.size())
+    return false;
+  for(int i = 0; i < polygon1.points.size(); i++) {
+    if(polygon1.points[i].x != polygon2.points[i].x || polygon1.points[i].y != polygon2.points[i].y)
+      return false;
+  }
+  return true;
+}
+
 
 class PathFindingNode {
 public:
@@ -67,6 +78,11 @@ public:
   bool is_path_safe(const nav_msgs::OccupancyGrid::ConstPtr &map_msg_ptr,
                     nav_msgs::Path::Ptr path_ptr,
                     tf::StampedTransform tf_odom2base);
+  int find_path_collision(const nav_msgs::OccupancyGrid::ConstPtr &map_msg_ptr,
+                          const std::vector<geometry_msgs::Point> &path_pts,
+                          double start_yaw);
+  bool trim_unsafe_path(const nav_msgs::OccupancyGrid::ConstPtr &map_msg_ptr,
+                        nav_msgs::Path::Ptr path_ptr);
   bool is_robot_following_path(nav_msgs::Path::Ptr path_ptr,
                                double tracking_progress_percentage,
                                tf::StampedTransform tf_odom2base);
@@ -75,6 +91,7 @@ public:
   void cancel_navigation(void);
 
   void timer_cb(const ros::TimerEvent&);
+  bool lookup_base2odom(tf::StampedTransform &tf_base2odom);
 
   // ROS related
   ros::NodeHandle nh_, pnh_;
@@ -91,10 +108,13 @@ public:
   nav_msgs::Path::Ptr walkable_path_ptr_;
   geometry_msgs::PolygonStamped::ConstPtr footprint_ptr_;
   std::vector<std::pair<int, int> > footprint_cells_;
+  footprint_sweep::SweptFootprint swept_footprint_;   // footprint masks for is_path_safe
   std::string path_frame_id_;
 
   // TF related
   tf::TransformListener tflistener_;
+  int tf_found_count_ = 0;
+  int tf_missing_count_ = 0;    // planning steps skipped because the TF was not available
 
   // Sub-goal related
   visualization_msgs::Marker mkr_subgoal_candidate_;
@@ -135,7 +155,7 @@ PathFindingNode::PathFindingNode(ros::NodeHandle nh, ros::NodeHandle pnh): nh_(n
 
   // ROS publishers & subscribers
   sub_localmap_ = nh_.subscribe("local_map", 1, &PathFindingNode::localmap_cb, this);
-  // sub_footprint_= nh_.subscribe("footprint", 1, &PathFindingNode::footprint_cb, this);
+  sub_footprint_= nh_.subscribe("footprint", 1, &PathFindingNode::footprint_cb, this);
   sub_tracking_progress_percentage_ = nh_.subscribe("tracking_progress", 1, &PathFindingNode::progress_cb, this);
   pub_walkable_path_ = nh_.advertise<nav_msgs::Path>("walkable_path", 1);
   pub_marker_array_ = nh_.advertise<visualization_msgs::MarkerArray>("path_vis", 1);
@@ -155,6 +175,7 @@ PathFindingNode::PathFindingNode(ros::NodeHandle nh, ros::NodeHandle pnh): nh_(n
   footprint_ptr_ = ros::topic::waitForMessage<geometry_msgs::PolygonStamped>("footprint", ros::Duration(3.0));
   if(map_msg_ptr && footprint_ptr_){
     footprint_cells_ = localmap_utils::GetFootprintCells(footprint_ptr_, map_msg_ptr);
+    swept_footprint_.SetFootprint(footprint_ptr_->polygon, map_msg_ptr->info.resolution);
   }else{
     ROS_ERROR("Cannot get map and footprint message, aborting...");
     exit(-1);
@@ -227,6 +248,9 @@ void PathFindingNode::progress_cb(const std_msgs::Float32::ConstPtr &msg_ptr) {
 
 
 void PathFindingNode::footprint_cb(const geometry_msgs::PolygonStamped::ConstPtr &footprint_msg_ptr){
+  // Published with every local map, the masks are only rebuilt when the footprint changes
+  if(!footprint_ptr_ || !is_same_polygon(footprint_ptr_->polygon, footprint_msg_ptr->polygon))
+    swept_footprint_.SetFootprint(footprint_msg_ptr->polygon, swept_footprint_.GetResolution());
   footprint_ptr_ = footprint_msg_ptr;
 }
 
@@ -236,17 +260,13 @@ void PathFindingNode::finalgoal_cb(const geometry_msgs::PoseStamped::ConstPtr &g
 
   finalgoal_ptr_ = goal_msg_ptr;
 
-  // Get transformation from base to odom
+  // Get transformation from base to odom, without waiting for it. If it is not there yet,
+  // the goal is kept and planned by the next timer tick.
   tf::StampedTransform tf_base2odom;
-  try{
-    tflistener_.waitForTransform(path_frame_id_, "/base_link",
-                    ros::Time(0), ros::Duration(subgoal_timer_interval_));
-    tflistener_.lookupTransform(path_frame_id_, "/base_link",
-                    ros::Time(0), tf_base2odom);
-  }
-  catch (tf::TransformException ex){
-    ROS_ERROR("tf_error %s",ex.what());
-    ros::Duration(1.0).sleep();
+  if(!lookup_base2odom(tf_base2odom)) {
+    publish_robot_status_marker("waiting for TF, finalgoal will be planned later");
+    flag_planning_busy_ = false;
+    return;
   }
 
   // Check if robot footprint is safe
@@ -277,7 +297,13 @@ void PathFindingNode::finalgoal_cb(const geometry_msgs::PoseStamped::ConstPtr &g
                                                        solver_timeout_ms_);
     std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
     std::cout << "Time difference = " << std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() << "[µs]" << std::endl;
-    if(flag_success){
+    if(flag_success && !trim_unsafe_path(localmap_ptr_, walkable_path_ptr_)) {
+      ROS_ERROR("No safe path for the footprint");
+      publish_robot_status_marker("no safe path for the footprint");
+      walkable_path_ptr_->header.stamp = ros::Time::now();
+      pub_walkable_path_.publish(walkable_path_ptr_);
+    }
+    else if(flag_success){
       // Convert path from base_link coordinate to odom coordinate
       for(auto it = walkable_path_ptr_->poses.begin() ; it != walkable_path_ptr_->poses.end(); ++it) {
         tf::Vector3 vec_raw(it->pose.position.x, it->pose.position.y, it->pose.position.z);
@@ -418,37 +444,62 @@ bool PathFindingNode::is_subgoal_safe(const nav_msgs::OccupancyGrid::ConstPtr &m
 bool PathFindingNode::is_path_safe(const nav_msgs::OccupancyGrid::ConstPtr &map_msg_ptr,
                     nav_msgs::Path::Ptr path_ptr,
                     tf::StampedTransform tf_odom2base) {
-  double map_resolution = map_msg_ptr->info.resolution;
-  double map_origin_x = map_msg_ptr->info.origin.position.x;
-  double map_origin_y = map_msg_ptr->info.origin.position.y;
-  int map_width = map_msg_ptr->info.width;
-  int map_height = map_msg_ptr->info.height;
-
   if(!path_ptr || path_ptr->poses.size() == 0){
     return false;
   }
 
-  // Transformation matrix from odom to baselink (for localmap check)
-  // tf::Matrix3x3 rot_odom2base = tf_odom2base.getBasis();
-  tf::Vector3 tras_odom2base = tf_odom2base.getOrigin();
-  
-  for(std::vector<geometry_msgs::PoseStamped>::iterator it = path_ptr->poses.begin() ; it != path_ptr->poses.end(); ++it) {
-    tf::Vector3 vec_raw(it->pose.position.x, it->pose.position.y, it->pose.position.z);
-    tf::Vector3 vec_transformed = tf_odom2base * vec_raw;
-
-    int map_x = std::round((vec_transformed.getX() - map_origin_x) / map_resolution);
-    int map_y = std::round((vec_transformed.getY() - map_origin_y) / map_resolution);
-    int idx = map_y * map_width + map_x;
-    // if(map_msg_ptr->data[idx] >= kThresObstacleDangerCost || map_msg_ptr->data[idx] < 0) {
-    if(get_local_max_cost(map_msg_ptr, idx) >= kThresObstacleDangerCost || map_msg_ptr->data[idx] < 0) {
-      return false;
-    }
+  // Path from odom to base_link, the frame of the localmap
+  std::vector<geometry_msgs::Point> path_pts(path_ptr->poses.size());
+  for(int i = 0; i < path_ptr->poses.size(); i++) {
+    tf::Vector3 vec_raw;
+    tf::pointMsgToTF(path_ptr->poses[i].pose.position, vec_raw);
+    tf::pointTFToMsg(tf_odom2base * vec_raw, path_pts[i]);
   }
 
+  // The robot already turned along the path, whose first pose is behind it
+  int segment_idx = find_path_collision(map_msg_ptr, path_pts, footprint_sweep::SweptFootprint::kFirstSegmentYaw);
+  if(segment_idx >= 0) {
+    ROS_DEBUG("Path blocked on segment %d of %d", segment_idx, (int)path_pts.size());
+    return false;
+  }
   return true;
 }
 
 
+int PathFindingNode::find_path_collision(const nav_msgs::OccupancyGrid::ConstPtr &map_msg_ptr,
+                                         const std::vector<geometry_msgs::Point> &path_pts,
+                                         double start_yaw) {
+  // The masks are made for one map resolution
+  double map_resolution = map_msg_ptr->info.resolution;
+  if(swept_footprint_.GetResolution() != map_resolution && footprint_ptr_)
+    swept_footprint_.SetFootprint(footprint_ptr_->polygon, map_resolution);
+
+  // Sweep the footprint along the path instead of checking the poses only, so that thin
+  // obstacles between poses and the corners of the walker are not missed
+  return swept_footprint_.FindFirstCollision(*map_msg_ptr, path_pts, kThresObstacleDangerCost, start_yaw);
+}
+
+
+bool PathFindingNode::trim_unsafe_path(const nav_msgs::OccupancyGrid::ConstPtr &map_msg_ptr,
+                                       nav_msgs::Path::Ptr path_ptr) {
+  // The A* solver plans for a 0.6 x 0.6 m square, smaller than the swept footprint, so a new
+  // path (in base_link) is cut before its first blocked segment. The robot approaches the
+  // subgoal on the safe part and the next plan starts from there.
+  std::vector<geometry_msgs::Point> path_pts(path_ptr->poses.size());
+  for(int i = 0; i < path_ptr->poses.size(); i++)
+    path_pts[i] = path_ptr->poses[i].pose.position;
+
+  // The robot turns from its heading in base_link to the first segment
+  int segment_idx = find_path_collision(map_msg_ptr, path_pts, 0.0);
+  if(segment_idx < 0)
+    return true;
+  ROS_WARN("New path blocked on segment %d of %d, keep the safe part", segment_idx, (int)path_pts.size());
+  // A single pose is no path to follow
+  path_ptr->poses.resize(segment_idx > 0 ? segment_idx + 1 : 0);
+  return !path_ptr->poses.empty();
+}
+
+
 bool PathFindingNode::is_path_deprecated(nav_msgs::Path::Ptr path_ptr) {
   if(!path_ptr || path_ptr->poses.size() == 0){
     return true;
@@ -664,6 +715,28 @@ void PathFindingNode::cancel_navigation(void){
 }
 
 
+bool PathFindingNode::lookup_base2odom(tf::StampedTransform &tf_base2odom) {
+  // Non-blocking, the callbacks must not stall on TF
+  std::string error;
+  if(!tflistener_.canTransform(path_frame_id_, "/base_link", ros::Time(0), &error)) {
+    tf_missing_count_++;
+    ROS_WARN_THROTTLE(1.0, "No TF from base_link to %s yet, skip planning (%d of %d steps skipped): %s",
+                      path_frame_id_.c_str(), tf_missing_count_, tf_missing_count_ + tf_found_count_, error.c_str());
+    return false;
+  }
+  try{
+    tflistener_.lookupTransform(path_frame_id_, "/base_link", ros::Time(0), tf_base2odom);
+  }
+  catch (tf::TransformException ex){
+    tf_missing_count_++;
+    ROS_WARN_THROTTLE(1.0, "tf_error %s", ex.what());
+    return false;
+  }
+  tf_found_count_++;
+  return true;
+}
+
+
 void PathFindingNode::timer_cb(const ros::TimerEvent&){
   // Lock
   if (flag_planning_busy_){
@@ -688,15 +761,11 @@ void PathFindingNode::timer_cb(const ros::TimerEvent&){
   int map_width = localmap_ptr_->info.width;
   int map_height = localmap_ptr_->info.height;
 
-  // Get transformation from base to odom
+  // Get transformation from base to odom, skip this tick instead of waiting for it
   tf::StampedTransform tf_base2odom;
-  try{
-    tflistener_.waitForTransform(path_frame_id_, "/base_link", ros::Time(0), ros::Duration(subgoal_timer_interval_));
-    tflistener_.lookupTransform(path_frame_id_, "/base_link", ros::Time(0), tf_base2odom);
-  }
-  catch (tf::TransformException ex){
-    ROS_ERROR("%s",ex.what());
-    ros::Duration(1.0).sleep();
+  if(!lookup_base2odom(tf_base2odom)) {
+    flag_planning_busy_ = false;
+    return;
   }
 
   tf::StampedTransform tf_odom2base(tf_base2odom.inverse(), tf_base2odom.stamp_, "/base_link", path_frame_id_);
@@ -785,7 +854,14 @@ void PathFindingNode::timer_cb(const ros::TimerEvent&){
     int target_idx = map_y * map_width + map_x;
 
     bool flag_success = path_solver_.FindPathByHashmap(localmap_ptr_, walkable_path_ptr_, origin_idx, target_idx, solver_timeout_ms_);
-    if(flag_success){
+    if(flag_success && !trim_unsafe_path(localmap_ptr_, walkable_path_ptr_)) {
+      // Publish empty path if even the first segment is blocked
+      ROS_ERROR("No safe path for the footprint");
+      publish_robot_status_marker("no safe path for the footprint");
+      walkable_path_ptr_->header.stamp = ros::Time::now();
+      pub_walkable_path_.publish(walkable_path_ptr_);
+    }
+    else if(flag_success){
       // Convert path from base_link coordinate to odom coordinate
       for(std::vector<geometry_msgs::PoseStamped>::iterator it = walkable_path_ptr_->poses.begin() ; it != walkable_path_ptr_->poses.end(); ++it) {
         // Walkable path topic without direction info
@@ -13,6 +13,8 @@
 
 // TF
 #include <tf/transform_listener.h>
+#include <message_filters/subscriber.h>
+#include <tf2_ros/message_filter.h>
 
 // PCL
 #include <pcl_ros/transforms.h>
@@ -40,6 +42,7 @@ public:
     static void sigint_cb(int sig);
     void scan_cb(const sensor_msgs::LaserScan &laser_msg);
     void trk3d_cb(const walker_msgs::Trk3DArray::ConstPtr &msg_ptr);
+    void trk3d_dropped_cb(const walker_msgs::Trk3DArray::ConstPtr &msg_ptr, tf2_ros::FilterFailureReason reason);
 
     // ROS related
     ros::NodeHandle nh_, pnh_;
@@ -55,6 +58,11 @@ public:
     tf::TransformListener* tflistener_ptr_;
     tf::StampedTransform tf_laser2base_;    
 
+    // Trk3D input, released by the TF message filter once it can be transformed to the localmap frame
+    message_filters::Subscriber<walker_msgs::Trk3DArray> sub_trk3d_;
+    boost::shared_ptr<tf2_ros::MessageFilter<walker_msgs::Trk3DArray> > trk3d_filter_ptr_;
+    localmap_utils::TfFilterCounter trk3d_counter_;
+
     // Inflation filter kernel
     std::vector<std::vector<int8_t> > inflation_kernel_;
 
@@ -67,7 +75,7 @@ public:
 };
 
 
-Scan2LocalmapNode::Scan2LocalmapNode(ros::NodeHandle nh, ros::NodeHandle pnh): nh_(nh), pnh_(pnh) {
+Scan2LocalmapNode::Scan2LocalmapNode(ros::NodeHandle nh, ros::NodeHandle pnh): nh_(nh), pnh_(pnh), trk3d_counter_("trk3d") {
     // Signal handler
     signal(SIGINT, Scan2LocalmapNode::sigint_cb);
 
@@ -83,10 +91,20 @@ Scan2LocalmapNode::Scan2LocalmapNode(ros::NodeHandle nh, ros::NodeHandle pnh): n
     ros::param::param<std::string>("~localmap_frameid", localmap_frameid_, "base_link");
     ros::param::param<std::string>("~scan_src_frameid", scan_src_frameid, "laser_link");
     ros::param::param<int>("~agf_type", agf_type_, -1);
+    double trk3d_late_threshold;
+    ros::param::param<double>("~trk3d_late_threshold", trk3d_late_threshold, 0.1);
+    trk3d_counter_.set_late_threshold(trk3d_late_threshold);
 
     // ROS publishers & subscribers
-    if(agf_type_ >= 0)
-        sub_scan_ = nh_.subscribe("trk3d_result", 1, &Scan2LocalmapNode::trk3d_cb, this);
+    tflistener_ptr_ = new tf::TransformListener();
+    if(agf_type_ >= 0) {
+        // The tracking result is only passed on once its TF is available, the callback never waits for it
+        sub_trk3d_.subscribe(nh_, "trk3d_result", 1);
+        trk3d_filter_ptr_.reset(new tf2_ros::MessageFilter<walker_msgs::Trk3DArray>(
+            sub_trk3d_, *tflistener_ptr_->getTF2BufferPtr(), localmap_frameid_, 5, nh_));
+        trk3d_filter_ptr_->registerCallback(&Scan2LocalmapNode::trk3d_cb, this);
+        trk3d_filter_ptr_->registerFailureCallback(boost::bind(&Scan2LocalmapNode::trk3d_dropped_cb, this, _1, _2));
+    }
     else
         sub_scan_ = nh_.subscribe("scan", 1, &Scan2LocalmapNode::scan_cb, this);
 
@@ -94,7 +112,6 @@ Scan2LocalmapNode::Scan2LocalmapNode(ros::NodeHandle nh, ros::NodeHandle pnh): n
     pub_footprint_ = nh_.advertise<geometry_msgs::PolygonStamped>("footprint", 1);
 
     // Prepare the transformation matrix from laser to base
-    tflistener_ptr_ = new tf::TransformListener();
     ROS_INFO("Wait for TF from laser_link to %s in 10 seconds...", localmap_frameid_.c_str());
     try{
         tflistener_ptr_->waitForTransform(localmap_frameid_, scan_src_frameid,
@@ -143,18 +160,18 @@ Scan2LocalmapNode::Scan2LocalmapNode(ros::NodeHandle nh, ros::NodeHandle pnh): n
 
 
 void Scan2LocalmapNode::trk3d_cb(const walker_msgs::Trk3DArray::ConstPtr &msg_ptr) {
-    // Get the transformation from tracking result frame to base frame
+    // Get the transformation from tracking result frame to base frame, the message filter
+    // only releases the message once it is available
     tf::StampedTransform tf_trk2base;
     try{
-        tflistener_ptr_->waitForTransform(localmap_frameid_, msg_ptr->header.frame_id,
-                                    ros::Time(), ros::Duration(0.1));
         tflistener_ptr_->lookupTransform(localmap_frameid_, msg_ptr->header.frame_id,
-                                    ros::Time(), tf_trk2base);
+                                    msg_ptr->header.stamp, tf_trk2base);
     }
     catch (tf::TransformException ex){
-        ROS_ERROR("\nCannot get TF from odom to %s: %s. Aborting...", localmap_frameid_.c_str(), ex.what());
-        exit(-1);
+        trk3d_counter_.count_dropped(msg_ptr->header, localmap_frameid_, ex.what());
+        return;
     }
+    trk3d_counter_.count_released(msg_ptr->header.stamp, ros::Time::now());
 
     // std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
     sensor_msgs::LaserScan laser_msg = msg_ptr->scan;
@@ -316,6 +333,11 @@ void Scan2LocalmapNode::scan_cb(const sensor_msgs::LaserScan &laser_msg) {
 }
 
 
+void Scan2LocalmapNode::trk3d_dropped_cb(const walker_msgs::Trk3DArray::ConstPtr &msg_ptr, tf2_ros::FilterFailureReason reason) {
+    trk3d_counter_.count_dropped(msg_ptr->header, localmap_frameid_, reason);
+}
+
+
 void Scan2LocalmapNode::sigint_cb(int sig) {
     ROS_INFO_STREAM("Node name: " << ros::this_node::getName() << " is shutdown.");
     // All the default sigint handler does is call shutdown()
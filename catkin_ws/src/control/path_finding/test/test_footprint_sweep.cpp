@@ -0,0 +1,292 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "footprint_sweep.hpp"
+
+static const int kThresObstacleDangerCost = 80;
+
+
+// Empty local map of scan2localmap_node, 10 x 10 m around base_link at 0.1 m
+static nav_msgs::OccupancyGrid MakeMap(double resolution = 0.1, int size = 100) {
+  nav_msgs::OccupancyGrid map;
+  map.header.frame_id = "base_link";
+  map.info.resolution = resolution;
+  map.info.width = size;
+  map.info.height = size;
+  map.info.origin.position.x = -resolution * size / 2;
+  map.info.origin.position.y = -resolution * size / 2;
+  map.info.origin.orientation.w = 1.0;
+  map.data.assign(size * size, 0);
+  return map;
+}
+
+
+// Footprint of the real walker, cfg/footprint.yaml
+static geometry_msgs::Polygon MakeFootprint() {
+  const double pts[6][2] = {{0.45, 0.35}, {0.65, 0.2}, {0.65, -0.2}, {0.45, -0.35}, {-0.1, -0.35}, {-0.1, 0.35}};
+  geometry_msgs::Polygon footprint;
+  for(int i = 0; i < 6; i++) {
+    geometry_msgs::Point32 pt;
+    pt.x = pts[i][0];
+    pt.y = pts[i][1];
+    footprint.points.push_back(pt);
+  }
+  return footprint;
+}
+
+
+static double CellCenter(const nav_msgs::OccupancyGrid& map, int i) {
+  return map.info.origin.position.x + (i + 0.5) * map.info.resolution;
+}
+
+
+// Straight path of poses every step, as the A* solver gives them
+static std::vector<geometry_msgs::Point> MakePath(double x0, double y0, double x1, double y1, double step) {
+  std::vector<geometry_msgs::Point> path;
+  const int num_steps = std::max(1, (int)std::round(std::hypot(x1 - x0, y1 - y0) / step));
+  for(int k = 0; k <= num_steps; k++) {
+    geometry_msgs::Point pt;
+    pt.x = x0 + (x1 - x0) * k / num_steps;
+    pt.y = y0 + (y1 - y0) * k / num_steps;
+    path.push_back(pt);
+  }
+  return path;
+}
+
+
+// The check is_path_safe did before: the max cost of a 0.6 m square around each pose
+static bool IsPathSafeDiscrete(const nav_msgs::OccupancyGrid& map, const std::vector<geometry_msgs::Point>& path) {
+  const int map_width = map.info.width;
+  const int max_map_idx = map.info.width * map.info.height - 1;
+  int kernel_size = int(std::floor(0.6 / map.info.resolution));
+  kernel_size = kernel_size + (kernel_size % 2 == 0);
+  const int bound = kernel_size / 2;
+  for(int i = 0; i < path.size(); i++) {
+    const int map_x = std::round((path[i].x - map.info.origin.position.x) / map.info.resolution);
+    const int map_y = std::round((path[i].y - map.info.origin.position.y) / map.info.resolution);
+    const int idx = map_y * map_width + map_x;
+    int cost = 0;
+    for(int y = -bound; y <= bound; y++) {
+      for(int x = -bound; x <= bound; x++) {
+        const int op_idx = idx + x + map_width * y;
+        if(op_idx < 0 || op_idx > max_map_idx) continue;
+        else if(std::abs((op_idx % map_width) - (idx % map_width)) > bound) continue;
+        cost = std::max(cost, (int)map.data[op_idx]);
+      }
+    }
+    if(cost >= kThresObstacleDangerCost || map.data[idx] < 0)
+      return false;
+  }
+  return true;
+}
+
+
+// Wall across the x axis at x, one cell thick, open for the cells of y from gap_min to gap_max
+static void AddWall(nav_msgs::OccupancyGrid& map, double x, double gap_min, double gap_max) {
+  const int map_x = std::floor((x - map.info.origin.position.x) / map.info.resolution);
+  for(int j = 0; j < map.info.height; j++) {
+    const double y = CellCenter(map, j);
+    if(y < gap_min || y > gap_max)
+      map.data[j * map.info.width + map_x] = 100;
+  }
+}
+
+
+class FootprintSweepTest: public ::testing::Test {
+  protected:
+  void SetUp() {
+    map_ = MakeMap();
+    sweep_.SetFootprint(MakeFootprint(), map_.info.resolution);
+  }
+
+  bool IsInMask(int heading_bin, double x, double y) {
+    const int cell_x = std::floor(x / map_.info.resolution + 0.5);
+    const int cell_y = std::floor(y / map_.info.resolution + 0.5);
+    const std::vector<std::pair<int, int> >& mask = sweep_.GetMask(heading_bin);
+    return std::find(mask.begin(), mask.end(), std::make_pair(cell_x, cell_y)) != mask.end();
+  }
+
+  nav_msgs::OccupancyGrid map_;
+  footprint_sweep::SweptFootprint sweep_;
+};
+
+
+TEST_F(FootprintSweepTest, MasksFollowTheHeading) {
+  ASSERT_TRUE(sweep_.IsReady());
+  ASSERT_EQ(sweep_.GetNumHeadings(), 64);
+  EXPECT_LT(sweep_.GetMargin(), 0.15);
+
+  // Forward, the footprint is longer in x
+  const int forward = sweep_.GetHeadingBin(0.0);
+  EXPECT_TRUE(IsInMask(forward, 0.6, 0.0));
+  EXPECT_TRUE(IsInMask(forward, -0.1, 0.3));
+  EXPECT_FALSE(IsInMask(forward, 1.0, 0.0));
+  EXPECT_FALSE(IsInMask(forward, 0.0, 0.7));
+
+  // Heading left, the same footprint turned by 90 degrees
+  const int left = sweep_.GetHeadingBin(M_PI / 2);
+  EXPECT_EQ(left, 16);
+  EXPECT_TRUE(IsInMask(left, 0.0, 0.6));
+  EXPECT_TRUE(IsInMask(left, -0.3, -0.1));
+  EXPECT_FALSE(IsInMask(left, 0.0, 1.0));
+  EXPECT_FALSE(IsInMask(left, 0.7, 0.0));
+  EXPECT_EQ(sweep_.GetHeadingBin(-M_PI / 2), 48);
+  EXPECT_EQ(sweep_.GetHeadingBin(M_PI), sweep_.GetHeadingBin(-M_PI));
+}
+
+
+TEST_F(FootprintSweepTest, ThinObstacleBetweenPoses) {
+  AddWall(map_, 1.0, 10.0, 10.0);
+  const std::vector<geometry_msgs::Point> path = MakePath(0.0, 0.0, 2.0, 0.0, 2.0);
+  ASSERT_EQ(path.size(), 2);
+  // Missed by the poses, not by the sweep
+  EXPECT_TRUE(IsPathSafeDiscrete(map_, path));
+  EXPECT_EQ(sweep_.FindFirstCollision(map_, path, kThresObstacleDangerCost), 0);
+}
+
+
+TEST_F(FootprintSweepTest, NarrowGap) {
+  const std::vector<geometry_msgs::Point> path = MakePath(-1.0, 0.0, 3.0, 0.0, 0.1);
+
+  // 0.7 m open, as wide as the walker: the 0.6 m square of the poses goes through
+  nav_msgs::OccupancyGrid narrow_map = map_;
+  AddWall(narrow_map, 1.5, -0.3, 0.4);
+  EXPECT_TRUE(IsPathSafeDiscrete(narrow_map, path));
+  EXPECT_FALSE(sweep_.IsPathSafe(narrow_map, path, kThresObstacleDangerCost));
+
+  // 1.4 m open
+  nav_msgs::OccupancyGrid wide_map = map_;
+  AddWall(wide_map, 1.5, -0.7, 0.7);
+  EXPECT_TRUE(IsPathSafeDiscrete(wide_map, path));
+  EXPECT_TRUE(sweep_.IsPathSafe(wide_map, path, kThresObstacleDangerCost));
+
+  // Costs under the threshold are free
+  std::replace(narrow_map.data.begin(), narrow_map.data.end(), (int8_t)100, (int8_t)(kThresObstacleDangerCost - 1));
+  EXPECT_TRUE(sweep_.IsPathSafe(narrow_map, path, kThresObstacleDangerCost));
+}
+
+
+TEST_F(FootprintSweepTest, DiagonalCorridor) {
+  // Walls outside of a corridor along y = x
+  auto make_corridor = [this](double width) {
+    nav_msgs::OccupancyGrid map = map_;
+    for(int j = 0; j < map.info.height; j++) {
+      for(int i = 0; i < map.info.width; i++) {
+        if(std::abs(CellCenter(map, j) - CellCenter(map, i)) / std::sqrt(2.0) > width / 2)
+          map.data[j * map.info.width + i] = 100;
+      }
+    }
+    return map;
+  };
+  const std::vector<geometry_msgs::Point> path = MakePath(-2.0, -2.0, 2.0, 2.0, 0.1 * std::sqrt(2.0));
+
+  const nav_msgs::OccupancyGrid wide_map = make_corridor(1.4);
+  EXPECT_TRUE(sweep_.IsPathSafe(wide_map, path, kThresObstacleDangerCost));
+
+  // The walker along the corridor is 0.7 m wide, more than the diagonal of the 0.6 m square
+  const nav_msgs::OccupancyGrid narrow_map = make_corridor(0.9);
+  EXPECT_TRUE(IsPathSafeDiscrete(narrow_map, path));
+  EXPECT_FALSE(sweep_.IsPathSafe(narrow_map, path, kThresObstacleDangerCost));
+
+  // Leaving the corridor along the x axis, the corners of the walker go through its wall
+  std::vector<geometry_msgs::Point> turn_path = MakePath(-2.0, -2.0, 0.0, 0.0, 0.1 * std::sqrt(2.0));
+  const std::vector<geometry_msgs::Point> straight_path = MakePath(0.0, 0.0, 0.5, 0.0, 0.1);
+  turn_path.insert(turn_path.end(), straight_path.begin() + 1, straight_path.end());
+  EXPECT_FALSE(sweep_.IsPathSafe(wide_map, turn_path, kThresObstacleDangerCost));
+}
+
+
+TEST_F(FootprintSweepTest, InitialTurn) {
+  // Obstacle 0.75 m away at 45 degrees on the left, clear of the walker heading along x or y but
+  // not of its front corners turning from one to the other
+  const int cell_x = std::floor((0.53 - map_.info.origin.position.x) / map_.info.resolution);
+  const int cell_y = std::floor((0.53 - map_.info.origin.position.y) / map_.info.resolution);
+  map_.data[cell_y * map_.info.width + cell_x] = 100;
+
+  // A new path from base_link starts at heading 0 (x), the turn to the first segment is swept
+  EXPECT_TRUE(sweep_.IsPathSafe(map_, MakePath(0.0, 0.0, 2.0, 0.0, 0.1), kThresObstacleDangerCost, 0.0));
+  EXPECT_EQ(sweep_.FindFirstCollision(map_, MakePath(0.0, 0.0, 0.0, 2.0, 0.1), kThresObstacleDangerCost, 0.0), 0);
+  // Turning right, away from it
+  EXPECT_TRUE(sweep_.IsPathSafe(map_, MakePath(0.0, 0.0, 0.0, -2.0, 0.1), kThresObstacleDangerCost, 0.0));
+  // Already heading along the first segment
+  EXPECT_TRUE(sweep_.IsPathSafe(map_, MakePath(0.0, 0.0, 0.0, 2.0, 0.1), kThresObstacleDangerCost));
+}
+
+
+TEST_F(FootprintSweepTest, FollowedPathHasTurned) {
+  // The walker came up a 1.2 m corridor along y at x = -1 and turned along x at (-1, 0). The path
+  // it follows is in its current base_link frame, the first pose behind it in the corridor.
+  for(int j = 0; j < map_.info.height; j++) {
+    if(CellCenter(map_, j) > -1.0)
+      continue;
+    for(double x : {-1.65, -0.35}) {
+      const int i = std::floor((x - map_.info.origin.position.x) / map_.info.resolution);
+      map_.data[j * map_.info.width + i] = 100;
+    }
+  }
+  std::vector<geometry_msgs::Point> path = MakePath(-1.0, -2.0, -1.0, 0.0, 0.1);
+  const std::vector<geometry_msgs::Point> straight_path = MakePath(-1.0, 0.0, 3.0, 0.0, 0.1);
+  path.insert(path.end(), straight_path.begin() + 1, straight_path.end());
+
+  // The walker went along the first segment, its turn at (-1, 0) is in the open
+  EXPECT_TRUE(sweep_.IsPathSafe(map_, path, kThresObstacleDangerCost));
+  // A turn from the current heading at the first pose, which never happens, meets the corridor
+  EXPECT_EQ(sweep_.FindFirstCollision(map_, path, kThresObstacleDangerCost, 0.0), 0);
+}
+
+
+TEST_F(FootprintSweepTest, FirstViolation) {
+  AddWall(map_, 1.0, -0.7, 0.7);
+  AddWall(map_, 2.0, 10.0, 10.0);
+  AddWall(map_, 3.0, 10.0, 10.0);
+  const std::vector<geometry_msgs::Point> path = MakePath(0.0, 0.0, 4.0, 0.0, 0.5);
+  // The footprint reaches 0.65 m ahead, and more with the margin
+  const int segment = sweep_.FindFirstCollision(map_, path, kThresObstacleDangerCost);
+  EXPECT_GE(segment, 1);
+  EXPECT_LE(segment, 3);
+  EXPECT_LT(path[segment].x, 2.0);
+
+  // Unknown cell under the pose at x = 1.05, reached by the segment before it
+  nav_msgs::OccupancyGrid unknown_map = MakeMap();
+  unknown_map.data[50 * unknown_map.info.width + 60] = -1;
+  EXPECT_EQ(sweep_.FindFirstCollision(unknown_map, MakePath(0.05, 0.05, 2.05, 0.05, 0.1), kThresObstacleDangerCost), 9);
+
+  // Single pose, and out of the map
+  std::vector<geometry_msgs::Point> pose(1);
+  pose[0].x = 1.5;
+  EXPECT_EQ(sweep_.FindFirstCollision(map_, pose, kThresObstacleDangerCost), 0);
+  pose[0].x = -20.0;
+  EXPECT_EQ(sweep_.FindFirstCollision(map_, pose, kThresObstacleDangerCost), -1);
+  EXPECT_EQ(sweep_.FindFirstCollision(map_, std::vector<geometry_msgs::Point>(), kThresObstacleDangerCost), -1);
+}
+
+
+TEST_F(FootprintSweepTest, Timing) {
+  // A safe 5.7 m path, every pose is checked by both
+  const std::vector<geometry_msgs::Point> path = MakePath(0.0, 0.0, 4.0, 4.0, 0.1 * std::sqrt(2.0));
+  ASSERT_TRUE(IsPathSafeDiscrete(map_, path));
+  ASSERT_TRUE(sweep_.IsPathSafe(map_, path, kThresObstacleDangerCost));
+
+  const int num_runs = 1000;
+  int num_safe = 0;
+  std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+  for(int i = 0; i < num_runs; i++)
+    num_safe += IsPathSafeDiscrete(map_, path);
+  std::chrono::steady_clock::time_point middle = std::chrono::steady_clock::now();
+  for(int i = 0; i < num_runs; i++)
+    num_safe += sweep_.IsPathSafe(map_, path, kThresObstacleDangerCost);
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+  EXPECT_EQ(num_safe, 2 * num_runs);
+
+  const double discrete_us = std::chrono::duration<double, std::micro>(middle - begin).count() / num_runs;
+  const double sweep_us = std::chrono::duration<double, std::micro>(end - middle).count() / num_runs;
+  std::cout << path.size() << " poses: discrete check " << discrete_us << " us, swept footprint "
+            << sweep_us << " us" << std::endl;
+  // Well within a planning step of 0.5 s
+  EXPECT_LT(sweep_us, 5000.0);
+}
@@ -0,0 +1,196 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include <ros/ros.h>
+#include <rosbag/bag.h>
+#include <rosbag/view.h>
+#include <nav_msgs/OccupancyGrid.h>
+#include <tf2_msgs/TFMessage.h>
+#include <walker_msgs/Trk3DArray.h>
+
+#include "localmap_utils.hpp"
+
+// Bag of the trk3d input of scan2localmap_node at 20 Hz in the odom frame, with the odom to
+// base_link TF recorded kTfDelay after the stamp it carries, as a lagging localization sends it.
+// The TF is missing for a second in the middle of the bag.
+static const double kRate = 20.0;
+static const double kDuration = 6.0;
+static const double kTfDelay = 0.15;           // within the queue of the message filter (5 messages)
+static const double kOutageBegin = 2.0;
+static const double kOutageEnd = 3.0;
+static const ros::Time kBagBegin(1000.0);
+
+
+static walker_msgs::Trk3DArray MakeTrk3d(const ros::Time& stamp) {
+  walker_msgs::Trk3DArray msg;
+  msg.header.stamp = stamp;
+  msg.header.frame_id = "odom";
+
+  walker_msgs::Trk3D trk;
+  trk.x = 2.0;
+  trk.vx = 1.0;
+  trk.radius = 0.3;
+  trk.confidence = 1.0;
+  msg.trks_list.push_back(trk);
+
+  msg.scan.header = msg.header;
+  msg.scan.header.frame_id = "laser_link";
+  msg.scan.angle_min = -M_PI / 2;
+  msg.scan.angle_max = M_PI / 2;
+  msg.scan.angle_increment = M_PI / 90;
+  msg.scan.range_min = 0.1;
+  msg.scan.range_max = 10.0;
+  msg.scan.ranges.assign(91, 3.0);
+  return msg;
+}
+
+
+static tf2_msgs::TFMessage MakeTf(const ros::Time& stamp) {
+  geometry_msgs::TransformStamped tf;
+  tf.header.stamp = stamp;
+  tf.header.frame_id = "base_link";
+  tf.child_frame_id = "odom";
+  tf.transform.translation.x = -0.5 * (stamp - kBagBegin).toSec();     // walker moving at 0.5 m/s
+  tf.transform.rotation.w = 1.0;
+  tf2_msgs::TFMessage msg;
+  msg.transforms.push_back(tf);
+  return msg;
+}
+
+
+static std::string WriteBag() {
+  const std::string path = "/tmp/path_finding_delayed_tf_" + std::to_string(getpid()) + ".bag";
+  rosbag::Bag bag(path, rosbag::bagmode::Write);
+  const int num_msgs = kDuration * kRate;
+  for(int i = 0; i < num_msgs; i++) {
+    const double t = i / kRate;
+    const ros::Time stamp = kBagBegin + ros::Duration(t);
+    bag.write("trk3d_result", stamp, MakeTrk3d(stamp));
+    if(t < kOutageBegin || t >= kOutageEnd)
+      bag.write("/tf", stamp + ros::Duration(kTfDelay), MakeTf(stamp));
+  }
+  bag.close();
+  return path;
+}
+
+
+class TfMessageFilterTest : public testing::Test {
+  protected:
+  void SetUp() override {
+    pub_trk3d_ = nh_.advertise<walker_msgs::Trk3DArray>("trk3d_result", 10);
+    pub_tf_ = nh_.advertise<tf2_msgs::TFMessage>("/tf", 100);
+    sub_map_ = nh_.subscribe("local_map", 10, &TfMessageFilterTest::MapCb, this);
+  }
+
+  void MapCb(const nav_msgs::OccupancyGrid::ConstPtr&) {
+    map_times_.push_back((ros::Time::now() - replay_begin_).toSec());
+  }
+
+  bool WaitForConnections(double timeout) {
+    const ros::Time deadline = ros::Time::now() + ros::Duration(timeout);
+    while(ros::ok() && ros::Time::now() < deadline) {
+      if(pub_trk3d_.getNumSubscribers() > 0 && pub_tf_.getNumSubscribers() > 0 && sub_map_.getNumPublishers() > 0)
+        return true;
+      ros::Duration(0.1).sleep();
+    }
+    return false;
+  }
+
+  // Publishes the messages of the bag at their record times from now, with the stamps moved
+  // by the same offset
+  void Replay(const std::string& path) {
+    rosbag::Bag bag(path, rosbag::bagmode::Read);
+    rosbag::View view(bag);
+    replay_begin_ = ros::Time::now();
+    const ros::Duration offset = replay_begin_ - kBagBegin;
+    for(const rosbag::MessageInstance& m : view) {
+      ros::Time::sleepUntil(m.getTime() + offset);
+      if(m.getTopic() == "/tf") {
+        tf2_msgs::TFMessage::Ptr msg = m.instantiate<tf2_msgs::TFMessage>();
+        for(int i = 0; i < msg->transforms.size(); i++)
+          msg->transforms[i].header.stamp += offset;
+        pub_tf_.publish(msg);
+      }
+      else {
+        walker_msgs::Trk3DArray::Ptr msg = m.instantiate<walker_msgs::Trk3DArray>();
+        msg->header.stamp += offset;
+        msg->scan.header.stamp += offset;
+        pub_trk3d_.publish(msg);
+      }
+    }
+    bag.close();
+    // Let the last messages through
+    ros::Duration(2.0 * kTfDelay + 0.5).sleep();
+  }
+
+  ros::NodeHandle nh_;
+  ros::Publisher pub_trk3d_;
+  ros::Publisher pub_tf_;
+  ros::Subscriber sub_map_;
+  ros::Time replay_begin_;
+  std::vector<double> map_times_;       // arrival of the local maps from the replay begin
+};
+
+
+TEST(TfFilterCounterTest, Counts) {
+  localmap_utils::TfFilterCounter counter("trk3d", 0.1);
+  const ros::Time now(100.0);
+  counter.count_released(now - ros::Duration(0.05), now);
+  counter.count_released(now - ros::Duration(0.3), now);
+  counter.count_released(ros::Time(0), now);      // unstamped, never late
+
+  std_msgs::Header header;
+  header.stamp = now;
+  header.frame_id = "odom";
+  counter.count_dropped(header, "base_link", tf2_ros::filter_failure_reasons::Unknown);
+  counter.count_dropped(header, "base_link", "lookup failed");
+
+  EXPECT_EQ(counter.get_released(), 3);
+  EXPECT_EQ(counter.get_late(), 1);
+  EXPECT_EQ(counter.get_dropped(), 2);
+}
+
+
+TEST_F(TfMessageFilterTest, CallbackNeverWaitsForTf) {
+  const std::string path = WriteBag();
+  ASSERT_TRUE(WaitForConnections(15.0));
+  ros::AsyncSpinner spinner(1);
+  spinner.start();
+  Replay(path);
+  spinner.stop();
+  std::remove(path.c_str());
+
+  // Every message with its TF gets a local map, the queue of the filter covers the delay
+  const int num_with_tf = (kDuration - (kOutageEnd - kOutageBegin)) * kRate;
+  EXPECT_GE(map_times_.size(), 0.9 * num_with_tf);
+
+  // While the TF flows, the local maps come at the input rate: a callback that waited for TF
+  // would hold back the next messages
+  double max_gap = 0.0;
+  for(int i = 1; i < map_times_.size(); i++) {
+    const bool steady = (map_times_[i - 1] > 1.0 && map_times_[i] < kOutageBegin + kTfDelay) ||
+                        (map_times_[i - 1] > kOutageEnd + 1.0 && map_times_[i] < kDuration);
+    if(steady)
+      max_gap = std::max(max_gap, map_times_[i] - map_times_[i - 1]);
+  }
+  EXPECT_LT(max_gap, 3.0 / kRate);
+
+  // The first local map after the outage follows the first TF after it
+  std::vector<double>::const_iterator first_after_outage =
+      std::upper_bound(map_times_.begin(), map_times_.end(), kOutageEnd);
+  ASSERT_TRUE(first_after_outage != map_times_.end());
+  EXPECT_LT(*first_after_outage, kOutageEnd + kTfDelay + 0.3);
+}
+
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  ros::init(argc, argv, "test_tf_message_filter");
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,240 @@
+#include "cubic_spline.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace cubic_spline {
+
+Spline::Spline(const std::vector<double> &x, const std::vector<double> &y): x_(x), a_(y) {
+  const int nx = x.size();
+  if(nx < 2) {
+    b_.assign(nx, 0.0);
+    c_.assign(nx, 0.0);
+    d_.assign(nx, 0.0);
+    return;
+  }
+  std::vector<double> h(nx - 1);
+  for(int i = 0; i < nx - 1; i++)
+    h[i] = x[i + 1] - x[i];
+
+  // Tridiagonal system A c = B of the natural spline (c[0] = c[nx - 1] = 0),
+  // forward sweep of the Thomas algorithm
+  std::vector<double> sup(nx, 0.0), rhs(nx, 0.0);
+  for(int i = 1; i < nx - 1; i++) {
+    double sub = h[i - 1];
+    double diag = 2.0 * (h[i - 1] + h[i]);
+    double b = 3.0 * (a_[i + 1] - a_[i]) / h[i] - 3.0 * (a_[i] - a_[i - 1]) / h[i - 1];
+    double denom = diag - sub * sup[i - 1];
+    sup[i] = h[i] / denom;
+    rhs[i] = (b - sub * rhs[i - 1]) / denom;
+  }
+  // Back substitution
+  c_.assign(nx, 0.0);
+  for(int i = nx - 2; i >= 1; i--)
+    c_[i] = rhs[i] - sup[i] * c_[i + 1];
+
+  b_.resize(nx - 1);
+  d_.resize(nx - 1);
+  for(int i = 0; i < nx - 1; i++) {
+    d_[i] = (c_[i + 1] - c_[i]) / (3.0 * h[i]);
+    b_[i] = (a_[i + 1] - a_[i]) / h[i] - h[i] * (c_[i + 1] + 2.0 * c_[i]) / 3.0;
+  }
+}
+
+
+void Spline::evaluate(int i, double dt, double &value, double &d1, double &d2) const {
+  if(x_.size() < 2) {
+    value = a_.empty() ? 0.0 : a_[0];
+    d1 = d2 = 0.0;
+    return;
+  }
+  value = a_[i] + (b_[i] + (c_[i] + d_[i] * dt) * dt) * dt;
+  d1 = b_[i] + (2.0 * c_[i] + 3.0 * d_[i] * dt) * dt;
+  d2 = 2.0 * c_[i] + 6.0 * d_[i] * dt;
+}
+
+
+int Spline::search_index(double t) const {
+  // bisect.bisect(x, t) - 1, restricted to a valid segment
+  int i = std::upper_bound(x_.begin(), x_.end(), t) - x_.begin() - 1;
+  return std::max(0, std::min(i, (int)x_.size() - 2));
+}
+
+
+double Spline::calc(double t) const {
+  if(x_.size() < 2)
+    return a_.empty() ? 0.0 : a_[0];
+  int i = search_index(t);
+  double dx = std::max(x_.front(), std::min(t, x_.back())) - x_[i];
+  return a_[i] + b_[i] * dx + c_[i] * dx * dx + d_[i] * dx * dx * dx;
+}
+
+
+double Spline::calcd(double t) const {
+  if(x_.size() < 2)
+    return 0.0;
+  int i = search_index(t);
+  double dx = std::max(x_.front(), std::min(t, x_.back())) - x_[i];
+  return b_[i] + 2.0 * c_[i] * dx + 3.0 * d_[i] * dx * dx;
+}
+
+
+double Spline::calcdd(double t) const {
+  if(x_.size() < 2)
+    return 0.0;
+  int i = search_index(t);
+  double dx = std::max(x_.front(), std::min(t, x_.back())) - x_[i];
+  return 2.0 * c_[i] + 6.0 * d_[i] * dx;
+}
+
+
+Spline2D::Spline2D(const std::vector<double> &x, const std::vector<double> &y) {
+  // Consecutive duplicated waypoints would give zero length segments
+  std::vector<double> wx, wy;
+  wx.reserve(x.size());
+  wy.reserve(y.size());
+  s_.reserve(x.size());
+  for(int i = 0; i < x.size() && i < y.size(); i++) {
+    if(!wx.empty() && x[i] == wx.back() && y[i] == wy.back())
+      continue;
+    s_.push_back(wx.empty() ? 0.0 : s_.back() + std::hypot(x[i] - wx.back(), y[i] - wy.back()));
+    wx.push_back(x[i]);
+    wy.push_back(y[i]);
+  }
+  sx_ = Spline(s_, wx);
+  sy_ = Spline(s_, wy);
+}
+
+
+void Spline2D::calc_position(double s, double &x, double &y) const {
+  x = sx_.calc(s);
+  y = sy_.calc(s);
+}
+
+
+double Spline2D::calc_yaw(double s) const {
+  return std::atan2(sy_.calcd(s), sx_.calcd(s));
+}
+
+
+double Spline2D::calc_curvature(double s) const {
+  double dx = sx_.calcd(s), ddx = sx_.calcdd(s);
+  double dy = sy_.calcd(s), ddy = sy_.calcdd(s);
+  return (ddy * dx - ddx * dy) / std::pow(dx * dx + dy * dy, 1.5);
+}
+
+
+void Spline2D::calc_course(double ds, std::vector<double> &rx, std::vector<double> &ry,
+                           std::vector<double> &ryaw, std::vector<double> &rk, std::vector<double> &rs) const {
+  // np.arange(0, length, ds)
+  const int num_samples = (ds > 0.0 && s_.size() >= 2) ? std::ceil(length() / ds) : 0;
+  rx.resize(num_samples);
+  ry.resize(num_samples);
+  ryaw.resize(num_samples);
+  rk.resize(num_samples);
+  rs.resize(num_samples);
+
+  // Samples are increasing, the segment only moves forward (same as bisect for each sample)
+  const int last_segment = (int)s_.size() - 2;
+  int i = 0;
+  for(int k = 0; k < num_samples; k++) {
+    double s = k * ds;
+    while(i < last_segment && s_[i + 1] <= s)
+      i++;
+    double dx, ddx, dy, ddy;
+    sx_.evaluate(i, s - s_[i], rx[k], dx, ddx);
+    sy_.evaluate(i, s - s_[i], ry[k], dy, ddy);
+    rs[k] = s;
+    ryaw[k] = std::atan2(dy, dx);
+    rk[k] = (ddy * dx - ddx * dy) / std::pow(dx * dx + dy * dy, 1.5);
+  }
+}
+
+
+double Spline2D::refine_nearest(double x, double y, double s) const {
+  // Newton iterations on f(s) = |p(s) - q|^2 / 2: f' = (p - q).p', f'' = p'.p' + (p - q).p''
+  const int kMaxIterations = 20;
+  const double kTolerance = 1e-10;
+  s = std::max(0.0, std::min(s, length()));
+  for(int iter = 0; iter < kMaxIterations; iter++) {
+    int i = sx_.search_index(s);
+    double px, dx, ddx, py, dy, ddy;
+    sx_.evaluate(i, s - s_[i], px, dx, ddx);
+    sy_.evaluate(i, s - s_[i], py, dy, ddy);
+    double ex = px - x, ey = py - y;
+    double grad = ex * dx + ey * dy;
+    double hess = dx * dx + dy * dy + ex * ddx + ey * ddy;
+    if(hess <= 1e-12)
+      hess = dx * dx + dy * dy;    // Not locally convex, gradient step
+    if(hess <= 1e-12)
+      break;
+    double next_s = std::max(0.0, std::min(s - grad / hess, length()));
+    bool converged = std::fabs(next_s - s) < kTolerance;
+    s = next_s;
+    if(converged)
+      break;
+  }
+  return s;
+}
+
+
+double Spline2D::calc_nearest(double x, double y, double &crosstrack_error, double s_guess) const {
+  crosstrack_error = 0.0;
+  if(s_.size() < 2) {
+    if(!s_.empty()) {
+      double px, py;
+      calc_position(0.0, px, py);
+      crosstrack_error = std::hypot(x - px, y - py);
+    }
+    return 0.0;
+  }
+
+  double s;
+  if(s_guess >= 0.0) {
+    s = refine_nearest(x, y, s_guess);
+  }
+  else {
+    // Coarse sampling at the knots and the segment midpoints, then refine every local minimum
+    // of the sampled distance since far from the spline there may be several basins
+    const int num_samples = 2 * s_.size() - 1;
+    std::vector<double> sample_s(num_samples), sample_dist2(num_samples);
+    for(int k = 0; k < num_samples; k++) {
+      sample_s[k] = (k % 2 == 0) ? s_[k / 2] : 0.5 * (s_[k / 2] + s_[k / 2 + 1]);
+      double px, py;
+      calc_position(sample_s[k], px, py);
+      sample_dist2[k] = (x - px) * (x - px) + (y - py) * (y - py);
+    }
+    double min_dist2 = INFINITY;
+    s = 0.0;
+    for(int k = 0; k < num_samples; k++) {
+      if((k > 0 && sample_dist2[k - 1] < sample_dist2[k]) ||
+         (k + 1 < num_samples && sample_dist2[k + 1] < sample_dist2[k]))
+        continue;
+      double sk = refine_nearest(x, y, sample_s[k]);
+      double px, py;
+      calc_position(sk, px, py);
+      double dist2 = (x - px) * (x - px) + (y - py) * (y - py);
+      if(dist2 < min_dist2) {
+        min_dist2 = dist2;
+        s = sk;
+      }
+    }
+  }
+
+  double px, py;
+  calc_position(s, px, py);
+  double yaw = calc_yaw(s);
+  crosstrack_error = std::cos(yaw) * (y - py) - std::sin(yaw) * (x - px);
+  return s;
+}
+
+
+void calc_spline_course(const std::vector<double> &x, const std::vector<double> &y, double ds,
+                        std::vector<double> &rx, std::vector<double> &ry,
+                        std::vector<double> &ryaw, std::vector<double> &rk,
+                        std::vector<double> &rs) {
+  Spline2D sp(x, y);
+  sp.calc_course(ds, rx, ry, ryaw, rk, rs);
+}
+
+} // namespace cubic_spline
@@ -0,0 +1,75 @@
+#ifndef PATH_TRACKING_CUBIC_SPLINE_HPP
+#define PATH_TRACKING_CUBIC_SPLINE_HPP
+
+#include <vector>
+
+namespace cubic_spline {
+
+// Natural cubic spline y(t), same as cubic_spline_planner.Spline.
+// The tridiagonal system of the c coefficients is solved with the Thomas algorithm in O(n).
+class Spline {
+public:
+  Spline() {}
+  Spline(const std::vector<double> &x, const std::vector<double> &y);
+
+  // Value, first and second derivatives, t is clamped to [x.front(), x.back()]
+  double calc(double t) const;
+  double calcd(double t) const;
+  double calcdd(double t) const;
+
+  // Segment index i such that x[i] <= t < x[i + 1]
+  int search_index(double t) const;
+
+  // Value and derivatives at x[i] + dt, without searching the segment
+  void evaluate(int i, double dt, double &value, double &d1, double &d2) const;
+
+private:
+  std::vector<double> x_;
+  std::vector<double> a_, b_, c_, d_;
+};
+
+
+// 2D cubic spline parameterized by the cumulative chord length s, same as
+// cubic_spline_planner.Spline2D. Consecutive duplicated waypoints are dropped.
+class Spline2D {
+public:
+  Spline2D(const std::vector<double> &x, const std::vector<double> &y);
+
+  void calc_position(double s, double &x, double &y) const;
+  double calc_yaw(double s) const;
+  double calc_curvature(double s) const;
+
+  // Sample position, yaw and curvature every ds of arc length, s = 0, ds, 2 ds, ... < length().
+  // The segments are walked once, O(n + number of samples).
+  void calc_course(double ds, std::vector<double> &rx, std::vector<double> &ry,
+                   std::vector<double> &ryaw, std::vector<double> &rk, std::vector<double> &rs) const;
+
+  // Arc length of the point of the spline closest to (x, y), with Newton iterations on the
+  // squared distance starting from s_guess (e.g. the previous projection), or from the local
+  // minima of the distance to the knots and segment midpoints if s_guess < 0.
+  // crosstrack_error is the signed distance, positive on the left of the spline.
+  double calc_nearest(double x, double y, double &crosstrack_error, double s_guess = -1.0) const;
+
+  double length() const { return s_.empty() ? 0.0 : s_.back(); }
+  const std::vector<double> &s() const { return s_; }
+
+private:
+  double refine_nearest(double x, double y, double s) const;
+
+  std::vector<double> s_;
+  Spline sx_, sy_;
+};
+
+
+// Same as cubic_spline_planner.calc_spline_course: sample the spline through the
+// waypoints every ds of arc length, s = 0, ds, 2 ds, ... < length.
+// Consecutive duplicated waypoints are dropped (the python version divides by zero).
+// Fewer than 2 distinct waypoints give an empty course.
+void calc_spline_course(const std::vector<double> &x, const std::vector<double> &y, double ds,
+                        std::vector<double> &rx, std::vector<double> &ry,
+                        std::vector<double> &ryaw, std::vector<double> &rk,
+                        std::vector<double> &rs);
+
+} // namespace cubic_spline
+
+#endif
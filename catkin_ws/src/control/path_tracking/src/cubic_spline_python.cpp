@@ -0,0 +1,73 @@
+// Python module cubic_spline_cpp, drop-in replacement of cubic_spline_planner:
+//   import cubic_spline_cpp as cubic_spline_planner
+//   cx, cy, cyaw, ck, s = cubic_spline_planner.calc_spline_course(x, y, ds=0.1)
+#include <vector>
+
+#include <boost/python.hpp>
+
+#include "cubic_spline.hpp"
+
+namespace bp = boost::python;
+
+
+// Any python sequence of numbers (list, tuple, numpy array)
+static std::vector<double> to_vector(const bp::object &seq) {
+  std::vector<double> v(bp::len(seq));
+  for(int i = 0; i < v.size(); i++)
+    v[i] = bp::extract<double>(seq[i]);
+  return v;
+}
+
+
+static bp::list to_list(const std::vector<double> &v) {
+  bp::list l;
+  for(int i = 0; i < v.size(); i++)
+    l.append(v[i]);
+  return l;
+}
+
+
+static bp::tuple calc_spline_course(const bp::object &x, const bp::object &y, double ds) {
+  std::vector<double> rx, ry, ryaw, rk, rs;
+  cubic_spline::calc_spline_course(to_vector(x), to_vector(y), ds, rx, ry, ryaw, rk, rs);
+  return bp::make_tuple(to_list(rx), to_list(ry), to_list(ryaw), to_list(rk), to_list(rs));
+}
+
+
+static cubic_spline::Spline2D *make_spline_2d(const bp::object &x, const bp::object &y) {
+  return new cubic_spline::Spline2D(to_vector(x), to_vector(y));
+}
+
+
+static bp::tuple spline_2d_calc_position(const cubic_spline::Spline2D &sp, double s) {
+  double x, y;
+  sp.calc_position(s, x, y);
+  return bp::make_tuple(x, y);
+}
+
+
+static bp::tuple spline_2d_calc_nearest(const cubic_spline::Spline2D &sp, double x, double y, double s_guess) {
+  double crosstrack_error;
+  double s = sp.calc_nearest(x, y, crosstrack_error, s_guess);
+  return bp::make_tuple(s, crosstrack_error);
+}
+
+
+static bp::list spline_2d_s(const cubic_spline::Spline2D &sp) {
+  return to_list(sp.s());
+}
+
+
+BOOST_PYTHON_MODULE(cubic_spline_cpp)
+{
+  bp::def("calc_spline_course", &calc_spline_course, (bp::arg("x"), bp::arg("y"), bp::arg("ds") = 0.1));
+
+  bp::class_<cubic_spline::Spline2D>("Spline2D", bp::no_init)
+    .def("__init__", bp::make_constructor(&make_spline_2d))
+    .def("calc_position", &spline_2d_calc_position)
+    .def("calc_yaw", &cubic_spline::Spline2D::calc_yaw)
+    .def("calc_curvature", &cubic_spline::Spline2D::calc_curvature)
+    .def("calc_nearest", &spline_2d_calc_nearest, (bp::arg("x"), bp::arg("y"), bp::arg("s_guess") = -1.0))
+    .add_property("s", &spline_2d_s)
+    .add_property("length", &cubic_spline::Spline2D::length);
+}
@@ -0,0 +1,238 @@
+#include <cmath>
+#include <vector>
+
+// ROS
+#include <ros/ros.h>
+#include <geometry_msgs/PointStamped.h>
+#include <geometry_msgs/PoseStamped.h>
+#include <geometry_msgs/Twist.h>
+#include <geometry_msgs/WrenchStamped.h>
+#include <nav_msgs/Odometry.h>
+#include <nav_msgs/Path.h>
+#include <std_msgs/Float32.h>
+#include <message_filters/subscriber.h>
+#include <message_filters/synchronizer.h>
+#include <message_filters/sync_policies/approximate_time.h>
+#include <tf/transform_datatypes.h>
+
+// Custom library
+#include "cubic_spline.hpp"
+#include "steering_controller.hpp"
+
+typedef message_filters::sync_policies::ApproximateTime<geometry_msgs::WrenchStamped, nav_msgs::Odometry> ForceOdomPolicy;
+
+static const double kRobotRefLength = 0.6;  // [m] Wheel base of vehicle
+
+
+// C++ version of steering_control_with_user_pushing_node.py, same topics and parameters
+class SteeringControlWithPushingNode {
+public:
+  SteeringControlWithPushingNode(ros::NodeHandle nh, ros::NodeHandle pnh);
+  void path_cb(const nav_msgs::Path::ConstPtr &msg_ptr);
+  void force_odom_cb(const geometry_msgs::WrenchStamped::ConstPtr &force_msg_ptr,
+                     const nav_msgs::Odometry::ConstPtr &odom_msg_ptr);
+  void control_step();
+  void stop();
+  double cmd_freq() const { return cmd_freq_; }
+
+private:
+  static path_tracking::WalkerDynamics load_dynamics(ros::NodeHandle &nh);
+  static path_tracking::WalkerConstraints load_constraints(ros::NodeHandle &nh);
+  void publish_float(ros::Publisher &pub, double value);
+
+  ros::NodeHandle nh_, pnh_;
+  ros::Publisher pub_cmd_;
+  ros::Publisher pub_path_flat_;
+  ros::Publisher pub_tracking_progress_;
+  ros::Publisher pub_short_term_goal_;
+  ros::Publisher pub_inhibition_force_;
+  ros::Publisher pub_system_torque_;
+  ros::Subscriber sub_path_;
+  message_filters::Subscriber<geometry_msgs::WrenchStamped> sub_user_force_;
+  message_filters::Subscriber<nav_msgs::Odometry> sub_odom_;
+  message_filters::Synchronizer<ForceOdomPolicy> sync_;
+
+  double map_resolution_;
+  double smooth_path_resolution_;
+  double cmd_freq_;
+  double goal_tolerance_;
+
+  path_tracking::Pose2D robot_pose_;
+  double robot_linear_velocity_;
+  path_tracking::UserForce user_force_;
+  path_tracking::SteeringController controller_;
+  bool flag_message_published_;
+};
+
+
+SteeringControlWithPushingNode::SteeringControlWithPushingNode(ros::NodeHandle nh, ros::NodeHandle pnh):
+    nh_(nh), pnh_(pnh),
+    sub_user_force_(nh, "force_filtered", 10),
+    sub_odom_(nh, "odom_filtered", 10),
+    sync_(ForceOdomPolicy(10), sub_user_force_, sub_odom_),
+    map_resolution_(pnh.param("map_resolution", 0.2)),
+    smooth_path_resolution_(map_resolution_ / 2.0),     // much smoother than original path
+    cmd_freq_(pnh.param("cmd_freq", 10.0)),
+    goal_tolerance_(pnh.param("goal_tolerance", 0.2)),
+    robot_linear_velocity_(0.0),
+    controller_(load_dynamics(nh), load_constraints(nh), cmd_freq_, goal_tolerance_, kRobotRefLength),
+    flag_message_published_(false) {
+  robot_pose_.x = robot_pose_.y = robot_pose_.theta = 0.0;
+  user_force_.force_y = user_force_.force_z = user_force_.torque_z = 0.0;
+
+  // ROS publishers & subscribers
+  pub_cmd_ = nh_.advertise<geometry_msgs::Twist>("cmd_vel", 1);
+  pub_path_flat_ = nh_.advertise<nav_msgs::Path>("smooth_path", 1);
+  pub_tracking_progress_ = nh_.advertise<std_msgs::Float32>("tracking_progress", 1);
+  pub_short_term_goal_ = nh_.advertise<geometry_msgs::PointStamped>("short_term_goal", 1);
+  pub_inhibition_force_ = nh_.advertise<std_msgs::Float32>("inhibition_force", 1);
+  pub_system_torque_ = nh_.advertise<std_msgs::Float32>("system_torque", 1);
+  sub_path_ = nh_.subscribe("walkable_path", 1, &SteeringControlWithPushingNode::path_cb, this);
+  sync_.getPolicy()->setMaxIntervalDuration(ros::Duration(0.1));
+  sync_.registerCallback(boost::bind(&SteeringControlWithPushingNode::force_odom_cb, this, _1, _2));
+
+  ROS_INFO("%s is ready.", ros::this_node::getName().c_str());
+}
+
+
+path_tracking::WalkerDynamics SteeringControlWithPushingNode::load_dynamics(ros::NodeHandle &nh) {
+  path_tracking::WalkerDynamics dynamics;
+  nh.param("dynamics/mass", dynamics.mass, 30.0);
+  nh.param("dynamics/moment_of_inertia", dynamics.moment_of_inertia, 10.0);
+  nh.param("dynamics/damping_xy", dynamics.damping_xy, 45.0);
+  nh.param("dynamics/damping_theta", dynamics.damping_theta, 20.0);
+  nh.param("dynamics/constant_fraction_xy", dynamics.constant_fraction_xy, 0.001);
+  nh.param("dynamics/constant_fraction_theta", dynamics.constant_fraction_theta, 0.001);
+  return dynamics;
+}
+
+
+path_tracking::WalkerConstraints SteeringControlWithPushingNode::load_constraints(ros::NodeHandle &nh) {
+  path_tracking::WalkerConstraints constraints;
+  nh.param("constraints/min_enable_force", constraints.min_enable_force, 6.0);
+  nh.param("constraints/min_enable_torque", constraints.min_enable_torque, 0.8);
+  nh.param("constraints/max_linear_velocity", constraints.max_linear_velocity, 0.5);
+  nh.param("constraints/max_angular_velocity", constraints.max_angular_velocity, 0.5);
+  return constraints;
+}
+
+
+void SteeringControlWithPushingNode::force_odom_cb(const geometry_msgs::WrenchStamped::ConstPtr &force_msg_ptr,
+                                                   const nav_msgs::Odometry::ConstPtr &odom_msg_ptr) {
+  robot_pose_.x = odom_msg_ptr->pose.pose.position.x;
+  robot_pose_.y = odom_msg_ptr->pose.pose.position.y;
+  robot_pose_.theta = tf::getYaw(odom_msg_ptr->pose.pose.orientation);
+  robot_linear_velocity_ = odom_msg_ptr->twist.twist.linear.x;
+  user_force_.force_y = force_msg_ptr->wrench.force.y;
+  user_force_.force_z = force_msg_ptr->wrench.force.z;
+  user_force_.torque_z = force_msg_ptr->wrench.torque.z;
+}
+
+
+void SteeringControlWithPushingNode::path_cb(const nav_msgs::Path::ConstPtr &msg_ptr) {
+  std::vector<double> cx, cy, cyaw, ck, s;
+  std::vector<path_tracking::Pose2D> flat_path;
+
+  if(msg_ptr->poses.size() > 0 && msg_ptr->poses.size() < 3) {
+    const geometry_msgs::Point &p = msg_ptr->poses[0].pose.position;
+    path_tracking::Pose2D pose = {p.x, p.y, std::atan2(p.y - robot_pose_.y, p.x - robot_pose_.x)};
+    flat_path.push_back(pose);
+  }
+  else if(msg_ptr->poses.size() >= 3) {
+    // The path starts from the goal
+    std::vector<double> path_x_raw, path_y_raw;
+    path_x_raw.reserve(msg_ptr->poses.size());
+    path_y_raw.reserve(msg_ptr->poses.size());
+    for(int i = msg_ptr->poses.size() - 1; i >= 0; i--) {
+      path_x_raw.push_back(msg_ptr->poses[i].pose.position.x);
+      path_y_raw.push_back(msg_ptr->poses[i].pose.position.y);
+    }
+    cubic_spline::calc_spline_course(path_x_raw, path_y_raw, smooth_path_resolution_, cx, cy, cyaw, ck, s);
+    flat_path.resize(cx.size());
+    for(int i = 0; i < cx.size(); i++) {
+      flat_path[i].x = cx[i];
+      flat_path[i].y = cy[i];
+      flat_path[i].theta = cyaw[i];
+    }
+  }
+  controller_.set_path(flat_path);
+
+  // Visualization
+  nav_msgs::Path flat_path_msg;
+  flat_path_msg.header.frame_id = msg_ptr->header.frame_id;
+  flat_path_msg.header.stamp = ros::Time::now();
+  flat_path_msg.poses.resize(cx.size());
+  for(int i = 0; i < cx.size(); i++) {
+    flat_path_msg.poses[i].pose.position.x = cx[i];
+    flat_path_msg.poses[i].pose.position.y = cy[i];
+    flat_path_msg.poses[i].pose.orientation = tf::createQuaternionMsgFromYaw(cyaw[i]);
+  }
+  pub_path_flat_.publish(flat_path_msg);
+}
+
+
+void SteeringControlWithPushingNode::publish_float(ros::Publisher &pub, double value) {
+  std_msgs::Float32 msg;
+  msg.data = value;
+  pub.publish(msg);
+}
+
+
+void SteeringControlWithPushingNode::control_step() {
+  path_tracking::SteeringCommand cmd = controller_.update(robot_pose_, robot_linear_velocity_, user_force_);
+
+  if(!cmd.has_path) {
+    if(!flag_message_published_) {
+      ROS_INFO("Empty planning path, wait for new path");
+      flag_message_published_ = true;
+    }
+  }
+  else {
+    flag_message_published_ = false;
+
+    // Short term goal
+    const path_tracking::Pose2D &target = controller_.path()[cmd.target_idx];
+    geometry_msgs::PointStamped point_msg;
+    point_msg.header.frame_id = "odom";
+    point_msg.point.x = target.x;
+    point_msg.point.y = target.y;
+    pub_short_term_goal_.publish(point_msg);
+    publish_float(pub_tracking_progress_, cmd.tracking_progress);
+    if(cmd.goal_reached) {
+      const path_tracking::Pose2D &goal = controller_.path().back();
+      ROS_INFO("goal reached! %.2f", std::hypot(robot_pose_.x - goal.x, robot_pose_.y - goal.y));
+    }
+  }
+
+  publish_float(pub_inhibition_force_, cmd.inhibition_force);
+  if(cmd.has_system_torque)
+    publish_float(pub_system_torque_, cmd.system_torque);
+
+  geometry_msgs::Twist cmd_msg;
+  cmd_msg.linear.x = cmd.v;
+  cmd_msg.angular.z = cmd.w;
+  pub_cmd_.publish(cmd_msg);
+}
+
+
+void SteeringControlWithPushingNode::stop() {
+  pub_cmd_.publish(geometry_msgs::Twist());
+  ROS_INFO("Shutdown %s", ros::this_node::getName().c_str());
+}
+
+
+int main(int argc, char **argv) {
+  ros::init(argc, argv, "steering_control_with_user_pushing_node");
+  ros::NodeHandle nh, pnh("~");
+  SteeringControlWithPushingNode node(nh, pnh);
+
+  // Control rate
+  ros::Rate rate(node.cmd_freq());
+  while(ros::ok()) {
+    ros::spinOnce();
+    node.control_step();
+    rate.sleep();
+  }
+  node.stop();
+  return 0;
+}
@@ -2,7 +2,7 @@
 # -*- coding: utf-8 -*-
 import numpy as np
 import copy
-from steering_control_libs import cubic_spline_planner
+import cubic_spline_cpp as cubic_spline_planner
 from steering_control_libs.utils import calc_target_index, stanley_control, proportional_control, my_steering_control
 
 # ROS
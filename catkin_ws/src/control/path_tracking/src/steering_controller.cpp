@@ -0,0 +1,204 @@
+#include "steering_controller.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace path_tracking {
+
+static const double kK1Gain = 1.0;
+static const double kK2Gain = 2.0;
+static const double kGravity = 9.8;
+static const double kMinTurningVelocity = 0.05;     // [m/s] no steering below this velocity
+static const double kDefaultSearchWindow = 1.0;     // [m] of arc length ahead of the last target
+
+
+static double normalize_angle(double angle) {
+  while(angle > M_PI)
+    angle -= 2.0 * M_PI;
+  while(angle < -M_PI)
+    angle += 2.0 * M_PI;
+  return angle;
+}
+
+
+static double clip(double value, double min_value, double max_value) {
+  return std::max(min_value, std::min(value, max_value));
+}
+
+
+SteeringController::SteeringController(const WalkerDynamics &dynamics, const WalkerConstraints &constraints,
+                                       double cmd_freq, double goal_tolerance, double robot_ref_length):
+    dynamics_(dynamics), constraints_(constraints), dt_(1.0 / cmd_freq), goal_tolerance_(goal_tolerance),
+    robot_ref_length_(robot_ref_length), search_window_(kDefaultSearchWindow),
+    last_target_idx_(-1), last_v_(0.0), last_w_(0.0) {
+}
+
+
+void SteeringController::reset() {
+  path_.clear();
+  path_s_.clear();
+  last_target_idx_ = -1;
+  last_v_ = 0.0;
+  last_w_ = 0.0;
+}
+
+
+bool SteeringController::set_path(const std::vector<Pose2D> &path) {
+  if(path.size() == path_.size()) {
+    bool same = true;
+    for(int i = 0; i < path.size() && same; i++)
+      same = (path[i].x == path_[i].x && path[i].y == path_[i].y && path[i].theta == path_[i].theta);
+    if(same)
+      return false;
+  }
+
+  path_ = path;
+  path_s_.resize(path_.size());
+  for(int i = 0; i < path_.size(); i++)
+    path_s_[i] = (i == 0) ? 0.0 : path_s_[i - 1] + std::hypot(path_[i].x - path_[i - 1].x, path_[i].y - path_[i - 1].y);
+  last_target_idx_ = -1;
+  return true;
+}
+
+
+void SteeringController::front_axle(const Pose2D &robot_pose, double &fx, double &fy) const {
+  fx = robot_pose.x + robot_ref_length_ * std::cos(robot_pose.theta);
+  fy = robot_pose.y + robot_ref_length_ * std::sin(robot_pose.theta);
+}
+
+
+double SteeringController::front_axle_error(const Pose2D &robot_pose, double fx, double fy, int idx) const {
+  // Project the error onto the front axle vector
+  double dx = fx - path_[idx].x;
+  double dy = fy - path_[idx].y;
+  return dx * -std::cos(robot_pose.theta + M_PI / 2) + dy * -std::sin(robot_pose.theta + M_PI / 2);
+}
+
+
+int SteeringController::calc_target_index_full(const Pose2D &robot_pose, double &error_front_axle) const {
+  double fx, fy;
+  front_axle(robot_pose, fx, fy);
+  int target_idx = 0;
+  double min_dist2 = INFINITY;
+  for(int i = 0; i < path_.size(); i++) {
+    double dist2 = (fx - path_[i].x) * (fx - path_[i].x) + (fy - path_[i].y) * (fy - path_[i].y);
+    if(dist2 < min_dist2) {
+      min_dist2 = dist2;
+      target_idx = i;
+    }
+  }
+  error_front_axle = front_axle_error(robot_pose, fx, fy, target_idx);
+  return target_idx;
+}
+
+
+int SteeringController::calc_target_index(const Pose2D &robot_pose, double &error_front_axle) {
+  if(last_target_idx_ < 0 || last_target_idx_ >= path_.size()) {
+    last_target_idx_ = calc_target_index_full(robot_pose, error_front_axle);
+    return last_target_idx_;
+  }
+
+  double fx, fy;
+  front_axle(robot_pose, fx, fy);
+  const double s_end = path_s_[last_target_idx_] + search_window_;
+  int target_idx = last_target_idx_;
+  double min_dist2 = INFINITY;
+  for(int i = last_target_idx_; i < path_.size() && path_s_[i] <= s_end; i++) {
+    double dist2 = (fx - path_[i].x) * (fx - path_[i].x) + (fy - path_[i].y) * (fy - path_[i].y);
+    if(dist2 < min_dist2) {
+      min_dist2 = dist2;
+      target_idx = i;
+    }
+  }
+
+  // The robot is farther than the window from the path (e.g. relocalized), search everything
+  if(min_dist2 > search_window_ * search_window_) {
+    last_target_idx_ = calc_target_index_full(robot_pose, error_front_axle);
+    return last_target_idx_;
+  }
+
+  last_target_idx_ = target_idx;
+  error_front_axle = front_axle_error(robot_pose, fx, fy, target_idx);
+  return target_idx;
+}
+
+
+void SteeringController::apply_estop_force(double user_force_forwarding, double user_torque_rotation, double total_mass,
+                                           double &next_v, double &estop_force, double &estop_torque) const {
+  estop_torque = user_torque_rotation + last_w_ * (dynamics_.damping_theta - kK1Gain * dynamics_.moment_of_inertia);
+  estop_force = user_force_forwarding + last_v_ * (dynamics_.damping_xy - kK1Gain * total_mass);
+  double v_dot = user_force_forwarding / total_mass
+                 - last_v_ * dynamics_.damping_xy / total_mass
+                 - estop_force / total_mass;
+  next_v = clip(last_v_ + v_dot * dt_, 0.0, constraints_.max_linear_velocity);
+}
+
+
+SteeringCommand SteeringController::update(const Pose2D &robot_pose, double robot_linear_velocity,
+                                           const UserForce &user_force) {
+  SteeringCommand cmd;
+  cmd.v = 0.0;
+  cmd.w = 0.0;
+  cmd.has_path = !path_.empty();
+  cmd.goal_reached = false;
+  cmd.target_idx = -1;
+  cmd.tracking_progress = 0.0;
+  cmd.inhibition_force = 0.0;
+  cmd.has_system_torque = false;
+  cmd.system_torque = 0.0;
+
+  double force_forwarding = 0.0;
+  if(std::fabs(user_force.force_y) > constraints_.min_enable_force)
+    force_forwarding = user_force.force_y;
+  double total_mass = dynamics_.mass + (-user_force.force_z / kGravity);    // Newton -> kg
+  double torque_rotation = user_force.torque_z;
+
+  if(path_.empty()) {
+    // Stop the robot by provide estop force
+    apply_estop_force(force_forwarding, torque_rotation, total_mass, cmd.v, cmd.inhibition_force, cmd.system_torque);
+    cmd.has_system_torque = true;
+  }
+  else {
+    // Steering control law (my_steering_control)
+    double error_front_axle;
+    cmd.target_idx = calc_target_index(robot_pose, error_front_axle);
+    double heading_error = normalize_angle(path_[cmd.target_idx].theta - robot_pose.theta);
+    double total_steering_error = std::fabs(robot_linear_velocity) * heading_error
+                                  + error_front_axle * robot_linear_velocity;
+    cmd.tracking_progress = (cmd.target_idx + 1.0) / path_.size();
+
+    double dis_robot2goal = std::hypot(robot_pose.x - path_.back().x, robot_pose.y - path_.back().y);
+    if(dis_robot2goal > goal_tolerance_) {
+      // Assign angular velocity command
+      //    theta_dot_dot = -k1 * theta_dot + k2 * total_steering_error
+      if(robot_linear_velocity > kMinTurningVelocity) {
+        double accel_angular = -last_w_ * kK1Gain + total_steering_error * kK2Gain;
+        cmd.w = clip(last_w_ + accel_angular * dt_, -constraints_.max_angular_velocity, constraints_.max_angular_velocity);
+        cmd.system_torque = accel_angular * dynamics_.moment_of_inertia;
+        cmd.has_system_torque = true;
+      }
+
+      // Assign linear velocity command, the pushing force is inhibited with the steering error
+      double x_t = std::fabs(total_steering_error) / (M_PI / 4);
+      cmd.inhibition_force = force_forwarding * (1.0 / (1.0 + std::exp(-x_t * 10.0 + 5.0)));
+      double v_dot = force_forwarding / total_mass
+                     - last_v_ * dynamics_.damping_xy / total_mass
+                     - dynamics_.constant_fraction_xy
+                     - cmd.inhibition_force / total_mass;
+      cmd.v = clip(last_v_ + v_dot * dt_, 0.0, constraints_.max_linear_velocity);
+    }
+    else {
+      // Stop the robot by provide estop force
+      cmd.goal_reached = true;
+      apply_estop_force(force_forwarding, torque_rotation, total_mass, cmd.v, cmd.inhibition_force, cmd.system_torque);
+      cmd.has_system_torque = true;
+      cmd.tracking_progress = 1.0;
+    }
+  }
+
+  last_v_ = cmd.v;
+  last_w_ = cmd.w;
+  return cmd;
+}
+
+} // namespace path_tracking
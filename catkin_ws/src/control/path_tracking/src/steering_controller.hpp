@@ -0,0 +1,100 @@
+#ifndef PATH_TRACKING_STEERING_CONTROLLER_HPP
+#define PATH_TRACKING_STEERING_CONTROLLER_HPP
+
+#include <vector>
+
+namespace path_tracking {
+
+struct Pose2D {
+  double x, y, theta;
+};
+
+// Parameters 'dynamics' and 'constraints' of config/walker_dynamics.yaml
+struct WalkerDynamics {
+  double mass;
+  double moment_of_inertia;
+  double damping_xy;
+  double damping_theta;
+  double constant_fraction_xy;
+  double constant_fraction_theta;
+};
+
+struct WalkerConstraints {
+  double min_enable_force;
+  double min_enable_torque;
+  double max_linear_velocity;
+  double max_angular_velocity;
+};
+
+// User pushing force, the fields of geometry_msgs/Wrench used by the controller
+struct UserForce {
+  double force_y;   // forwarding force [N]
+  double force_z;   // leaning on the walker [N], adds -force_z / g to the mass
+  double torque_z;  // rotation torque [Nm]
+};
+
+// Result of one control tick, with the values published by the node
+struct SteeringCommand {
+  double v, w;
+  bool has_path;
+  bool goal_reached;
+  int target_idx;
+  double tracking_progress;
+  double inhibition_force;
+  bool has_system_torque;   // system_torque is not published when turning is disabled
+  double system_torque;
+};
+
+
+// Steering control with user pushing, same control law and pushing-force inhibition
+// model as steering_control_with_user_pushing_node.py (my_steering_control).
+// The nearest path point to the front axle is searched in a window of arc length
+// ahead of the previous target instead of over the whole path, so that a tick
+// costs O(1) in the path length. The target index never moves backward on a path;
+// a full search is only done for a new path or when the robot left the window.
+class SteeringController {
+public:
+  SteeringController(const WalkerDynamics &dynamics, const WalkerConstraints &constraints,
+                     double cmd_freq, double goal_tolerance, double robot_ref_length = 0.6);
+
+  // Track a new path of poses (x, y, yaw). Returns false and keeps the search state
+  // if the path is the same as the current one.
+  bool set_path(const std::vector<Pose2D> &path);
+  const std::vector<Pose2D> &path() const { return path_; }
+
+  // One control tick at cmd_freq with the robot pose, its measured linear velocity
+  // and the user pushing force
+  SteeringCommand update(const Pose2D &robot_pose, double robot_linear_velocity, const UserForce &user_force);
+
+  // Nearest path point to the front axle, and the cross-track error projected on the front axle
+  int calc_target_index(const Pose2D &robot_pose, double &error_front_axle);
+
+  // Same as calc_target_index with a search over the whole path, as the python node
+  int calc_target_index_full(const Pose2D &robot_pose, double &error_front_axle) const;
+
+  void set_search_window(double length) { search_window_ = length; }
+  void reset();
+
+private:
+  void apply_estop_force(double user_force_forwarding, double user_torque_rotation, double total_mass,
+                         double &next_v, double &estop_force, double &estop_torque) const;
+  void front_axle(const Pose2D &robot_pose, double &fx, double &fy) const;
+  double front_axle_error(const Pose2D &robot_pose, double fx, double fy, int idx) const;
+
+  WalkerDynamics dynamics_;
+  WalkerConstraints constraints_;
+  double dt_;
+  double goal_tolerance_;
+  double robot_ref_length_;
+  double search_window_;
+
+  std::vector<Pose2D> path_;
+  std::vector<double> path_s_;    // arc length at each path point
+  int last_target_idx_;           // -1: full search at the next tick
+
+  double last_v_, last_w_;
+};
+
+} // namespace path_tracking
+
+#endif
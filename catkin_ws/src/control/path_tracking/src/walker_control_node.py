@@ -6,7 +6,7 @@ import matplotlib.pyplot as plt
 import sys
 import time
 import copy
-from CubicSpline import cubic_spline_planner
+import cubic_spline_cpp as cubic_spline_planner
 
 # ROS
 import rospy
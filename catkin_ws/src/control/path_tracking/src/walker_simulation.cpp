@@ -0,0 +1,347 @@
+#include "walker_simulation.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "cubic_spline.hpp"
+
+namespace path_tracking {
+
+static double normalize_angle(double angle) {
+  while(angle > M_PI)
+    angle -= 2.0 * M_PI;
+  while(angle < -M_PI)
+    angle += 2.0 * M_PI;
+  return angle;
+}
+
+
+static double clip(double value, double min_value, double max_value) {
+  return std::max(min_value, std::min(value, max_value));
+}
+
+
+PushingProfile default_pushing_profile() {
+  PushingProfile profile;
+  profile.gait_period = 5.0;
+  profile.max_force = 16.0 + 14.0;
+  profile.min_force = 6.0;
+  profile.up_slope_ratio = 2.0 / 7.0;
+  profile.noise = 1.0;
+  profile.duration = 120.0;
+  profile.lean_force = 0.0;
+  profile.steering_gain = 0.0;
+  return profile;
+}
+
+
+PushingForceGenerator::PushingForceGenerator(const PushingProfile &profile, double rate, unsigned int seed):
+    profile_(profile), dt_(1.0 / rate), force_y_(0.0), t_(0.0), rng_(seed), noise_(-0.5, 0.5) {
+  up_slope_ = (profile.max_force - profile.min_force) / (profile.gait_period / 2 * profile.up_slope_ratio);
+  down_slope_ = (profile.min_force - profile.max_force) / (profile.gait_period / 2 * (1.0 - profile.up_slope_ratio));
+  // The first step rises twice as fast, from zero
+  slope_ = up_slope_ * 2;
+}
+
+
+double PushingForceGenerator::next() {
+  if(t_ <= profile_.duration) {
+    if(slope_ > 0 && force_y_ >= profile_.max_force)
+      slope_ = down_slope_;
+    else if(slope_ < 0 && force_y_ <= profile_.min_force)
+      slope_ = up_slope_;
+    force_y_ += slope_ * dt_ + noise_(rng_) * profile_.noise;
+  }
+  else {
+    force_y_ = noise_(rng_) * profile_.noise;
+  }
+  t_ += dt_;
+  return force_y_;
+}
+
+
+AdmittanceController::AdmittanceController(const WalkerDynamics &dynamics, const WalkerConstraints &constraints,
+                                           double cmd_freq):
+    dynamics_(dynamics), constraints_(constraints), dt_(1.0 / cmd_freq), last_v_(0.0), last_w_(0.0) {
+}
+
+
+void AdmittanceController::reset() {
+  last_v_ = 0.0;
+  last_w_ = 0.0;
+}
+
+
+void AdmittanceController::update(const UserForce &user_force, double &v, double &w) {
+  v = last_v_;
+  w = last_w_;
+
+  double force_y = (std::fabs(user_force.force_y) > constraints_.min_enable_force) ? user_force.force_y : 0.0;
+  double torque_z = (std::fabs(user_force.torque_z) > constraints_.min_enable_torque) ? user_force.torque_z : 0.0;
+  double total_mass = dynamics_.mass + (-user_force.force_z / 9.8);    // Newton -> kg
+
+  double v_dot = force_y / total_mass
+                 - last_v_ * dynamics_.damping_xy / total_mass
+                 - dynamics_.constant_fraction_xy;
+  double w_dot = torque_z / dynamics_.moment_of_inertia
+                 - last_w_ * dynamics_.damping_theta / dynamics_.moment_of_inertia
+                 - dynamics_.constant_fraction_theta;
+
+  last_w_ = clip(last_w_ + w_dot * dt_, -constraints_.max_angular_velocity, constraints_.max_angular_velocity);
+  last_v_ = clip(last_v_ + v_dot * dt_, 0.0, constraints_.max_linear_velocity);
+}
+
+
+SimulationConfig default_simulation_config() {
+  SimulationConfig config;
+  config.dynamics.mass = 30.0;
+  config.dynamics.moment_of_inertia = 10.0;
+  config.dynamics.damping_xy = 45.0;
+  config.dynamics.damping_theta = 20.0;
+  config.dynamics.constant_fraction_xy = 0.001;
+  config.dynamics.constant_fraction_theta = 0.001;
+  config.constraints.min_enable_force = 6.0;
+  config.constraints.min_enable_torque = 0.8;
+  config.constraints.max_linear_velocity = 0.5;
+  config.constraints.max_angular_velocity = 0.5;
+  config.sim_dt = 0.01;
+  config.cmd_freq = 10.0;
+  config.force_rate = 20.0;
+  config.goal_tolerance = 0.4;
+  config.path_resolution = 0.1;
+  config.velocity_time_constant = 0.1;
+  config.user_lookahead = 1.0;
+  return config;
+}
+
+
+ScenarioResult run_scenario(const SimulationConfig &config, const Scenario &scenario) {
+  ScenarioResult result;
+  result.name = scenario.name;
+  result.goal_reached = false;
+  result.goal_reach_time = 0.0;
+  result.travelled_distance = 0.0;
+  result.max_crosstrack_error = 0.0;
+  result.max_inhibition_force = 0.0;
+  result.num_ticks = 0;
+
+  // Smooth path, as the steering node does with the walkable path
+  cubic_spline::Spline2D spline(scenario.waypoints_x, scenario.waypoints_y);
+  std::vector<double> cx, cy, cyaw, ck, cs;
+  spline.calc_course(config.path_resolution, cx, cy, cyaw, ck, cs);
+  std::vector<Pose2D> path(cx.size());
+  for(int i = 0; i < cx.size(); i++) {
+    path[i].x = cx[i];
+    path[i].y = cy[i];
+    path[i].theta = cyaw[i];
+  }
+  result.path_length = spline.length();
+  double goal_x, goal_y;
+  spline.calc_position(spline.length(), goal_x, goal_y);
+
+  SteeringController steering(config.dynamics, config.constraints, config.cmd_freq, config.goal_tolerance);
+  steering.set_path(path);
+  AdmittanceController admittance(config.dynamics, config.constraints, config.cmd_freq);
+  PushingForceGenerator pushing(scenario.pushing, config.force_rate, scenario.seed);
+
+  const int steps_per_tick = std::max(1, (int)std::lround(1.0 / (config.cmd_freq * config.sim_dt)));
+  const int steps_per_force = std::max(1, (int)std::lround(1.0 / (config.force_rate * config.sim_dt)));
+  const int num_steps = std::ceil(scenario.max_time / config.sim_dt);
+  const double velocity_gain = std::min(1.0, config.sim_dt / config.velocity_time_constant);
+
+  Pose2D pose = scenario.start;
+  double v = 0.0, w = 0.0;
+  double cmd_v = 0.0, cmd_w = 0.0;
+  UserForce force = {0.0, scenario.pushing.lean_force, 0.0};
+  double s_nearest = -1.0;
+  double sum_crosstrack_error2 = 0.0;
+  double sum_inhibition_force = 0.0, sum_inhibition_force2 = 0.0;
+  double sum_pushing_force = 0.0;
+
+  int step;
+  for(step = 0; step < num_steps; step++) {
+    if(step % steps_per_force == 0)
+      force.force_y = pushing.next();
+
+    if(step % steps_per_tick == 0) {
+      // Tracking error w.r.t. the smooth path, warm started from the last projection
+      double crosstrack_error;
+      s_nearest = spline.calc_nearest(pose.x, pose.y, crosstrack_error, s_nearest);
+      result.max_crosstrack_error = std::max(result.max_crosstrack_error, std::fabs(crosstrack_error));
+      sum_crosstrack_error2 += crosstrack_error * crosstrack_error;
+
+      // The user turns the walker toward the path ahead
+      double lx, ly;
+      spline.calc_position(std::min(s_nearest + config.user_lookahead, spline.length()), lx, ly);
+      force.torque_z = scenario.pushing.steering_gain * normalize_angle(std::atan2(ly - pose.y, lx - pose.x) - pose.theta);
+
+      if(std::fabs(force.force_y) > config.constraints.min_enable_force)
+        sum_pushing_force += force.force_y;
+
+      bool goal_reached;
+      if(scenario.controller == STEERING_CONTROLLER) {
+        SteeringCommand cmd = steering.update(pose, v, force);
+        cmd_v = cmd.v;
+        cmd_w = cmd.w;
+        goal_reached = cmd.goal_reached;
+        sum_inhibition_force += cmd.inhibition_force;
+        sum_inhibition_force2 += cmd.inhibition_force * cmd.inhibition_force;
+        result.max_inhibition_force = std::max(result.max_inhibition_force, cmd.inhibition_force);
+      }
+      else {
+        // Without a path the controller cannot stop the walker, the user stops at the goal
+        // or once the end of the path is passed
+        admittance.update(force, cmd_v, cmd_w);
+        goal_reached = std::hypot(pose.x - goal_x, pose.y - goal_y) <= config.goal_tolerance
+                       || s_nearest >= spline.length();
+      }
+      result.num_ticks++;
+
+      if(goal_reached) {
+        result.goal_reached = true;
+        break;
+      }
+    }
+
+    // Differential drive base following the velocity command with a first order lag
+    v += (cmd_v - v) * velocity_gain;
+    w += (cmd_w - w) * velocity_gain;
+    double heading = pose.theta + 0.5 * w * config.sim_dt;
+    pose.x += v * std::cos(heading) * config.sim_dt;
+    pose.y += v * std::sin(heading) * config.sim_dt;
+    pose.theta = normalize_angle(pose.theta + w * config.sim_dt);
+    result.travelled_distance += std::fabs(v) * config.sim_dt;
+  }
+
+  result.goal_reach_time = step * config.sim_dt;
+  const int num_ticks = std::max(1, result.num_ticks);
+  result.mean_speed = result.travelled_distance / std::max(config.sim_dt, result.goal_reach_time);
+  result.rms_crosstrack_error = std::sqrt(sum_crosstrack_error2 / num_ticks);
+  result.mean_inhibition_force = sum_inhibition_force / num_ticks;
+  result.stddev_inhibition_force = std::sqrt(std::max(0.0, sum_inhibition_force2 / num_ticks
+                                                      - result.mean_inhibition_force * result.mean_inhibition_force));
+  result.mean_pushing_force = sum_pushing_force / num_ticks;
+  return result;
+}
+
+
+void make_straight_path(double length, std::vector<double> &x, std::vector<double> &y) {
+  // Straight line of fake_path_node.py
+  const double step = 0.6;
+  x.clear();
+  y.clear();
+  for(double l = 0.0; l < length; l += step) {
+    x.push_back(l);
+    y.push_back(0.4 + l * 0.5);
+  }
+}
+
+
+void make_turn_path(double length, std::vector<double> &x, std::vector<double> &y) {
+  // 90 degree turning of fake_path_node.py
+  const double step = 0.6;
+  x.clear();
+  y.clear();
+  for(double l = 0.0; l < length; l += step) {
+    if(l < step * 5) {
+      x.push_back(l);
+      y.push_back(0.0);
+    }
+    else {
+      x.push_back(step * 5);
+      y.push_back(l - step * 5);
+    }
+  }
+}
+
+
+void make_figure_eight_path(double scale, std::vector<double> &x, std::vector<double> &y) {
+  // Figure-eight curve of fake_path_node.py
+  const int num_points = 50;
+  x.resize(num_points);
+  y.resize(num_points);
+  for(int i = 0; i < num_points; i++) {
+    double t = M_PI * 2 / 50 + (M_PI * 98 / 50 - M_PI * 2 / 50) * i / (num_points - 1);
+    x[i] = std::sin(t) * scale;
+    y[i] = std::sin(t) * std::cos(t) * scale;
+  }
+}
+
+
+void make_s_curve_path(double length, std::vector<double> &x, std::vector<double> &y) {
+  x.clear();
+  y.clear();
+  for(double l = 0.0; l <= length; l += 0.5) {
+    x.push_back(l);
+    y.push_back(1.5 * std::sin(l * 2.0 * M_PI / 8.0));
+  }
+}
+
+
+std::vector<Scenario> make_scenarios(int num_seeds) {
+  struct NamedPath {
+    const char *name;
+    std::vector<double> x, y;
+  };
+  std::vector<NamedPath> paths(4);
+  paths[0].name = "straight";
+  make_straight_path(12.0, paths[0].x, paths[0].y);
+  paths[1].name = "turn";
+  make_turn_path(12.0, paths[1].x, paths[1].y);
+  paths[2].name = "figure_eight";
+  make_figure_eight_path(5.0, paths[2].x, paths[2].y);
+  paths[3].name = "s_curve";
+  make_s_curve_path(16.0, paths[3].x, paths[3].y);
+
+  std::vector<std::pair<const char *, PushingProfile> > profiles;
+  PushingProfile nominal = default_pushing_profile();
+  nominal.steering_gain = 5.0;
+  profiles.push_back(std::make_pair("nominal", nominal));
+  PushingProfile weak = nominal;
+  weak.max_force = 16.0;
+  profiles.push_back(std::make_pair("weak", weak));
+  PushingProfile strong = nominal;
+  strong.max_force = 45.0;
+  strong.min_force = 12.0;
+  profiles.push_back(std::make_pair("strong", strong));
+  PushingProfile leaning = nominal;
+  leaning.lean_force = -100.0;
+  profiles.push_back(std::make_pair("leaning", leaning));
+
+  std::vector<Scenario> scenarios;
+  for(int p = 0; p < paths.size(); p++) {
+    for(int f = 0; f < profiles.size(); f++) {
+      for(int c = 0; c < 2; c++) {
+        for(int seed = 0; seed < num_seeds; seed++) {
+          Scenario scenario;
+          scenario.controller = (c == 0) ? STEERING_CONTROLLER : ADMITTANCE_CONTROLLER;
+          scenario.name = std::string(paths[p].name) + "/" + profiles[f].first + "/"
+                          + (c == 0 ? "steering" : "admittance") + "/" + std::to_string(seed);
+          scenario.waypoints_x = paths[p].x;
+          scenario.waypoints_y = paths[p].y;
+          scenario.pushing = profiles[f].second;
+          scenario.seed = 1000 * p + 100 * f + seed;
+
+          // Start near the first waypoint, heading along the path
+          std::mt19937 rng(scenario.seed);
+          std::uniform_real_distribution<double> offset(-0.3, 0.3), heading(-0.2, 0.2);
+          double yaw = std::atan2(paths[p].y[1] - paths[p].y[0], paths[p].x[1] - paths[p].x[0]);
+          double lateral = offset(rng);
+          scenario.start.x = paths[p].x[0] - lateral * std::sin(yaw);
+          scenario.start.y = paths[p].y[0] + lateral * std::cos(yaw);
+          scenario.start.theta = yaw + heading(rng);
+
+          double path_length = 0.0;
+          for(int i = 1; i < paths[p].x.size(); i++)
+            path_length += std::hypot(paths[p].x[i] - paths[p].x[i - 1], paths[p].y[i] - paths[p].y[i - 1]);
+          scenario.max_time = 30.0 + path_length / 0.15;
+          scenario.pushing.duration = scenario.max_time;    // the user pushes until the end
+          scenarios.push_back(scenario);
+        }
+      }
+    }
+  }
+  return scenarios;
+}
+
+} // namespace path_tracking
@@ -0,0 +1,137 @@
+#ifndef PATH_TRACKING_WALKER_SIMULATION_HPP
+#define PATH_TRACKING_WALKER_SIMULATION_HPP
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "steering_controller.hpp"
+
+namespace path_tracking {
+
+// Scripted user pushing, same gait wave as pushing_action_simulation_node.py: the
+// forwarding force rises from min_force to max_force during up_slope_ratio of half
+// the gait period and falls back during the rest of it.
+struct PushingProfile {
+  double gait_period;     // [s] period of single-leg contacting the ground
+  double max_force;       // [N]
+  double min_force;       // [N]
+  double up_slope_ratio;  // part of the half period with a rising force
+  double noise;           // [N] peak to peak uniform noise added at every sample
+  double duration;        // [s] pushing time, only noise afterwards
+  double lean_force;      // [N] force_z, negative when the user leans on the walker
+  double steering_gain;   // [Nm/rad] user torque toward the path ahead, 0 for no torque
+};
+
+// Values of pushing_action_simulation_node.py, without torque
+PushingProfile default_pushing_profile();
+
+
+// Forwarding force samples of a PushingProfile at a fixed rate, reproducible with the seed
+class PushingForceGenerator {
+public:
+  PushingForceGenerator(const PushingProfile &profile, double rate, unsigned int seed);
+
+  // force_y of the next sample
+  double next();
+
+private:
+  PushingProfile profile_;
+  double dt_;
+  double up_slope_, down_slope_;
+  double slope_;
+  double force_y_;
+  double t_;
+  std::mt19937 rng_;
+  std::uniform_real_distribution<double> noise_;
+};
+
+
+// Admittance control without path, same as force2cmd_node.py: the pushing force and
+// torque drive the mass / damping / inertia model of the walker
+class AdmittanceController {
+public:
+  AdmittanceController(const WalkerDynamics &dynamics, const WalkerConstraints &constraints, double cmd_freq);
+
+  // One tick at cmd_freq. As the node, the command of the previous tick is returned
+  // before the model is updated with the new force.
+  void update(const UserForce &user_force, double &v, double &w);
+  void reset();
+
+private:
+  WalkerDynamics dynamics_;
+  WalkerConstraints constraints_;
+  double dt_;
+  double last_v_, last_w_;
+};
+
+
+enum ControllerType {
+  STEERING_CONTROLLER,    // steering_control_with_user_pushing_node
+  ADMITTANCE_CONTROLLER   // force2cmd_node
+};
+
+
+struct SimulationConfig {
+  WalkerDynamics dynamics;
+  WalkerConstraints constraints;
+  double sim_dt;                  // [s] integration step of the walker model
+  double cmd_freq;                // [Hz] controller rate
+  double force_rate;              // [Hz] pushing force rate
+  double goal_tolerance;          // [m]
+  double path_resolution;         // [m] spacing of the smoothed path given to the controller
+  double velocity_time_constant;  // [s] first order lag of the base following cmd_vel
+  double user_lookahead;          // [m] the user steers toward the path this far ahead
+};
+
+// Values of config/walker_dynamics.yaml and of the simulation launch file
+SimulationConfig default_simulation_config();
+
+
+struct Scenario {
+  std::string name;
+  std::vector<double> waypoints_x, waypoints_y;   // from the start to the goal
+  Pose2D start;
+  PushingProfile pushing;
+  ControllerType controller;
+  unsigned int seed;
+  double max_time;                                // [s]
+};
+
+
+// Regression metrics of one run
+struct ScenarioResult {
+  std::string name;
+  bool goal_reached;
+  double goal_reach_time;           // [s], the simulated time if the goal is not reached
+  double path_length;               // [m]
+  double travelled_distance;        // [m]
+  double mean_speed;                // [m/s]
+  double rms_crosstrack_error;      // [m] distance to the smoothed path
+  double max_crosstrack_error;      // [m]
+  double mean_inhibition_force;     // [N]
+  double max_inhibition_force;      // [N]
+  double stddev_inhibition_force;   // [N]
+  double mean_pushing_force;        // [N] forwarding force above min_enable_force
+  int num_ticks;                    // controller ticks
+};
+
+
+// Step the walker model, the scripted user and the controller at fixed rates until the goal
+// is reached or max_time. Runs are deterministic: the only randomness is the force noise,
+// seeded with scenario.seed.
+ScenarioResult run_scenario(const SimulationConfig &config, const Scenario &scenario);
+
+// Waypoints of the paths of fake_path_node.py and a few more, length ~ scale [m]
+void make_straight_path(double length, std::vector<double> &x, std::vector<double> &y);
+void make_turn_path(double length, std::vector<double> &x, std::vector<double> &y);
+void make_figure_eight_path(double scale, std::vector<double> &x, std::vector<double> &y);
+void make_s_curve_path(double length, std::vector<double> &x, std::vector<double> &y);
+
+// num_seeds runs of every combination of path, pushing profile and controller,
+// with start poses perturbed around the first waypoint
+std::vector<Scenario> make_scenarios(int num_seeds);
+
+} // namespace path_tracking
+
+#endif
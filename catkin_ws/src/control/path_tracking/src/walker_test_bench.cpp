@@ -0,0 +1,98 @@
+// Headless controller-in-the-loop bench of the pushing walker, no ROS master needed.
+//   rosrun path_tracking walker_test_bench [num_seeds] [results.csv]
+// Runs make_scenarios(num_seeds) and prints the regression metrics per path / pushing /
+// controller combination, averaged over the seeds. The CSV has one line per scenario.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "walker_simulation.hpp"
+
+using path_tracking::Scenario;
+using path_tracking::ScenarioResult;
+
+struct GroupSummary {
+  int num_runs;
+  int num_goal_reached;
+  double sum_goal_reach_time;
+  double sum_rms_crosstrack_error;
+  double max_crosstrack_error;
+  double sum_mean_inhibition_force;
+  double max_inhibition_force;
+};
+
+
+int main(int argc, char **argv) {
+  int num_seeds = (argc > 1) ? std::atoi(argv[1]) : 8;
+  const char *csv_file_name = (argc > 2) ? argv[2] : NULL;
+
+  path_tracking::SimulationConfig config = path_tracking::default_simulation_config();
+  std::vector<Scenario> scenarios = path_tracking::make_scenarios(num_seeds);
+
+  std::vector<ScenarioResult> results(scenarios.size());
+  double simulated_time = 0.0;
+  std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+  for(int i = 0; i < scenarios.size(); i++) {
+    results[i] = path_tracking::run_scenario(config, scenarios[i]);
+    simulated_time += results[i].goal_reach_time;
+  }
+  double wall_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+  if(csv_file_name) {
+    FILE *csv_file = std::fopen(csv_file_name, "w");
+    if(!csv_file) {
+      std::fprintf(stderr, "Cannot open %s\n", csv_file_name);
+      return 1;
+    }
+    std::fprintf(csv_file, "name,goal_reached,goal_reach_time,path_length,travelled_distance,mean_speed,"
+                           "rms_crosstrack_error,max_crosstrack_error,mean_inhibition_force,"
+                           "max_inhibition_force,stddev_inhibition_force,mean_pushing_force\n");
+    for(int i = 0; i < results.size(); i++) {
+      const ScenarioResult &r = results[i];
+      std::fprintf(csv_file, "%s,%d,%.3f,%.3f,%.3f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f\n",
+                   r.name.c_str(), r.goal_reached, r.goal_reach_time, r.path_length, r.travelled_distance,
+                   r.mean_speed, r.rms_crosstrack_error, r.max_crosstrack_error, r.mean_inhibition_force,
+                   r.max_inhibition_force, r.stddev_inhibition_force, r.mean_pushing_force);
+    }
+    std::fclose(csv_file);
+  }
+
+  // Summary over the seeds of each combination, the name without the trailing "/<seed>"
+  std::map<std::string, GroupSummary> groups;
+  for(int i = 0; i < results.size(); i++) {
+    const ScenarioResult &r = results[i];
+    std::string group_name = r.name.substr(0, r.name.rfind('/'));
+    std::map<std::string, GroupSummary>::iterator it = groups.find(group_name);
+    if(it == groups.end()) {
+      GroupSummary empty = {0, 0, 0.0, 0.0, 0.0, 0.0, 0.0};
+      it = groups.insert(std::make_pair(group_name, empty)).first;
+    }
+    GroupSummary &g = it->second;
+    g.num_runs++;
+    if(r.goal_reached) {
+      g.num_goal_reached++;
+      g.sum_goal_reach_time += r.goal_reach_time;
+    }
+    g.sum_rms_crosstrack_error += r.rms_crosstrack_error;
+    g.max_crosstrack_error = std::max(g.max_crosstrack_error, r.max_crosstrack_error);
+    g.sum_mean_inhibition_force += r.mean_inhibition_force;
+    g.max_inhibition_force = std::max(g.max_inhibition_force, r.max_inhibition_force);
+  }
+
+  std::printf("%-36s %7s %10s %9s %9s %10s %10s\n", "scenario", "reached", "time [s]", "rms [m]", "max [m]",
+              "inhib [N]", "max inhib");
+  for(std::map<std::string, GroupSummary>::const_iterator it = groups.begin(); it != groups.end(); ++it) {
+    const GroupSummary &g = it->second;
+    std::printf("%-36s %3d/%-3d %10.2f %9.3f %9.3f %10.2f %10.2f\n", it->first.c_str(),
+                g.num_goal_reached, g.num_runs,
+                g.num_goal_reached ? g.sum_goal_reach_time / g.num_goal_reached : 0.0,
+                g.sum_rms_crosstrack_error / g.num_runs, g.max_crosstrack_error,
+                g.sum_mean_inhibition_force / g.num_runs, g.max_inhibition_force);
+  }
+  std::printf("%d scenarios, %.1f s simulated in %.3f s (x%.0f real time)\n", (int)results.size(),
+              simulated_time, wall_time, simulated_time / wall_time);
+  return 0;
+}
@@ -0,0 +1,195 @@
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "cubic_spline.hpp"
+
+#ifndef SPLINE_TEST_DATA_DIR
+#define SPLINE_TEST_DATA_DIR "test/data"
+#endif
+
+
+// Waypoints and calc_spline_course outputs of the former python cubic_spline_planner
+struct ReferenceCase {
+  double ds;
+  std::vector<double> x, y;
+  std::vector<double> rx, ry, ryaw, rk, rs;
+};
+
+
+static std::vector<ReferenceCase> load_reference(const std::string &file_name) {
+  std::vector<ReferenceCase> cases;
+  std::ifstream file(file_name.c_str());
+  std::string line;
+  while(std::getline(file, line)) {
+    std::istringstream header(line);
+    std::string tag;
+    int num_waypoints;
+    ReferenceCase c;
+    if(!(header >> tag >> num_waypoints >> c.ds) || tag != "path")
+      continue;
+    c.x.resize(num_waypoints);
+    c.y.resize(num_waypoints);
+    for(int i = 0; i < num_waypoints; i++)
+      file >> c.x[i] >> c.y[i];
+
+    int num_samples;
+    file >> tag >> num_samples;
+    c.rx.resize(num_samples);
+    c.ry.resize(num_samples);
+    c.ryaw.resize(num_samples);
+    c.rk.resize(num_samples);
+    c.rs.resize(num_samples);
+    for(int i = 0; i < num_samples; i++)
+      file >> c.rx[i] >> c.ry[i] >> c.ryaw[i] >> c.rk[i] >> c.rs[i];
+    cases.push_back(c);
+  }
+  return cases;
+}
+
+
+static double angle_diff(double a, double b) {
+  return std::fabs(std::remainder(a - b, 2.0 * M_PI));
+}
+
+
+static void random_walk(int num_waypoints, unsigned int seed, std::vector<double> &x, std::vector<double> &y) {
+  srand(seed);
+  x.assign(1, 0.0);
+  y.assign(1, 0.0);
+  double heading = 0.0;
+  for(int i = 1; i < num_waypoints; i++) {
+    heading += 0.6 * (rand() / (double)RAND_MAX - 0.5);
+    x.push_back(x.back() + 0.5 * std::cos(heading));
+    y.push_back(y.back() + 0.5 * std::sin(heading));
+  }
+}
+
+
+TEST(CubicSpline, matchesPythonPlanner)
+{
+  std::vector<ReferenceCase> cases = load_reference(std::string(SPLINE_TEST_DATA_DIR) + "/spline_reference.txt");
+  ASSERT_FALSE(cases.empty());
+  for(int n = 0; n < cases.size(); n++) {
+    const ReferenceCase &c = cases[n];
+    std::vector<double> rx, ry, ryaw, rk, rs;
+    cubic_spline::calc_spline_course(c.x, c.y, c.ds, rx, ry, ryaw, rk, rs);
+    ASSERT_EQ(rx.size(), c.rx.size()) << "case " << n;
+    for(int i = 0; i < rx.size(); i++) {
+      EXPECT_NEAR(rx[i], c.rx[i], 1e-9) << "case " << n << " sample " << i;
+      EXPECT_NEAR(ry[i], c.ry[i], 1e-9) << "case " << n << " sample " << i;
+      EXPECT_LT(angle_diff(ryaw[i], c.ryaw[i]), 1e-9) << "case " << n << " sample " << i;
+      EXPECT_NEAR(rk[i], c.rk[i], 1e-9 * std::max(1.0, std::fabs(c.rk[i]))) << "case " << n << " sample " << i;
+      EXPECT_NEAR(rs[i], c.rs[i], 1e-9) << "case " << n << " sample " << i;
+    }
+  }
+}
+
+
+TEST(CubicSpline, duplicatedWaypoints)
+{
+  std::vector<double> x = {0.0, 1.0, 1.0, 2.0, 3.0};
+  std::vector<double> y = {0.0, 0.5, 0.5, 0.0, 0.5};
+  std::vector<double> rx, ry, ryaw, rk, rs;
+  cubic_spline::calc_spline_course(x, y, 0.1, rx, ry, ryaw, rk, rs);
+  ASSERT_FALSE(rx.empty());
+  for(int i = 0; i < rx.size(); i++) {
+    EXPECT_TRUE(std::isfinite(rx[i]) && std::isfinite(ry[i]) && std::isfinite(ryaw[i]) && std::isfinite(rk[i]));
+  }
+
+  // A single distinct waypoint gives no course
+  cubic_spline::calc_spline_course({1.0, 1.0}, {2.0, 2.0}, 0.1, rx, ry, ryaw, rk, rs);
+  EXPECT_TRUE(rx.empty());
+}
+
+
+TEST(CubicSpline, nearestMatchesDenseSampling)
+{
+  std::vector<double> x, y;
+  random_walk(40, 1, x, y);
+  cubic_spline::Spline2D sp(x, y);
+
+  srand(2);
+  for(int k = 0; k < 200; k++) {
+    double qx = -1.0 + (rand() / (double)RAND_MAX) * 22.0;
+    double qy = -6.0 + (rand() / (double)RAND_MAX) * 12.0;
+
+    // Dense sampling of the squared distance
+    double best_s = 0.0, best_dist2 = INFINITY;
+    for(double s = 0.0; s <= sp.length(); s += 1e-3) {
+      double px, py;
+      sp.calc_position(s, px, py);
+      double dist2 = (qx - px) * (qx - px) + (qy - py) * (qy - py);
+      if(dist2 < best_dist2) {
+        best_dist2 = dist2;
+        best_s = s;
+      }
+    }
+
+    double crosstrack_error;
+    double s = sp.calc_nearest(qx, qy, crosstrack_error);
+    double px, py;
+    sp.calc_position(s, px, py);
+    double dist = std::hypot(qx - px, qy - py);
+    // Never farther than the sampled minimum, up to the sampling step
+    EXPECT_LE(dist, std::sqrt(best_dist2) + 1e-6) << "query " << qx << " " << qy << " best s " << best_s;
+    // Inside the spline the closest point is the foot of the normal
+    if(s > 0.0 && s < sp.length()) {
+      EXPECT_NEAR(std::fabs(crosstrack_error), dist, 1e-6);
+    }
+  }
+}
+
+
+TEST(CubicSpline, nearestCrosstrackSign)
+{
+  // Straight line along x, the left side is +y
+  cubic_spline::Spline2D sp({0.0, 1.0, 2.0, 3.0}, {0.0, 0.0, 0.0, 0.0});
+  double crosstrack_error;
+  EXPECT_NEAR(sp.calc_nearest(1.3, 0.4, crosstrack_error), 1.3, 1e-9);
+  EXPECT_NEAR(crosstrack_error, 0.4, 1e-9);
+  EXPECT_NEAR(sp.calc_nearest(2.2, -0.7, crosstrack_error, 0.5), 2.2, 1e-9);
+  EXPECT_NEAR(crosstrack_error, -0.7, 1e-9);
+  // Beyond the end the projection is clamped
+  EXPECT_NEAR(sp.calc_nearest(4.0, 0.0, crosstrack_error), 3.0, 1e-9);
+}
+
+
+TEST(CubicSpline, timing)
+{
+  // Fit + resampling and nearest point projection for 10^2 .. 10^4 waypoints
+  for(int num_waypoints = 100; num_waypoints <= 10000; num_waypoints *= 10) {
+    std::vector<double> x, y;
+    random_walk(num_waypoints, 3, x, y);
+
+    std::vector<double> rx, ry, ryaw, rk, rs;
+    const int num_repeats = 10;
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    for(int k = 0; k < num_repeats; k++)
+      cubic_spline::calc_spline_course(x, y, 0.1, rx, ry, ryaw, rk, rs);
+    double course_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count() / num_repeats;
+
+    // Track a point moving along the course, warm started from the previous projection
+    cubic_spline::Spline2D sp(x, y);
+    double s = -1.0, crosstrack_error;
+    begin = std::chrono::steady_clock::now();
+    for(int i = 0; i < rx.size(); i++)
+      s = sp.calc_nearest(rx[i] + 0.1, ry[i] - 0.1, crosstrack_error, s);
+    double nearest_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count() / rx.size();
+
+    std::cout << num_waypoints << " waypoints, " << rx.size() << " samples: calc_spline_course "
+              << course_ms << " ms, calc_nearest " << nearest_us << " us" << std::endl;
+  }
+}
+
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,220 @@
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "cubic_spline.hpp"
+#include "steering_controller.hpp"
+
+using path_tracking::Pose2D;
+using path_tracking::SteeringCommand;
+using path_tracking::SteeringController;
+
+static const double kCmdFreq = 10.0;
+
+
+// Same values as config/walker_dynamics.yaml
+static path_tracking::WalkerDynamics walker_dynamics() {
+  path_tracking::WalkerDynamics dynamics = {30.0, 10.0, 45.0, 20.0, 0.001, 0.001};
+  return dynamics;
+}
+
+static path_tracking::WalkerConstraints walker_constraints() {
+  path_tracking::WalkerConstraints constraints = {6.0, 0.8, 0.5, 0.5};
+  return constraints;
+}
+
+
+// Smooth an S-shaped waypoint list the same way the node does
+static std::vector<Pose2D> s_curve_path(double length, double ds) {
+  std::vector<double> wx, wy;
+  for(double x = 0.0; x <= length + 1e-9; x += 0.5) {
+    wx.push_back(x);
+    wy.push_back(1.0 * std::sin(x * 2.0 * M_PI / 8.0));
+  }
+  std::vector<double> cx, cy, cyaw, ck, s;
+  cubic_spline::calc_spline_course(wx, wy, ds, cx, cy, cyaw, ck, s);
+  std::vector<Pose2D> path(cx.size());
+  for(int i = 0; i < cx.size(); i++) {
+    path[i].x = cx[i];
+    path[i].y = cy[i];
+    path[i].theta = cyaw[i];
+  }
+  return path;
+}
+
+
+static double distance_to_path(const std::vector<Pose2D> &path, double x, double y) {
+  double min_dist = INFINITY;
+  for(int i = 0; i < path.size(); i++)
+    min_dist = std::min(min_dist, std::hypot(x - path[i].x, y - path[i].y));
+  return min_dist;
+}
+
+
+struct ClosedLoopResult {
+  bool goal_reached;
+  int steps;
+  double max_crosstrack_error;
+  double mean_inhibition_force;
+  std::vector<double> v, w;
+};
+
+
+// Unicycle model driven by the controller commands, with a constant user pushing force
+static ClosedLoopResult run_closed_loop(const std::vector<Pose2D> &path, Pose2D pose, double push_force,
+                                       int max_steps, bool check_full_search) {
+  SteeringController controller(walker_dynamics(), walker_constraints(), kCmdFreq, 0.4);
+  controller.set_path(path);
+  path_tracking::UserForce force = {push_force, 0.0, 0.0};
+  const double dt = 1.0 / kCmdFreq;
+
+  ClosedLoopResult result;
+  result.goal_reached = false;
+  result.max_crosstrack_error = 0.0;
+  double sum_inhibition_force = 0.0;
+  double velocity = 0.0;
+  int step;
+  for(step = 0; step < max_steps; step++) {
+    if(check_full_search) {
+      // Along a path which does not fold back, the windowed search finds the global nearest point
+      double error_full, error_windowed;
+      SteeringController probe = controller;
+      int full_idx = probe.calc_target_index_full(pose, error_full);
+      int windowed_idx = probe.calc_target_index(pose, error_windowed);
+      EXPECT_EQ(full_idx, windowed_idx) << "at step " << step;
+      EXPECT_DOUBLE_EQ(error_full, error_windowed);
+    }
+
+    SteeringCommand cmd = controller.update(pose, velocity, force);
+    result.v.push_back(cmd.v);
+    result.w.push_back(cmd.w);
+    sum_inhibition_force += cmd.inhibition_force;
+    if(cmd.goal_reached) {
+      result.goal_reached = true;
+      break;
+    }
+
+    // Unicycle model, the walker follows the velocity command
+    pose.x += cmd.v * std::cos(pose.theta) * dt;
+    pose.y += cmd.v * std::sin(pose.theta) * dt;
+    pose.theta += cmd.w * dt;
+    velocity = cmd.v;
+    if(step > 50)
+      result.max_crosstrack_error = std::max(result.max_crosstrack_error, distance_to_path(path, pose.x, pose.y));
+  }
+  result.steps = step;
+  result.mean_inhibition_force = sum_inhibition_force / std::max(1, step);
+  return result;
+}
+
+
+TEST(SteeringController, closedLoopReachesGoal)
+{
+  std::vector<Pose2D> path = s_curve_path(16.0, 0.1);
+  Pose2D start = {0.0, -0.3, 0.0};
+  ClosedLoopResult result = run_closed_loop(path, start, 20.0, 2000, true);
+
+  EXPECT_TRUE(result.goal_reached);
+  // ~16.5 m at ~0.4 m/s
+  EXPECT_LT(result.steps, 800);
+  EXPECT_LT(result.max_crosstrack_error, 0.5);
+  EXPECT_GE(result.mean_inhibition_force, 0.0);
+  std::cout << "Goal reached in " << result.steps / kCmdFreq << " s, max cross-track error "
+            << result.max_crosstrack_error << " m, mean inhibition force "
+            << result.mean_inhibition_force << " N" << std::endl;
+}
+
+
+TEST(SteeringController, closedLoopIsDeterministic)
+{
+  std::vector<Pose2D> path = s_curve_path(16.0, 0.1);
+  Pose2D start = {0.0, 0.2, 0.1};
+  ClosedLoopResult first = run_closed_loop(path, start, 15.0, 2000, false);
+  ClosedLoopResult second = run_closed_loop(path, start, 15.0, 2000, false);
+  ASSERT_EQ(first.steps, second.steps);
+  ASSERT_EQ(first.v.size(), second.v.size());
+  for(int i = 0; i < first.v.size(); i++) {
+    EXPECT_EQ(first.v[i], second.v[i]);
+    EXPECT_EQ(first.w[i], second.w[i]);
+  }
+}
+
+
+TEST(SteeringController, noPushNoMotion)
+{
+  // Pushing below min_enable_force is ignored, the walker does not move
+  std::vector<Pose2D> path = s_curve_path(4.0, 0.1);
+  Pose2D start = {0.0, 0.0, 0.0};
+  ClosedLoopResult result = run_closed_loop(path, start, 5.0, 50, false);
+  EXPECT_FALSE(result.goal_reached);
+  for(int i = 0; i < result.v.size(); i++)
+    EXPECT_EQ(result.v[i], 0.0);
+}
+
+
+TEST(SteeringController, emptyPathStops)
+{
+  SteeringController controller(walker_dynamics(), walker_constraints(), kCmdFreq, 0.4);
+  Pose2D pose = {0.0, 0.0, 0.0};
+  path_tracking::UserForce force = {20.0, 0.0, 0.0};
+  SteeringCommand cmd = controller.update(pose, 0.0, force);
+  EXPECT_FALSE(cmd.has_path);
+  EXPECT_TRUE(cmd.has_system_torque);
+  EXPECT_EQ(cmd.v, 0.0);
+  EXPECT_EQ(cmd.w, 0.0);
+  // The estop force cancels the user force
+  EXPECT_DOUBLE_EQ(cmd.inhibition_force, 20.0);
+}
+
+
+TEST(SteeringController, samePathKeepsState)
+{
+  std::vector<Pose2D> path = s_curve_path(8.0, 0.1);
+  SteeringController controller(walker_dynamics(), walker_constraints(), kCmdFreq, 0.4);
+  EXPECT_TRUE(controller.set_path(path));
+  EXPECT_FALSE(controller.set_path(path));
+  path.back().x += 0.01;
+  EXPECT_TRUE(controller.set_path(path));
+}
+
+
+TEST(SteeringController, targetSearchTiming)
+{
+  // Per-tick cost of the windowed and the full nearest point search on long paths
+  for(double length = 10.0; length <= 1000.0; length *= 10.0) {
+    std::vector<Pose2D> path = s_curve_path(length, 0.1);
+    SteeringController controller(walker_dynamics(), walker_constraints(), kCmdFreq, 0.4);
+    controller.set_path(path);
+
+    // The robot moves along the whole path, one point per tick
+    const int num_ticks = path.size();
+    double error;
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    for(int k = 0; k < num_ticks; k++) {
+      const Pose2D &p = path[k];
+      Pose2D pose = {p.x - 0.6 * std::cos(p.theta), p.y - 0.6 * std::sin(p.theta), p.theta};
+      controller.calc_target_index(pose, error);
+    }
+    double windowed_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count() / num_ticks;
+
+    begin = std::chrono::steady_clock::now();
+    for(int k = 0; k < num_ticks; k++) {
+      const Pose2D &p = path[k];
+      Pose2D pose = {p.x - 0.6 * std::cos(p.theta), p.y - 0.6 * std::sin(p.theta), p.theta};
+      controller.calc_target_index_full(pose, error);
+    }
+    double full_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count() / num_ticks;
+
+    std::cout << "Path of " << path.size() << " points: windowed search " << windowed_us
+              << " us/tick, full search " << full_us << " us/tick" << std::endl;
+  }
+}
+
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,120 @@
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "walker_simulation.hpp"
+
+using path_tracking::Scenario;
+using path_tracking::ScenarioResult;
+
+
+TEST(WalkerSimulation, pushingForceWave)
+{
+  path_tracking::PushingProfile profile = path_tracking::default_pushing_profile();
+  profile.noise = 0.0;
+  const double rate = 20.0;
+  path_tracking::PushingForceGenerator generator(profile, rate, 0);
+
+  // After the first rise the force oscillates between min_force and max_force
+  double min_force = INFINITY, max_force = -INFINITY;
+  int num_peaks = 0;
+  double last_force = 0.0, last_slope = 0.0;
+  for(int i = 0; i < 100 * rate; i++) {
+    double force = generator.next();
+    if(i > 2 * rate) {
+      min_force = std::min(min_force, force);
+      max_force = std::max(max_force, force);
+      if(last_slope > 0 && force < last_force)
+        num_peaks++;
+    }
+    last_slope = force - last_force;
+    last_force = force;
+  }
+  EXPECT_NEAR(min_force, profile.min_force, 1.0);
+  EXPECT_NEAR(max_force, profile.max_force, 3.0);
+  // One peak per half gait period, the slope changes one sample after crossing the bounds
+  const double expected_num_peaks = 98.0 / (profile.gait_period / 2);
+  EXPECT_NEAR(num_peaks, expected_num_peaks, 0.1 * expected_num_peaks);
+
+  // No pushing after the duration
+  profile.duration = 1.0;
+  path_tracking::PushingForceGenerator stopped(profile, rate, 0);
+  for(int i = 0; i < 2 * rate; i++)
+    stopped.next();
+  EXPECT_EQ(stopped.next(), 0.0);
+}
+
+
+TEST(WalkerSimulation, admittanceSteadyState)
+{
+  path_tracking::SimulationConfig config = path_tracking::default_simulation_config();
+  config.dynamics.constant_fraction_xy = 0.0;
+  config.dynamics.constant_fraction_theta = 0.0;
+  path_tracking::AdmittanceController controller(config.dynamics, config.constraints, config.cmd_freq);
+
+  // v = force / damping_xy, w = torque / damping_theta
+  path_tracking::UserForce force = {9.0, 0.0, 2.0};
+  double v, w;
+  for(int i = 0; i < 1000; i++)
+    controller.update(force, v, w);
+  EXPECT_NEAR(v, 9.0 / config.dynamics.damping_xy, 1e-6);
+  EXPECT_NEAR(w, 2.0 / config.dynamics.damping_theta, 1e-6);
+
+  // Below the enable thresholds the walker stops
+  path_tracking::UserForce small_force = {5.0, 0.0, 0.5};
+  for(int i = 0; i < 1000; i++)
+    controller.update(small_force, v, w);
+  EXPECT_NEAR(v, 0.0, 1e-6);
+  EXPECT_NEAR(w, 0.0, 1e-3);
+}
+
+
+TEST(WalkerSimulation, deterministic)
+{
+  path_tracking::SimulationConfig config = path_tracking::default_simulation_config();
+  std::vector<Scenario> scenarios = path_tracking::make_scenarios(1);
+  for(int i = 0; i < scenarios.size(); i += 7) {
+    ScenarioResult first = path_tracking::run_scenario(config, scenarios[i]);
+    ScenarioResult second = path_tracking::run_scenario(config, scenarios[i]);
+    EXPECT_EQ(first.num_ticks, second.num_ticks) << scenarios[i].name;
+    EXPECT_EQ(first.goal_reach_time, second.goal_reach_time) << scenarios[i].name;
+    EXPECT_EQ(first.rms_crosstrack_error, second.rms_crosstrack_error) << scenarios[i].name;
+    EXPECT_EQ(first.mean_inhibition_force, second.mean_inhibition_force) << scenarios[i].name;
+  }
+}
+
+
+TEST(WalkerSimulation, steeringRegression)
+{
+  // Regression bounds of the steering controller over all the paths and pushing profiles
+  path_tracking::SimulationConfig config = path_tracking::default_simulation_config();
+  std::vector<Scenario> scenarios = path_tracking::make_scenarios(2);
+  double sum_steering_rms = 0.0, sum_admittance_rms = 0.0;
+  for(int i = 0; i < scenarios.size(); i++) {
+    ScenarioResult result = path_tracking::run_scenario(config, scenarios[i]);
+    if(scenarios[i].controller == path_tracking::STEERING_CONTROLLER) {
+      EXPECT_TRUE(result.goal_reached) << result.name;
+      EXPECT_LT(result.rms_crosstrack_error, 0.15) << result.name;
+      EXPECT_LT(result.max_crosstrack_error, 0.5) << result.name;
+      EXPECT_GE(result.mean_inhibition_force, 0.0) << result.name;
+      EXPECT_LT(result.mean_inhibition_force, result.mean_pushing_force) << result.name;
+      // Never faster than max_linear_velocity
+      EXPECT_GT(result.goal_reach_time, result.path_length / config.constraints.max_linear_velocity - 2.0) << result.name;
+      sum_steering_rms += result.rms_crosstrack_error;
+    }
+    else {
+      sum_admittance_rms += result.rms_crosstrack_error;
+    }
+  }
+  std::cout << "Mean rms cross-track error: steering " << 2.0 * sum_steering_rms / scenarios.size()
+            << " m, admittance " << 2.0 * sum_admittance_rms / scenarios.size() << " m" << std::endl;
+  EXPECT_LT(sum_steering_rms, sum_admittance_rms);
+}
+
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
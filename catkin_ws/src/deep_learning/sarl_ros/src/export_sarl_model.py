@@ -0,0 +1,154 @@
+#!/usr/bin/env python3
+'''
+Export a trained SARL model for sarl_policy_node (C++):
+    python3 export_sarl_model.py --model_dir ../models/output_unicycle_sarl
+
+Optionally record reference decisions of the python policy on the observations of a bag
+(topics rl_observation_array and odom_filtered), to be checked with sarl_policy_check:
+    python3 export_sarl_model.py --model_dir ... --bag run.bag --goal 0 4 --reference reference.txt
+
+Model file (little endian):
+    'SARL', int32 version, int32 kinematics (0: holonomic, 1: unicycle),
+    int32 speed_samples, int32 rotation_samples, float32 gamma, float32 time_step,
+    int32 self_state_dim, int32 with_global_state,
+    4 MLPs (mlp1, mlp2, attention, mlp3), each: int32 num_layers, int32 last_relu,
+        and for every layer: int32 out, int32 in, float32 weight[out][in], float32 bias[out]
+'''
+import argparse
+import configparser
+import os
+import struct
+
+import numpy as np
+import torch
+import torch.nn as nn
+
+from crowd_nav.policy.policy_factory import policy_factory
+from crowd_sim.envs.utils.state import FullState, ObservableState, JointState
+
+MODEL_FILE_VERSION = 1
+# Same as sarl_node.py
+MAX_LINEAR_VELOCITY = 0.5
+ROBOT_RADIUS = 0.7
+
+
+def get_tf_matrix(theta, x=0.0, y=0.0):
+    return np.array([[np.cos(theta), -np.sin(theta), x],
+                     [np.sin(theta),  np.cos(theta), y],
+                     [          0.0,            0.0, 1.0]], dtype=np.float32)
+
+
+def write_mlp(f, mlp):
+    linears = [m for m in mlp if isinstance(m, nn.Linear)]
+    f.write(struct.pack('<ii', len(linears), int(isinstance(mlp[-1], nn.ReLU))))
+    for linear in linears:
+        weight = linear.weight.detach().cpu().numpy().astype('<f4')
+        bias = linear.bias.detach().cpu().numpy().astype('<f4')
+        f.write(struct.pack('<ii', weight.shape[0], weight.shape[1]))
+        f.write(weight.tobytes())
+        f.write(bias.tobytes())
+
+
+def load_policy(args):
+    policy_config = configparser.RawConfigParser()
+    policy_config.read(os.path.join(args.model_dir, 'policy.config'))
+    env_config = configparser.RawConfigParser()
+    env_config.read(os.path.join(args.model_dir, 'env.config'))
+
+    policy = policy_factory['sarl']()
+    policy.configure(policy_config)
+    if policy.with_om:
+        raise ValueError('OM-SARL is not supported by the C++ policy')
+    weights = 'il_model.pth' if args.il else \
+        ('resumed_rl_model.pth' if os.path.exists(os.path.join(args.model_dir, 'resumed_rl_model.pth')) else 'rl_model.pth')
+    policy.get_model().load_state_dict(torch.load(os.path.join(args.model_dir, weights), map_location='cpu'))
+    policy.set_phase('test')
+    policy.set_device(torch.device('cpu'))
+    policy.time_step = env_config.getfloat('env', 'time_step')
+    policy.query_env = False    # Humans are propagated with constant velocity, as the C++ policy
+    policy.get_model().eval()
+    return policy, policy_config
+
+
+def export_model(policy, policy_config, output):
+    model = policy.get_model()
+    with open(output, 'wb') as f:
+        f.write(b'SARL')
+        f.write(struct.pack('<iiii', MODEL_FILE_VERSION, 0 if policy.kinematics == 'holonomic' else 1,
+                            policy.speed_samples, policy.rotation_samples))
+        f.write(struct.pack('<ff', policy.gamma, policy.time_step))
+        f.write(struct.pack('<ii', model.self_state_dim, int(policy_config.getboolean('sarl', 'with_global_state'))))
+        for mlp in [model.mlp1, model.mlp2, model.attention, model.mlp3]:
+            write_mlp(f, mlp)
+    print('Export the model to {}'.format(output))
+
+
+def record_reference(policy, args):
+    import rosbag
+    from tf.transformations import euler_from_quaternion
+
+    robot_state = None
+    num_cases = 0
+    with rosbag.Bag(args.bag) as bag, open(args.reference, 'w') as out:
+        for topic, msg, _ in bag.read_messages(topics=[args.odom_topic, args.observation_topic]):
+            if topic == args.odom_topic:
+                q = msg.pose.pose.orientation
+                robot_state = [msg.pose.pose.position.x, msg.pose.pose.position.y,
+                               euler_from_quaternion([q.x, q.y, q.z, q.w])[2]]
+                continue
+            if robot_state is None:
+                continue
+
+            # Same sarl frame as sarl_node.py, fixed by the first odometry and the goal
+            if num_cases == 0:
+                tf_odom2sarl = np.linalg.inv(get_tf_matrix(
+                    theta=np.arctan2(args.goal[1] - robot_state[1], args.goal[0] - robot_state[0]) - np.pi / 2,
+                    x=(args.goal[0] + robot_state[0]) / 2, y=(args.goal[1] + robot_state[1]) / 2))
+            start = np.dot(tf_odom2sarl, get_tf_matrix(robot_state[2], robot_state[0], robot_state[1]))
+            goal = np.dot(tf_odom2sarl, get_tf_matrix(0.0, args.goal[0], args.goal[1]))
+            self_state = FullState(start[0, 2], start[1, 2], 0.0, 0.0, ROBOT_RADIUS, goal[0, 2], goal[1, 2],
+                                   MAX_LINEAR_VELOCITY, np.arctan2(start[1, 0], start[0, 0]))
+            humans = []
+            for obs in msg.trks_list:
+                speed = np.hypot(obs.vx, obs.vy)
+                obs_matrix = np.dot(tf_odom2sarl, get_tf_matrix(np.arctan2(obs.vy, obs.vx), obs.x, obs.y))
+                direction = np.arctan2(obs_matrix[1, 0], obs_matrix[0, 0])
+                humans.append(ObservableState(obs_matrix[0, 2], obs_matrix[1, 2], speed * np.cos(direction),
+                                              speed * np.sin(direction),
+                                              args.dynamic_obstacle_radius if speed > 0.25 else args.static_obstacle_radius))
+            if len(humans) == 0:
+                humans.append(ObservableState(10, 10, 0, 0, 0.5))
+
+            with torch.no_grad():
+                policy.predict(JointState(self_state, humans))
+            if policy.action_values is None or len(policy.action_values) == 0:
+                continue    # Reached the goal, no evaluation
+            fields = [self_state.px, self_state.py, self_state.vx, self_state.vy, self_state.radius,
+                      self_state.gx, self_state.gy, self_state.v_pref, self_state.theta, len(humans)]
+            for human in humans:
+                fields += [human.px, human.py, human.vx, human.vy, human.radius]
+            fields += [len(policy.action_values)] + list(policy.action_values)
+            out.write(' '.join('{:.9g}'.format(float(x)) for x in fields) + '\n')
+            policy.action_values = None
+            num_cases += 1
+    print('Record {} reference decisions to {}'.format(num_cases, args.reference))
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser('Export SARL model for the C++ policy')
+    parser.add_argument('--model_dir', type=str, required=True)
+    parser.add_argument('--il', default=False, action='store_true')
+    parser.add_argument('--output', type=str, default=None, help='default: <model_dir>/sarl_model.bin')
+    parser.add_argument('--bag', type=str, default=None)
+    parser.add_argument('--goal', type=float, nargs=2, default=[0.0, 4.0], help='final goal in odom frame')
+    parser.add_argument('--reference', type=str, default='sarl_reference.txt')
+    parser.add_argument('--odom_topic', type=str, default='/walker/odom_filtered')
+    parser.add_argument('--observation_topic', type=str, default='/walker/rl_observation_array')
+    parser.add_argument('--static_obstacle_radius', type=float, default=0.5)
+    parser.add_argument('--dynamic_obstacle_radius', type=float, default=0.4)
+    args = parser.parse_args()
+
+    policy, policy_config = load_policy(args)
+    export_model(policy, policy_config, args.output or os.path.join(args.model_dir, 'sarl_model.bin'))
+    if args.bag is not None:
+        record_reference(policy, args)
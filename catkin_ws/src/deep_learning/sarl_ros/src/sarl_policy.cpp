@@ -0,0 +1,171 @@
+#include "sarl_policy.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <stdint.h>
+#include <string.h>
+
+// Rewards of MultiHumanRL.compute_reward
+static const double kCollisionPenalty = -0.25;
+static const double kSuccessReward = 1.0;
+static const double kDiscomfortDist = 0.2;
+static const double kDiscomfortPenaltyFactor = 0.5;
+static const int kModelFileVersion = 1;
+
+
+SarlPolicy::SarlPolicy(): holonomic_(false), speed_samples_(5), rotation_samples_(16), gamma_(0.9), time_step_(0.25),
+                          action_space_v_pref_(-1.0) {
+}
+
+
+bool SarlPolicy::load(const std::string &model_file) {
+    std::ifstream file(model_file.c_str(), std::ios::binary);
+    if(!file.is_open())
+        return false;
+
+    char magic[4];
+    int32_t version, kinematics, speed_samples, rotation_samples;
+    float gamma, time_step;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char *>(&version), sizeof(version));
+    file.read(reinterpret_cast<char *>(&kinematics), sizeof(kinematics));
+    file.read(reinterpret_cast<char *>(&speed_samples), sizeof(speed_samples));
+    file.read(reinterpret_cast<char *>(&rotation_samples), sizeof(rotation_samples));
+    file.read(reinterpret_cast<char *>(&gamma), sizeof(gamma));
+    file.read(reinterpret_cast<char *>(&time_step), sizeof(time_step));
+    if(!file.good() || strncmp(magic, "SARL", 4) != 0 || version != kModelFileVersion)
+        return false;
+
+    holonomic_ = (kinematics == 0);
+    speed_samples_ = speed_samples;
+    rotation_samples_ = rotation_samples;
+    gamma_ = gamma;
+    time_step_ = time_step;
+    action_space_.clear();
+    action_space_v_pref_ = -1.0;
+    return network_.load(file) && network_.input_dim() == 13;
+}
+
+
+void SarlPolicy::build_action_space(double v_pref) {
+    // Same order as CADRL.build_action_space: stop, then rotations x speeds
+    action_space_.clear();
+    SarlAction stop = {0.0, 0.0, 0.0, 0.0};
+    action_space_.push_back(stop);
+    for(int i = 0; i < rotation_samples_; i++) {
+        double rotation;
+        if(holonomic_)
+            rotation = 2.0 * M_PI * i / rotation_samples_;
+        else
+            rotation = (rotation_samples_ > 1) ? -M_PI / 4 + (M_PI / 2) * i / (rotation_samples_ - 1) : -M_PI / 4;
+        for(int j = 0; j < speed_samples_; j++) {
+            double speed = (std::exp((j + 1.0) / speed_samples_) - 1.0) / (M_E - 1.0) * v_pref;
+            SarlAction action = {0.0, 0.0, 0.0, 0.0};
+            if(holonomic_) {
+                action.vx = speed * std::cos(rotation);
+                action.vy = speed * std::sin(rotation);
+            }
+            else {
+                action.v = speed;
+                action.r = rotation;
+            }
+            action_space_.push_back(action);
+        }
+    }
+    action_space_v_pref_ = v_pref;
+}
+
+
+SarlFullState SarlPolicy::propagate(const SarlFullState &state, const SarlAction &action) const {
+    SarlFullState next = state;
+    if(holonomic_) {
+        next.vx = action.vx;
+        next.vy = action.vy;
+    }
+    else {
+        next.theta = state.theta + action.r;
+        next.vx = action.v * std::cos(next.theta);
+        next.vy = action.v * std::sin(next.theta);
+    }
+    next.px = state.px + next.vx * time_step_;
+    next.py = state.py + next.vy * time_step_;
+    return next;
+}
+
+
+double SarlPolicy::compute_reward(const SarlFullState &nav, const std::vector<SarlObservableState> &humans) const {
+    double dmin = INFINITY;
+    for(int i = 0; i < humans.size(); i++) {
+        double dist = std::hypot(nav.px - humans[i].px, nav.py - humans[i].py) - nav.radius - humans[i].radius;
+        if(dist < 0)
+            return kCollisionPenalty;
+        dmin = std::min(dmin, dist);
+    }
+    if(std::hypot(nav.px - nav.gx, nav.py - nav.gy) < nav.radius)
+        return kSuccessReward;
+    if(dmin < kDiscomfortDist)
+        return (dmin - kDiscomfortDist) * kDiscomfortPenaltyFactor * time_step_;
+    return 0.0;
+}
+
+
+int SarlPolicy::predict(const SarlFullState &self_state, const std::vector<SarlObservableState> &human_states) {
+    if(action_space_.empty() || action_space_v_pref_ != self_state.v_pref)
+        build_action_space(self_state.v_pref);
+    const int num_actions = action_space_.size();
+    const int num_humans = human_states.size();
+    action_values_.setZero(num_actions);
+
+    // Policy.reach_destination
+    if(num_humans == 0 || std::hypot(self_state.py - self_state.gy, self_state.px - self_state.gx) < self_state.radius)
+        return 0;
+
+    // Humans move with constant velocity, the same for every action
+    next_human_states_.resize(num_humans);
+    for(int h = 0; h < num_humans; h++) {
+        next_human_states_[h] = human_states[h];
+        next_human_states_[h].px += human_states[h].vx * time_step_;
+        next_human_states_[h].py += human_states[h].vy * time_step_;
+    }
+
+    // Rotated joint states (CADRL.rotate), column (action * num_humans + human)
+    // [dg, v_pref, theta, radius, vx, vy, px1, py1, vx1, vy1, radius1, da, radius_sum]
+    rotated_states_.resize(13, num_actions * num_humans);
+    for(int a = 0; a < num_actions; a++) {
+        SarlFullState next = propagate(self_state, action_space_[a]);
+        action_values_[a] = compute_reward(next, next_human_states_);
+
+        double rot = std::atan2(next.gy - next.py, next.gx - next.px);
+        double cos_rot = std::cos(rot), sin_rot = std::sin(rot);
+        double dg = std::hypot(next.gx - next.px, next.gy - next.py);
+        double vx = next.vx * cos_rot + next.vy * sin_rot;
+        double vy = next.vy * cos_rot - next.vx * sin_rot;
+        double theta = holonomic_ ? 0.0 : next.theta - rot;
+        for(int h = 0; h < num_humans; h++) {
+            const SarlObservableState &human = next_human_states_[h];
+            double dx = human.px - next.px;
+            double dy = human.py - next.py;
+            Eigen::MatrixXf::ColXpr col = rotated_states_.col(a * num_humans + h);
+            col << dg, next.v_pref, theta, next.radius, vx, vy,
+                   dx * cos_rot + dy * sin_rot,
+                   dy * cos_rot - dx * sin_rot,
+                   human.vx * cos_rot + human.vy * sin_rot,
+                   human.vy * cos_rot - human.vx * sin_rot,
+                   human.radius,
+                   std::hypot(dx, dy),
+                   next.radius + human.radius;
+        }
+    }
+
+    // One forward pass for all actions
+    network_.evaluate(rotated_states_, num_actions, num_humans, next_values_);
+    double discount = std::pow(gamma_, time_step_ * self_state.v_pref);
+    int best = 0;
+    for(int a = 0; a < num_actions; a++) {
+        action_values_[a] += discount * next_values_[a];
+        if(action_values_[a] > action_values_[best])
+            best = a;
+    }
+    return best;
+}
@@ -0,0 +1,71 @@
+#ifndef SARL_POLICY_H
+#define SARL_POLICY_H
+
+#include <string>
+#include <vector>
+
+// Eigen
+#include <Eigen/Dense>
+
+#include "sarl_value_network.h"
+
+
+// Same fields as crowd_sim FullState and ObservableState
+struct SarlFullState {
+    double px, py, vx, vy, radius, gx, gy, v_pref, theta;
+};
+
+struct SarlObservableState {
+    double px, py, vx, vy, radius;
+};
+
+// ActionXY (vx, vy) for holonomic, ActionRot (v, r) for unicycle
+struct SarlAction {
+    double vx, vy;
+    double v, r;
+};
+
+
+// One-step lookahead policy of crowd_nav MultiHumanRL with the SARL value network.
+// Humans are propagated with constant velocity (query_env = false), which is the only
+// option with real observations. Rotated joint states of all actions x humans are built
+// into one matrix and evaluated in a single batched forward pass.
+class SarlPolicy {
+public:
+    SarlPolicy();
+
+    // Model file from export_sarl_model.py: policy configuration followed by the network
+    bool load(const std::string &model_file);
+
+    // Index of the best action in action_space(), the values are kept in action_values()
+    int predict(const SarlFullState &self_state, const std::vector<SarlObservableState> &human_states);
+
+    const std::vector<SarlAction> &action_space() const { return action_space_; }
+    const Eigen::VectorXf &action_values() const { return action_values_; }
+    const SarlValueNetwork &network() const { return network_; }
+    bool is_holonomic() const { return holonomic_; }
+    double time_step() const { return time_step_; }
+
+private:
+    void build_action_space(double v_pref);
+    SarlFullState propagate(const SarlFullState &state, const SarlAction &action) const;
+    double compute_reward(const SarlFullState &nav, const std::vector<SarlObservableState> &humans) const;
+
+    SarlValueNetwork network_;
+    bool holonomic_;
+    int speed_samples_;
+    int rotation_samples_;
+    double gamma_;
+    double time_step_;
+
+    std::vector<SarlAction> action_space_;
+    double action_space_v_pref_;
+
+    // Preallocated workspaces
+    std::vector<SarlObservableState> next_human_states_;
+    Eigen::MatrixXf rotated_states_;
+    Eigen::VectorXf next_values_;
+    Eigen::VectorXf action_values_;
+};
+
+#endif
@@ -0,0 +1,88 @@
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "sarl_policy.h"
+
+
+// Check SarlPolicy against the decisions of the python policy recorded by
+// export_sarl_model.py --bag, and report the decision latency.
+// Usage: sarl_policy_check <sarl_model.bin> <sarl_reference.txt> [repeat]
+int main(int argc, char **argv) {
+    if(argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <sarl_model.bin> <sarl_reference.txt> [repeat]" << std::endl;
+        return -1;
+    }
+    int repeat = (argc > 3) ? std::atoi(argv[3]) : 100;
+
+    SarlPolicy policy;
+    if(!policy.load(argv[1])) {
+        std::cerr << "Cannot load the SARL model: " << argv[1] << std::endl;
+        return -1;
+    }
+    std::ifstream file(argv[2]);
+    if(!file.is_open()) {
+        std::cerr << "Cannot read reference file: " << argv[2] << std::endl;
+        return -1;
+    }
+
+    int num_cases = 0, num_same_action = 0, max_humans = 0;
+    double max_value_error = 0.0, sum_latency = 0.0, max_latency = 0.0;
+    std::string line;
+    while(std::getline(file, line)) {
+        std::istringstream ss(line);
+        SarlFullState self_state;
+        int num_humans, num_actions;
+        if(!(ss >> self_state.px >> self_state.py >> self_state.vx >> self_state.vy >> self_state.radius
+                >> self_state.gx >> self_state.gy >> self_state.v_pref >> self_state.theta >> num_humans))
+            continue;
+        std::vector<SarlObservableState> humans(num_humans);
+        for(int h = 0; h < num_humans; h++)
+            ss >> humans[h].px >> humans[h].py >> humans[h].vx >> humans[h].vy >> humans[h].radius;
+        ss >> num_actions;
+        std::vector<double> ref_values(num_actions);
+        for(int a = 0; a < num_actions; a++)
+            ss >> ref_values[a];
+        if(!ss)
+            continue;
+
+        int best = 0;
+        for(int k = 0; k < repeat; k++) {
+            std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+            best = policy.predict(self_state, humans);
+            double latency = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+            sum_latency += latency;
+            max_latency = std::max(max_latency, latency);
+        }
+        if(policy.action_values().size() != num_actions) {
+            std::cerr << "Action space size mismatch: " << policy.action_values().size() << " vs " << num_actions << std::endl;
+            return -1;
+        }
+
+        int ref_best = 0;
+        for(int a = 0; a < num_actions; a++) {
+            max_value_error = std::max(max_value_error, std::fabs(policy.action_values()[a] - ref_values[a]));
+            if(ref_values[a] > ref_values[ref_best])
+                ref_best = a;
+        }
+        num_same_action += (best == ref_best);
+        max_humans = std::max(max_humans, num_humans);
+        num_cases++;
+    }
+    if(num_cases == 0) {
+        std::cerr << "No reference decision in " << argv[2] << std::endl;
+        return -1;
+    }
+
+    std::cout << "Decisions: " << num_cases << ", actions: " << policy.action_space().size()
+              << ", max humans: " << max_humans << std::endl;
+    std::cout << "Same action: " << num_same_action << "/" << num_cases
+              << ", max |value error|: " << max_value_error << std::endl;
+    std::cout << "Decision latency: mean " << sum_latency * 1000.0 / (num_cases * repeat)
+              << " ms, max " << max_latency * 1000.0 << " ms" << std::endl;
+    return (num_same_action == num_cases) ? 0 : 1;
+}
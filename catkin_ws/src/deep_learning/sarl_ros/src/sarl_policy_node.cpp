@@ -0,0 +1,380 @@
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "ros/ros.h"
+#include <ros/package.h>
+#include <geometry_msgs/Twist.h>
+#include <geometry_msgs/PoseStamped.h>
+#include <nav_msgs/Odometry.h>
+#include <std_srvs/Empty.h>
+#include <visualization_msgs/Marker.h>
+#include <visualization_msgs/MarkerArray.h>
+#include <walker_msgs/Trk3DArray.h>
+#include <walker_msgs/Trk3D.h>
+
+// TF
+#include <tf/transform_datatypes.h>
+
+// Eigen
+#include <Eigen/Dense>
+
+#include "sarl_policy.h"
+
+
+static const double kMaxAngularVelocity = 0.5;
+static const double kMaxLinearVelocity = 0.5;
+static const double kRobotRadius = 0.7;         // need to be consistent with footprint approach
+static const double kRobotWheelsDistance = 0.6;
+
+
+static Eigen::Matrix3d get_tf_matrix(double theta, double x = 0.0, double y = 0.0) {
+    Eigen::Matrix3d mat;
+    mat << std::cos(theta), -std::sin(theta), x,
+           std::sin(theta),  std::cos(theta), y,
+           0.0,              0.0,             1.0;
+    return mat;
+}
+
+
+static double normalize_angle(double theta) {
+    while(theta >= M_PI * 2) theta -= M_PI * 2;
+    while(theta < 0) theta += M_PI * 2;
+    return theta;
+}
+
+
+// C++ version of sarl_node.py for the SARL policy. Same topics and services, the
+// observations from scan2observation_node are cached by a subscriber instead of
+// waiting for a message in the timer callback.
+class SarlPolicyNode {
+public:
+    SarlPolicyNode(ros::NodeHandle nh, ros::NodeHandle pnh);
+    void odom_cb(const nav_msgs::Odometry::ConstPtr &msg);
+    void finalgoal_cb(const geometry_msgs::PoseStamped::ConstPtr &msg);
+    void observation_cb(const walker_msgs::Trk3DArray::ConstPtr &msg);
+    bool cancel_cb(std_srvs::Empty::Request &req, std_srvs::Empty::Response &res);
+    void timer_cb(const ros::TimerEvent &event);
+    void publish_robot_status_marker(const std::string &str_message);
+    void pack_marker(visualization_msgs::MarkerArray &marker_array, const walker_msgs::Trk3D &obs_info);
+
+    // ROS related
+    ros::NodeHandle nh_, pnh_;
+    ros::Subscriber sub_odom_;
+    ros::Subscriber sub_finalgoal_;
+    ros::Subscriber sub_observation_;
+    ros::Publisher pub_cmd_;
+    ros::Publisher pub_mrk_vis_;
+    ros::Publisher pub_mrk_status_;
+    ros::Publisher pub_path_vis_;
+    ros::ServiceServer srv_cancel_;
+    ros::Timer timer_;
+
+    SarlPolicy policy_;
+    double cmd_freq_;
+    double goal_tolerance_;
+    double static_obstacle_radius_;
+    double dynamic_obstacle_radius_;
+
+    // States
+    bool has_robot_state_, has_finalgoal_;
+    Eigen::Vector3d robot_state_;           // x, y, yaw in odom
+    Eigen::Vector2d finalgoal_;
+    Eigen::Matrix3d tf_odom2sarl_;
+    Eigen::Vector2d robot_velocity_;        // Last commanded velocity in sarl frame
+    walker_msgs::Trk3DArray::ConstPtr observation_msg_;
+    ros::Time observation_time_;
+
+    visualization_msgs::Marker mrk_robot_status_;
+    visualization_msgs::MarkerArray mrk_array_;
+
+    // Decision latency
+    double sum_latency_, max_latency_;
+    int num_decisions_;
+};
+
+
+SarlPolicyNode::SarlPolicyNode(ros::NodeHandle nh, ros::NodeHandle pnh): nh_(nh), pnh_(pnh) {
+    // ROS parameters
+    std::string model_file;
+    pnh_.param<std::string>("model_file", model_file, ros::package::getPath("sarl_ros") + "/models/output_unicycle_sarl/sarl_model.bin");
+    pnh_.param<double>("cmd_freq", cmd_freq_, 5.0);
+    pnh_.param<double>("goal_tolerance", goal_tolerance_, 0.4);
+    pnh_.param<double>("static_obstacle_radius", static_obstacle_radius_, 0.4);
+    pnh_.param<double>("dynamic_obstacle_radius", dynamic_obstacle_radius_, 0.4);
+    ros::param::set("navi_approach", "SARL");
+
+    if(!policy_.load(model_file)) {
+        ROS_ERROR("Cannot load the SARL model: %s. Aborting...", model_file.c_str());
+        exit(-1);
+    }
+    ROS_INFO("Policy: SARL (%s), %d actions, from %s", policy_.is_holonomic() ? "holonomic" : "unicycle",
+             (int)policy_.action_space().size(), model_file.c_str());
+
+    has_robot_state_ = has_finalgoal_ = false;
+    tf_odom2sarl_.setIdentity();
+    robot_velocity_.setZero();
+    sum_latency_ = max_latency_ = 0.0;
+    num_decisions_ = 0;
+
+    // Markers
+    visualization_msgs::Marker mrk_goal;
+    mrk_goal.header.frame_id = "odom";
+    mrk_goal.ns = "subgoal";
+    mrk_goal.type = visualization_msgs::Marker::SPHERE;
+    mrk_goal.action = visualization_msgs::Marker::ADD;
+    mrk_goal.pose.orientation.w = 1.0;
+    mrk_goal.scale.x = mrk_goal.scale.y = mrk_goal.scale.z = 0.4;
+    mrk_goal.color.a = 0.0;     // Set transparent at beginning
+    mrk_goal.color.g = 1.0;
+    mrk_goal.lifetime = ros::Duration(30.0);
+    mrk_goal.id = 0;
+    mrk_array_.markers.push_back(mrk_goal);
+
+    mrk_robot_status_.header.frame_id = "base_link";
+    mrk_robot_status_.ns = "robot_status";
+    mrk_robot_status_.type = visualization_msgs::Marker::TEXT_VIEW_FACING;
+    mrk_robot_status_.action = visualization_msgs::Marker::ADD;
+    mrk_robot_status_.pose.orientation.w = 1.0;
+    mrk_robot_status_.pose.position.z = 1.5;
+    mrk_robot_status_.scale.z = 0.4;
+    mrk_robot_status_.color.a = mrk_robot_status_.color.r = mrk_robot_status_.color.g = mrk_robot_status_.color.b = 1.0;
+    mrk_robot_status_.lifetime = ros::Duration(8.0);
+
+    // ROS publishers & subscribers
+    sub_odom_ = nh_.subscribe("odom_filtered", 1, &SarlPolicyNode::odom_cb, this);
+    sub_finalgoal_ = nh_.subscribe("/move_base_simple/goal", 1, &SarlPolicyNode::finalgoal_cb, this);
+    sub_observation_ = nh_.subscribe("rl_observation_array", 1, &SarlPolicyNode::observation_cb, this);
+    pub_cmd_ = nh_.advertise<geometry_msgs::Twist>("cmd_vel", 1);
+    pub_mrk_vis_ = nh_.advertise<visualization_msgs::MarkerArray>("clustering_result", 1);
+    pub_mrk_status_ = nh_.advertise<visualization_msgs::Marker>("robot_status", 1);
+    pub_path_vis_ = nh_.advertise<visualization_msgs::MarkerArray>("path_vis", 1);     // The same topic with path_fing_node
+    srv_cancel_ = nh_.advertiseService("cancel_navigation", &SarlPolicyNode::cancel_cb, this);
+    timer_ = nh_.createTimer(ros::Duration(1.0 / cmd_freq_), &SarlPolicyNode::timer_cb, this);
+
+    ROS_INFO_STREAM(ros::this_node::getName() + " is ready.");
+}
+
+
+void SarlPolicyNode::publish_robot_status_marker(const std::string &str_message) {
+    mrk_robot_status_.text = str_message;
+    mrk_robot_status_.header.stamp = ros::Time();
+    pub_mrk_status_.publish(mrk_robot_status_);
+}
+
+
+bool SarlPolicyNode::cancel_cb(std_srvs::Empty::Request &req, std_srvs::Empty::Response &res) {
+    has_finalgoal_ = false;
+    pub_cmd_.publish(geometry_msgs::Twist());
+    pub_cmd_.publish(geometry_msgs::Twist());
+    return true;
+}
+
+
+void SarlPolicyNode::odom_cb(const nav_msgs::Odometry::ConstPtr &msg) {
+    robot_state_ << msg->pose.pose.position.x, msg->pose.pose.position.y, tf::getYaw(msg->pose.pose.orientation);
+    has_robot_state_ = true;
+}
+
+
+void SarlPolicyNode::observation_cb(const walker_msgs::Trk3DArray::ConstPtr &msg) {
+    observation_msg_ = msg;
+    observation_time_ = ros::Time::now();
+}
+
+
+void SarlPolicyNode::finalgoal_cb(const geometry_msgs::PoseStamped::ConstPtr &msg) {
+    // Goal visualization
+    mrk_array_.markers[0].pose = msg->pose;
+    mrk_array_.markers[0].color.a = 0.8;
+    pub_path_vis_.publish(mrk_array_);
+    publish_robot_status_marker("Get a new goal");
+
+    ROS_INFO("Get the finalgoal msg");
+    if(msg->header.frame_id.find("odom") == std::string::npos) {
+        ROS_ERROR("The finalgoal is not assigned in the global frame, aborting...");
+        timer_.stop();
+        ros::shutdown();
+        return;
+    }
+    if(!has_robot_state_) {
+        ROS_WARN("Cannot get robot odom info, ignore the finalgoal.");
+        return;
+    }
+    finalgoal_ << msg->pose.position.x, msg->pose.position.y;
+    has_finalgoal_ = true;
+
+    // SARL frame: origin at the middle of start and goal, y axis toward the goal
+    Eigen::Matrix3d tf_sarl2odom = get_tf_matrix(std::atan2(finalgoal_[1] - robot_state_[1], finalgoal_[0] - robot_state_[0]) - M_PI / 2,
+                                                 (finalgoal_[0] + robot_state_[0]) / 2,
+                                                 (finalgoal_[1] + robot_state_[1]) / 2);
+    tf_odom2sarl_ = tf_sarl2odom.inverse();
+    robot_velocity_.setZero();
+
+    Eigen::Vector3d sarl_goal = tf_odom2sarl_ * Eigen::Vector3d(finalgoal_[0], finalgoal_[1], 1.0);
+    Eigen::Vector3d sarl_start = tf_odom2sarl_ * Eigen::Vector3d(robot_state_[0], robot_state_[1], 1.0);
+    ROS_INFO("current position: (%.2f, %.2f)", sarl_start[0], sarl_start[1]);
+    ROS_INFO("goal position: (%.2f, %.2f)", sarl_goal[0], sarl_goal[1]);
+}
+
+
+void SarlPolicyNode::pack_marker(visualization_msgs::MarkerArray &marker_array, const walker_msgs::Trk3D &obs_info) {
+    visualization_msgs::Marker marker;
+    marker.header.frame_id = "odom";
+    marker.header.stamp = ros::Time(0);
+    marker.ns = "clustering_result";
+    marker.id = marker_array.markers.size();
+    marker.type = visualization_msgs::Marker::CYLINDER;
+    marker.lifetime = ros::Duration(0.5);
+    marker.action = visualization_msgs::Marker::ADD;
+    marker.pose.position.x = obs_info.x;
+    marker.pose.position.y = obs_info.y;
+    marker.pose.position.z = 1.0;
+    marker.pose.orientation.w = 1.0;
+    bool is_static = (obs_info.vx == 0.0 && obs_info.vy == 0.0);
+    marker.scale.x = marker.scale.y = (is_static ? static_obstacle_radius_ : dynamic_obstacle_radius_) * 2;
+    marker.scale.z = 1.0;
+    marker.color.a = 0.4;
+    if(is_static) marker.color.g = 1.0;
+    else marker.color.r = 1.0;
+    marker_array.markers.push_back(marker);
+}
+
+
+void SarlPolicyNode::timer_cb(const ros::TimerEvent &event) {
+    // Skip empty finalgoal
+    if(!has_finalgoal_) {
+        ROS_WARN("Yet to set the finalgoal in rviz.");
+        return;
+    }
+    else if(!has_robot_state_) {
+        ROS_WARN("Cannot get robot odom info, skipping this timer callback.");
+        return;
+    }
+
+    // Goal arrival situation
+    double dis_robot2goal = std::hypot(robot_state_[0] - finalgoal_[0], robot_state_[1] - finalgoal_[1]);
+    if(dis_robot2goal < (goal_tolerance_ - 0.02)) {
+        has_finalgoal_ = false;
+        ROS_INFO("goal reached! %.2f", dis_robot2goal);
+        pub_cmd_.publish(geometry_msgs::Twist());
+        return;
+    }
+
+    // Robot state in sarl frame
+    Eigen::Matrix3d sarl_start = tf_odom2sarl_ * get_tf_matrix(robot_state_[2], robot_state_[0], robot_state_[1]);
+    Eigen::Matrix3d sarl_goal = tf_odom2sarl_ * get_tf_matrix(0.0, finalgoal_[0], finalgoal_[1]);
+    SarlFullState self_state;
+    self_state.px = sarl_start(0, 2);
+    self_state.py = sarl_start(1, 2);
+    self_state.vx = robot_velocity_[0];
+    self_state.vy = robot_velocity_[1];
+    self_state.radius = kRobotRadius;
+    self_state.gx = sarl_goal(0, 2);
+    self_state.gy = sarl_goal(1, 2);
+    self_state.v_pref = kMaxLinearVelocity;
+    self_state.theta = std::atan2(sarl_start(1, 0), sarl_start(0, 0));
+
+    // Collect observations in sarl frame
+    std::vector<SarlObservableState> observations;
+    visualization_msgs::MarkerArray marker_array;
+    if(observation_msg_ && (ros::Time::now() - observation_time_).toSec() < 2.0 / cmd_freq_) {
+        for(int i = 0; i < observation_msg_->trks_list.size(); i++) {
+            const walker_msgs::Trk3D &obs_info = observation_msg_->trks_list[i];
+            double obs_direction = std::atan2(obs_info.vy, obs_info.vx);
+            double obs_speed = std::hypot(obs_info.vx, obs_info.vy);
+            Eigen::Matrix3d sarl_obs = tf_odom2sarl_ * get_tf_matrix(obs_direction, obs_info.x, obs_info.y);
+            double sarl_obs_direction = std::atan2(sarl_obs(1, 0), sarl_obs(0, 0));
+            SarlObservableState ob;
+            ob.px = sarl_obs(0, 2);
+            ob.py = sarl_obs(1, 2);
+            ob.vx = obs_speed * std::cos(sarl_obs_direction);
+            ob.vy = obs_speed * std::sin(sarl_obs_direction);
+            ob.radius = (obs_speed > 0.25) ? dynamic_obstacle_radius_ : static_obstacle_radius_;
+            observations.push_back(ob);
+
+            // Visualization
+            pack_marker(marker_array, obs_info);
+        }
+    }
+    else {
+        ROS_WARN_THROTTLE(5.0, "Cannot get obseravation msg %.2f sec(s), use the fake msg.", 1.0 / cmd_freq_);
+    }
+
+    // If there are no any observations, create a fake one
+    if(observations.size() == 0) {
+        SarlObservableState fake = {10, 10, 0, 0, 0.5};
+        observations.push_back(fake);
+    }
+
+    // Feed the observations to the policy
+    ros::WallTime start = ros::WallTime::now();
+    const SarlAction &action = policy_.action_space()[policy_.predict(self_state, observations)];
+    double latency = (ros::WallTime::now() - start).toSec();
+    sum_latency_ += latency;
+    max_latency_ = std::max(max_latency_, latency);
+    num_decisions_++;
+    ROS_INFO_THROTTLE(10.0, "Decision latency: %.3f ms (mean %.3f ms, max %.3f ms over %d decisions, %d humans)",
+                      latency * 1000.0, sum_latency_ * 1000.0 / num_decisions_, max_latency_ * 1000.0, num_decisions_,
+                      (int)observations.size());
+
+    geometry_msgs::Twist cmd_msg;
+    if(policy_.is_holonomic()) {
+        // Holonomic action (vx, vy) --> (v, w)
+        double desired_theta = std::atan2(action.vy, action.vx);
+        if(std::fabs(desired_theta - self_state.theta) > M_PI / 4) {
+            // Deal with high rotation angle situation
+            double diff_angle = normalize_angle(desired_theta - self_state.theta);
+            cmd_msg.angular.z = (diff_angle > M_PI) ? -kMaxAngularVelocity : kMaxAngularVelocity;
+            cmd_msg.linear.x = std::fabs(cmd_msg.angular.z) * kRobotWheelsDistance / 2;
+        }
+        else {
+            cmd_msg.angular.z = std::max(-kMaxAngularVelocity, std::min(kMaxAngularVelocity, desired_theta - self_state.theta));
+            cmd_msg.linear.x = std::hypot(action.vx, action.vy);
+        }
+
+        // Predict the robot safety in the next 0.5 seconds
+        bool flag_danger = false;
+        for(int k = 1; k <= 5 && !flag_danger; k++) {
+            double delta_t = 0.1 * k;
+            double robot_theta = self_state.theta + cmd_msg.angular.z * delta_t;
+            double robot_x = self_state.px + std::cos(robot_theta) * cmd_msg.linear.x * delta_t;
+            double robot_y = self_state.py + std::sin(robot_theta) * cmd_msg.linear.x * delta_t;
+            for(int i = 0; i < observations.size(); i++) {
+                const SarlObservableState &ob = observations[i];
+                if(std::hypot(ob.px - self_state.px, ob.py - self_state.py) >= ob.radius + kRobotRadius * 2)
+                    continue;
+                if(std::hypot(ob.px + ob.vx * delta_t - robot_x, ob.py + ob.vy * delta_t - robot_y) < ob.radius + kRobotRadius) {
+                    flag_danger = true;
+                    break;
+                }
+            }
+        }
+        if(flag_danger) {
+            publish_robot_status_marker("Get danger, stopping");
+            ROS_INFO("Get danger due to simulated-holonomic motion, stopping...");
+            cmd_msg = geometry_msgs::Twist();
+        }
+        robot_velocity_ << action.vx, action.vy;
+    }
+    else {
+        // Unicycle action (v, r)
+        cmd_msg.linear.x = action.v;
+        cmd_msg.angular.z = action.r;
+        robot_velocity_ << action.v * std::cos(self_state.theta + action.r), action.v * std::sin(self_state.theta + action.r);
+    }
+    pub_cmd_.publish(cmd_msg);
+
+    // Publish visualization msg if there are any subscribers existed
+    if(pub_mrk_vis_.getNumSubscribers() > 0)
+        pub_mrk_vis_.publish(marker_array);
+}
+
+
+int main(int argc, char **argv) {
+    ros::init(argc, argv, "sarl_policy_node");
+    ros::NodeHandle nh, pnh("~");
+    SarlPolicyNode node(nh, pnh);
+    ros::spin();
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include "sarl_value_network.h"
+
+#include <cmath>
+#include <istream>
+#include <stdint.h>
+
+
+template <typename T>
+static bool read_value(std::istream &stream, T &value) {
+    stream.read(reinterpret_cast<char *>(&value), sizeof(T));
+    return stream.good();
+}
+
+
+static bool read_mlp(std::istream &stream, SarlValueNetwork::Mlp &mlp) {
+    int32_t num_layers, last_relu;
+    if(!read_value(stream, num_layers) || !read_value(stream, last_relu) || num_layers <= 0)
+        return false;
+    mlp.last_relu = (last_relu != 0);
+    mlp.layers.resize(num_layers);
+    for(int i = 0; i < num_layers; i++) {
+        int32_t rows, cols;
+        if(!read_value(stream, rows) || !read_value(stream, cols) || rows <= 0 || cols <= 0)
+            return false;
+        // Row major as torch nn.Linear
+        Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> weight(rows, cols);
+        mlp.layers[i].bias.resize(rows);
+        stream.read(reinterpret_cast<char *>(weight.data()), sizeof(float) * rows * cols);
+        stream.read(reinterpret_cast<char *>(mlp.layers[i].bias.data()), sizeof(float) * rows);
+        if(!stream.good())
+            return false;
+        mlp.layers[i].weight = weight;
+        if(i > 0 && mlp.layers[i].weight.cols() != mlp.layers[i - 1].weight.rows())
+            return false;
+    }
+    return true;
+}
+
+
+void SarlValueNetwork::Mlp::forward(const Eigen::MatrixXf &input, std::vector<Eigen::MatrixXf> &buffers) const {
+    buffers.resize(layers.size());
+    const Eigen::MatrixXf *x = &input;
+    for(int i = 0; i < layers.size(); i++) {
+        Eigen::MatrixXf &y = buffers[i];
+        y.resize(layers[i].weight.rows(), x->cols());
+        y.noalias() = layers[i].weight * (*x);
+        y.colwise() += layers[i].bias;
+        if(i != layers.size() - 1 || last_relu)
+            y = y.cwiseMax(0.0f);
+        x = &y;
+    }
+}
+
+
+SarlValueNetwork::SarlValueNetwork(): self_state_dim_(6), with_global_state_(true) {
+}
+
+
+bool SarlValueNetwork::load(std::istream &stream) {
+    int32_t self_state_dim, with_global_state;
+    if(!read_value(stream, self_state_dim) || !read_value(stream, with_global_state))
+        return false;
+    self_state_dim_ = self_state_dim;
+    with_global_state_ = (with_global_state != 0);
+
+    if(!read_mlp(stream, mlp1_) || !read_mlp(stream, mlp2_) || !read_mlp(stream, attention_) || !read_mlp(stream, mlp3_))
+        return false;
+
+    // Shapes must chain as in sarl.py
+    int global_dim = mlp1_.output_dim();
+    return mlp2_.input_dim() == global_dim &&
+           attention_.input_dim() == (with_global_state_ ? global_dim * 2 : global_dim) &&
+           attention_.output_dim() == 1 &&
+           mlp3_.input_dim() == mlp2_.output_dim() + self_state_dim_ &&
+           mlp3_.output_dim() == 1;
+}
+
+
+void SarlValueNetwork::evaluate(const Eigen::MatrixXf &states, int num_actions, int num_humans, Eigen::VectorXf &values) {
+    const int batch = num_actions * num_humans;
+
+    mlp1_.forward(states, mlp1_buffers_);
+    const Eigen::MatrixXf &mlp1_output = mlp1_buffers_.back();
+    mlp2_.forward(mlp1_output, mlp2_buffers_);
+    const Eigen::MatrixXf &features = mlp2_buffers_.back();
+
+    // Attention input: [mlp1 output; mean of mlp1 output over the humans of the same action]
+    const int global_dim = mlp1_output.rows();
+    if(with_global_state_) {
+        attention_input_.resize(global_dim * 2, batch);
+        attention_input_.topRows(global_dim) = mlp1_output;
+        for(int a = 0; a < num_actions; a++) {
+            attention_input_.block(global_dim, a * num_humans, global_dim, num_humans) =
+                mlp1_output.middleCols(a * num_humans, num_humans).rowwise().mean().replicate(1, num_humans);
+        }
+        attention_.forward(attention_input_, attention_buffers_);
+    }
+    else {
+        attention_.forward(mlp1_output, attention_buffers_);
+    }
+    const Eigen::MatrixXf &scores = attention_buffers_.back();
+
+    // Masked softmax over the humans, then the weighted sum of the features
+    const int self_dim = self_state_dim_;
+    const int feature_dim = features.rows();
+    attention_weights_.resize(num_humans, num_actions);
+    joint_state_.resize(self_dim + feature_dim, num_actions);
+    for(int a = 0; a < num_actions; a++) {
+        Eigen::MatrixXf::ColXpr weights = attention_weights_.col(a);
+        for(int h = 0; h < num_humans; h++) {
+            float score = scores(0, a * num_humans + h);
+            weights[h] = (score != 0.0f) ? std::exp(score) : 0.0f;
+        }
+        weights /= weights.sum();
+
+        joint_state_.block(0, a, self_dim, 1) = states.block(0, a * num_humans, self_dim, 1);
+        joint_state_.block(self_dim, a, feature_dim, 1).noalias() = features.middleCols(a * num_humans, num_humans) * weights;
+    }
+
+    mlp3_.forward(joint_state_, mlp3_buffers_);
+    values = mlp3_buffers_.back().row(0).transpose();
+}
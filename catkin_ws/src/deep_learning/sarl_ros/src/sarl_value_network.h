@@ -0,0 +1,60 @@
+#ifndef SARL_VALUE_NETWORK_H
+#define SARL_VALUE_NETWORK_H
+
+#include <string>
+#include <vector>
+
+// Eigen
+#include <Eigen/Dense>
+
+
+// SARL value network (crowd_nav/policy/sarl.py) with Eigen.
+// All the (action, human) pairs of one decision are evaluated together: every layer
+// is one matrix product over a (features x num_actions*num_humans) matrix, and the
+// attention pooling is done per action on contiguous column blocks.
+// The weights are exported by export_sarl_model.py, see the file layout there.
+class SarlValueNetwork {
+public:
+    struct Layer {
+        Eigen::MatrixXf weight;     // out x in
+        Eigen::VectorXf bias;
+    };
+
+    struct Mlp {
+        std::vector<Layer> layers;
+        bool last_relu;
+
+        // Every layer writes into its own buffer, the last one holds the output
+        void forward(const Eigen::MatrixXf &input, std::vector<Eigen::MatrixXf> &buffers) const;
+        int input_dim() const { return layers.front().weight.cols(); }
+        int output_dim() const { return layers.back().weight.rows(); }
+    };
+
+    SarlValueNetwork();
+
+    // Read the network part of the model file, the stream is positioned right after it
+    bool load(std::istream &stream);
+
+    // states: rotated joint states, column (action * num_humans + human)
+    // values: value of the next state for every action
+    void evaluate(const Eigen::MatrixXf &states, int num_actions, int num_humans, Eigen::VectorXf &values);
+
+    int input_dim() const { return mlp1_.input_dim(); }
+    int self_state_dim() const { return self_state_dim_; }
+
+    // Attention weights of the last evaluation, column per action
+    const Eigen::MatrixXf &attention_weights() const { return attention_weights_; }
+
+private:
+    Mlp mlp1_, mlp2_, attention_, mlp3_;
+    int self_state_dim_;
+    bool with_global_state_;
+
+    // Preallocated workspaces, only resized when the batch shape changes
+    std::vector<Eigen::MatrixXf> mlp1_buffers_, mlp2_buffers_, attention_buffers_, mlp3_buffers_;
+    Eigen::MatrixXf attention_input_;
+    Eigen::MatrixXf attention_weights_;
+    Eigen::MatrixXf joint_state_;
+};
+
+#endif
@@ -14,6 +14,8 @@
 
 // TF
 #include <tf/transform_listener.h>
+#include <message_filters/subscriber.h>
+#include <tf2_ros/message_filter.h>
 
 // PCL
 #include <pcl_ros/transforms.h>
@@ -27,6 +29,9 @@
 #include <pcl/filters/extract_indices.h>
 #include <pcl/kdtree/kdtree.h>
 
+// Local map utilities of path_finding
+#include "localmap_utils.hpp"
+
 
 typedef pcl::PointCloud<pcl::PointXYZ> PointCloudXYZ;
 typedef pcl::PointCloud<pcl::PointXYZ>::Ptr PointCloudXYZPtr;
@@ -39,12 +44,11 @@ public:
     Scan2ObservationNode(ros::NodeHandle nh, ros::NodeHandle pnh);
     static void sigint_cb(int sig);
     void convert_scan_to_observations(walker_msgs::Trk3DArray::Ptr observation_msg_ptr, PointCloudXYZPtr cloud_baseframe, tf::StampedTransform tf_base2odom);
-    void scan_cb(const sensor_msgs::LaserScan &laser_msg);
+    void scan_cb(const sensor_msgs::LaserScan::ConstPtr &laser_msg_ptr);
     void trk3d_cb(const walker_msgs::Trk3DArray::ConstPtr &msg_ptr);
 
     // ROS related
     ros::NodeHandle nh_, pnh_;
-    ros::Subscriber sub_scan_;
     ros::Publisher pub_marker_array_;
     ros::Publisher pub_pc_filtered_;
     ros::Publisher pub_observation_;
@@ -56,6 +60,14 @@ public:
     tf::TransformListener* tflistener_ptr_;
     tf::StampedTransform tf_laser2base_;    
 
+    // Scan or trk3d input, released by the TF message filters once it can be transformed, so that
+    // the callbacks never wait for TF
+    message_filters::Subscriber<sensor_msgs::LaserScan> sub_scan_;
+    message_filters::Subscriber<walker_msgs::Trk3DArray> sub_trk3d_;
+    boost::shared_ptr<tf2_ros::MessageFilter<sensor_msgs::LaserScan> > scan_filter_ptr_;
+    boost::shared_ptr<tf2_ros::MessageFilter<walker_msgs::Trk3DArray> > trk3d_filter_ptr_;
+    localmap_utils::TfFilterCounter input_counter_;
+
     // Cropbox filter
     pcl::CropBox<pcl::PointXYZ> box_filter_;
     // Voxel grid filter
@@ -66,7 +78,7 @@ public:
 };
 
 
-Scan2ObservationNode::Scan2ObservationNode(ros::NodeHandle nh, ros::NodeHandle pnh): nh_(nh), pnh_(pnh) {
+Scan2ObservationNode::Scan2ObservationNode(ros::NodeHandle nh, ros::NodeHandle pnh): nh_(nh), pnh_(pnh), input_counter_("input") {
     // Signal handler
     signal(SIGINT, Scan2ObservationNode::sigint_cb);
 
@@ -76,25 +88,46 @@ Scan2ObservationNode::Scan2ObservationNode(ros::NodeHandle nh, ros::NodeHandle p
     double localmap_range_x, localmap_range_y;
     bool flag_only_static;
     std::string scan_src_frameid;
+    double input_late_threshold;
     ros::param::param<double>("~static_obstacle_radius", static_obstacle_radius_, 0.8);
     ros::param::param<double>("~dynamic_obstacle_radius", dynamic_obstacle_radius_, 0.4);
     ros::param::param<std::string>("~base_frameid", base_frameid_, "base_link");
     ros::param::param<std::string>("~odom_frameid", odom_frameid_, "odom");
     ros::param::param<std::string>("~scan_src_frameid", scan_src_frameid, "laser_link");
     ros::param::param<bool>("~flag_only_static", flag_only_static, true);
+    ros::param::param<double>("~input_late_threshold", input_late_threshold, 0.1);
 
     // ROS publishers & subscribers
-    if(flag_only_static == true)
-        sub_scan_ = nh_.subscribe("scan", 1, &Scan2ObservationNode::scan_cb, this);
-    else
-        sub_scan_ = nh_.subscribe("trk3d_result", 1, &Scan2ObservationNode::trk3d_cb, this);
+    tflistener_ptr_ = new tf::TransformListener();
+    tf2_ros::Buffer &tf_buffer = *tflistener_ptr_->getTF2BufferPtr();
+    input_counter_ = localmap_utils::TfFilterCounter(flag_only_static ? "scan" : "trk3d", input_late_threshold);
+    if(flag_only_static == true) {
+        // The scan needs base_link in odom at its stamp, which comes with laser_link in odom
+        sub_scan_.subscribe(nh_, "scan", 1);
+        scan_filter_ptr_.reset(new tf2_ros::MessageFilter<sensor_msgs::LaserScan>(
+            sub_scan_, tf_buffer, odom_frameid_, 5, nh_));
+        scan_filter_ptr_->registerCallback(&Scan2ObservationNode::scan_cb, this);
+        scan_filter_ptr_->registerFailureCallback(
+            [this](const sensor_msgs::LaserScan::ConstPtr &msg_ptr, tf2_ros::FilterFailureReason reason) {
+                input_counter_.count_dropped(msg_ptr->header, odom_frameid_, reason);
+            });
+    }
+    else {
+        sub_trk3d_.subscribe(nh_, "trk3d_result", 1);
+        trk3d_filter_ptr_.reset(new tf2_ros::MessageFilter<walker_msgs::Trk3DArray>(
+            sub_trk3d_, tf_buffer, base_frameid_, 5, nh_));
+        trk3d_filter_ptr_->registerCallback(&Scan2ObservationNode::trk3d_cb, this);
+        trk3d_filter_ptr_->registerFailureCallback(
+            [this](const walker_msgs::Trk3DArray::ConstPtr &msg_ptr, tf2_ros::FilterFailureReason reason) {
+                input_counter_.count_dropped(msg_ptr->header, base_frameid_, reason);
+            });
+    }
 
     // pub_marker_array_ = nh.advertise<visualization_msgs::MarkerArray>("clustering_result", 1);
     pub_pc_filtered_ = nh.advertise<sensor_msgs::PointCloud2>("pc_filtered", 1);
     pub_observation_ = nh.advertise<walker_msgs::Trk3DArray>("rl_observation_array", 1);
 
     // Prepare the transformation matrix from laser to base
-    tflistener_ptr_ = new tf::TransformListener();
     ROS_INFO("Wait for TF from laser_link to %s in 10 seconds...", base_frameid_.c_str());
     try{
         tflistener_ptr_->waitForTransform(base_frameid_, scan_src_frameid,
@@ -177,18 +210,19 @@ void Scan2ObservationNode::trk3d_cb(const walker_msgs::Trk3DArray::ConstPtr &msg
         throw std::runtime_error("The frame_id of trk3d message must be 'odom'.");
     }
 
-    // Get the transformation from tracking result frame to base frame
+    // Get the transformation from tracking result frame to base frame, the message filter
+    // only releases the message once it is available
     tf::StampedTransform tf_trk2base;
     try{
-        tflistener_ptr_->waitForTransform(base_frameid_, msg_ptr->header.frame_id,
-                                    ros::Time(), ros::Duration(0.1));
         tflistener_ptr_->lookupTransform(base_frameid_, msg_ptr->header.frame_id,
-                                    ros::Time(), tf_trk2base);
+                                    msg_ptr->header.stamp, tf_trk2base);
     }
     catch (tf::TransformException ex){
-        ROS_ERROR("\nCannot get TF from odom to %s: %s. Aborting...", base_frameid_.c_str(), ex.what());
-        exit(-1);
+        ROS_WARN("Cannot get TF from odom to %s: %s. Skip this message.", base_frameid_.c_str(), ex.what());
+        input_counter_.count_dropped(msg_ptr->header, base_frameid_, ex.what());
+        return;
     }
+    input_counter_.count_released(msg_ptr->header.stamp, ros::Time::now());
     // Get TF from odom2base
     tf::StampedTransform tf_base2odom(tf_trk2base.inverse(), tf_trk2base.stamp_, msg_ptr->header.frame_id, base_frameid_);
 
@@ -236,18 +270,19 @@ void Scan2ObservationNode::trk3d_cb(const walker_msgs::Trk3DArray::ConstPtr &msg
 }
 
 
-void Scan2ObservationNode::scan_cb(const sensor_msgs::LaserScan &laser_msg) {
+void Scan2ObservationNode::scan_cb(const sensor_msgs::LaserScan::ConstPtr &laser_msg_ptr) {
     // std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    const sensor_msgs::LaserScan &laser_msg = *laser_msg_ptr;
     tf::StampedTransform tf_base2odom;
     try{
-        tflistener_ptr_->waitForTransform(odom_frameid_, base_frameid_,
-                                    ros::Time(), ros::Duration(0.1));
         tflistener_ptr_->lookupTransform(odom_frameid_, base_frameid_,
-                                    ros::Time(), tf_base2odom);
+                                    laser_msg.header.stamp, tf_base2odom);
     }catch (tf::TransformException ex){
-        ROS_ERROR("\nCannot get TF from %s to %s: %s. Aborting...", base_frameid_.c_str(), odom_frameid_.c_str(), ex.what());
-        exit(-1);
+        ROS_WARN("Cannot get TF from %s to %s: %s. Skip this scan.", base_frameid_.c_str(), odom_frameid_.c_str(), ex.what());
+        input_counter_.count_dropped(laser_msg.header, odom_frameid_, ex.what());
+        return;
     }
+    input_counter_.count_released(laser_msg.header.stamp, ros::Time::now());
 
     // Convert laserscan to pointcloud:  laserscan --> ROS PointCloud2 --> PCL PointCloudXYZ
     sensor_msgs::PointCloud2 cloud_msg;
@@ -0,0 +1,39 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+'''
+Record the person detections of the pytorch model as reference for
+active_walker/yolo_detector_benchmark:
+    python3 dump_reference.py cfgfile weightfile output.csv img1 [img2 ...]
+Each line: image_path,score,center_x,center_y,size_x,size_y (pixels),
+images without any person are written with the path only.
+'''
+import sys
+import cv2
+from tool.darknet2pytorch import Darknet
+from tool.torch_utils import do_detect
+
+PERSON_ID = 0
+
+
+if __name__ == '__main__':
+    if len(sys.argv) < 5:
+        print(__doc__)
+        sys.exit(-1)
+    cfgfile, weightfile, output = sys.argv[1:4]
+    model = Darknet(cfgfile)
+    model.load_weights(weightfile)
+    model.eval()
+
+    with open(output, 'w') as f:
+        for imgfile in sys.argv[4:]:
+            img = cv2.cvtColor(cv2.imread(imgfile), cv2.COLOR_BGR2RGB)
+            height, width = img.shape[:2]
+            sized = cv2.resize(img, (model.width, model.height))
+            boxes = do_detect(model, sized, 0.5, 0.2, 0)[0]
+            persons = [box for box in boxes if box[6] == PERSON_ID]
+            if not persons:
+                f.write('%s\n' % imgfile)
+            for box in persons:
+                f.write('%s,%f,%f,%f,%f,%f\n' % (imgfile, box[5], box[0] * width, box[1] * height,
+                                                box[2] * width, box[3] * height))
+            print('%s: %d person(s)' % (imgfile, len(persons)))
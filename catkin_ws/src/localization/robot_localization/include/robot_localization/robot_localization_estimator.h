@@ -37,6 +37,7 @@
 #include <vector>
 #include <boost/circular_buffer.hpp>
 #include <Eigen/Dense>
+#include <Eigen/Geometry>
 
 #include "robot_localization/filter_base.h"
 #include "robot_localization/filter_utilities.h"
@@ -132,13 +133,18 @@ public:
 
   //! @brief Sets the current internal state of the listener.
   //!
+  //! States are kept sorted by time stamp. An older state is inserted at its position with a binary search, and a
+  //! state with the time stamp of a buffered one replaces it.
+  //!
   //! @param[in] state - The new state vector to set the internal state to
   //!
   void setState(const EstimatorState& state);
 
   //! @brief Returns the state at a given time
   //!
-  //! Projects the current state and error matrices forward using a model of the robot's motion.
+  //! Interpolates between the buffered states around the given time, or projects the closest one forward or
+  //! backward using a model of the robot's motion if the time is outside of the buffer. The bracketing states are
+  //! found with a binary search.
   //!
   //! @param[in] time - The time to which the prediction is being made
   //! @param[out] state - The returned state at the given time
@@ -197,6 +203,10 @@ private:
 
   //! @brief Interpolates the given state to a requested time stamp
   //!
+  //! The position follows a cubic Hermite curve through both states and their world frame velocities, so a turning
+  //! robot stays on its arc. The orientation is slerped, the velocities and accelerations are interpolated linearly
+  //! and the covariances are blended with the same weight.
+  //!
   //! @param[in] given_state_1 - last state update before requested time
   //! @param[in] given_state_2 - next state update after requested time
   //! @param[in] requested_time - time stamp to extrapolate to
@@ -34,6 +34,8 @@
 #include "robot_localization/ekf.h"
 #include "robot_localization/ukf.h"
 
+#include <algorithm>
+#include <cmath>
 #include <vector>
 
 namespace RobotLocalization
@@ -63,24 +65,44 @@ RobotLocalizationEstimator::~RobotLocalizationEstimator()
   delete filter_;
 }
 
+namespace
+{
+//! @brief Orders states by time stamp for the binary searches in the state buffer
+//!
+bool isEarlier(const EstimatorState& state, const double time)
+{
+  return state.time_stamp < time;
+}
+
+//! @brief Rotation from the body to the world frame, with the roll-pitch-yaw convention of the filters
+//!
+Eigen::Quaterniond orientationFromState(const Eigen::VectorXd& state)
+{
+  return Eigen::AngleAxisd(state(StateMemberYaw), Eigen::Vector3d::UnitZ()) *
+         Eigen::AngleAxisd(state(StateMemberPitch), Eigen::Vector3d::UnitY()) *
+         Eigen::AngleAxisd(state(StateMemberRoll), Eigen::Vector3d::UnitX());
+}
+}  // namespace
+
 void RobotLocalizationEstimator::setState(const EstimatorState& state)
 {
   // If newly received state is newer than any in the buffer, push back
   if ( state_buffer_.empty() || state.time_stamp > state_buffer_.back().time_stamp )
   {
     state_buffer_.push_back(state);
+    return;
   }
+
   // If it is older, put it in the right position
+  boost::circular_buffer<EstimatorState>::iterator it =
+    std::lower_bound(state_buffer_.begin(), state_buffer_.end(), state.time_stamp, isEarlier);
+  if ( it->time_stamp == state.time_stamp )
+  {
+    *it = state;
+  }
   else
   {
-    for ( boost::circular_buffer<EstimatorState>::iterator it = state_buffer_.begin(); it != state_buffer_.end(); ++it )
-    {
-      if ( state.time_stamp < it->time_stamp )
-      {
-        state_buffer_.insert(it, state);
-        return;
-      }
-    }
+    state_buffer_.insert(it, state);
   }
 }
 
@@ -93,66 +115,33 @@ EstimatorResult RobotLocalizationEstimator::getState(const double time,
     return EstimatorResults::EmptyBuffer;
   }
 
-  // Set state to the most recent one for now
-  state = state_buffer_.back();
-
-  // Go through buffer from new to old
-  EstimatorState last_state_before_time = state_buffer_.front();
-  EstimatorState next_state_after_time = state_buffer_.back();
-  bool previous_state_found = false;
-  bool next_state_found = false;
-
-  for (boost::circular_buffer<EstimatorState>::const_reverse_iterator it = state_buffer_.rbegin();
-       it != state_buffer_.rend(); ++it)
-  {
-    /* If the time stamp of the current state from the buffer is
-     * older than the requested time, store it as the last state
-     * before the requested time. If it is younger, save it as the
-     * next one after, and go on to find the last one before.
-     */
-    if ( it->time_stamp == time )
-    {
-      state = *it;
-      return EstimatorResults::Exact;
-    }
-    else if ( it->time_stamp <= time )
-    {
-      last_state_before_time = *it;
-      previous_state_found = true;
-      break;
-    }
-    else
-    {
-      next_state_after_time = *it;
-      next_state_found = true;
-    }
-  }
+  // First state at or after the requested time
+  boost::circular_buffer<EstimatorState>::const_iterator next_state_after_time =
+    std::lower_bound(state_buffer_.begin(), state_buffer_.end(), time, isEarlier);
 
-  // If we found a previous state and a next state, we can do interpolation
-  if ( previous_state_found && next_state_found )
+  if ( next_state_after_time != state_buffer_.end() && next_state_after_time->time_stamp == time )
   {
-    interpolate(last_state_before_time, next_state_after_time, time, state);
-    return EstimatorResults::Interpolation;
+    state = *next_state_after_time;
+    return EstimatorResults::Exact;
   }
 
   // If only a previous state is found, we can do extrapolation into the future
-  else if ( previous_state_found )
+  if ( next_state_after_time == state_buffer_.end() )
   {
-    extrapolate(last_state_before_time, time, state);
+    extrapolate(state_buffer_.back(), time, state);
     return EstimatorResults::ExtrapolationIntoFuture;
   }
 
   // If only a next state is found, we'll have to extrapolate into the past.
-  else if ( next_state_found )
+  if ( next_state_after_time == state_buffer_.begin() )
   {
-    extrapolate(next_state_after_time, time, state);
+    extrapolate(*next_state_after_time, time, state);
     return EstimatorResults::ExtrapolationIntoPast;
   }
 
-  else
-  {
-    return EstimatorResults::Failed;
-  }
+  // If we found a previous state and a next state, we can do interpolation
+  interpolate(*(next_state_after_time - 1), *next_state_after_time, time, state);
+  return EstimatorResults::Interpolation;
 }
 
 void RobotLocalizationEstimator::setBufferCapacity(const int capacity)
@@ -201,12 +190,37 @@ void RobotLocalizationEstimator::interpolate(const EstimatorState& given_state_1
                                              const double requested_time,
                                              EstimatorState& state_at_req_time) const
 {
-  /*
-   * TODO: Right now, we only extrapolate from the last known state before the requested time. But as the state after
-   * the requested time is also known, we may want to perform interpolation between states.
-   */
-  extrapolate(given_state_1, requested_time, state_at_req_time);
-  return;
+  const double dt = given_state_2.time_stamp - given_state_1.time_stamp;
+  const double t = (requested_time - given_state_1.time_stamp) / dt;
+
+  const Eigen::VectorXd& x1 = given_state_1.state;
+  const Eigen::VectorXd& x2 = given_state_2.state;
+  Eigen::VectorXd& x = state_at_req_time.state;
+
+  // Velocities, accelerations and the covariance change slowly enough between two filter outputs to be blended
+  // linearly.
+  x = (1.0 - t) * x1 + t * x2;
+  state_at_req_time.covariance = (1.0 - t) * given_state_1.covariance + t * given_state_2.covariance;
+  state_at_req_time.time_stamp = requested_time;
+
+  // Orientation along the shortest rotation between the two states
+  const Eigen::Quaterniond q1 = orientationFromState(x1);
+  const Eigen::Quaterniond q2 = orientationFromState(x2);
+  const Eigen::Matrix3d rotation = q1.slerp(t, q2).toRotationMatrix();
+  x(StateMemberRoll) = std::atan2(rotation(2, 1), rotation(2, 2));
+  x(StateMemberPitch) = std::asin(std::max(-1.0, std::min(1.0, -rotation(2, 0))));
+  x(StateMemberYaw) = std::atan2(rotation(1, 0), rotation(0, 0));
+
+  // Position on the cubic Hermite curve through both poses. The body frame velocities are rotated into the world
+  // frame for the tangents.
+  const Eigen::Vector3d p1 = x1.segment<3>(POSITION_OFFSET);
+  const Eigen::Vector3d p2 = x2.segment<3>(POSITION_OFFSET);
+  const Eigen::Vector3d v1 = dt * (q1 * x1.segment<3>(POSITION_V_OFFSET));
+  const Eigen::Vector3d v2 = dt * (q2 * x2.segment<3>(POSITION_V_OFFSET));
+  const double t2 = t * t;
+  const double t3 = t2 * t;
+  x.segment<3>(POSITION_OFFSET) = (2 * t3 - 3 * t2 + 1) * p1 + (t3 - 2 * t2 + t) * v1 +
+                                  (-2 * t3 + 3 * t2) * p2 + (t3 - t2) * v2;
 }
 
 }  // namespace RobotLocalization
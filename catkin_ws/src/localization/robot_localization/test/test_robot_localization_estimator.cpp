@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2016, TNO IVS Helmond.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "robot_localization/robot_localization_estimator.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+namespace RobotLocalization
+{
+namespace
+{
+//! @brief Planar state with the body frame velocities of a unicycle
+//!
+EstimatorState makeState(const double time, const double x, const double y, const double yaw, const double vx,
+                         const double vyaw)
+{
+  EstimatorState state;
+  state.time_stamp = time;
+  state.state(StateMemberX) = x;
+  state.state(StateMemberY) = y;
+  state.state(StateMemberYaw) = yaw;
+  state.state(StateMemberVx) = vx;
+  state.state(StateMemberVyaw) = vyaw;
+  state.covariance.setIdentity();
+  return state;
+}
+
+Eigen::MatrixXd processNoise()
+{
+  return 1e-3 * Eigen::MatrixXd::Identity(STATE_SIZE, STATE_SIZE);
+}
+
+// Straight line at yaw, speed
+const double LINE_YAW = 0.5;
+const double LINE_SPEED = 2.0;
+
+EstimatorState lineState(const double time)
+{
+  return makeState(time, LINE_SPEED * time * std::cos(LINE_YAW), LINE_SPEED * time * std::sin(LINE_YAW), LINE_YAW,
+                   LINE_SPEED, 0.0);
+}
+
+// Circle of radius SPEED / YAW_RATE around (0, RADIUS), starting at the origin with yaw 0
+const double ARC_SPEED = 1.0;
+const double ARC_YAW_RATE = 0.5;
+const double ARC_RADIUS = ARC_SPEED / ARC_YAW_RATE;
+
+EstimatorState arcState(const double time)
+{
+  const double yaw = ARC_YAW_RATE * time;
+  return makeState(time, ARC_RADIUS * std::sin(yaw), ARC_RADIUS * (1.0 - std::cos(yaw)), yaw, ARC_SPEED,
+                   ARC_YAW_RATE);
+}
+}  // namespace
+
+TEST(RobotLocalizationEstimatorTest, EmptyBuffer)
+{
+  RobotLocalizationEstimator estimator(10, FilterTypes::EKF, processNoise());
+  EstimatorState state;
+
+  EXPECT_EQ(EstimatorResults::EmptyBuffer, estimator.getState(1.0, state));
+
+  estimator.setState(lineState(0.0));
+  EXPECT_EQ(1u, estimator.getSize());
+  estimator.clearBuffer();
+  EXPECT_EQ(0u, estimator.getSize());
+  EXPECT_EQ(EstimatorResults::EmptyBuffer, estimator.getState(1.0, state));
+}
+
+TEST(RobotLocalizationEstimatorTest, BufferOrder)
+{
+  RobotLocalizationEstimator estimator(3, FilterTypes::EKF, processNoise());
+
+  // Out of order states are sorted in, a state with a buffered time stamp replaces it
+  estimator.setState(lineState(2.0));
+  estimator.setState(lineState(0.0));
+  estimator.setState(lineState(1.0));
+  EstimatorState replacement = lineState(1.0);
+  replacement.state(StateMemberZ) = 1.0;
+  estimator.setState(replacement);
+  EXPECT_EQ(3u, estimator.getSize());
+  EXPECT_EQ(3u, estimator.getBufferCapacity());
+
+  EstimatorState state;
+  EXPECT_EQ(EstimatorResults::Exact, estimator.getState(1.0, state));
+  EXPECT_DOUBLE_EQ(1.0, state.state(StateMemberZ));
+  EXPECT_EQ(EstimatorResults::Interpolation, estimator.getState(0.5, state));
+  EXPECT_EQ(EstimatorResults::Interpolation, estimator.getState(1.5, state));
+
+  // A full buffer drops the oldest state
+  estimator.setState(lineState(3.0));
+  EXPECT_EQ(3u, estimator.getSize());
+  EXPECT_EQ(EstimatorResults::ExtrapolationIntoPast, estimator.getState(0.5, state));
+}
+
+TEST(RobotLocalizationEstimatorTest, ConstantVelocity)
+{
+  RobotLocalizationEstimator estimator(10, FilterTypes::EKF, processNoise());
+  for (int i = 0; i <= 4; ++i)
+  {
+    estimator.setState(lineState(i));
+  }
+
+  EstimatorState state;
+  EXPECT_EQ(EstimatorResults::Exact, estimator.getState(2.0, state));
+  EXPECT_DOUBLE_EQ(2.0, state.time_stamp);
+  EXPECT_DOUBLE_EQ(lineState(2.0).state(StateMemberX), state.state(StateMemberX));
+
+  // The cubic through two poses of a straight motion is the straight motion
+  const double interpolation_times[] = {0.25, 1.5, 3.9};
+  for (double time : interpolation_times)
+  {
+    EXPECT_EQ(EstimatorResults::Interpolation, estimator.getState(time, state));
+    const EstimatorState expected = lineState(time);
+    EXPECT_DOUBLE_EQ(time, state.time_stamp);
+    EXPECT_NEAR(expected.state(StateMemberX), state.state(StateMemberX), 1e-9);
+    EXPECT_NEAR(expected.state(StateMemberY), state.state(StateMemberY), 1e-9);
+    EXPECT_NEAR(LINE_YAW, state.state(StateMemberYaw), 1e-9);
+    EXPECT_NEAR(LINE_SPEED, state.state(StateMemberVx), 1e-9);
+  }
+
+  // Both ways out of the buffer, the filter moves on with the velocity of the boundary state
+  EXPECT_EQ(EstimatorResults::ExtrapolationIntoFuture, estimator.getState(6.0, state));
+  EXPECT_DOUBLE_EQ(6.0, state.time_stamp);
+  EXPECT_NEAR(lineState(6.0).state(StateMemberX), state.state(StateMemberX), 1e-9);
+  EXPECT_NEAR(lineState(6.0).state(StateMemberY), state.state(StateMemberY), 1e-9);
+  EXPECT_NEAR(LINE_YAW, state.state(StateMemberYaw), 1e-9);
+
+  EXPECT_EQ(EstimatorResults::ExtrapolationIntoPast, estimator.getState(-1.0, state));
+  EXPECT_DOUBLE_EQ(-1.0, state.time_stamp);
+  EXPECT_NEAR(lineState(-1.0).state(StateMemberX), state.state(StateMemberX), 1e-9);
+  EXPECT_NEAR(lineState(-1.0).state(StateMemberY), state.state(StateMemberY), 1e-9);
+}
+
+TEST(RobotLocalizationEstimatorTest, ConstantVelocityUkf)
+{
+  std::vector<double> args;
+  args.push_back(0.001);
+  args.push_back(0.0);
+  args.push_back(2.0);
+  RobotLocalizationEstimator estimator(10, FilterTypes::UKF, processNoise(), args);
+  estimator.setState(lineState(0.0));
+  estimator.setState(lineState(1.0));
+
+  EstimatorState state;
+  EXPECT_EQ(EstimatorResults::ExtrapolationIntoFuture, estimator.getState(1.5, state));
+  EXPECT_NEAR(lineState(1.5).state(StateMemberX), state.state(StateMemberX), 1e-6);
+  EXPECT_NEAR(lineState(1.5).state(StateMemberY), state.state(StateMemberY), 1e-6);
+}
+
+TEST(RobotLocalizationEstimatorTest, Turning)
+{
+  RobotLocalizationEstimator estimator(10, FilterTypes::EKF, processNoise());
+  for (int i = 4; i >= 0; --i)
+  {
+    estimator.setState(arcState(i));
+  }
+
+  // Between two states 0.5 rad apart, the cubic stays within a mm of the arc, and the heading turns at the constant
+  // rate. A linear blend of the positions would cut the chord, 6 cm inside the arc halfway.
+  EstimatorState state;
+  const double interpolation_times[] = {0.5, 1.25, 2.9, 3.5};
+  for (double time : interpolation_times)
+  {
+    EXPECT_EQ(EstimatorResults::Interpolation, estimator.getState(time, state));
+    const EstimatorState expected = arcState(time);
+    EXPECT_NEAR(expected.state(StateMemberX), state.state(StateMemberX), 1e-3);
+    EXPECT_NEAR(expected.state(StateMemberY), state.state(StateMemberY), 1e-3);
+    EXPECT_NEAR(ARC_RADIUS, std::hypot(state.state(StateMemberX), state.state(StateMemberY) - ARC_RADIUS), 1e-3);
+    EXPECT_NEAR(expected.state(StateMemberYaw), state.state(StateMemberYaw), 1e-9);
+    EXPECT_NEAR(ARC_SPEED, state.state(StateMemberVx), 1e-9);
+    EXPECT_NEAR(ARC_YAW_RATE, state.state(StateMemberVyaw), 1e-9);
+  }
+
+  // The filter extrapolates along the heading of the boundary state, off the arc by about v w dt^2 / 2
+  const double dt = 0.1;
+  const double tolerance = ARC_SPEED * ARC_YAW_RATE * dt * dt;
+
+  EXPECT_EQ(EstimatorResults::ExtrapolationIntoFuture, estimator.getState(4.0 + dt, state));
+  EXPECT_NEAR(arcState(4.0 + dt).state(StateMemberX), state.state(StateMemberX), tolerance);
+  EXPECT_NEAR(arcState(4.0 + dt).state(StateMemberY), state.state(StateMemberY), tolerance);
+  EXPECT_NEAR(arcState(4.0 + dt).state(StateMemberYaw), state.state(StateMemberYaw), 1e-9);
+
+  EXPECT_EQ(EstimatorResults::ExtrapolationIntoPast, estimator.getState(-dt, state));
+  EXPECT_NEAR(arcState(-dt).state(StateMemberX), state.state(StateMemberX), tolerance);
+  EXPECT_NEAR(arcState(-dt).state(StateMemberY), state.state(StateMemberY), tolerance);
+  EXPECT_NEAR(arcState(-dt).state(StateMemberYaw), state.state(StateMemberYaw), 1e-9);
+}
+
+}  // namespace RobotLocalization
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
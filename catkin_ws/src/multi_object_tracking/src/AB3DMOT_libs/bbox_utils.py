@@ -4,6 +4,7 @@
 import numpy as np, copy
 from numba import jit
 from scipy.spatial import ConvexHull
+import box_iou_cpp
 
 @jit          
 def poly_area(x,y):
@@ -112,6 +113,23 @@ def iou3d(corners1, corners2):
 	iou = inter_vol / (vol1 + vol2 - inter_vol)
 	return iou, iou_2d
 
+def bev_iou_matrix(boxes1, boxes2, giou=False):
+	''' Bird's eye view IoU (or GIoU) of every pair of 3D boxes, by the compiled kernel
+
+	Input:
+	    boxes1: numpy array (N,7), [x,y,z,theta,l,w,h] as in convert_3dbox_to_8corner
+	    boxes2: numpy array (M,7)
+	Output:
+	    numpy array (N,M), iou[i, j] is the iou_2d of iou3d(corners of boxes1[i], corners of boxes2[j])
+	'''
+	def to_bev(boxes):
+		# ground plane x-z, roty turns the box clockwise in it
+		boxes = np.asarray(boxes, dtype=np.float64).reshape(-1, 7)
+		return np.stack((boxes[:, 0], boxes[:, 2], boxes[:, 4], boxes[:, 5], -boxes[:, 3]), axis=1)
+
+	iou = box_iou_cpp.iou_matrix(to_bev(boxes1), to_bev(boxes2), giou)
+	return np.array(iou, dtype=np.float64).reshape(len(boxes1), len(boxes2))
+
 @jit          
 def roty(t):
 	''' Rotation about the y-axis. '''
@@ -3,15 +3,30 @@
 
 import numpy as np
 from filterpy.kalman import KalmanFilter
+import imm_filter_cpp
+
+def new_track_id():
+	track_id = KalmanBoxTracker.count
+	KalmanBoxTracker.count += 1
+	return track_id
+
+def smooth_appearance(appearance, descriptor, alpha=0.2):
+	"""
+	Exponential moving average of the appearance descriptors of a track, descriptor None if the detection has none
+	"""
+	if descriptor is None: return appearance
+	if appearance is None: return np.array(descriptor, dtype=np.float32)
+	return (1.0 - alpha) * appearance + alpha * np.asarray(descriptor, dtype=np.float32)
 
 class KalmanBoxTracker(object):
 	"""
 	This class represents the internel state of individual tracked objects observed as bbox.
 	"""
 	count = 0
-	def __init__(self, det2D, info):
+	def __init__(self, det2D, info, track_id=None):
 		"""
 		Initialises a tracker using initial bounding box.
+		track_id: id of a lost track this one continues, a new id if None
 		"""
 		# define constant velocity model
 		# self.kf = KalmanFilter(dim_x=10, dim_z=7)       
@@ -58,8 +73,7 @@ class KalmanBoxTracker(object):
 		self.kf.x[:3] = det2D.reshape((3, 1)) # x, y, r
 
 		self.time_since_update = 0
-		self.id = KalmanBoxTracker.count
-		KalmanBoxTracker.count += 1
+		self.id = new_track_id() if track_id is None else track_id
 		self.history = []
 		self.hits = 1           # number of total hits including the first detection
 		self.hit_streak = 1     # number of continuing hit considering the first detection
@@ -67,6 +81,7 @@ class KalmanBoxTracker(object):
 		self.still_first = True
 		self.age = 0
 		self.info = info        # other info associated
+		self.appearance = None  # smoothed appearance descriptor, None if never seen by the camera
 
 	def update(self, det2D, info): 
 		""" 
@@ -82,6 +97,9 @@ class KalmanBoxTracker(object):
 		self.kf.update(det2D)
 		self.info = info
 
+	def update_appearance(self, descriptor):
+		self.appearance = smooth_appearance(self.appearance, descriptor)
+
 	def predict(self):       
 		"""
 		Advances the state vector and returns the predicted bounding box estimate.
@@ -102,4 +120,70 @@ class KalmanBoxTracker(object):
 		"""
 		# return self.kf.x[:7].reshape((7, ))
 		# self.kf.x[3] = np.arctan2(self.kf.x[8], self.kf.x[7]) 
-		return self.kf.x[:5].reshape((5, ))
\ No newline at end of file
+		return self.kf.x[:5].reshape((5, ))
+
+	def get_mode_probabilities(self):
+		"""
+		Returns the probabilities of standing, walking and turning, always walking for this filter.
+		"""
+		return np.array([0.0, 1.0, 0.0])
+
+	def remove(self):
+		pass
+
+
+class ImmBoxTracker(object):
+	"""
+	Same interface as KalmanBoxTracker, with an IMM filter of constant position, constant velocity
+	and coordinated turn models. The filters of all the tracks live in one imm_filter_cpp.ImmFilterBank,
+	which AB3DMOT predicts once per frame before calling predict() of the tracks.
+	"""
+	def __init__(self, det2D, info, bank, track_id=None):
+		self.bank = bank
+		self.id = new_track_id() if track_id is None else track_id
+		self.bank.add(self.id, det2D)
+
+		self.time_since_update = 0
+		self.history = []
+		self.hits = 1
+		self.hit_streak = 1
+		self.first_continuing_hit = 1
+		self.still_first = True
+		self.age = 0
+		self.info = info
+		self.appearance = None
+
+	def update(self, det2D, info):
+		self.time_since_update = 0
+		self.history = []
+		self.hits += 1
+		self.hit_streak += 1
+		if self.still_first:
+			self.first_continuing_hit += 1
+
+		self.bank.update(self.id, det2D)
+		self.info = info
+
+	def update_appearance(self, descriptor):
+		self.appearance = smooth_appearance(self.appearance, descriptor)
+
+	def predict(self):
+		"""
+		Bookkeeping of a frame, returns the state predicted by the bank, [x, y, r, vx, vy]
+		"""
+		self.age += 1
+		if (self.time_since_update > 0):
+			self.hit_streak = 0
+			self.still_first = False
+		self.time_since_update += 1
+		self.history.append(self.get_state().reshape((5, 1)))     # column, as KalmanFilter.x
+		return self.history[-1]
+
+	def get_state(self):
+		return np.array(self.bank.state(self.id)[:5])
+
+	def get_mode_probabilities(self):
+		return np.array(self.bank.mode_probabilities(self.id))
+
+	def remove(self):
+		self.bank.remove(self.id)
@@ -4,8 +4,11 @@
 import numpy as np
 # from sklearn.utils.linear_assignment_ import linear_assignment    # deprecated
 from scipy.optimize import linear_sum_assignment
+import box_iou_cpp
 from AB3DMOT_libs.bbox_utils import convert_3dbox_to_8corner, iou3d
-from AB3DMOT_libs.kalman_filter import KalmanBoxTracker
+import imm_filter_cpp
+import reid_cpp
+from AB3DMOT_libs.kalman_filter import KalmanBoxTracker, ImmBoxTracker
 
 def iou2d(det, trk):
 	assert len(det) == 3 and len(trk) == 3
@@ -39,10 +42,8 @@ def iou2d(det, trk):
 def associate_detections_to_trackers(detections, trackers, iou_threshold=0.01):
 	if (len(trackers)==0): 
 		return np.empty((0, 2), dtype=int), np.arange(len(detections)), np.empty((0, 8, 3), dtype=int) 
-	iou_matrix = np.zeros((len(detections), len(trackers)), dtype=np.float32)
-	for d, det in enumerate(detections):
-		for t, trk in enumerate(trackers):
-			iou_matrix[d, t] = iou2d(det, trk)
+	# same values as iou2d on every pair, computed by the compiled kernel
+	iou_matrix = np.array(box_iou_cpp.circle_iou_matrix(detections, trackers), dtype=np.float32).reshape(len(detections), len(trackers))
 	row_ind, col_ind = linear_sum_assignment(-iou_matrix)      # hougarian algorithm
 	matched_indices = np.stack((row_ind, col_ind), axis=1)
 
@@ -68,18 +69,32 @@ def associate_detections_to_trackers(detections, trackers, iou_threshold=0.01):
 
 
 class AB3DMOT(object):			  # A baseline of 3D multi-object tracking
-	def __init__(self, max_age=2, min_hits=3):      # max age will preserve the bbox does not appear no more than 2 frames, interpolate the detection
+	def __init__(self, max_age=2, min_hits=3, motion_model='cv', reid=False):      # max age will preserve the bbox does not appear no more than 2 frames, interpolate the detection
 		"""
 		Sets key parameters for SORT                
+		motion_model: 'cv' for a constant velocity Kalman filter per track, 'imm' for the IMM filter bank
+		reid: keep the lost tracks in a gallery, a new track matching one by motion and appearance gets its id back
 		"""
 		self.max_age = max_age
 		self.min_hits = min_hits
 		self.trackers = []
 		self.frame_count = 0
+		self.imm_bank = imm_filter_cpp.ImmFilterBank() if motion_model == 'imm' else None
+		self.gallery = reid_cpp.Gallery() if reid else None
 		# self.reorder = [3, 4, 5, 6, 2, 1, 0]
 		# self.reorder_back = [6, 5, 4, 0, 1, 2, 3]
 		# self.reorder_back = [6, 5, 4, 0, 1, 2, 3, 7, 8, 9]
 
+	def remove_dead_tracker(self, i):
+		"""
+		Removes the tracker i which has not been updated for max_age frames, confirmed tracks seen by the camera go to the gallery
+		"""
+		trk = self.trackers.pop(i)
+		if self.gallery is not None and trk.appearance is not None and trk.hits >= self.min_hits:
+			d = trk.get_state()
+			self.gallery.add(trk.id, d[0], d[1], d[3], d[4], trk.appearance)
+		trk.remove()
+
 	def update_with_no_dets(self):
 		"""
 		
@@ -87,6 +102,8 @@ class AB3DMOT(object):			  # A baseline of 3D multi-object tracking
 		"""
 		self.frame_count += 1
 
+		if self.gallery is not None: self.gallery.step()
+		if self.imm_bank is not None: self.imm_bank.predict(1.0)     # all the tracks at once
 		trks = np.zeros((len(self.trackers), 3))         # N x 3 , # get predicted locations from existing trackers.
 		to_del = []
 		ret = []
@@ -99,7 +116,7 @@ class AB3DMOT(object):			  # A baseline of 3D multi-object tracking
 				
 		trks = np.ma.compress_rows(np.ma.masked_invalid(trks))   
 		for t in reversed(to_del): 
-			self.trackers.pop(t)
+			self.trackers.pop(t).remove()
 
 		i = len(self.trackers)
 		for trk in reversed(self.trackers):
@@ -107,13 +124,13 @@ class AB3DMOT(object):			  # A baseline of 3D multi-object tracking
 			# d = d[self.reorder_back]			# change format from [x,y,z,theta,l,w,h] to [h,w,l,x,y,z,theta]
 
 			if ((trk.time_since_update < self.max_age) and (trk.hits >= self.min_hits or self.frame_count <= self.min_hits)):      
-				ret.append(np.concatenate((d, [trk.id + 1], trk.info)).reshape(1, -1)) # +1 as MOT benchmark requires positive
+				ret.append(np.concatenate((d, [trk.id + 1], trk.info, trk.get_mode_probabilities())).reshape(1, -1)) # +1 as MOT benchmark requires positive
 			i -= 1
 
 			# remove dead tracklet
 			if (trk.time_since_update >= self.max_age): 
-				self.trackers.pop(i)
-		if (len(ret) > 0): return np.concatenate(ret)			# h,w,l,x,y,z,theta, ID, other info, confidence
+				self.remove_dead_tracker(i)
+		if (len(ret) > 0): return np.concatenate(ret)			# x, y, r, vx, vy, ID, confidence, class_id, p(standing), p(walking), p(turning)
 		return np.empty((0, 15))    
 
 
@@ -125,12 +142,14 @@ class AB3DMOT(object):			  # A baseline of 3D multi-object tracking
 		  dets_all: dict
 			dets - a numpy array of detections in the format [[h,w,l,x,y,z,theta],...]
 			info: a array of other info for each det
+			appearance (optional): a list of the appearance descriptors of the dets, None for a det without one
 		Requires: this method must be called once for each frame even with empty detections.
 		Returns the a similar array, where the last column is the object ID.
 
 		NOTE: The number of objects returned may differ from the number of detections provided.
 		"""
 		dets, info = dets_all['dets'], dets_all['info']         # dets: N x 3, float numpy array
+		appearance = dets_all.get('appearance', [None] * len(dets))
 
 		# reorder the data to put x,y,z in front to be compatible with the state transition matrix
 		# where the constant velocity model is defined in the first three rows of the matrix
@@ -138,6 +157,8 @@ class AB3DMOT(object):			  # A baseline of 3D multi-object tracking
 
 		self.frame_count += 1
 
+		if self.gallery is not None: self.gallery.step()
+		if self.imm_bank is not None: self.imm_bank.predict(1.0)     # all the tracks at once
 		trks = np.zeros((len(self.trackers), 3))         # N x 3 , # get predicted locations from existing trackers.
 		to_del = []
 		ret = []
@@ -149,7 +170,7 @@ class AB3DMOT(object):			  # A baseline of 3D multi-object tracking
 				to_del.append(t)
 		trks = np.ma.compress_rows(np.ma.masked_invalid(trks))   
 		for t in reversed(to_del): 
-			self.trackers.pop(t)
+			self.trackers.pop(t).remove()
 
 		matched, unmatched_dets, unmatched_trks = associate_detections_to_trackers(dets, trks)
 
@@ -158,10 +179,18 @@ class AB3DMOT(object):			  # A baseline of 3D multi-object tracking
 			if t not in unmatched_trks:
 				d = matched[np.where(matched[:, 1] == t)[0], 0]     # a list of index
 				trk.update(dets[d, :][0], info[d, :][0])
+				trk.update_appearance(appearance[d[0]])
 
-		# create and initialise new trackers for unmatched detections
+		# create and initialise new trackers for unmatched detections, or continue a lost track of the gallery
 		for i in unmatched_dets:        # a scalar of index
-			trk = KalmanBoxTracker(dets[i, :], info[i, :]) 
+			track_id = None
+			if self.gallery is not None and appearance[i] is not None:
+				track_id = self.gallery.match(dets[i, 0], dets[i, 1], appearance[i])
+				if track_id < 0: track_id = None
+			if self.imm_bank is not None: trk = ImmBoxTracker(dets[i, :], info[i, :], self.imm_bank, track_id)
+			else: trk = KalmanBoxTracker(dets[i, :], info[i, :], track_id) 
+			trk.update_appearance(appearance[i])
+			if track_id is not None: trk.hits = self.min_hits     # confirmed before the occlusion, reported right away
 			self.trackers.append(trk)
 
 		i = len(self.trackers)
@@ -170,11 +199,11 @@ class AB3DMOT(object):			  # A baseline of 3D multi-object tracking
 			# d = d[self.reorder_back]			# change format from [x,y,z,theta,l,w,h] to [h,w,l,x,y,z,theta]
 
 			if ((trk.time_since_update < self.max_age) and (trk.hits >= self.min_hits or self.frame_count <= self.min_hits)):      
-				ret.append(np.concatenate((d, [trk.id + 1], trk.info)).reshape(1, -1)) # +1 as MOT benchmark requires positive
+				ret.append(np.concatenate((d, [trk.id + 1], trk.info, trk.get_mode_probabilities())).reshape(1, -1)) # +1 as MOT benchmark requires positive
 			i -= 1
 
 			# remove dead tracklet
 			if (trk.time_since_update >= self.max_age): 
-				self.trackers.pop(i)
-		if (len(ret) > 0): return np.concatenate(ret)			# h,w,l,x,y,z,theta, ID, other info, confidence
+				self.remove_dead_tracker(i)
+		if (len(ret) > 0): return np.concatenate(ret)			# x, y, r, vx, vy, ID, confidence, class_id, p(standing), p(walking), p(turning)
 		return np.empty((0, 15))    
\ No newline at end of file
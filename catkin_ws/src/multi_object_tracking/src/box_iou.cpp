@@ -0,0 +1,203 @@
+#include "box_iou.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace box_iou {
+
+namespace {
+
+struct Point {
+  double x, y;
+  bool operator<(const Point &other) const {
+    return x < other.x || (x == other.x && y < other.y);
+  }
+};
+
+// Corners in counter-clockwise order and axis-aligned bounds of a box
+struct Corners {
+  Point p[4];
+  double min_x, max_x, min_y, max_y;
+  double area;
+};
+
+// A quadrilateral clipped by four half-planes keeps at most 8 vertices, each half-plane
+// adds at most one vertex to a convex polygon
+struct Polygon {
+  Point p[8];
+  int size;
+};
+
+
+Corners make_corners(const Box &box) {
+  static const double sx[4] = {0.5, -0.5, -0.5, 0.5};
+  static const double sy[4] = {0.5, 0.5, -0.5, -0.5};
+  const double c = std::cos(box.yaw), s = std::sin(box.yaw);
+  Corners corners;
+  for(int i = 0; i < 4; i++) {
+    const double lx = sx[i] * box.l, ly = sy[i] * box.w;
+    corners.p[i].x = box.x + c * lx - s * ly;
+    corners.p[i].y = box.y + s * lx + c * ly;
+  }
+  corners.min_x = corners.max_x = corners.p[0].x;
+  corners.min_y = corners.max_y = corners.p[0].y;
+  for(int i = 1; i < 4; i++) {
+    corners.min_x = std::min(corners.min_x, corners.p[i].x);
+    corners.max_x = std::max(corners.max_x, corners.p[i].x);
+    corners.min_y = std::min(corners.min_y, corners.p[i].y);
+    corners.max_y = std::max(corners.max_y, corners.p[i].y);
+  }
+  corners.area = std::fabs(box.l * box.w);
+  return corners;
+}
+
+
+bool bounds_overlap(const Corners &a, const Corners &b) {
+  return a.min_x < b.max_x && b.min_x < a.max_x && a.min_y < b.max_y && b.min_y < a.max_y;
+}
+
+
+double polygon_area(const Point *p, int size) {
+  double sum = 0.0;
+  for(int i = 0, j = size - 1; i < size; j = i++)
+    sum += p[j].x * p[i].y - p[i].x * p[j].y;
+  return 0.5 * std::fabs(sum);
+}
+
+
+double clipped_area(const Corners &a, const Corners &b) {
+  Polygon polygons[2];
+  int current = 0;
+  std::copy(a.p, a.p + 4, polygons[0].p);
+  polygons[0].size = 4;
+
+  for(int e = 0; e < 4; e++) {
+    // Keep the left side of the edge b.p[e] -> b.p[e + 1]
+    const Point &p = b.p[e];
+    const Point &q = b.p[(e + 1) & 3];
+    const double ex = q.x - p.x, ey = q.y - p.y;
+    const Polygon &in = polygons[current];
+    Polygon &out = polygons[1 - current];
+    out.size = 0;
+
+    Point s = in.p[in.size - 1];
+    double s_side = ex * (s.y - p.y) - ey * (s.x - p.x);
+    for(int i = 0; i < in.size; i++) {
+      const Point &v = in.p[i];
+      const double v_side = ex * (v.y - p.y) - ey * (v.x - p.x);
+      if((s_side > 0.0 && v_side < 0.0) || (s_side < 0.0 && v_side > 0.0)) {
+        const double t = s_side / (s_side - v_side);
+        out.p[out.size].x = s.x + t * (v.x - s.x);
+        out.p[out.size].y = s.y + t * (v.y - s.y);
+        out.size++;
+      }
+      if(v_side >= 0.0)
+        out.p[out.size++] = v;
+      s = v;
+      s_side = v_side;
+    }
+    current = 1 - current;
+    if(out.size < 3)
+      return 0.0;
+  }
+  return polygon_area(polygons[current].p, polygons[current].size);
+}
+
+
+// Area of the convex hull of the corners of both boxes (monotone chain)
+double hull_area(const Corners &a, const Corners &b) {
+  Point points[8];
+  std::copy(a.p, a.p + 4, points);
+  std::copy(b.p, b.p + 4, points + 4);
+  std::sort(points, points + 8);
+
+  Point hull[16];
+  int size = 0;
+  for(int i = 0; i < 8; i++) {
+    while(size >= 2 && (hull[size - 1].x - hull[size - 2].x) * (points[i].y - hull[size - 2].y) -
+                       (hull[size - 1].y - hull[size - 2].y) * (points[i].x - hull[size - 2].x) <= 0.0)
+      size--;
+    hull[size++] = points[i];
+  }
+  for(int i = 6, lower = size + 1; i >= 0; i--) {
+    while(size >= lower && (hull[size - 1].x - hull[size - 2].x) * (points[i].y - hull[size - 2].y) -
+                           (hull[size - 1].y - hull[size - 2].y) * (points[i].x - hull[size - 2].x) <= 0.0)
+      size--;
+    hull[size++] = points[i];
+  }
+  return polygon_area(hull, size - 1);
+}
+
+
+double corners_iou(const Corners &a, const Corners &b, bool generalized) {
+  const double intersection = bounds_overlap(a, b) ? clipped_area(a, b) : 0.0;
+  const double union_area = a.area + b.area - intersection;
+  const double iou = union_area > 0.0 ? intersection / union_area : 0.0;
+  if(!generalized)
+    return iou;
+  const double hull = hull_area(a, b);
+  return hull > 0.0 ? iou - (hull - union_area) / hull : iou;
+}
+
+}
+
+
+double intersection_area(const Box &a, const Box &b) {
+  const Corners ca = make_corners(a), cb = make_corners(b);
+  return bounds_overlap(ca, cb) ? clipped_area(ca, cb) : 0.0;
+}
+
+
+double iou(const Box &a, const Box &b) {
+  return corners_iou(make_corners(a), make_corners(b), false);
+}
+
+
+double giou(const Box &a, const Box &b) {
+  return corners_iou(make_corners(a), make_corners(b), true);
+}
+
+
+double circle_iou(const Circle &a, const Circle &b) {
+  const double distance = std::hypot(a.x - b.x, a.y - b.y);
+  if(distance >= a.r + b.r)
+    return 0.0;
+  // One circle inside the other
+  if(a.r - b.r >= distance)
+    return (b.r * b.r) / (a.r * a.r);
+  if(b.r - a.r >= distance)
+    return (a.r * a.r) / (b.r * b.r);
+  // Lens area from the law of cosines
+  const double angle_a = std::acos((a.r * a.r + distance * distance - b.r * b.r) / (2.0 * a.r * distance));
+  const double angle_b = std::acos((b.r * b.r + distance * distance - a.r * a.r) / (2.0 * b.r * distance));
+  const double intersection = a.r * a.r * angle_a + b.r * b.r * angle_b - a.r * distance * std::sin(angle_a);
+  return intersection / (M_PI * (a.r * a.r + b.r * b.r) - intersection);
+}
+
+
+void iou_matrix(const std::vector<Box> &dets, const std::vector<Box> &trks,
+                std::vector<double> &matrix, bool generalized) {
+  std::vector<Corners> trk_corners(trks.size());
+  for(int t = 0; t < trks.size(); t++)
+    trk_corners[t] = make_corners(trks[t]);
+
+  matrix.resize(dets.size() * trks.size());
+  double *row = matrix.data();
+  for(int d = 0; d < dets.size(); d++, row += trks.size()) {
+    const Corners det_corners = make_corners(dets[d]);
+    for(int t = 0; t < trks.size(); t++)
+      row[t] = corners_iou(det_corners, trk_corners[t], generalized);
+  }
+}
+
+
+void circle_iou_matrix(const std::vector<Circle> &dets, const std::vector<Circle> &trks,
+                       std::vector<double> &matrix) {
+  matrix.resize(dets.size() * trks.size());
+  double *row = matrix.data();
+  for(int d = 0; d < dets.size(); d++, row += trks.size())
+    for(int t = 0; t < trks.size(); t++)
+      row[t] = circle_iou(dets[d], trks[t]);
+}
+
+}
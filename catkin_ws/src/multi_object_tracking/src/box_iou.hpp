@@ -0,0 +1,44 @@
+#ifndef MULTI_OBJECT_TRACKING_BOX_IOU_HPP
+#define MULTI_OBJECT_TRACKING_BOX_IOU_HPP
+
+#include <vector>
+
+namespace box_iou {
+
+// Rotated box in the bird's eye view: center, length along the heading, width, heading
+struct Box {
+  double x, y, l, w, yaw;
+};
+
+// Circle footprint of a person, the [x, y, r] state of mot2d_node
+struct Circle {
+  double x, y, r;
+};
+
+// Area of the intersection of two rotated boxes, the corners of a are clipped by the
+// four edges of b (Sutherland-Hodgman on fixed-size buffers).
+double intersection_area(const Box &a, const Box &b);
+
+// Intersection over union, 0 for disjoint boxes
+double iou(const Box &a, const Box &b);
+
+// Generalized IoU, iou - (hull - union) / hull where hull is the area of the convex hull of
+// both boxes. In [-1, 1], negative for disjoint boxes and decreasing with their distance.
+double giou(const Box &a, const Box &b);
+
+// Same as AB3DMOT_libs.model.iou2d
+double circle_iou(const Circle &a, const Circle &b);
+
+// Row-major dets.size() x trks.size() matrix of iou (or giou if generalized) of every
+// detection/track pair. The corners and axis-aligned bounds of every box are computed once,
+// pairs with disjoint bounds are not clipped.
+void iou_matrix(const std::vector<Box> &dets, const std::vector<Box> &trks,
+                std::vector<double> &matrix, bool generalized = false);
+
+// Row-major dets.size() x trks.size() matrix of circle_iou
+void circle_iou_matrix(const std::vector<Circle> &dets, const std::vector<Circle> &trks,
+                       std::vector<double> &matrix);
+
+}
+
+#endif
@@ -0,0 +1,96 @@
+// Python module box_iou_cpp, det x trk association matrices for AB3DMOT_libs:
+//   import box_iou_cpp
+//   iou = box_iou_cpp.circle_iou_matrix(dets, trks)          # rows [x, y, r]
+//   iou = box_iou_cpp.iou_matrix(dets, trks, giou=False)     # rows [x, y, l, w, yaw]
+// The matrices are returned as lists of rows.
+#include <vector>
+
+#include <boost/python.hpp>
+
+#include "box_iou.hpp"
+#include "python_utils.hpp"
+
+namespace bp = boost::python;
+using python_utils::to_double;
+
+
+// Any python sequence of rows of numbers (list of lists, 2D numpy array)
+static void to_rows(const bp::object &seq, int num_columns, std::vector<double> &values) {
+  const int num_rows = bp::len(seq);
+  values.resize(num_rows * num_columns);
+  for(int i = 0; i < num_rows; i++) {
+    bp::object row = seq[i];
+    if(bp::len(row) < num_columns) {
+      PyErr_SetString(PyExc_ValueError, "box_iou_cpp: row too short");
+      bp::throw_error_already_set();
+    }
+    for(int j = 0; j < num_columns; j++)
+      values[i * num_columns + j] = to_double(row[j]);
+  }
+}
+
+
+static std::vector<box_iou::Box> to_boxes(const bp::object &seq) {
+  std::vector<double> values;
+  to_rows(seq, 5, values);
+  std::vector<box_iou::Box> boxes(values.size() / 5);
+  for(int i = 0; i < boxes.size(); i++) {
+    const double *v = &values[i * 5];
+    boxes[i] = {v[0], v[1], v[2], v[3], v[4]};
+  }
+  return boxes;
+}
+
+
+static std::vector<box_iou::Circle> to_circles(const bp::object &seq) {
+  std::vector<double> values;
+  to_rows(seq, 3, values);
+  std::vector<box_iou::Circle> circles(values.size() / 3);
+  for(int i = 0; i < circles.size(); i++) {
+    const double *v = &values[i * 3];
+    circles[i] = {v[0], v[1], v[2]};
+  }
+  return circles;
+}
+
+
+static bp::list to_list(const std::vector<double> &matrix, int num_rows, int num_columns) {
+  bp::list rows;
+  for(int i = 0; i < num_rows; i++) {
+    bp::list row;
+    for(int j = 0; j < num_columns; j++)
+      row.append(matrix[i * num_columns + j]);
+    rows.append(row);
+  }
+  return rows;
+}
+
+
+static bp::list iou_matrix(const bp::object &dets, const bp::object &trks, bool giou) {
+  std::vector<box_iou::Box> det_boxes = to_boxes(dets), trk_boxes = to_boxes(trks);
+  std::vector<double> matrix;
+  box_iou::iou_matrix(det_boxes, trk_boxes, matrix, giou);
+  return to_list(matrix, det_boxes.size(), trk_boxes.size());
+}
+
+
+static bp::list circle_iou_matrix(const bp::object &dets, const bp::object &trks) {
+  std::vector<box_iou::Circle> det_circles = to_circles(dets), trk_circles = to_circles(trks);
+  std::vector<double> matrix;
+  box_iou::circle_iou_matrix(det_circles, trk_circles, matrix);
+  return to_list(matrix, det_circles.size(), trk_circles.size());
+}
+
+
+static double box_pair_iou(const bp::object &a, const bp::object &b, bool giou) {
+  std::vector<box_iou::Box> boxes = to_boxes(bp::make_tuple(a, b));
+  return giou ? box_iou::giou(boxes[0], boxes[1]) : box_iou::iou(boxes[0], boxes[1]);
+}
+
+
+BOOST_PYTHON_MODULE(box_iou_cpp)
+{
+  bp::def("iou_matrix", &iou_matrix, (bp::arg("dets"), bp::arg("trks"), bp::arg("giou") = false));
+  bp::def("circle_iou_matrix", &circle_iou_matrix, (bp::arg("dets"), bp::arg("trks")));
+  bp::def("iou", &box_pair_iou, (bp::arg("box1"), bp::arg("box2"), bp::arg("giou") = false));
+}
@@ -0,0 +1,226 @@
+#include "clear_mot.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace clear_mot {
+
+static double ratio(double numerator, double denominator) {
+  return denominator > 0.0 ? numerator / denominator : 0.0;
+}
+
+
+double Metrics::mota() const {
+  return 1.0 - ratio(num_misses + num_false_positives + (identities ? num_switches : 0), num_ground_truth);
+}
+
+double Metrics::motp() const { return ratio(sum_distance, num_matches); }
+double Metrics::precision() const { return ratio(num_matches, num_hypotheses); }
+double Metrics::recall() const { return ratio(num_matches, num_ground_truth); }
+
+double Metrics::idf1() const {
+  return ratio(2.0 * id_true_positives, 2.0 * id_true_positives + id_false_positives + id_false_negatives);
+}
+
+double Metrics::idp() const { return ratio(id_true_positives, id_true_positives + id_false_positives); }
+double Metrics::idr() const { return ratio(id_true_positives, id_true_positives + id_false_negatives); }
+
+
+void linear_assignment(const std::vector<double> &cost, int rows, int cols, double max_cost,
+                       std::vector<int> &assignment) {
+  assignment.assign(rows, -1);
+  const int n = std::max(rows, cols);
+  if(n == 0)
+    return;
+
+  // Square matrix, the padding and the forbidden pairs cost more than any full assignment
+  double max_abs = 0.0;
+  for(int i = 0; i < rows * cols; i++)
+    if(cost[i] < max_cost)
+      max_abs = std::max(max_abs, std::fabs(cost[i]));
+  const double forbidden = (max_abs + 1.0) * (n + 1);
+  std::vector<double> a(n * n, forbidden);
+  for(int i = 0; i < rows; i++)
+    for(int j = 0; j < cols; j++)
+      if(cost[i * cols + j] < max_cost)
+        a[i * n + j] = cost[i * cols + j];
+
+  // Shortest augmenting paths with row and column potentials, 1-based with column 0 as the root
+  const double inf = std::numeric_limits<double>::infinity();
+  std::vector<double> u(n + 1, 0.0), v(n + 1, 0.0);
+  std::vector<int> p(n + 1, 0), way(n + 1, 0);
+  for(int i = 1; i <= n; i++) {
+    p[0] = i;
+    int j0 = 0;
+    std::vector<double> min_v(n + 1, inf);
+    std::vector<bool> used(n + 1, false);
+    do {
+      used[j0] = true;
+      const int i0 = p[j0];
+      double delta = inf;
+      int j1 = 0;
+      for(int j = 1; j <= n; j++) {
+        if(used[j])
+          continue;
+        const double reduced = a[(i0 - 1) * n + j - 1] - u[i0] - v[j];
+        if(reduced < min_v[j]) {
+          min_v[j] = reduced;
+          way[j] = j0;
+        }
+        if(min_v[j] < delta) {
+          delta = min_v[j];
+          j1 = j;
+        }
+      }
+      for(int j = 0; j <= n; j++) {
+        if(used[j]) {
+          u[p[j]] += delta;
+          v[j] -= delta;
+        }
+        else
+          min_v[j] -= delta;
+      }
+      j0 = j1;
+    } while(p[j0] != 0);
+    do {
+      const int j1 = way[j0];
+      p[j0] = p[j1];
+      j0 = j1;
+    } while(j0 != 0);
+  }
+
+  for(int j = 1; j <= n; j++) {
+    const int i = p[j] - 1, col = j - 1;
+    if(i < rows && col < cols && cost[i * cols + col] < max_cost)
+      assignment[i] = col;
+  }
+}
+
+
+Evaluator::Evaluator(double threshold, bool identities): threshold_(threshold) {
+  metrics_ = Metrics();
+  metrics_.identities = identities;
+}
+
+
+void Evaluator::add_frame(const std::vector<Object> &ground_truth, const std::vector<Object> &hypotheses) {
+  const int num_gt = ground_truth.size(), num_hyp = hypotheses.size();
+  metrics_.num_frames++;
+  metrics_.num_ground_truth += num_gt;
+  metrics_.num_hypotheses += num_hyp;
+
+  std::vector<double> distance(num_gt * num_hyp);
+  for(int g = 0; g < num_gt; g++)
+    for(int h = 0; h < num_hyp; h++)
+      distance[g * num_hyp + h] = std::hypot(ground_truth[g].x - hypotheses[h].x, ground_truth[g].y - hypotheses[h].y);
+
+  // Keep the matches of the previous frame that are still within the threshold
+  std::vector<int> gt_match(num_gt, -1), hyp_match(num_hyp, -1);
+  if(metrics_.identities) {
+    std::map<long, int> hyp_index;
+    for(int h = 0; h < num_hyp; h++)
+      hyp_index[hypotheses[h].id] = h;
+    for(int g = 0; g < num_gt; g++) {
+      std::map<long, long>::const_iterator previous = previous_matches_.find(ground_truth[g].id);
+      if(previous == previous_matches_.end())
+        continue;
+      std::map<long, int>::const_iterator h = hyp_index.find(previous->second);
+      if(h != hyp_index.end() && hyp_match[h->second] < 0 && distance[g * num_hyp + h->second] < threshold_) {
+        gt_match[g] = h->second;
+        hyp_match[h->second] = g;
+      }
+    }
+  }
+
+  // Minimum distance assignment of the others
+  std::vector<int> free_gt, free_hyp;
+  for(int g = 0; g < num_gt; g++)
+    if(gt_match[g] < 0)
+      free_gt.push_back(g);
+  for(int h = 0; h < num_hyp; h++)
+    if(hyp_match[h] < 0)
+      free_hyp.push_back(h);
+  std::vector<double> cost(free_gt.size() * free_hyp.size());
+  for(int i = 0; i < free_gt.size(); i++)
+    for(int j = 0; j < free_hyp.size(); j++)
+      cost[i * free_hyp.size() + j] = distance[free_gt[i] * num_hyp + free_hyp[j]];
+  std::vector<int> assignment;
+  linear_assignment(cost, free_gt.size(), free_hyp.size(), threshold_, assignment);
+  for(int i = 0; i < free_gt.size(); i++) {
+    if(assignment[i] >= 0) {
+      gt_match[free_gt[i]] = free_hyp[assignment[i]];
+      hyp_match[free_hyp[assignment[i]]] = free_gt[i];
+    }
+  }
+
+  // Count the frame
+  previous_matches_.clear();
+  for(int g = 0; g < num_gt; g++) {
+    GroundTruthTrack &track = ground_truth_tracks_.insert(
+      std::make_pair(ground_truth[g].id, GroundTruthTrack{false, false, 0})).first->second;
+    const int h = gt_match[g];
+    if(h < 0) {
+      metrics_.num_misses++;
+      track.tracked = false;
+      continue;
+    }
+    metrics_.num_matches++;
+    metrics_.sum_distance += distance[g * num_hyp + h];
+    if(track.ever_tracked && !track.tracked)
+      metrics_.num_fragmentations++;
+    if(metrics_.identities) {
+      if(track.ever_tracked && track.last_hypothesis_id != hypotheses[h].id)
+        metrics_.num_switches++;
+      previous_matches_[ground_truth[g].id] = hypotheses[h].id;
+    }
+    track.tracked = track.ever_tracked = true;
+    track.last_hypothesis_id = hypotheses[h].id;
+  }
+  for(int h = 0; h < num_hyp; h++) {
+    hypothesis_counts_[hypotheses[h].id]++;
+    if(hyp_match[h] < 0)
+      metrics_.num_false_positives++;
+  }
+
+  // Identity overlaps for IDF1
+  if(metrics_.identities) {
+    for(int g = 0; g < num_gt; g++)
+      for(int h = 0; h < num_hyp; h++)
+        if(distance[g * num_hyp + h] < threshold_)
+          id_overlaps_[std::make_pair(ground_truth[g].id, hypotheses[h].id)]++;
+  }
+}
+
+
+Metrics Evaluator::metrics() const {
+  Metrics metrics = metrics_;
+  metrics.num_ground_truth_ids = ground_truth_tracks_.size();
+  metrics.num_hypothesis_ids = hypothesis_counts_.size();
+  if(!metrics.identities)
+    return metrics;
+
+  // Global one-to-one matching of the ids maximizing the frames where they overlap. Ids that
+  // never overlap are left out, the pairs that do not overlap are allowed at no cost.
+  std::map<long, int> rows, cols;
+  for(std::map<std::pair<long, long>, int>::const_iterator it = id_overlaps_.begin(); it != id_overlaps_.end(); ++it) {
+    rows.insert(std::make_pair(it->first.first, (int)rows.size()));
+    cols.insert(std::make_pair(it->first.second, (int)cols.size()));
+  }
+  std::vector<double> cost(rows.size() * cols.size(), 0.0);
+  for(std::map<std::pair<long, long>, int>::const_iterator it = id_overlaps_.begin(); it != id_overlaps_.end(); ++it)
+    cost[rows[it->first.first] * cols.size() + cols[it->first.second]] = -it->second;
+  std::vector<int> assignment;
+  linear_assignment(cost, rows.size(), cols.size(), 1.0, assignment);
+
+  int id_true_positives = 0;
+  for(int i = 0; i < assignment.size(); i++)
+    if(assignment[i] >= 0)
+      id_true_positives -= cost[i * cols.size() + assignment[i]];
+  metrics.id_true_positives = id_true_positives;
+  metrics.id_false_negatives = metrics.num_ground_truth - id_true_positives;
+  metrics.id_false_positives = metrics.num_hypotheses - id_true_positives;
+  return metrics;
+}
+
+}
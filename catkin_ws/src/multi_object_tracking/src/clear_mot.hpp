@@ -0,0 +1,79 @@
+#ifndef MULTI_OBJECT_TRACKING_CLEAR_MOT_HPP
+#define MULTI_OBJECT_TRACKING_CLEAR_MOT_HPP
+
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace clear_mot {
+
+// Ground truth object or hypothesis of a frame, on the ground plane
+struct Object {
+  long id;
+  double x, y;
+};
+
+struct Metrics {
+  bool identities;            // hypotheses carry track ids, false for raw detections
+  int num_frames;
+  int num_ground_truth;       // ground truth objects summed over the frames
+  int num_hypotheses;
+  int num_matches;
+  int num_false_positives;
+  int num_misses;
+  int num_switches;           // a ground truth object matched to another hypothesis than last time
+  int num_fragmentations;     // a ground truth trajectory tracked again after being lost
+  int num_ground_truth_ids;
+  int num_hypothesis_ids;
+  double sum_distance;        // of the matches
+  int id_true_positives;      // frames of the ground truth / hypothesis id pairs of the global IDF1 matching
+  int id_false_positives;
+  int id_false_negatives;
+
+  double mota() const;
+  double motp() const;        // mean distance of the matches
+  double precision() const;
+  double recall() const;
+  double idf1() const;
+  double idp() const;
+  double idr() const;
+};
+
+// Assignment of the rows to the columns of the row-major rows x cols matrix with the most
+// pairs whose cost is below max_cost, and among those the minimum total cost (Hungarian
+// algorithm, O(n^3) with n = max(rows, cols)). assignment[row] is the column of row, or -1.
+void linear_assignment(const std::vector<double> &cost, int rows, int cols, double max_cost,
+                       std::vector<int> &assignment);
+
+
+// CLEAR MOT (MOTA, MOTP) and identity (IDF1) metrics of a sequence, frame by frame.
+// A ground truth object and a hypothesis match when they are closer than the threshold.
+// The matches of the previous frame are kept when still valid, the other objects are
+// assigned by minimum total distance.
+class Evaluator {
+public:
+  explicit Evaluator(double threshold = 0.5, bool identities = true);
+
+  void add_frame(const std::vector<Object> &ground_truth, const std::vector<Object> &hypotheses);
+
+  // The IDF1 terms come from a global matching of the ids over all the frames so far
+  Metrics metrics() const;
+
+private:
+  struct GroundTruthTrack {
+    bool tracked;             // matched the last time it was present
+    bool ever_tracked;
+    long last_hypothesis_id;  // of the last match
+  };
+
+  double threshold_;
+  Metrics metrics_;
+  std::map<long, GroundTruthTrack> ground_truth_tracks_;
+  std::map<long, long> previous_matches_;                    // ground truth id -> hypothesis id
+  std::map<long, int> hypothesis_counts_;                    // frames of each hypothesis id
+  std::map<std::pair<long, long>, int> id_overlaps_;         // frames where the pair is within the threshold
+};
+
+}
+
+#endif
@@ -0,0 +1,276 @@
+#include "imm_filter.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <Eigen/Cholesky>
+
+namespace imm_filter {
+
+ImmParameters::ImmParameters() {
+  transition << 0.90, 0.08, 0.02,
+                0.05, 0.90, 0.05,
+                0.02, 0.08, 0.90;
+  initial_mode_probabilities << 0.2, 0.6, 0.2;
+  position_measurement_noise = 0.1;
+  radius_measurement_noise = 0.1;
+  position_noise = 0.01;
+  acceleration_noise = 0.01;
+  turn_rate_noise = 0.02;
+  radius_noise = 0.005;
+  initial_velocity_noise = 0.15;
+  initial_turn_rate_noise = 0.1;
+}
+
+
+namespace {
+
+// Process noise of a white acceleration on the position (0, 1) and velocity (3, 4) pairs
+void add_acceleration_noise(double sigma, double dt, Covariance &Q) {
+  const double q = sigma * sigma;
+  for(int axis = 0; axis < 2; axis++) {
+    Q(axis, axis) += q * dt * dt * dt * dt / 4.0;
+    Q(axis, axis + 3) += q * dt * dt * dt / 2.0;
+    Q(axis + 3, axis) += q * dt * dt * dt / 2.0;
+    Q(axis + 3, axis + 3) += q * dt * dt;
+  }
+}
+
+
+// Coordinated turn transition of x and its Jacobian, with the w -> 0 limit for straight walking
+void coordinated_turn(const State &x, double dt, State &x_pred, Covariance &F) {
+  const double vx = x(3), vy = x(4), w = x(5);
+  const double s = std::sin(w * dt), c = std::cos(w * dt);
+  double a, b, da, db;
+  if(std::fabs(w) > 1e-6) {
+    a = s / w;
+    b = (1.0 - c) / w;
+    da = (dt * c * w - s) / (w * w);
+    db = (dt * s * w - (1.0 - c)) / (w * w);
+  }
+  else {
+    a = dt;
+    b = 0.5 * w * dt * dt;
+    da = 0.0;
+    db = 0.5 * dt * dt;
+  }
+
+  x_pred = x;
+  x_pred(0) += a * vx - b * vy;
+  x_pred(1) += b * vx + a * vy;
+  x_pred(3) = c * vx - s * vy;
+  x_pred(4) = s * vx + c * vy;
+
+  F.setIdentity();
+  F(0, 3) = a;   F(0, 4) = -b;  F(0, 5) = da * vx - db * vy;
+  F(1, 3) = b;   F(1, 4) = a;   F(1, 5) = db * vx + da * vy;
+  F(3, 3) = c;   F(3, 4) = -s;  F(3, 5) = -dt * (s * vx + c * vy);
+  F(4, 3) = s;   F(4, 4) = c;   F(4, 5) = dt * (c * vx - s * vy);
+}
+
+}
+
+
+ImmFilterBank::ImmFilterBank(const ImmParameters &parameters): parameters_(parameters) {
+  measurement_covariance_.setZero();
+  measurement_covariance_(0, 0) = measurement_covariance_(1, 1) =
+    parameters_.position_measurement_noise * parameters_.position_measurement_noise;
+  measurement_covariance_(2, 2) = parameters_.radius_measurement_noise * parameters_.radius_measurement_noise;
+}
+
+
+void ImmFilterBank::add(int id, const Measurement &z) {
+  std::unordered_map<int, int>::const_iterator it = index_.find(id);
+  if(it == index_.end()) {
+    index_[id] = tracks_.size();
+    tracks_.push_back(Track());
+  }
+  Track &track = tracks_[index_[id]];
+  track.id = id;
+
+  State x = State::Zero();
+  x.head<3>() = z;
+  Covariance P = Covariance::Zero();
+  P.topLeftCorner<3, 3>() = measurement_covariance_;
+  P(3, 3) = P(4, 4) = parameters_.initial_velocity_noise * parameters_.initial_velocity_noise;
+  P(5, 5) = parameters_.initial_turn_rate_noise * parameters_.initial_turn_rate_noise;
+  for(int j = 0; j < NUM_MODELS; j++) {
+    track.x[j] = x;
+    track.P[j] = P;
+  }
+  track.mode_probabilities = parameters_.initial_mode_probabilities / parameters_.initial_mode_probabilities.sum();
+  combine(track);
+}
+
+
+bool ImmFilterBank::remove(int id) {
+  std::unordered_map<int, int>::iterator it = index_.find(id);
+  if(it == index_.end())
+    return false;
+  // Move the last track into the hole
+  const int index = it->second;
+  index_.erase(it);
+  if(index != tracks_.size() - 1) {
+    tracks_[index] = tracks_.back();
+    index_[tracks_[index].id] = index;
+  }
+  tracks_.pop_back();
+  return true;
+}
+
+
+void ImmFilterBank::clear() {
+  tracks_.clear();
+  index_.clear();
+}
+
+
+void ImmFilterBank::predict(double dt) {
+  for(int i = 0; i < tracks_.size(); i++)
+    predict(tracks_[i], dt);
+}
+
+
+void ImmFilterBank::predict(Track &track, double dt) const {
+  // Mixing: the prior of model j starts from the estimates of every model i weighted by the
+  // probability that the track was in mode i given it switches to j
+  const Eigen::Matrix3d &p = parameters_.transition;
+  const ModeProbabilities predicted = p.transpose() * track.mode_probabilities;
+  State x0[NUM_MODELS];
+  Covariance P0[NUM_MODELS];
+  for(int j = 0; j < NUM_MODELS; j++) {
+    x0[j].setZero();
+    double weights[NUM_MODELS];
+    for(int i = 0; i < NUM_MODELS; i++) {
+      weights[i] = predicted(j) > 0.0 ? p(i, j) * track.mode_probabilities(i) / predicted(j) : 0.0;
+      x0[j] += weights[i] * track.x[i];
+    }
+    P0[j].setZero();
+    for(int i = 0; i < NUM_MODELS; i++) {
+      const State d = track.x[i] - x0[j];
+      P0[j] += weights[i] * (track.P[i] + d * d.transpose());
+    }
+  }
+
+  const double radius_q = parameters_.radius_noise * parameters_.radius_noise * dt;
+  const double turn_rate_q = parameters_.initial_turn_rate_noise * parameters_.initial_turn_rate_noise;
+
+  // Standing: the position random walks, the velocity and turn rate are reset to 0 with their
+  // initial uncertainty
+  {
+    State &x = track.x[CONSTANT_POSITION];
+    Covariance &P = track.P[CONSTANT_POSITION];
+    Covariance F = Covariance::Identity();
+    F(3, 3) = F(4, 4) = F(5, 5) = 0.0;
+    x = F * x0[CONSTANT_POSITION];
+    P = F * P0[CONSTANT_POSITION] * F.transpose();
+    P(0, 0) += parameters_.position_noise * parameters_.position_noise * dt;
+    P(1, 1) += parameters_.position_noise * parameters_.position_noise * dt;
+    P(2, 2) += radius_q;
+    P(3, 3) += parameters_.initial_velocity_noise * parameters_.initial_velocity_noise;
+    P(4, 4) += parameters_.initial_velocity_noise * parameters_.initial_velocity_noise;
+    P(5, 5) += turn_rate_q;
+  }
+
+  // Walking straight: the turn rate is reset to 0 with its initial uncertainty, so that the
+  // turning model can pick it up again when mixing
+  {
+    State &x = track.x[CONSTANT_VELOCITY];
+    Covariance &P = track.P[CONSTANT_VELOCITY];
+    Covariance F = Covariance::Identity();
+    F(0, 3) = F(1, 4) = dt;
+    F(5, 5) = 0.0;
+    x = F * x0[CONSTANT_VELOCITY];
+    P = F * P0[CONSTANT_VELOCITY] * F.transpose();
+    add_acceleration_noise(parameters_.acceleration_noise, dt, P);
+    P(2, 2) += radius_q;
+    P(5, 5) += turn_rate_q;
+  }
+
+  // Turning
+  {
+    State &x = track.x[COORDINATED_TURN];
+    Covariance &P = track.P[COORDINATED_TURN];
+    Covariance F;
+    coordinated_turn(x0[COORDINATED_TURN], dt, x, F);
+    P = F * P0[COORDINATED_TURN] * F.transpose();
+    add_acceleration_noise(parameters_.acceleration_noise, dt, P);
+    P(2, 2) += radius_q;
+    P(5, 5) += parameters_.turn_rate_noise * parameters_.turn_rate_noise * dt * dt;
+  }
+
+  track.mode_probabilities = predicted;
+  combine(track);
+}
+
+
+bool ImmFilterBank::update(int id, const Measurement &z) {
+  std::unordered_map<int, int>::const_iterator it = index_.find(id);
+  if(it == index_.end())
+    return false;
+  Track &track = tracks_[it->second];
+
+  double log_likelihood[NUM_MODELS];
+  for(int j = 0; j < NUM_MODELS; j++) {
+    State &x = track.x[j];
+    Covariance &P = track.P[j];
+    // H selects [x, y, r]
+    const Eigen::Vector3d innovation = z - x.head<3>();
+    const Eigen::Matrix3d S = P.topLeftCorner<3, 3>() + measurement_covariance_;
+    const Eigen::LLT<Eigen::Matrix3d> llt(S);
+    const Eigen::Matrix<double, 3, 6> HP = P.topRows<3>();
+    // K = P H^T S^-1 = (S^-1 H P)^T
+    const Eigen::Matrix<double, 6, 3> K = llt.solve(HP).transpose();
+    x += K * innovation;
+    P -= K * HP;
+    P = 0.5 * (P + P.transpose()).eval();
+
+    const double log_det = 2.0 * llt.matrixLLT().diagonal().array().log().sum();
+    log_likelihood[j] = -0.5 * (innovation.dot(llt.solve(innovation)) + log_det + 3.0 * std::log(2.0 * M_PI));
+  }
+
+  // Mode probabilities from the likelihoods, normalized in the log domain so that a far
+  // detection does not underflow all of them
+  const double max_log_likelihood = *std::max_element(log_likelihood, log_likelihood + NUM_MODELS);
+  ModeProbabilities mode_probabilities;
+  for(int j = 0; j < NUM_MODELS; j++)
+    mode_probabilities(j) = track.mode_probabilities(j) * std::exp(log_likelihood[j] - max_log_likelihood);
+  const double sum = mode_probabilities.sum();
+  if(sum > 0.0 && std::isfinite(sum))
+    track.mode_probabilities = mode_probabilities / sum;
+
+  combine(track);
+  return true;
+}
+
+
+void ImmFilterBank::combine(Track &track) const {
+  track.state.setZero();
+  for(int j = 0; j < NUM_MODELS; j++)
+    track.state += track.mode_probabilities(j) * track.x[j];
+  track.covariance.setZero();
+  for(int j = 0; j < NUM_MODELS; j++) {
+    const State d = track.x[j] - track.state;
+    track.covariance += track.mode_probabilities(j) * (track.P[j] + d * d.transpose());
+  }
+}
+
+
+bool ImmFilterBank::get(int id, State &state, Covariance &covariance, ModeProbabilities &mode_probabilities) const {
+  std::unordered_map<int, int>::const_iterator it = index_.find(id);
+  if(it == index_.end())
+    return false;
+  const Track &track = tracks_[it->second];
+  state = track.state;
+  covariance = track.covariance;
+  mode_probabilities = track.mode_probabilities;
+  return true;
+}
+
+
+bool ImmFilterBank::get(int id, State &state, ModeProbabilities &mode_probabilities) const {
+  Covariance covariance;
+  return get(id, state, covariance, mode_probabilities);
+}
+
+}
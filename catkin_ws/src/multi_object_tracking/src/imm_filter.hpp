@@ -0,0 +1,94 @@
+#ifndef MULTI_OBJECT_TRACKING_IMM_FILTER_HPP
+#define MULTI_OBJECT_TRACKING_IMM_FILTER_HPP
+
+#include <unordered_map>
+#include <vector>
+
+#include <Eigen/Core>
+#include <Eigen/StdVector>
+
+namespace imm_filter {
+
+// Motion models of the filter bank
+enum Model {
+  CONSTANT_POSITION = 0,  // standing
+  CONSTANT_VELOCITY = 1,  // walking straight
+  COORDINATED_TURN = 2,   // walking on a circle, extended Kalman filter
+  NUM_MODELS = 3
+};
+
+// State [x, y, r, vx, vy, w] shared by all the models: position, radius of the footprint,
+// velocity and turn rate. Measurement [x, y, r] of a detection.
+typedef Eigen::Matrix<double, 6, 1> State;
+typedef Eigen::Matrix<double, 6, 6> Covariance;
+typedef Eigen::Vector3d Measurement;
+typedef Eigen::Vector3d ModeProbabilities;
+
+// Noise is given per step, as the AB3DMOT tracker runs with dt = 1 frame. The defaults are
+// tuned for people detected at 8-10 Hz.
+struct ImmParameters {
+  ImmParameters();
+
+  Eigen::Matrix3d transition;         // transition(i, j), probability to switch from model i to j per step
+  ModeProbabilities initial_mode_probabilities;
+  double position_measurement_noise;  // std of the detected x, y
+  double radius_measurement_noise;    // std of the detected r
+  double position_noise;              // std of the position random walk of CONSTANT_POSITION
+  double acceleration_noise;          // std of the acceleration of CONSTANT_VELOCITY and COORDINATED_TURN
+  double turn_rate_noise;             // std of the turn rate change of COORDINATED_TURN
+  double radius_noise;                // std of the radius random walk
+  double initial_velocity_noise;      // std of the unobserved velocity of a new track
+  double initial_turn_rate_noise;     // std of the unobserved turn rate of a new track
+};
+
+
+// Interacting multiple model filters of all the tracks. Every track runs the three models on
+// fixed-size matrices; predict() mixes and advances all of them in one pass, update() fuses
+// a detection and updates the mode probabilities from the model likelihoods.
+class ImmFilterBank {
+public:
+  explicit ImmFilterBank(const ImmParameters &parameters = ImmParameters());
+
+  // Starts the track id at the measurement z, an existing track id is replaced
+  void add(int id, const Measurement &z);
+  bool remove(int id);
+  bool contains(int id) const { return index_.count(id) > 0; }
+  int size() const { return tracks_.size(); }
+  void clear();
+
+  // Mixing and prediction of every track, the mode probabilities become the predicted ones
+  void predict(double dt = 1.0);
+
+  // Fuses the measurement z into the track id, false if there is no such track
+  bool update(int id, const Measurement &z);
+
+  // Combined (moment matched) estimate and mode probabilities of the track id
+  bool get(int id, State &state, Covariance &covariance, ModeProbabilities &mode_probabilities) const;
+  bool get(int id, State &state, ModeProbabilities &mode_probabilities) const;
+
+  const ImmParameters &parameters() const { return parameters_; }
+
+private:
+  struct Track {
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    int id;
+    State x[NUM_MODELS];
+    Covariance P[NUM_MODELS];
+    ModeProbabilities mode_probabilities;
+    State state;
+    Covariance covariance;
+  };
+
+  void predict(Track &track, double dt) const;
+  void combine(Track &track) const;
+
+  ImmParameters parameters_;
+  Eigen::Matrix3d measurement_covariance_;
+  std::vector<Track, Eigen::aligned_allocator<Track> > tracks_;
+  std::unordered_map<int, int> index_;  // track id -> index in tracks_
+};
+
+}
+
+#endif
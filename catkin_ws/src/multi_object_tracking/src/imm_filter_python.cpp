@@ -0,0 +1,88 @@
+// Python module imm_filter_cpp, IMM filters of all the tracks of AB3DMOT_libs:
+//   import imm_filter_cpp
+//   bank = imm_filter_cpp.ImmFilterBank()
+//   bank.add(track_id, [x, y, r])
+//   bank.predict(1.0)                           # every track, once per frame
+//   bank.update(track_id, [x, y, r])
+//   x, y, r, vx, vy, w = bank.state(track_id)
+//   p_standing, p_walking, p_turning = bank.mode_probabilities(track_id)
+#include <boost/python.hpp>
+
+#include "imm_filter.hpp"
+#include "python_utils.hpp"
+
+namespace bp = boost::python;
+using python_utils::to_double;
+
+
+// Any python sequence of 3 numbers (list, tuple, numpy array)
+static imm_filter::Measurement to_measurement(const bp::object &seq) {
+  if(bp::len(seq) < 3) {
+    PyErr_SetString(PyExc_ValueError, "imm_filter_cpp: measurement [x, y, r] expected");
+    bp::throw_error_already_set();
+  }
+  return imm_filter::Measurement(to_double(seq[0]), to_double(seq[1]), to_double(seq[2]));
+}
+
+
+static void raise_key_error(int id) {
+  PyErr_SetObject(PyExc_KeyError, bp::object(id).ptr());
+  bp::throw_error_already_set();
+}
+
+
+static void bank_add(imm_filter::ImmFilterBank &bank, int id, const bp::object &z) {
+  bank.add(id, to_measurement(z));
+}
+
+
+static void bank_update(imm_filter::ImmFilterBank &bank, int id, const bp::object &z) {
+  if(!bank.update(id, to_measurement(z)))
+    raise_key_error(id);
+}
+
+
+static bp::list bank_state(const imm_filter::ImmFilterBank &bank, int id) {
+  imm_filter::State state;
+  imm_filter::ModeProbabilities mode_probabilities;
+  if(!bank.get(id, state, mode_probabilities))
+    raise_key_error(id);
+  bp::list l;
+  for(int i = 0; i < state.size(); i++)
+    l.append(state(i));
+  return l;
+}
+
+
+static bp::list bank_mode_probabilities(const imm_filter::ImmFilterBank &bank, int id) {
+  imm_filter::State state;
+  imm_filter::ModeProbabilities mode_probabilities;
+  if(!bank.get(id, state, mode_probabilities))
+    raise_key_error(id);
+  bp::list l;
+  for(int i = 0; i < mode_probabilities.size(); i++)
+    l.append(mode_probabilities(i));
+  return l;
+}
+
+
+static void (imm_filter::ImmFilterBank::*bank_predict)(double) = &imm_filter::ImmFilterBank::predict;
+
+
+BOOST_PYTHON_MODULE(imm_filter_cpp)
+{
+  bp::scope().attr("CONSTANT_POSITION") = int(imm_filter::CONSTANT_POSITION);
+  bp::scope().attr("CONSTANT_VELOCITY") = int(imm_filter::CONSTANT_VELOCITY);
+  bp::scope().attr("COORDINATED_TURN") = int(imm_filter::COORDINATED_TURN);
+
+  bp::class_<imm_filter::ImmFilterBank, boost::noncopyable>("ImmFilterBank")
+    .def("add", &bank_add, (bp::arg("id"), bp::arg("z")))
+    .def("remove", &imm_filter::ImmFilterBank::remove, bp::arg("id"))
+    .def("contains", &imm_filter::ImmFilterBank::contains, bp::arg("id"))
+    .def("clear", &imm_filter::ImmFilterBank::clear)
+    .def("predict", bank_predict, bp::arg("dt") = 1.0)
+    .def("update", &bank_update, (bp::arg("id"), bp::arg("z")))
+    .def("state", &bank_state, bp::arg("id"))
+    .def("mode_probabilities", &bank_mode_probabilities, bp::arg("id"))
+    .def("__len__", &imm_filter::ImmFilterBank::size);
+}
@@ -49,14 +49,16 @@ class MultiObjectTrackingNode(object):
         rospy.on_shutdown(self.shutdown_cb)
         self.last_time = None
 
-        # Tracker
-        self.mot_tracker = AB3DMOT(max_age=6, min_hits=3)
-
         # ROS parameters
         self.flag_trk_vis = rospy.get_param('~flag_trk_vis', False)
+        self.motion_model = rospy.get_param('~motion_model', 'imm')     # 'cv' or 'imm'
+        self.reid = rospy.get_param('~reid', True)                      # re-identify the tracks lost in occlusions
         self.desired_trk_rate = rospy.get_param('~desired_trk_rate', 8.0)
         self.marker_lifetime = 1.0 / self.desired_trk_rate
 
+        # Tracker
+        self.mot_tracker = AB3DMOT(max_age=6, min_hits=3, motion_model=self.motion_model, reid=self.reid)
+
         # ROS publisher & subscriber
         self.pub_trk3d_vis = rospy.Publisher('trk3d_vis', MarkerArray, queue_size=1)
         self.pub_trk3d_result = rospy.Publisher('trk3d_result', Trk3DArray, queue_size=1)
@@ -87,6 +89,7 @@ class MultiObjectTrackingNode(object):
 
         dets_list = None
         info_list = None
+        appearance_list = []
         for idx, det in enumerate(msg.dets_list):
             # Transform detection result to odom frame
             new_det = np.dot(tf_laser2odom, np.array([det.x, det.y, det.z, 1.0]))
@@ -96,11 +99,12 @@ class MultiObjectTrackingNode(object):
             else:
                 dets_list = np.vstack([dets_list, [new_det[0], new_det[1], det.radius]])
                 info_list = np.vstack([info_list, [det.confidence, det.class_id]])
+            appearance_list.append(np.array(det.appearance, dtype=np.float32) if len(det.appearance) > 0 else None)
 
         if dets_list is not None:
             if len(dets_list.shape) == 1: dets_list = np.expand_dims(dets_list, axis=0)
             if len(info_list.shape) == 1: info_list = np.expand_dims(info_list, axis=0)
-            dets_all = {'dets': dets_list, 'info': info_list}
+            dets_all = {'dets': dets_list, 'info': info_list, 'appearance': appearance_list}
 
             trackers = self.mot_tracker.update(dets_all)
         else:
@@ -128,7 +132,7 @@ class MultiObjectTrackingNode(object):
 
         for idx, d in enumerate(trackers):
             '''
-                x, y, r, vx, vy, id, confidence, class_id
+                x, y, r, vx, vy, id, confidence, class_id, p(standing), p(walking), p(turning)
             '''
             # vx, vy = np.array([d[3], d[4]]) / delta_t - np.array([self.ego_velocity.x, self.ego_velocity.y])
             vx, vy = np.array([d[3], d[4]]) / delta_t 
@@ -142,7 +146,9 @@ class MultiObjectTrackingNode(object):
             trk3d_msg.vx, trk3d_msg.vy = vx, vy
             trk3d_msg.yaw = yaw
             trk3d_msg.confidence = d[6]
+            trk3d_msg.id = int(d[5])
             trk3d_msg.class_id = int(d[7])
+            trk3d_msg.mode_probabilities = d[8:11]
             trk3d_array.trks_list.append(trk3d_msg)
 
             # Visualization
@@ -0,0 +1,407 @@
+// Offline CLEAR MOT evaluation of the perception stack on recorded bags, no ROS master needed.
+//   rosrun multi_object_tracking mot_evaluation [options] run1.bag [run2.bag ...]
+//     --tracks TOPIC          walker_msgs/Trk3DArray       (/walker/trk3d_result, "" to skip)
+//     --detections TOPIC      walker_msgs/Det3DArray       (/walker/det3d_result, "" to skip)
+//     --agents TOPIC          pedsim_msgs/AgentStates ground truth (/pedsim_simulator/simulated_agents)
+//     --annotations FILE      ground truth lines "stamp id x y" in the evaluation frame, instead of the agents
+//     --frame FRAME           evaluation frame (odom)
+//     --threshold METERS      match distance (0.5)
+//     --max-time-offset SEC   to the closest ground truth frame (0.1)
+//     --base-frame FRAME      robot frame for --max-range (base_link)
+//     --max-range METERS      only evaluate the objects closer to the robot, 0 for all (0)
+//     --csv FILE              one line per bag and topic
+// Prints MOTA, MOTP, IDF1, ID switches and fragmentations per bag and topic. The detections
+// carry no ids, they only get the CLEAR MOT terms. Each hypothesis frame is stamped with the
+// scan it was computed from, the latency is the time from that scan to the recording of the
+// result.
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/foreach.hpp>
+#include <pedsim_msgs/AgentStates.h>
+#include <rosbag/bag.h>
+#include <rosbag/view.h>
+#include <tf2/buffer_core.h>
+#include <tf2/exceptions.h>
+#include <tf2/LinearMath/Transform.h>
+#include <tf2_msgs/TFMessage.h>
+#include <walker_msgs/Det3DArray.h>
+#include <walker_msgs/Trk3DArray.h>
+
+#include "clear_mot.hpp"
+
+using clear_mot::Object;
+
+struct Options {
+  std::string tracks_topic = "/walker/trk3d_result";
+  std::string detections_topic = "/walker/det3d_result";
+  std::string agents_topic = "/pedsim_simulator/simulated_agents";
+  std::string annotations_file;
+  std::string frame = "odom";
+  double threshold = 0.5;
+  double max_time_offset = 0.1;
+  std::string base_frame = "base_link";
+  double max_range = 0.0;
+  std::string csv_file;
+  std::vector<std::string> bags;
+};
+
+struct HypothesisFrame {
+  ros::Time stamp;
+  double latency;             // recording time - stamp
+  std::string frame_id;
+  std::vector<Object> objects;
+};
+
+// Ground truth frames in the evaluation frame, by stamp
+typedef std::map<ros::Time, std::vector<Object> > GroundTruth;
+
+struct TopicResult {
+  std::string bag, topic;
+  int num_skipped_frames;     // no ground truth close enough in time or no transform
+  clear_mot::Metrics metrics;
+  std::vector<double> latencies;
+};
+
+
+static bool parse_options(int argc, char **argv, Options &options) {
+  for(int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    if(arg.compare(0, 2, "--") != 0) {
+      options.bags.push_back(arg);
+      continue;
+    }
+    if(i + 1 >= argc) {
+      std::fprintf(stderr, "Missing value of %s\n", arg.c_str());
+      return false;
+    }
+    const std::string value = argv[++i];
+    if(arg == "--tracks") options.tracks_topic = value;
+    else if(arg == "--detections") options.detections_topic = value;
+    else if(arg == "--agents") options.agents_topic = value;
+    else if(arg == "--annotations") options.annotations_file = value;
+    else if(arg == "--frame") options.frame = value;
+    else if(arg == "--threshold") options.threshold = std::atof(value.c_str());
+    else if(arg == "--max-time-offset") options.max_time_offset = std::atof(value.c_str());
+    else if(arg == "--base-frame") options.base_frame = value;
+    else if(arg == "--max-range") options.max_range = std::atof(value.c_str());
+    else if(arg == "--csv") options.csv_file = value;
+    else {
+      std::fprintf(stderr, "Unknown option %s\n", arg.c_str());
+      return false;
+    }
+  }
+  return !options.bags.empty();
+}
+
+
+static bool load_annotations(const std::string &file_name, GroundTruth &ground_truth) {
+  std::ifstream file(file_name.c_str());
+  if(!file)
+    return false;
+  std::string line;
+  while(std::getline(file, line)) {
+    if(line.empty() || line[0] == '#')
+      continue;
+    std::istringstream fields(line);
+    double stamp;
+    Object object;
+    if(fields >> stamp >> object.id >> object.x >> object.y)
+      ground_truth[ros::Time(stamp)].push_back(object);
+  }
+  return true;
+}
+
+
+// Scan the hypotheses were computed from, the header stamp of the arrays is not always set
+template<class ArrayMsg>
+static ros::Time input_stamp(const ArrayMsg &msg, const ros::Time &recording_time) {
+  if(!msg.scan.header.stamp.isZero())
+    return msg.scan.header.stamp;
+  if(!msg.header.stamp.isZero())
+    return msg.header.stamp;
+  return recording_time;
+}
+
+
+static bool lookup(const tf2::BufferCore &buffer, const std::string &target_frame, const std::string &source_frame,
+                   const ros::Time &stamp, tf2::Transform &transform) {
+  if(target_frame == source_frame) {
+    transform.setIdentity();
+    return true;
+  }
+  try {
+    const geometry_msgs::TransformStamped t = buffer.lookupTransform(target_frame, source_frame, stamp);
+    transform.setOrigin(tf2::Vector3(t.transform.translation.x, t.transform.translation.y, t.transform.translation.z));
+    transform.setRotation(tf2::Quaternion(t.transform.rotation.x, t.transform.rotation.y,
+                                          t.transform.rotation.z, t.transform.rotation.w));
+    return true;
+  }
+  catch(const tf2::TransformException &) {
+    return false;
+  }
+}
+
+
+static void transform_objects(const tf2::Transform &transform, std::vector<Object> &objects) {
+  for(int i = 0; i < objects.size(); i++) {
+    const tf2::Vector3 p = transform * tf2::Vector3(objects[i].x, objects[i].y, 0.0);
+    objects[i].x = p.x();
+    objects[i].y = p.y();
+  }
+}
+
+
+// Ground truth at stamp, linearly interpolated between the bracketing frames for the ids
+// present in both when they are both within max_time_offset, else the closest frame.
+// Fails if no ground truth frame is within max_time_offset.
+static bool ground_truth_at(const GroundTruth &ground_truth, const ros::Time &stamp, double max_time_offset,
+                            std::vector<Object> &objects) {
+  GroundTruth::const_iterator after = ground_truth.lower_bound(stamp);
+  GroundTruth::const_iterator before = (after == ground_truth.begin()) ? ground_truth.end() : std::prev(after);
+  const double dt_before = (before != ground_truth.end()) ? (stamp - before->first).toSec() : 1e9;
+  const double dt_after = (after != ground_truth.end()) ? (after->first - stamp).toSec() : 1e9;
+  if(std::min(dt_before, dt_after) > max_time_offset)
+    return false;
+
+  GroundTruth::const_iterator closest = (dt_before <= dt_after) ? before : after;
+  objects = closest->second;
+  if(std::max(dt_before, dt_after) > max_time_offset || dt_before + dt_after <= 0.0)
+    return true;
+  const double s = dt_before / (dt_before + dt_after);
+  for(int i = 0; i < objects.size(); i++) {
+    for(int j = 0; j < before->second.size(); j++) {
+      if(before->second[j].id != objects[i].id)
+        continue;
+      for(int k = 0; k < after->second.size(); k++) {
+        if(after->second[k].id != objects[i].id)
+          continue;
+        objects[i].x = (1.0 - s) * before->second[j].x + s * after->second[k].x;
+        objects[i].y = (1.0 - s) * before->second[j].y + s * after->second[k].y;
+      }
+    }
+  }
+  return true;
+}
+
+
+static void remove_out_of_range(const tf2::Vector3 &robot, double max_range, std::vector<Object> &objects) {
+  int n = 0;
+  for(int i = 0; i < objects.size(); i++)
+    if(std::hypot(objects[i].x - robot.x(), objects[i].y - robot.y()) <= max_range)
+      objects[n++] = objects[i];
+  objects.resize(n);
+}
+
+
+static TopicResult evaluate(const Options &options, const tf2::BufferCore &buffer, const GroundTruth &ground_truth,
+                            const std::vector<HypothesisFrame> &frames, bool identities) {
+  TopicResult result;
+  result.num_skipped_frames = 0;
+  clear_mot::Evaluator evaluator(options.threshold, identities);
+  for(int i = 0; i < frames.size(); i++) {
+    const HypothesisFrame &frame = frames[i];
+    std::vector<Object> gt_objects, hyp_objects = frame.objects;
+    tf2::Transform transform, robot_pose;
+    if(!ground_truth_at(ground_truth, frame.stamp, options.max_time_offset, gt_objects) ||
+       !lookup(buffer, options.frame, frame.frame_id, frame.stamp, transform) ||
+       (options.max_range > 0.0 && !lookup(buffer, options.frame, options.base_frame, frame.stamp, robot_pose))) {
+      result.num_skipped_frames++;
+      continue;
+    }
+    transform_objects(transform, hyp_objects);
+    if(options.max_range > 0.0) {
+      remove_out_of_range(robot_pose.getOrigin(), options.max_range, gt_objects);
+      remove_out_of_range(robot_pose.getOrigin(), options.max_range, hyp_objects);
+    }
+    evaluator.add_frame(gt_objects, hyp_objects);
+    result.latencies.push_back(frame.latency);
+  }
+  result.metrics = evaluator.metrics();
+  return result;
+}
+
+
+static bool evaluate_bag(const Options &options, const std::string &bag_file_name, std::vector<TopicResult> &results) {
+  rosbag::Bag bag;
+  try {
+    bag.open(bag_file_name, rosbag::bagmode::Read);
+  }
+  catch(const rosbag::BagException &e) {
+    std::fprintf(stderr, "Cannot open %s: %s\n", bag_file_name.c_str(), e.what());
+    return false;
+  }
+
+  // The whole bag is evaluated after reading it, keep all its transforms
+  rosbag::View full_view(bag);
+  tf2::BufferCore buffer(full_view.getEndTime() - full_view.getBeginTime() + ros::Duration(10.0));
+
+  GroundTruth ground_truth;
+  if(!options.annotations_file.empty() && !load_annotations(options.annotations_file, ground_truth)) {
+    std::fprintf(stderr, "Cannot read %s\n", options.annotations_file.c_str());
+    return false;
+  }
+  std::vector<pedsim_msgs::AgentStates::ConstPtr> agents;
+  std::vector<HypothesisFrame> track_frames, detection_frames;
+
+  std::vector<std::string> topics;
+  topics.push_back("/tf");
+  topics.push_back("/tf_static");
+  if(options.annotations_file.empty())
+    topics.push_back(options.agents_topic);
+  if(!options.tracks_topic.empty())
+    topics.push_back(options.tracks_topic);
+  if(!options.detections_topic.empty())
+    topics.push_back(options.detections_topic);
+  rosbag::View view(bag, rosbag::TopicQuery(topics));
+  BOOST_FOREACH(const rosbag::MessageInstance &m, view) {
+    if(m.getTopic() == "/tf" || m.getTopic() == "/tf_static") {
+      tf2_msgs::TFMessage::ConstPtr tf = m.instantiate<tf2_msgs::TFMessage>();
+      if(tf)
+        for(int i = 0; i < tf->transforms.size(); i++)
+          buffer.setTransform(tf->transforms[i], "rosbag", m.getTopic() == "/tf_static");
+    }
+    else if(m.getTopic() == options.agents_topic) {
+      pedsim_msgs::AgentStates::ConstPtr msg = m.instantiate<pedsim_msgs::AgentStates>();
+      if(msg)
+        agents.push_back(msg);
+    }
+    else if(m.getTopic() == options.tracks_topic) {
+      walker_msgs::Trk3DArray::ConstPtr msg = m.instantiate<walker_msgs::Trk3DArray>();
+      if(!msg)
+        continue;
+      HypothesisFrame frame;
+      frame.stamp = input_stamp(*msg, m.getTime());
+      frame.latency = (m.getTime() - frame.stamp).toSec();
+      frame.frame_id = msg->header.frame_id;
+      for(int i = 0; i < msg->trks_list.size(); i++)
+        frame.objects.push_back(Object{msg->trks_list[i].id, msg->trks_list[i].x, msg->trks_list[i].y});
+      track_frames.push_back(frame);
+    }
+    else if(m.getTopic() == options.detections_topic) {
+      walker_msgs::Det3DArray::ConstPtr msg = m.instantiate<walker_msgs::Det3DArray>();
+      if(!msg)
+        continue;
+      HypothesisFrame frame;
+      frame.stamp = input_stamp(*msg, m.getTime());
+      frame.latency = (m.getTime() - frame.stamp).toSec();
+      frame.frame_id = msg->header.frame_id;
+      for(int i = 0; i < msg->dets_list.size(); i++)
+        frame.objects.push_back(Object{i, msg->dets_list[i].x, msg->dets_list[i].y});
+      detection_frames.push_back(frame);
+    }
+  }
+  bag.close();
+
+  // pedsim ground truth, without the robot agent, once all the transforms are known
+  for(int i = 0; i < agents.size(); i++) {
+    tf2::Transform transform;
+    if(!lookup(buffer, options.frame, agents[i]->header.frame_id, agents[i]->header.stamp, transform))
+      continue;
+    std::vector<Object> &objects = ground_truth[agents[i]->header.stamp];
+    for(int j = 0; j < agents[i]->agent_states.size(); j++) {
+      const pedsim_msgs::AgentState &agent = agents[i]->agent_states[j];
+      if(agent.type != 2)
+        objects.push_back(Object{(long)agent.id, agent.pose.position.x, agent.pose.position.y});
+    }
+    transform_objects(transform, objects);
+  }
+  if(ground_truth.empty()) {
+    std::fprintf(stderr, "No ground truth for %s\n", bag_file_name.c_str());
+    return false;
+  }
+
+  if(!track_frames.empty()) {
+    results.push_back(evaluate(options, buffer, ground_truth, track_frames, true));
+    results.back().topic = options.tracks_topic;
+  }
+  if(!detection_frames.empty()) {
+    results.push_back(evaluate(options, buffer, ground_truth, detection_frames, false));
+    results.back().topic = options.detections_topic;
+  }
+  for(int i = 0; i < results.size(); i++)
+    if(results[i].bag.empty())
+      results[i].bag = bag_file_name;
+  return true;
+}
+
+
+struct LatencySummary {
+  double mean, median, p95, max;
+};
+
+static LatencySummary summarize(std::vector<double> latencies) {
+  LatencySummary s = {0.0, 0.0, 0.0, 0.0};
+  if(latencies.empty())
+    return s;
+  std::sort(latencies.begin(), latencies.end());
+  for(int i = 0; i < latencies.size(); i++)
+    s.mean += latencies[i] / latencies.size();
+  s.median = latencies[latencies.size() / 2];
+  s.p95 = latencies[std::min<int>(latencies.size() - 1, std::ceil(0.95 * latencies.size()) - 1)];
+  s.max = latencies.back();
+  return s;
+}
+
+
+int main(int argc, char **argv) {
+  Options options;
+  if(!parse_options(argc, argv, options)) {
+    std::fprintf(stderr, "Usage: %s [--tracks TOPIC] [--detections TOPIC] [--agents TOPIC] [--annotations FILE] "
+                         "[--frame FRAME] [--threshold METERS] [--max-time-offset SEC] [--base-frame FRAME] "
+                         "[--max-range METERS] [--csv FILE] run.bag [...]\n", argv[0]);
+    return 1;
+  }
+  ros::Time::init();
+
+  std::vector<TopicResult> results;
+  for(int i = 0; i < options.bags.size(); i++)
+    if(!evaluate_bag(options, options.bags[i], results))
+      return 1;
+
+  for(int i = 0; i < results.size(); i++) {
+    const TopicResult &r = results[i];
+    const clear_mot::Metrics &m = r.metrics;
+    const LatencySummary latency = summarize(r.latencies);
+    std::printf("%s %s: %d frames (%d skipped)\n", r.bag.c_str(), r.topic.c_str(), m.num_frames, r.num_skipped_frames);
+    std::printf("  MOTA %.3f  MOTP %.3f m  precision %.3f  recall %.3f\n", m.mota(), m.motp(), m.precision(), m.recall());
+    std::printf("  GT %d  matches %d  FP %d  FN %d", m.num_ground_truth, m.num_matches, m.num_false_positives, m.num_misses);
+    if(m.identities)
+      std::printf("  IDSW %d  FM %d  IDF1 %.3f  IDP %.3f  IDR %.3f  ids %d / %d",
+                  m.num_switches, m.num_fragmentations, m.idf1(), m.idp(), m.idr(),
+                  m.num_hypothesis_ids, m.num_ground_truth_ids);
+    std::printf("\n  latency mean %.1f ms  median %.1f ms  p95 %.1f ms  max %.1f ms\n",
+                latency.mean * 1e3, latency.median * 1e3, latency.p95 * 1e3, latency.max * 1e3);
+  }
+
+  if(!options.csv_file.empty()) {
+    FILE *csv_file = std::fopen(options.csv_file.c_str(), "w");
+    if(!csv_file) {
+      std::fprintf(stderr, "Cannot open %s\n", options.csv_file.c_str());
+      return 1;
+    }
+    std::fprintf(csv_file, "bag,topic,frames,skipped_frames,ground_truth,matches,false_positives,misses,"
+                           "switches,fragmentations,mota,motp,idf1,idp,idr,"
+                           "mean_latency,median_latency,p95_latency,max_latency\n");
+    for(int i = 0; i < results.size(); i++) {
+      const TopicResult &r = results[i];
+      const clear_mot::Metrics &m = r.metrics;
+      const LatencySummary latency = summarize(r.latencies);
+      std::fprintf(csv_file, "%s,%s,%d,%d,%d,%d,%d,%d,%d,%d,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f\n",
+                   r.bag.c_str(), r.topic.c_str(), m.num_frames, r.num_skipped_frames, m.num_ground_truth,
+                   m.num_matches, m.num_false_positives, m.num_misses, m.num_switches, m.num_fragmentations,
+                   m.mota(), m.motp(), m.idf1(), m.idp(), m.idr(),
+                   latency.mean, latency.median, latency.p95, latency.max);
+    }
+    std::fclose(csv_file);
+  }
+  return 0;
+}
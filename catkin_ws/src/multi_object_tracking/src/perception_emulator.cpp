@@ -0,0 +1,233 @@
+#include "perception_emulator.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <set>
+
+namespace perception_emulator {
+
+static const double kInfinity = std::numeric_limits<double>::infinity();
+
+
+static double normalize_angle(double angle) {
+  return std::atan2(std::sin(angle), std::cos(angle));
+}
+
+
+EmulatorParameters::EmulatorParameters() {
+  min_range = 0.1;
+  max_range = 8.0;
+  field_of_view = 1.2;
+  sensor_yaw_offset = M_PI;
+  agent_radius = 0.3;
+  occlusion_rays = 8;
+  min_visible_fraction = 0.3;
+  position_noise = 0.05;
+  velocity_noise = 0.1;
+  miss_rate = 0.05;
+  false_positive_rate = 0.05;
+  false_positive_frames = 4;
+  id_switch_rate = 0.002;
+  id_switch_distance = 1.0;
+  confirm_frames = 3;
+  max_lost_frames = 6;
+}
+
+
+Emulator::Emulator(const EmulatorParameters &parameters, unsigned int seed): parameters_(parameters), seed_(seed) {
+  reset();
+}
+
+
+void Emulator::reset() {
+  rng_.seed(seed_);
+  next_id_ = 1;
+  tracks_.clear();
+  false_positives_.clear();
+}
+
+
+// Distance along the ray to the person at x, y, infinity if the ray misses it
+double Emulator::ray_hit(const SensorPose &sensor, double angle, double x, double y) const {
+  const double cx = x - sensor.x, cy = y - sensor.y;
+  const double b = cx * std::cos(angle) + cy * std::sin(angle);
+  const double discriminant = b * b - (cx * cx + cy * cy - parameters_.agent_radius * parameters_.agent_radius);
+  if(discriminant < 0.0)
+    return kInfinity;
+  const double root = std::sqrt(discriminant);
+  if(b + root < 0.0)
+    return kInfinity;
+  return std::max(0.0, b - root);
+}
+
+
+double Emulator::ray_hit(const SensorPose &sensor, double angle, const Wall &wall) const {
+  const double ux = std::cos(angle), uy = std::sin(angle);
+  const double ex = wall.x1 - wall.x0, ey = wall.y1 - wall.y0;
+  const double wx = wall.x0 - sensor.x, wy = wall.y0 - sensor.y;
+  const double denominator = ux * ey - uy * ex;
+  if(std::fabs(denominator) < 1e-12)
+    return kInfinity;
+  const double t = (wx * ey - wy * ex) / denominator;
+  const double s = (wx * uy - wy * ux) / denominator;
+  if(t < 0.0 || s < 0.0 || s > 1.0)
+    return kInfinity;
+  return t;
+}
+
+
+double Emulator::visible_fraction(const SensorPose &sensor, const std::vector<Agent> &agents, int i) const {
+  const double dx = agents[i].x - sensor.x, dy = agents[i].y - sensor.y;
+  const double distance = std::hypot(dx, dy);
+  if(distance < parameters_.min_range || distance > parameters_.max_range)
+    return 0.0;
+  const double bearing = std::atan2(dy, dx);
+  if(std::fabs(normalize_angle(bearing - sensor.yaw - parameters_.sensor_yaw_offset)) > 0.5 * parameters_.field_of_view)
+    return 0.0;
+  if(distance <= parameters_.agent_radius)
+    return 1.0;
+
+  const double half_width = std::asin(parameters_.agent_radius / distance);
+  int num_visible = 0;
+  for(int k = 0; k < parameters_.occlusion_rays; k++) {
+    const double angle = bearing + half_width * (2.0 * (k + 0.5) / parameters_.occlusion_rays - 1.0);
+    double range = ray_hit(sensor, angle, agents[i].x, agents[i].y);
+    if(range == kInfinity)
+      range = distance;
+    bool blocked = false;
+    for(int j = 0; j < agents.size() && !blocked; j++) {
+      if(j == i || std::hypot(agents[j].x - sensor.x, agents[j].y - sensor.y) - parameters_.agent_radius > range)
+        continue;
+      blocked = ray_hit(sensor, angle, agents[j].x, agents[j].y) < range;
+    }
+    for(int j = 0; j < walls_.size() && !blocked; j++)
+      blocked = ray_hit(sensor, angle, walls_[j]) < range;
+    if(!blocked)
+      num_visible++;
+  }
+  return (double)num_visible / parameters_.occlusion_rays;
+}
+
+
+// A confirmed track swaps ids with the closest detected track, or gets a new id if none is close
+void Emulator::switch_ids(const std::vector<Agent> &agents, const std::vector<int> &detected) {
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  for(int a = 0; a < detected.size(); a++) {
+    const Agent &agent = agents[detected[a]];
+    Track &track = tracks_[agent.id];
+    if(track.hits < parameters_.confirm_frames || uniform(rng_) >= parameters_.id_switch_rate)
+      continue;
+    Track *closest = NULL;
+    double closest_distance = parameters_.id_switch_distance;
+    for(int b = 0; b < detected.size(); b++) {
+      const Agent &other = agents[detected[b]];
+      const double distance = std::hypot(other.x - agent.x, other.y - agent.y);
+      if(b != a && distance < closest_distance) {
+        closest = &tracks_[other.id];
+        closest_distance = distance;
+      }
+    }
+    if(closest != NULL)
+      std::swap(track.id, closest->id);
+    else
+      track.id = next_id_++;
+  }
+}
+
+
+void Emulator::step(const SensorPose &sensor, const std::vector<Agent> &agents,
+                    std::vector<Observation> &detections, std::vector<Observation> &tracks) {
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  std::normal_distribution<double> normal(0.0, 1.0);
+  detections.clear();
+  tracks.clear();
+
+  // Visible and detected people
+  std::vector<int> detected;
+  std::vector<double> fractions;
+  std::set<long> detected_ids;
+  for(int i = 0; i < agents.size(); i++) {
+    const double fraction = visible_fraction(sensor, agents, i);
+    if(fraction <= 0.0 || fraction < parameters_.min_visible_fraction || uniform(rng_) < parameters_.miss_rate)
+      continue;
+    detected.push_back(i);
+    fractions.push_back(fraction);
+    detected_ids.insert(agents[i].id);
+  }
+
+  // Tracker bookkeeping, a person missed for too long comes back with a new id
+  for(std::map<long, Track>::iterator it = tracks_.begin(); it != tracks_.end();) {
+    if(detected_ids.count(it->first) == 0 && ++it->second.lost_frames > parameters_.max_lost_frames)
+      tracks_.erase(it++);
+    else
+      ++it;
+  }
+  for(int a = 0; a < detected.size(); a++) {
+    std::map<long, Track>::iterator it = tracks_.find(agents[detected[a]].id);
+    if(it == tracks_.end()) {
+      Track track = {next_id_++, 0, 0};
+      it = tracks_.insert(std::make_pair(agents[detected[a]].id, track)).first;
+    }
+    it->second.hits++;
+    it->second.lost_frames = 0;
+  }
+  switch_ids(agents, detected);
+
+  for(int a = 0; a < detected.size(); a++) {
+    const Agent &agent = agents[detected[a]];
+    Observation observation;
+    observation.id = 0;
+    observation.agent_id = agent.id;
+    observation.x = agent.x + parameters_.position_noise * normal(rng_);
+    observation.y = agent.y + parameters_.position_noise * normal(rng_);
+    observation.vx = observation.vy = 0.0;
+    observation.confidence = fractions[a];
+    detections.push_back(observation);
+
+    const Track &track = tracks_[agent.id];
+    if(track.hits < parameters_.confirm_frames)
+      continue;
+    observation.id = track.id;
+    observation.vx = agent.vx + parameters_.velocity_noise * normal(rng_);
+    observation.vy = agent.vy + parameters_.velocity_noise * normal(rng_);
+    tracks.push_back(observation);
+  }
+
+  // False positives, somewhere in the field of view, detected again for a few frames
+  if(parameters_.false_positive_rate > 0.0) {
+    std::poisson_distribution<int> poisson(parameters_.false_positive_rate);
+    const int num_new = poisson(rng_);
+    for(int k = 0; k < num_new; k++) {
+      const double angle = sensor.yaw + parameters_.sensor_yaw_offset +
+                           parameters_.field_of_view * (uniform(rng_) - 0.5);
+      const double range = parameters_.min_range + (parameters_.max_range - parameters_.min_range) * uniform(rng_);
+      FalsePositive false_positive = {next_id_++, sensor.x + range * std::cos(angle), sensor.y + range * std::sin(angle),
+                                      0, parameters_.false_positive_frames};
+      false_positives_.push_back(false_positive);
+    }
+  }
+  int n = 0;
+  for(int k = 0; k < false_positives_.size(); k++) {
+    FalsePositive &false_positive = false_positives_[k];
+    Observation observation;
+    observation.id = 0;
+    observation.agent_id = -1;
+    observation.x = false_positive.x + parameters_.position_noise * normal(rng_);
+    observation.y = false_positive.y + parameters_.position_noise * normal(rng_);
+    observation.vx = observation.vy = 0.0;
+    observation.confidence = 0.5 + 0.5 * uniform(rng_);
+    detections.push_back(observation);
+    if(++false_positive.hits >= parameters_.confirm_frames) {
+      observation.id = false_positive.id;
+      observation.vx = parameters_.velocity_noise * normal(rng_);
+      observation.vy = parameters_.velocity_noise * normal(rng_);
+      tracks.push_back(observation);
+    }
+    if(--false_positive.frames_left > 0)
+      false_positives_[n++] = false_positive;
+  }
+  false_positives_.resize(n);
+}
+
+}
@@ -0,0 +1,113 @@
+#ifndef MULTI_OBJECT_TRACKING_PERCEPTION_EMULATOR_HPP
+#define MULTI_OBJECT_TRACKING_PERCEPTION_EMULATOR_HPP
+
+#include <map>
+#include <random>
+#include <vector>
+
+namespace perception_emulator {
+
+// Everything is in the world frame of the simulator, velocities in m/s
+struct Agent {
+  long id;
+  double x, y, vx, vy;
+};
+
+struct Wall {
+  double x0, y0, x1, y1;
+};
+
+// Pose of the sensor frame, the field of view is centered on its x axis turned by
+// EmulatorParameters::sensor_yaw_offset
+struct SensorPose {
+  double x, y, yaw;
+};
+
+struct Observation {
+  long id;                    // track id, 0 for the detections
+  long agent_id;              // -1 for a false positive
+  double x, y, vx, vy;
+  double confidence;
+};
+
+
+// Per frame rates, the emulator runs once per published frame
+struct EmulatorParameters {
+  EmulatorParameters();
+
+  double min_range, max_range;  // of the lidar
+  double field_of_view;         // of the camera, rad
+  double sensor_yaw_offset;     // heading of the camera in the sensor frame, pi on the walker: the
+                                //   cameras face -x of laser_link
+  double agent_radius;          // of the people, for the occlusions and in the messages
+  int occlusion_rays;           // cast over the width of a person
+  double min_visible_fraction;  // of the rays, below that the person is occluded
+
+  double position_noise;        // std, m
+  double velocity_noise;        // std of the track velocities, m/s
+  double miss_rate;             // probability to miss a visible person
+  double false_positive_rate;   // mean number of false positives per frame
+  int false_positive_frames;    // a false positive is detected again for that many frames
+  double id_switch_rate;        // probability for a track to switch id
+  double id_switch_distance;    // a switching track swaps ids with a track that close, which switches
+                                //   too, else it gets a new id
+
+  // Tracker behaviour, as min_hits and max_age of AB3DMOT
+  int confirm_frames;           // a track is published after that many detections
+  int max_lost_frames;          // a track missed for longer is dropped, the person gets a new id
+};
+
+
+// Turns the exact agent states of the simulator into the detections and tracks of the walker
+// perception stack, with the field of view, the occlusions by other people and by walls, the
+// position noise, the missed detections, the false positives and the id switches. The random
+// draws come from the seed only, the same inputs give the same outputs.
+class Emulator {
+public:
+  explicit Emulator(const EmulatorParameters &parameters = EmulatorParameters(), unsigned int seed = 0);
+
+  void set_walls(const std::vector<Wall> &walls) { walls_ = walls; }
+
+  // Fraction of the rays of the sensor over the width of agents[i] that reach it, 0 outside
+  // the range or the field of view
+  double visible_fraction(const SensorPose &sensor, const std::vector<Agent> &agents, int i) const;
+
+  // One frame: the detections of the visible people and the false positives, and the
+  // confirmed tracks of the detected ones
+  void step(const SensorPose &sensor, const std::vector<Agent> &agents,
+            std::vector<Observation> &detections, std::vector<Observation> &tracks);
+
+  void reset();
+
+  const EmulatorParameters &parameters() const { return parameters_; }
+
+private:
+  struct Track {
+    long id;
+    int hits;
+    int lost_frames;
+  };
+
+  struct FalsePositive {
+    long id;
+    double x, y;
+    int hits;
+    int frames_left;
+  };
+
+  double ray_hit(const SensorPose &sensor, double angle, double x, double y) const;
+  double ray_hit(const SensorPose &sensor, double angle, const Wall &wall) const;
+  void switch_ids(const std::vector<Agent> &agents, const std::vector<int> &detected);
+
+  EmulatorParameters parameters_;
+  std::vector<Wall> walls_;
+  std::mt19937 rng_;
+  const unsigned int seed_;
+  long next_id_;
+  std::map<long, Track> tracks_;   // by agent id
+  std::vector<FalsePositive> false_positives_;
+};
+
+}
+
+#endif
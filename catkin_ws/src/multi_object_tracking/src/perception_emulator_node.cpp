@@ -0,0 +1,200 @@
+// Ground-truth perception emulator, publishes the det3d_result and trk3d_result of the walker
+// perception stack from the pedsim agent states, instead of yolov4_node, scan_image_combine_node
+// and mot2d_node, so that the planners can be tested headless with a controlled degradation.
+//   simulated_agents  pedsim_msgs/AgentStates   (remap to /pedsim_simulator/simulated_agents)
+//   simulated_walls   pedsim_msgs/LineObstacles occluders, in the frame of the agents
+//   scan              sensor_msgs/LaserScan     passed on in the outputs, the localmap is built from it
+// The detections are in the sensor frame, the tracks in the frame of the agents (odom), as the
+// real nodes publish them. The field of view is centered on sensor_yaw_offset in the sensor frame,
+// pi for laser_link of the walker, whose cameras face its -x axis.
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include <ros/ros.h>
+#include <message_filters/subscriber.h>
+#include <pedsim_msgs/AgentStates.h>
+#include <pedsim_msgs/LineObstacles.h>
+#include <sensor_msgs/LaserScan.h>
+#include <tf/transform_listener.h>
+#include <tf2_ros/message_filter.h>
+#include <walker_msgs/Det3DArray.h>
+#include <walker_msgs/Trk3DArray.h>
+
+#include "perception_emulator.hpp"
+
+using perception_emulator::Observation;
+
+static const int kPersonClassId = 0;
+
+
+class PerceptionEmulatorNode {
+public:
+  PerceptionEmulatorNode(ros::NodeHandle nh, ros::NodeHandle pnh);
+
+private:
+  void agents_cb(const pedsim_msgs::AgentStates::ConstPtr &msg_ptr);
+  void walls_cb(const pedsim_msgs::LineObstacles::ConstPtr &msg_ptr);
+  void scan_cb(const sensor_msgs::LaserScan::ConstPtr &msg_ptr);
+
+  ros::NodeHandle nh_, pnh_;
+  ros::Subscriber sub_walls_, sub_scan_;
+  ros::Publisher pub_det3d_, pub_trk3d_;
+  tf::TransformListener tflistener_;
+
+  // The agents are released by the TF message filter once the sensor pose is known at their stamp
+  message_filters::Subscriber<pedsim_msgs::AgentStates> sub_agents_;
+  boost::shared_ptr<tf2_ros::MessageFilter<pedsim_msgs::AgentStates> > agents_filter_ptr_;
+
+  std::string sensor_frameid_;
+  double period_;
+  ros::Time last_stamp_;
+  sensor_msgs::LaserScan::ConstPtr scan_ptr_;
+  boost::shared_ptr<perception_emulator::Emulator> emulator_ptr_;
+};
+
+
+PerceptionEmulatorNode::PerceptionEmulatorNode(ros::NodeHandle nh, ros::NodeHandle pnh): nh_(nh), pnh_(pnh) {
+  // ROS parameters, the rates are per published frame
+  perception_emulator::EmulatorParameters p;
+  double rate;
+  int seed;
+  pnh_.param<std::string>("sensor_frameid", sensor_frameid_, "laser_link");
+  pnh_.param<double>("rate", rate, 8.0);
+  pnh_.param<int>("seed", seed, 0);
+  pnh_.param<double>("min_range", p.min_range, p.min_range);
+  pnh_.param<double>("max_range", p.max_range, p.max_range);
+  pnh_.param<double>("field_of_view", p.field_of_view, p.field_of_view);
+  pnh_.param<double>("sensor_yaw_offset", p.sensor_yaw_offset, p.sensor_yaw_offset);
+  pnh_.param<double>("agent_radius", p.agent_radius, p.agent_radius);
+  pnh_.param<int>("occlusion_rays", p.occlusion_rays, p.occlusion_rays);
+  pnh_.param<double>("min_visible_fraction", p.min_visible_fraction, p.min_visible_fraction);
+  pnh_.param<double>("position_noise", p.position_noise, p.position_noise);
+  pnh_.param<double>("velocity_noise", p.velocity_noise, p.velocity_noise);
+  pnh_.param<double>("miss_rate", p.miss_rate, p.miss_rate);
+  pnh_.param<double>("false_positive_rate", p.false_positive_rate, p.false_positive_rate);
+  pnh_.param<int>("false_positive_frames", p.false_positive_frames, p.false_positive_frames);
+  pnh_.param<double>("id_switch_rate", p.id_switch_rate, p.id_switch_rate);
+  pnh_.param<double>("id_switch_distance", p.id_switch_distance, p.id_switch_distance);
+  pnh_.param<int>("confirm_frames", p.confirm_frames, p.confirm_frames);
+  pnh_.param<int>("max_lost_frames", p.max_lost_frames, p.max_lost_frames);
+  period_ = rate > 0.0 ? 1.0 / rate : 0.0;
+  emulator_ptr_.reset(new perception_emulator::Emulator(p, seed));
+
+  // ROS publishers & subscribers
+  pub_det3d_ = nh_.advertise<walker_msgs::Det3DArray>("det3d_result", 1);
+  pub_trk3d_ = nh_.advertise<walker_msgs::Trk3DArray>("trk3d_result", 1);
+  sub_walls_ = nh_.subscribe("simulated_walls", 1, &PerceptionEmulatorNode::walls_cb, this);
+  sub_scan_ = nh_.subscribe("scan", 1, &PerceptionEmulatorNode::scan_cb, this);
+  sub_agents_.subscribe(nh_, "simulated_agents", 1);
+  agents_filter_ptr_.reset(new tf2_ros::MessageFilter<pedsim_msgs::AgentStates>(
+    sub_agents_, *tflistener_.getTF2BufferPtr(), sensor_frameid_, 5, nh_));
+  agents_filter_ptr_->registerCallback(&PerceptionEmulatorNode::agents_cb, this);
+
+  ROS_INFO("Emulating %s: range %.1f m, fov %.2f rad at %.2f rad, noise %.2f m, miss %.2f, false positives %.2f, id switches %.3f per frame",
+           sensor_frameid_.c_str(), p.max_range, p.field_of_view, p.sensor_yaw_offset, p.position_noise, p.miss_rate,
+           p.false_positive_rate, p.id_switch_rate);
+  ROS_INFO_STREAM(ros::this_node::getName() + " is ready.");
+}
+
+
+void PerceptionEmulatorNode::walls_cb(const pedsim_msgs::LineObstacles::ConstPtr &msg_ptr) {
+  std::vector<perception_emulator::Wall> walls;
+  for(int i = 0; i < msg_ptr->obstacles.size(); i++) {
+    const pedsim_msgs::LineObstacle &obstacle = msg_ptr->obstacles[i];
+    perception_emulator::Wall wall = {obstacle.start.x, obstacle.start.y, obstacle.end.x, obstacle.end.y};
+    walls.push_back(wall);
+  }
+  emulator_ptr_->set_walls(walls);
+}
+
+
+void PerceptionEmulatorNode::scan_cb(const sensor_msgs::LaserScan::ConstPtr &msg_ptr) {
+  scan_ptr_ = msg_ptr;
+}
+
+
+void PerceptionEmulatorNode::agents_cb(const pedsim_msgs::AgentStates::ConstPtr &msg_ptr) {
+  // pedsim publishes faster than the perception stack runs
+  if(!last_stamp_.isZero() && msg_ptr->header.stamp >= last_stamp_ &&
+     (msg_ptr->header.stamp - last_stamp_).toSec() < period_)
+    return;
+  last_stamp_ = msg_ptr->header.stamp;
+
+  tf::StampedTransform tf_sensor2world;
+  try{
+    tflistener_.lookupTransform(msg_ptr->header.frame_id, sensor_frameid_, msg_ptr->header.stamp, tf_sensor2world);
+  }
+  catch (tf::TransformException ex){
+    ROS_WARN("Cannot get TF from %s to %s: %s. Skip these agents.",
+             sensor_frameid_.c_str(), msg_ptr->header.frame_id.c_str(), ex.what());
+    return;
+  }
+  const perception_emulator::SensorPose sensor = {tf_sensor2world.getOrigin().x(), tf_sensor2world.getOrigin().y(),
+                                                  tf::getYaw(tf_sensor2world.getRotation())};
+
+  std::vector<perception_emulator::Agent> agents;
+  for(int i = 0; i < msg_ptr->agent_states.size(); i++) {
+    const pedsim_msgs::AgentState &state = msg_ptr->agent_states[i];
+    perception_emulator::Agent agent = {(long)state.id, state.pose.position.x, state.pose.position.y,
+                                        state.twist.linear.x, state.twist.linear.y};
+    agents.push_back(agent);
+  }
+  std::vector<Observation> detections, tracks;
+  emulator_ptr_->step(sensor, agents, detections, tracks);
+  const double radius = emulator_ptr_->parameters().agent_radius;
+
+  if(pub_det3d_.getNumSubscribers() > 0) {
+    const tf::Transform tf_world2sensor = tf_sensor2world.inverse();
+    walker_msgs::Det3DArray det3d_array;
+    det3d_array.header.frame_id = sensor_frameid_;
+    det3d_array.header.stamp = msg_ptr->header.stamp;
+    for(int i = 0; i < detections.size(); i++) {
+      const tf::Vector3 pt_sensor = tf_world2sensor * tf::Vector3(detections[i].x, detections[i].y, 0.0);
+      walker_msgs::Det3D det_msg;
+      det_msg.x = pt_sensor.x();
+      det_msg.y = pt_sensor.y();
+      det_msg.z = 0;
+      det_msg.yaw = 0;
+      det_msg.radius = radius;
+      det_msg.w = det_msg.l = 2 * radius;
+      det_msg.confidence = detections[i].confidence;
+      det_msg.class_name = "person";
+      det_msg.class_id = kPersonClassId;
+      det3d_array.dets_list.push_back(det_msg);
+    }
+    if(scan_ptr_)
+      det3d_array.scan = *scan_ptr_;
+    pub_det3d_.publish(det3d_array);
+  }
+
+  if(pub_trk3d_.getNumSubscribers() > 0) {
+    walker_msgs::Trk3DArray trk3d_array;
+    trk3d_array.header = msg_ptr->header;
+    for(int i = 0; i < tracks.size(); i++) {
+      walker_msgs::Trk3D trk3d_msg;
+      trk3d_msg.x = tracks[i].x;
+      trk3d_msg.y = tracks[i].y;
+      trk3d_msg.vx = tracks[i].vx;
+      trk3d_msg.vy = tracks[i].vy;
+      trk3d_msg.yaw = std::atan2(tracks[i].vy, tracks[i].vx);
+      trk3d_msg.radius = radius;
+      trk3d_msg.confidence = tracks[i].confidence;
+      trk3d_msg.class_id = kPersonClassId;
+      trk3d_msg.id = tracks[i].id;
+      trk3d_array.trks_list.push_back(trk3d_msg);
+    }
+    if(scan_ptr_)
+      trk3d_array.scan = *scan_ptr_;
+    pub_trk3d_.publish(trk3d_array);
+  }
+}
+
+
+int main(int argc, char **argv) {
+  ros::init(argc, argv, "perception_emulator_node");
+  ros::NodeHandle nh, pnh("~");
+  PerceptionEmulatorNode node(nh, pnh);
+  ros::spin();
+  return 0;
+}
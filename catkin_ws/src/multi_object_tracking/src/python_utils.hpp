@@ -0,0 +1,19 @@
+#ifndef MULTI_OBJECT_TRACKING_PYTHON_UTILS_HPP
+#define MULTI_OBJECT_TRACKING_PYTHON_UTILS_HPP
+
+#include <boost/python.hpp>
+
+// Conversions shared by the python modules box_iou_cpp, imm_filter_cpp and reid_cpp
+namespace python_utils {
+
+// Any python number, numpy scalars such as float32 have no registered converter to double
+inline double to_double(const boost::python::object &value) {
+  const double d = PyFloat_AsDouble(value.ptr());
+  if(d == -1.0 && PyErr_Occurred())
+    boost::python::throw_error_already_set();
+  return d;
+}
+
+}
+
+#endif
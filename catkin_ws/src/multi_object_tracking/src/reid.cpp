@@ -0,0 +1,157 @@
+#include "reid.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace reid {
+
+// Pixels with less saturation or value go to the gray bins, their hue is noise
+static const double kMinSaturation = 0.2;
+static const double kMinValue = 0.2;
+static const int kMaxSamples = 4096;
+
+
+bool compute_descriptor(const unsigned char *rgb, int width, int height, int step, const Box &box,
+                        Descriptor &descriptor) {
+  const int x0 = std::max(0, (int)std::floor(box.x + 0.2 * box.width));
+  const int x1 = std::min(width, (int)std::ceil(box.x + 0.8 * box.width));
+  const int y0 = std::max(0, (int)std::floor(box.y + 0.15 * box.height));
+  const int y1 = std::min(height, (int)std::ceil(box.y + box.height));
+  if(x1 - x0 < 2 || y1 - y0 < 2)
+    return false;
+  const int stride = std::max(1, (int)std::sqrt((double)(x1 - x0) * (y1 - y0) / kMaxSamples));
+
+  double histogram[kHistogramSize] = {0.0};
+  double sum[kNumStripes][3] = {{0.0}}, sum_squares[kNumStripes][3] = {{0.0}};
+  int count[kNumStripes] = {0}, num_samples = 0;
+  for(int v = y0; v < y1; v += stride) {
+    const int stripe = (v - y0) * kNumStripes / (y1 - y0);
+    const unsigned char *row = rgb + (long)v * step;
+    for(int u = x0; u < x1; u += stride) {
+      const int r = row[3 * u], g = row[3 * u + 1], b = row[3 * u + 2];
+      const int max = std::max(r, std::max(g, b)), min = std::min(r, std::min(g, b));
+      const double value = max / 255.0, saturation = (max > 0) ? (double)(max - min) / max : 0.0;
+      if(saturation < kMinSaturation || value < kMinValue) {
+        histogram[kHueBins * kSaturationBins + std::min(kGrayBins - 1, (int)(value * kGrayBins))] += 1.0;
+      }
+      else {
+        const double delta = max - min;
+        double hue;           // [0, 6)
+        if(max == r)
+          hue = (g - b) / delta + (g < b ? 6.0 : 0.0);
+        else if(max == g)
+          hue = (b - r) / delta + 2.0;
+        else
+          hue = (r - g) / delta + 4.0;
+        // Bins centered on red, green, blue... so that red does not straddle hue 0
+        const int h = (int)(hue / 6.0 * kHueBins + 0.5) % kHueBins;
+        const int s = std::min(kSaturationBins - 1, (int)((saturation - kMinSaturation) / (1.0 - kMinSaturation) * kSaturationBins));
+        histogram[h * kSaturationBins + s] += 1.0;
+      }
+      sum[stripe][0] += r;
+      sum[stripe][1] += g;
+      sum[stripe][2] += b;
+      sum_squares[stripe][0] += r * r;
+      sum_squares[stripe][1] += g * g;
+      sum_squares[stripe][2] += b * b;
+      count[stripe]++;
+      num_samples++;
+    }
+  }
+
+  for(int i = 0; i < kHistogramSize; i++)
+    descriptor[i] = histogram[i] / num_samples;
+  float *moments = &descriptor[kHistogramSize];
+  for(int i = 0; i < kNumStripes; i++) {
+    for(int c = 0; c < 3; c++) {
+      const double mean = count[i] ? sum[i][c] / count[i] : 0.0;
+      const double variance = count[i] ? sum_squares[i][c] / count[i] - mean * mean : 0.0;
+      moments[6 * i + c] = mean / 255.0;
+      moments[6 * i + 3 + c] = std::sqrt(std::max(0.0, variance)) / 255.0;
+    }
+  }
+  return true;
+}
+
+
+double descriptor_distance(const Descriptor &a, const Descriptor &b) {
+  double bhattacharyya = 0.0;
+  for(int i = 0; i < kHistogramSize; i++)
+    bhattacharyya += std::sqrt((double)a[i] * b[i]);
+  const double hellinger = std::sqrt(std::max(0.0, 1.0 - bhattacharyya));
+
+  // A mean difference of 0.25 (64 gray levels) is as different as it gets
+  double difference = 0.0;
+  for(int i = kHistogramSize; i < kDescriptorSize; i++)
+    difference += std::fabs(a[i] - b[i]);
+  const double moments = std::min(1.0, 4.0 * difference / kMomentsSize);
+
+  return 0.5 * (hellinger + moments);
+}
+
+
+GalleryParameters::GalleryParameters() {
+  max_lost_frames = 30;
+  gate_radius = 0.5;
+  gate_growth = 0.1;
+  max_velocity_frames = 10;
+  max_appearance_distance = 0.3;
+  appearance_weight = 0.5;
+}
+
+
+Gallery::Gallery(const GalleryParameters &parameters): parameters_(parameters) {}
+
+
+void Gallery::add(long id, double x, double y, double vx, double vy, const Descriptor &descriptor) {
+  Entry entry = {id, x, y, vx, vy, 0, descriptor};
+  for(int i = 0; i < entries_.size(); i++) {
+    if(entries_[i].id == id) {
+      entries_[i] = entry;
+      return;
+    }
+  }
+  entries_.push_back(entry);
+}
+
+
+void Gallery::step() {
+  int n = 0;
+  for(int i = 0; i < entries_.size(); i++) {
+    entries_[i].lost_frames++;
+    if(entries_[i].lost_frames <= parameters_.max_lost_frames)
+      entries_[n++] = entries_[i];
+  }
+  entries_.resize(n);
+}
+
+
+long Gallery::match(double x, double y, const Descriptor &descriptor) {
+  int best = -1;
+  double best_cost = 0.0;
+  for(int i = 0; i < entries_.size(); i++) {
+    const Entry &e = entries_[i];
+    const double t = std::min<double>(e.lost_frames, parameters_.max_velocity_frames);
+    const double gate = parameters_.gate_radius + parameters_.gate_growth * e.lost_frames;
+    const double distance = std::hypot(x - (e.x + t * e.vx), y - (e.y + t * e.vy));
+    if(distance > gate)
+      continue;
+    const double appearance = descriptor_distance(e.descriptor, descriptor);
+    if(appearance > parameters_.max_appearance_distance)
+      continue;
+    const double cost = parameters_.appearance_weight * appearance / parameters_.max_appearance_distance +
+                        (1.0 - parameters_.appearance_weight) * distance / gate;
+    if(best < 0 || cost < best_cost) {
+      best = i;
+      best_cost = cost;
+    }
+  }
+  if(best < 0)
+    return -1;
+  const long id = entries_[best].id;
+  entries_[best] = entries_.back();
+  entries_.pop_back();
+  return id;
+}
+
+}
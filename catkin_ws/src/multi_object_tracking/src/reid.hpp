@@ -0,0 +1,85 @@
+#ifndef MULTI_OBJECT_TRACKING_REID_HPP
+#define MULTI_OBJECT_TRACKING_REID_HPP
+
+#include <array>
+#include <vector>
+
+namespace reid {
+
+// Appearance descriptor of a person crop:
+//   [0, 36)   HSV histogram, 8 hue x 4 saturation bins for the colours and 4 value bins for the
+//             grays (low saturation or dark pixels), sums to 1
+//   [36, 72)  colour moments of 6 horizontal stripes, mean and std of R, G, B in [0, 1]
+const int kHueBins = 8;
+const int kSaturationBins = 4;
+const int kGrayBins = 4;
+const int kHistogramSize = kHueBins * kSaturationBins + kGrayBins;
+const int kNumStripes = 6;
+const int kMomentsSize = kNumStripes * 3 * 2;
+const int kDescriptorSize = kHistogramSize + kMomentsSize;
+typedef std::array<float, kDescriptorSize> Descriptor;
+
+// Box in pixels, top-left corner and size
+struct Box {
+  double x, y, width, height;
+};
+
+// Descriptor of the box in the interleaved 8-bit RGB image (row stride step in bytes). Only the
+// central part of the box is used, to leave out the background on the sides and above the head,
+// and large crops are subsampled to about 4096 pixels. False if the box is outside the image.
+bool compute_descriptor(const unsigned char *rgb, int width, int height, int step, const Box &box,
+                        Descriptor &descriptor);
+
+// 0 for the same appearance, 1 for nothing in common: mean of the Hellinger distance of the
+// histograms and of the scaled mean absolute difference of the stripe moments
+double descriptor_distance(const Descriptor &a, const Descriptor &b);
+
+
+// Per frame gallery parameters, the AB3DMOT tracker runs with dt = 1 frame
+struct GalleryParameters {
+  GalleryParameters();
+
+  int max_lost_frames;          // forgotten after that
+  double gate_radius;           // motion gate around the extrapolated position, grows with
+  double gate_growth;           //   gate_radius + gate_growth * frames lost
+  int max_velocity_frames;      // the lost velocity is extrapolated for at most that many frames
+  double max_appearance_distance;
+  double appearance_weight;     // of the appearance in the matching cost, the rest is the motion
+};
+
+
+// Short-term memory of the lost tracks, to give a new track the id of the person it belongs
+// to after an occlusion. A new track matches the lost track whose extrapolated position gates
+// it, with the lowest combined motion and appearance cost.
+class Gallery {
+public:
+  explicit Gallery(const GalleryParameters &parameters = GalleryParameters());
+
+  // Lost track id, at its last position and velocity per frame; an existing id is replaced
+  void add(long id, double x, double y, double vx, double vy, const Descriptor &descriptor);
+  int size() const { return entries_.size(); }
+  void clear() { entries_.clear(); }
+
+  // Ages the entries by one frame and forgets the old ones
+  void step();
+
+  // Id of the lost track matching a new track at x, y, which leaves the gallery, -1 if none
+  long match(double x, double y, const Descriptor &descriptor);
+
+  const GalleryParameters &parameters() const { return parameters_; }
+
+private:
+  struct Entry {
+    long id;
+    double x, y, vx, vy;
+    int lost_frames;
+    Descriptor descriptor;
+  };
+
+  GalleryParameters parameters_;
+  std::vector<Entry> entries_;
+};
+
+}
+
+#endif
@@ -0,0 +1,60 @@
+// Python module reid_cpp, re-identification of the tracks of AB3DMOT_libs after an occlusion:
+//   import reid_cpp
+//   gallery = reid_cpp.Gallery()
+//   gallery.step()                                          # once per frame
+//   gallery.add(track_id, x, y, vx, vy, descriptor)         # lost track, velocity per frame
+//   track_id = gallery.match(x, y, descriptor)              # new track, -1 if nobody matches
+//   d = reid_cpp.descriptor_distance(descriptor1, descriptor2)
+// The descriptors are the Det3D.appearance of the detections, reid_cpp.DESCRIPTOR_SIZE numbers.
+#include <boost/python.hpp>
+
+#include "reid.hpp"
+#include "python_utils.hpp"
+
+namespace bp = boost::python;
+using python_utils::to_double;
+
+
+// Any python sequence of DESCRIPTOR_SIZE numbers (list, tuple, numpy array)
+static reid::Descriptor to_descriptor(const bp::object &seq) {
+  if(bp::len(seq) != reid::kDescriptorSize) {
+    PyErr_SetString(PyExc_ValueError, "reid_cpp: descriptor of DESCRIPTOR_SIZE numbers expected");
+    bp::throw_error_already_set();
+  }
+  reid::Descriptor descriptor;
+  for(int i = 0; i < reid::kDescriptorSize; i++)
+    descriptor[i] = to_double(seq[i]);
+  return descriptor;
+}
+
+
+static double descriptor_distance(const bp::object &a, const bp::object &b) {
+  return reid::descriptor_distance(to_descriptor(a), to_descriptor(b));
+}
+
+
+static void gallery_add(reid::Gallery &gallery, long id, const bp::object &x, const bp::object &y,
+                        const bp::object &vx, const bp::object &vy, const bp::object &descriptor) {
+  gallery.add(id, to_double(x), to_double(y), to_double(vx), to_double(vy), to_descriptor(descriptor));
+}
+
+
+static long gallery_match(reid::Gallery &gallery, const bp::object &x, const bp::object &y,
+                          const bp::object &descriptor) {
+  return gallery.match(to_double(x), to_double(y), to_descriptor(descriptor));
+}
+
+
+BOOST_PYTHON_MODULE(reid_cpp)
+{
+  bp::scope().attr("DESCRIPTOR_SIZE") = reid::kDescriptorSize;
+
+  bp::def("descriptor_distance", &descriptor_distance, (bp::arg("descriptor1"), bp::arg("descriptor2")));
+
+  bp::class_<reid::Gallery, boost::noncopyable>("Gallery")
+    .def("add", &gallery_add, (bp::arg("id"), bp::arg("x"), bp::arg("y"), bp::arg("vx"), bp::arg("vy"), bp::arg("descriptor")))
+    .def("step", &reid::Gallery::step)
+    .def("match", &gallery_match, (bp::arg("x"), bp::arg("y"), bp::arg("descriptor")))
+    .def("clear", &reid::Gallery::clear)
+    .def("__len__", &reid::Gallery::size);
+}
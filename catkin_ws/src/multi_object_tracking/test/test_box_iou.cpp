@@ -0,0 +1,214 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "box_iou.hpp"
+
+#ifndef IOU_TEST_DATA_DIR
+#define IOU_TEST_DATA_DIR "test/data"
+#endif
+
+
+// Box pairs and circle pairs with the IoU of the python AB3DMOT_libs implementation
+struct Reference {
+  std::vector<box_iou::Box> box1, box2;
+  std::vector<double> box_iou;
+  std::vector<box_iou::Circle> circle1, circle2;
+  std::vector<double> circle_iou;
+};
+
+
+static Reference load_reference(const std::string &file_name) {
+  Reference reference;
+  std::ifstream file(file_name.c_str());
+  std::string line;
+  while(std::getline(file, line)) {
+    std::istringstream fields(line);
+    std::string tag;
+    fields >> tag;
+    if(tag == "box") {
+      box_iou::Box a, b;
+      double iou;
+      if(fields >> a.x >> a.y >> a.l >> a.w >> a.yaw >> b.x >> b.y >> b.l >> b.w >> b.yaw >> iou) {
+        reference.box1.push_back(a);
+        reference.box2.push_back(b);
+        reference.box_iou.push_back(iou);
+      }
+    }
+    else if(tag == "circle") {
+      box_iou::Circle a, b;
+      double iou;
+      if(fields >> a.x >> a.y >> a.r >> b.x >> b.y >> b.r >> iou) {
+        reference.circle1.push_back(a);
+        reference.circle2.push_back(b);
+        reference.circle_iou.push_back(iou);
+      }
+    }
+  }
+  return reference;
+}
+
+
+static double uniform(double low, double high) {
+  return low + (high - low) * (rand() / (double)RAND_MAX);
+}
+
+
+// People sized boxes in a crowd of the given radius
+static std::vector<box_iou::Box> random_boxes(int num_boxes, double radius) {
+  std::vector<box_iou::Box> boxes(num_boxes);
+  for(int i = 0; i < num_boxes; i++)
+    boxes[i] = {uniform(-radius, radius), uniform(-radius, radius), uniform(0.3, 0.9), uniform(0.3, 0.6), uniform(-M_PI, M_PI)};
+  return boxes;
+}
+
+
+TEST(BoxIou, matchesPythonImplementation)
+{
+  Reference reference = load_reference(std::string(IOU_TEST_DATA_DIR) + "/iou_reference.txt");
+  ASSERT_FALSE(reference.box_iou.empty());
+  ASSERT_FALSE(reference.circle_iou.empty());
+  for(int i = 0; i < reference.box_iou.size(); i++) {
+    EXPECT_NEAR(box_iou::iou(reference.box1[i], reference.box2[i]), reference.box_iou[i], 1e-9) << "box pair " << i;
+    // Symmetric
+    EXPECT_NEAR(box_iou::iou(reference.box2[i], reference.box1[i]), reference.box_iou[i], 1e-9) << "box pair " << i;
+  }
+  for(int i = 0; i < reference.circle_iou.size(); i++)
+    EXPECT_NEAR(box_iou::circle_iou(reference.circle1[i], reference.circle2[i]), reference.circle_iou[i], 1e-9) << "circle pair " << i;
+}
+
+
+TEST(BoxIou, degenerateConfigurations)
+{
+  box_iou::Box a = {1.0, 2.0, 0.8, 0.4, 0.3};
+  EXPECT_NEAR(box_iou::iou(a, a), 1.0, 1e-12);
+  EXPECT_NEAR(box_iou::giou(a, a), 1.0, 1e-12);
+
+  // Rotated by pi, same footprint
+  box_iou::Box flipped = a;
+  flipped.yaw += M_PI;
+  EXPECT_NEAR(box_iou::iou(a, flipped), 1.0, 1e-9);
+
+  // Contained: the area ratio
+  box_iou::Box inner = {1.0, 2.0, 0.4, 0.2, 0.3};
+  EXPECT_NEAR(box_iou::iou(a, inner), 0.25, 1e-9);
+
+  // Touching edges, then apart: iou 0, the giou decreases with the gap
+  box_iou::Box left = {0.0, 0.0, 1.0, 1.0, 0.0};
+  box_iou::Box touching = {1.0, 0.0, 1.0, 1.0, 0.0};
+  box_iou::Box apart = {3.0, 0.0, 1.0, 1.0, 0.0};
+  EXPECT_NEAR(box_iou::iou(left, touching), 0.0, 1e-12);
+  EXPECT_NEAR(box_iou::giou(left, touching), 0.0, 1e-12);
+  EXPECT_NEAR(box_iou::iou(left, apart), 0.0, 1e-12);
+  // Hull 4 x 1, union 2
+  EXPECT_NEAR(box_iou::giou(left, apart), -0.5, 1e-12);
+
+  // Cross: the intersection is a 0.2 x 0.2 square
+  box_iou::Box horizontal = {0.0, 0.0, 1.0, 0.2, 0.0};
+  box_iou::Box vertical = {0.0, 0.0, 1.0, 0.2, M_PI / 2};
+  EXPECT_NEAR(box_iou::intersection_area(horizontal, vertical), 0.04, 1e-12);
+  EXPECT_NEAR(box_iou::iou(horizontal, vertical), 0.04 / 0.36, 1e-12);
+
+  // Diamond in a square: the octagon of the two unit squares rotated by pi/4
+  box_iou::Box square = {0.0, 0.0, 1.0, 1.0, 0.0};
+  box_iou::Box diamond = {0.0, 0.0, 1.0, 1.0, M_PI / 4};
+  EXPECT_NEAR(box_iou::intersection_area(square, diamond), 2.0 * (std::sqrt(2.0) - 1.0), 1e-12);
+}
+
+
+TEST(BoxIou, matrixMatchesPairs)
+{
+  srand(1);
+  std::vector<box_iou::Box> dets = random_boxes(23, 2.0), trks = random_boxes(17, 2.0);
+  std::vector<double> matrix, generalized;
+  box_iou::iou_matrix(dets, trks, matrix);
+  box_iou::iou_matrix(dets, trks, generalized, true);
+  ASSERT_EQ(matrix.size(), dets.size() * trks.size());
+  ASSERT_EQ(generalized.size(), dets.size() * trks.size());
+  int num_overlapping = 0;
+  for(int d = 0; d < dets.size(); d++) {
+    for(int t = 0; t < trks.size(); t++) {
+      EXPECT_EQ(matrix[d * trks.size() + t], box_iou::iou(dets[d], trks[t]));
+      EXPECT_EQ(generalized[d * trks.size() + t], box_iou::giou(dets[d], trks[t]));
+      EXPECT_LE(generalized[d * trks.size() + t], matrix[d * trks.size() + t] + 1e-12);
+      EXPECT_GT(generalized[d * trks.size() + t], -1.0);
+      if(matrix[d * trks.size() + t] > 0.0)
+        num_overlapping++;
+    }
+  }
+  EXPECT_GT(num_overlapping, 0);
+
+  // No tracks or no detections
+  box_iou::iou_matrix(dets, std::vector<box_iou::Box>(), matrix);
+  EXPECT_TRUE(matrix.empty());
+  box_iou::iou_matrix(std::vector<box_iou::Box>(), trks, matrix);
+  EXPECT_TRUE(matrix.empty());
+}
+
+
+TEST(BoxIou, intersectionMatchesSampling)
+{
+  srand(2);
+  std::vector<box_iou::Box> boxes = random_boxes(20, 0.3);
+  for(int i = 0; i + 1 < boxes.size(); i += 2) {
+    const box_iou::Box &a = boxes[i], &b = boxes[i + 1];
+    // Grid sampling over the square around a
+    const double half = 0.5 * std::hypot(a.l, a.w), step = 2e-3;
+    int num_inside = 0;
+    for(double x = a.x - half; x < a.x + half; x += step) {
+      for(double y = a.y - half; y < a.y + half; y += step) {
+        bool inside = true;
+        for(const box_iou::Box *box : {&a, &b}) {
+          const double dx = x - box->x, dy = y - box->y;
+          const double u = std::cos(box->yaw) * dx + std::sin(box->yaw) * dy;
+          const double v = -std::sin(box->yaw) * dx + std::cos(box->yaw) * dy;
+          inside = inside && std::fabs(u) <= 0.5 * box->l && std::fabs(v) <= 0.5 * box->w;
+        }
+        if(inside)
+          num_inside++;
+      }
+    }
+    EXPECT_NEAR(box_iou::intersection_area(a, b), num_inside * step * step, 2e-3) << "pair " << i;
+  }
+}
+
+
+TEST(BoxIou, timing)
+{
+  // Association matrix of a crowd, 10 to 80 detections and tracks
+  srand(3);
+  for(int num_boxes = 10; num_boxes <= 80; num_boxes *= 2) {
+    std::vector<box_iou::Box> dets = random_boxes(num_boxes, 4.0), trks = random_boxes(num_boxes, 4.0);
+    std::vector<double> matrix;
+    const int num_repeats = 200;
+    double total = 0.0;
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    for(int k = 0; k < num_repeats; k++) {
+      box_iou::iou_matrix(dets, trks, matrix);
+      total += matrix[k % matrix.size()];
+    }
+    double iou_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count() / num_repeats;
+    begin = std::chrono::steady_clock::now();
+    for(int k = 0; k < num_repeats; k++) {
+      box_iou::iou_matrix(dets, trks, matrix, true);
+      total += matrix[k % matrix.size()];
+    }
+    double giou_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count() / num_repeats;
+
+    std::cout << num_boxes << " x " << num_boxes << " boxes: iou_matrix " << iou_us << " us, giou " << giou_us
+              << " us (checksum " << total << ")" << std::endl;
+  }
+}
+
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,185 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "clear_mot.hpp"
+
+using clear_mot::Object;
+
+
+// Most pairs below max_cost, then minimum cost, over all the assignments of the rows
+// (rows <= cols), by enumeration
+static std::pair<int, double> brute_force(const std::vector<double> &cost, int rows, int cols, double max_cost) {
+  std::vector<int> columns(cols);
+  for(int j = 0; j < cols; j++)
+    columns[j] = j;
+  std::pair<int, double> best(0, 0.0);
+  do {
+    std::pair<int, double> pairs(0, 0.0);
+    for(int i = 0; i < rows; i++) {
+      if(cost[i * cols + columns[i]] < max_cost) {
+        pairs.first--;
+        pairs.second += cost[i * cols + columns[i]];
+      }
+    }
+    best = std::min(best, pairs);
+  } while(std::next_permutation(columns.begin(), columns.end()));
+  return std::make_pair(-best.first, best.second);
+}
+
+
+TEST(ClearMot, LinearAssignmentIsOptimal) {
+  std::mt19937 rng(3);
+  std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+  for(int trial = 0; trial < 200; trial++) {
+    const int rows = 1 + trial % 5, cols = rows + trial % 3;
+    std::vector<double> cost(rows * cols);
+    for(int i = 0; i < cost.size(); i++)
+      cost[i] = uniform(rng);
+    std::vector<int> assignment;
+    clear_mot::linear_assignment(cost, rows, cols, 0.0, assignment);
+
+    int num_pairs = 0;
+    double sum = 0.0;
+    std::vector<bool> used(cols, false);
+    for(int i = 0; i < rows; i++) {
+      if(assignment[i] < 0)
+        continue;
+      ASSERT_LT(cost[i * cols + assignment[i]], 0.0);
+      ASSERT_FALSE(used[assignment[i]]);
+      used[assignment[i]] = true;
+      num_pairs++;
+      sum += cost[i * cols + assignment[i]];
+    }
+    const std::pair<int, double> best = brute_force(cost, rows, cols, 0.0);
+    EXPECT_EQ(num_pairs, best.first) << "trial " << trial;
+    EXPECT_NEAR(sum, best.second, 1e-9) << "trial " << trial;
+  }
+}
+
+
+TEST(ClearMot, LinearAssignmentMoreRowsThanColumns) {
+  const std::vector<double> cost = {1.0, 0.2,
+                                    0.1, 5.0,
+                                    0.3, 0.3};
+  std::vector<int> assignment;
+  clear_mot::linear_assignment(cost, 3, 2, 1.0, assignment);
+  EXPECT_EQ(assignment, std::vector<int>({1, 0, -1}));
+}
+
+
+TEST(ClearMot, PerfectTracking) {
+  clear_mot::Evaluator evaluator(0.5);
+  for(int t = 0; t < 10; t++)
+    evaluator.add_frame({{1, 0.1 * t, 0.0}, {2, 0.0, 2.0 + 0.1 * t}},
+                        {{7, 0.1 * t + 0.1, 0.0}, {8, 0.0, 2.0 + 0.1 * t}});
+  const clear_mot::Metrics m = evaluator.metrics();
+  EXPECT_EQ(m.num_frames, 10);
+  EXPECT_EQ(m.num_ground_truth, 20);
+  EXPECT_EQ(m.num_matches, 20);
+  EXPECT_EQ(m.num_false_positives, 0);
+  EXPECT_EQ(m.num_misses, 0);
+  EXPECT_EQ(m.num_switches, 0);
+  EXPECT_EQ(m.num_fragmentations, 0);
+  EXPECT_DOUBLE_EQ(m.mota(), 1.0);
+  EXPECT_NEAR(m.motp(), 0.05, 1e-12);
+  EXPECT_DOUBLE_EQ(m.idf1(), 1.0);
+  EXPECT_EQ(m.num_ground_truth_ids, 2);
+  EXPECT_EQ(m.num_hypothesis_ids, 2);
+}
+
+
+TEST(ClearMot, FalsePositivesAndMisses) {
+  clear_mot::Evaluator evaluator(0.5);
+  evaluator.add_frame({{1, 0.0, 0.0}, {2, 5.0, 0.0}}, {{1, 0.0, 0.0}, {2, 0.0, 5.0}});
+  evaluator.add_frame({{1, 0.0, 0.0}}, {});
+  const clear_mot::Metrics m = evaluator.metrics();
+  EXPECT_EQ(m.num_ground_truth, 3);
+  EXPECT_EQ(m.num_matches, 1);
+  EXPECT_EQ(m.num_false_positives, 1);
+  EXPECT_EQ(m.num_misses, 2);
+  EXPECT_NEAR(m.mota(), 1.0 - 3.0 / 3.0, 1e-12);
+  EXPECT_NEAR(m.precision(), 0.5, 1e-12);
+  EXPECT_NEAR(m.recall(), 1.0 / 3.0, 1e-12);
+  // The best id pair overlaps once: IDTP 1, IDFP 1, IDFN 2
+  EXPECT_EQ(m.id_true_positives, 1);
+  EXPECT_NEAR(m.idf1(), 2.0 / 5.0, 1e-12);
+}
+
+
+// The track keeps its hypothesis while it stays within the threshold, even if another
+// hypothesis comes closer, as in the CLEAR MOT paper
+TEST(ClearMot, MatchesArePersistent) {
+  clear_mot::Evaluator evaluator(0.5);
+  evaluator.add_frame({{1, 0.0, 0.0}}, {{10, 0.3, 0.0}});
+  evaluator.add_frame({{1, 0.0, 0.0}}, {{10, 0.3, 0.0}, {11, 0.0, 0.0}});
+  const clear_mot::Metrics m = evaluator.metrics();
+  EXPECT_EQ(m.num_switches, 0);
+  EXPECT_EQ(m.num_false_positives, 1);
+  EXPECT_NEAR(m.motp(), 0.3, 1e-12);
+}
+
+
+// Two pedestrians walking side by side, the tracker swaps their ids halfway
+TEST(ClearMot, IdentitySwitch) {
+  clear_mot::Evaluator evaluator(0.5);
+  for(int t = 0; t < 10; t++) {
+    const double x = 0.1 * t;
+    const bool swapped = t >= 5;
+    evaluator.add_frame({{1, x, -1.0}, {2, x, 1.0}},
+                        {{swapped ? 21 : 20, x, -1.0}, {swapped ? 20 : 21, x, 1.0}});
+  }
+  const clear_mot::Metrics m = evaluator.metrics();
+  EXPECT_EQ(m.num_matches, 20);
+  EXPECT_EQ(m.num_switches, 2);
+  EXPECT_EQ(m.num_fragmentations, 0);
+  EXPECT_NEAR(m.mota(), 1.0 - 2.0 / 20.0, 1e-12);
+  // Each ground truth id shares 5 of its 10 frames with its hypothesis of the global matching
+  EXPECT_EQ(m.id_true_positives, 10);
+  EXPECT_NEAR(m.idf1(), 0.5, 1e-12);
+}
+
+
+// Track lost for 3 frames then picked up again, first by the same track then by a new one
+TEST(ClearMot, Fragmentation) {
+  clear_mot::Evaluator evaluator(0.5);
+  for(int t = 0; t < 12; t++) {
+    std::vector<Object> hypotheses;
+    if(t < 3 || (t >= 6 && t < 9))
+      hypotheses.push_back({30, 0.0, 0.0});
+    else if(t >= 9)
+      hypotheses.push_back({31, 0.0, 0.0});
+    evaluator.add_frame({{1, 0.0, 0.0}}, hypotheses);
+  }
+  const clear_mot::Metrics m = evaluator.metrics();
+  EXPECT_EQ(m.num_matches, 9);
+  EXPECT_EQ(m.num_misses, 3);
+  EXPECT_EQ(m.num_fragmentations, 1);
+  EXPECT_EQ(m.num_switches, 1);
+  EXPECT_EQ(m.id_true_positives, 6);
+  EXPECT_EQ(m.id_false_positives, 3);
+  EXPECT_EQ(m.id_false_negatives, 6);
+}
+
+
+TEST(ClearMot, DetectionsHaveNoIdentities) {
+  clear_mot::Evaluator evaluator(0.5, false);
+  evaluator.add_frame({{1, 0.0, 0.0}}, {{0, 0.0, 0.1}});
+  evaluator.add_frame({{1, 0.0, 0.0}}, {{0, 3.0, 0.0}, {1, 0.0, 0.2}});
+  const clear_mot::Metrics m = evaluator.metrics();
+  EXPECT_EQ(m.num_matches, 2);
+  EXPECT_EQ(m.num_false_positives, 1);
+  EXPECT_EQ(m.num_switches, 0);
+  EXPECT_NEAR(m.mota(), 0.5, 1e-12);
+  EXPECT_NEAR(m.motp(), 0.15, 1e-12);
+}
+
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,269 @@
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <Eigen/Dense>
+
+#include "box_iou.hpp"
+#include "imm_filter.hpp"
+
+
+// Constant velocity Kalman filter of AB3DMOT_libs.kalman_filter.KalmanBoxTracker, state
+// [x, y, r, vx, vy], with its filterpy defaults
+class ConstantVelocityFilter {
+public:
+  explicit ConstantVelocityFilter(const Eigen::Vector3d &z) {
+    x_.setZero();
+    x_.head<3>() = z;
+    P_.setIdentity();
+    P_(3, 3) = P_(4, 4) = 1000.0;
+    P_ *= 10.0;
+    Q_.setIdentity();
+    Q_(3, 3) = Q_(4, 4) = 0.5;
+    F_.setIdentity();
+    F_(0, 3) = F_(1, 4) = 1.0;
+  }
+
+  void predict() {
+    x_ = F_ * x_;
+    P_ = F_ * P_ * F_.transpose() + Q_;
+  }
+
+  void update(const Eigen::Vector3d &z) {
+    const Eigen::Matrix3d S = P_.topLeftCorner<3, 3>() + 1e-2 * Eigen::Matrix3d::Identity();
+    const Eigen::Matrix<double, 5, 3> K = P_.leftCols<3>() * S.inverse();
+    x_ += K * (z - x_.head<3>());
+    P_ -= K * P_.topRows<3>();
+  }
+
+  const Eigen::Matrix<double, 5, 1> &state() const { return x_; }
+
+private:
+  Eigen::Matrix<double, 5, 1> x_;
+  Eigen::Matrix<double, 5, 5> P_, Q_, F_;
+};
+
+
+// Person walking around the walker at 10 Hz: walk, stop, walk, turn, walk
+struct Waypoint {
+  double x, y, vx, vy;
+  int mode;
+};
+
+
+static std::vector<Waypoint> simulate_person(double heading) {
+  const double dt = 0.1, speed = 1.2;
+  std::vector<Waypoint> path;
+  Waypoint p = {0.0, 0.0, speed * std::cos(heading), speed * std::sin(heading), imm_filter::CONSTANT_VELOCITY};
+  struct Phase { int steps; int mode; double turn_rate; };
+  const Phase phases[] = {{30, imm_filter::CONSTANT_VELOCITY, 0.0}, {25, imm_filter::CONSTANT_POSITION, 0.0},
+                          {30, imm_filter::CONSTANT_VELOCITY, 0.0}, {25, imm_filter::COORDINATED_TURN, 1.0},
+                          {20, imm_filter::CONSTANT_VELOCITY, 0.0}, {20, imm_filter::CONSTANT_POSITION, 0.0},
+                          {25, imm_filter::COORDINATED_TURN, -0.8}};
+  double vx = p.vx, vy = p.vy;
+  for(const Phase &phase : phases) {
+    for(int k = 0; k < phase.steps; k++) {
+      if(phase.mode == imm_filter::COORDINATED_TURN) {
+        const double c = std::cos(phase.turn_rate * dt), s = std::sin(phase.turn_rate * dt);
+        const double rvx = c * vx - s * vy, rvy = s * vx + c * vy;
+        vx = rvx;
+        vy = rvy;
+      }
+      p.vx = phase.mode == imm_filter::CONSTANT_POSITION ? 0.0 : vx;
+      p.vy = phase.mode == imm_filter::CONSTANT_POSITION ? 0.0 : vy;
+      p.x += p.vx * dt;
+      p.y += p.vy * dt;
+      p.mode = phase.mode;
+      path.push_back(p);
+    }
+  }
+  return path;
+}
+
+
+struct Errors {
+  double sum_squared_filtered = 0.0;
+  double sum_squared_predicted = 0.0;
+  int num_updates = 0;
+  int num_gate_losses = 0;  // predicted circle does not overlap the detection (iou < 0.01)
+
+  void add(double px, double py, double pr, double fx, double fy, const Waypoint &truth, const Eigen::Vector3d &z) {
+    sum_squared_predicted += (px - truth.x) * (px - truth.x) + (py - truth.y) * (py - truth.y);
+    sum_squared_filtered += (fx - truth.x) * (fx - truth.x) + (fy - truth.y) * (fy - truth.y);
+    num_updates++;
+    if(box_iou::circle_iou({px, py, pr}, {z(0), z(1), z(2)}) < 0.01)
+      num_gate_losses++;
+  }
+  double filtered_rmse() const { return std::sqrt(sum_squared_filtered / num_updates); }
+  double predicted_rmse() const { return std::sqrt(sum_squared_predicted / num_updates); }
+};
+
+
+TEST(ImmFilter, replayAgainstConstantVelocity)
+{
+  const double radius = 0.25, noise = 0.05, miss_probability = 0.1;
+  std::mt19937 generator(4);
+  std::normal_distribution<double> gaussian(0.0, noise);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+  Errors cv_errors, imm_errors;
+  double mode_probability_sum[imm_filter::NUM_MODELS] = {0.0, 0.0, 0.0};
+  int mode_steps[imm_filter::NUM_MODELS] = {0, 0, 0};
+  for(int person = 0; person < 20; person++) {
+    std::vector<Waypoint> path = simulate_person(2.0 * M_PI * person / 20);
+    Eigen::Vector3d z(path[0].x + gaussian(generator), path[0].y + gaussian(generator), radius);
+    ConstantVelocityFilter cv(z);
+    imm_filter::ImmFilterBank imm;
+    imm.add(person, z);
+
+    for(int k = 1; k < path.size(); k++) {
+      cv.predict();
+      imm.predict();
+      imm_filter::State state;
+      imm_filter::ModeProbabilities mode_probabilities;
+      ASSERT_TRUE(imm.get(person, state, mode_probabilities));
+      const Eigen::Matrix<double, 5, 1> cv_predicted = cv.state();
+      const imm_filter::State imm_predicted = state;
+
+      if(uniform(generator) < miss_probability)
+        continue;
+      z << path[k].x + gaussian(generator), path[k].y + gaussian(generator), radius + 0.2 * gaussian(generator);
+      cv.update(z);
+      ASSERT_TRUE(imm.update(person, z));
+      ASSERT_TRUE(imm.get(person, state, mode_probabilities));
+      EXPECT_NEAR(mode_probabilities.sum(), 1.0, 1e-9);
+
+      cv_errors.add(cv_predicted(0), cv_predicted(1), cv_predicted(2), cv.state()(0), cv.state()(1), path[k], z);
+      imm_errors.add(imm_predicted(0), imm_predicted(1), imm_predicted(2), state(0), state(1), path[k], z);
+      // Skip the transition right after a phase change
+      if(k >= 10 && path[k - 10].mode == path[k].mode) {
+        mode_probability_sum[path[k].mode] += mode_probabilities(path[k].mode);
+        mode_steps[path[k].mode]++;
+      }
+    }
+  }
+
+  std::cout << "constant velocity: filtered rmse " << cv_errors.filtered_rmse() << " m, predicted rmse "
+            << cv_errors.predicted_rmse() << " m, gate losses " << cv_errors.num_gate_losses << " / " << cv_errors.num_updates << std::endl;
+  std::cout << "imm: filtered rmse " << imm_errors.filtered_rmse() << " m, predicted rmse "
+            << imm_errors.predicted_rmse() << " m, gate losses " << imm_errors.num_gate_losses << " / " << imm_errors.num_updates << std::endl;
+  for(int j = 0; j < imm_filter::NUM_MODELS; j++)
+    std::cout << "mean probability of the true mode " << j << ": " << mode_probability_sum[j] / mode_steps[j] << std::endl;
+
+  EXPECT_LT(imm_errors.filtered_rmse(), cv_errors.filtered_rmse());
+  EXPECT_LT(imm_errors.predicted_rmse(), cv_errors.predicted_rmse());
+  EXPECT_LE(imm_errors.num_gate_losses, cv_errors.num_gate_losses);
+  // Standing and walking straight are told apart
+  EXPECT_GT(mode_probability_sum[imm_filter::CONSTANT_POSITION] / mode_steps[imm_filter::CONSTANT_POSITION], 0.5);
+  EXPECT_GT(mode_probability_sum[imm_filter::CONSTANT_VELOCITY] / mode_steps[imm_filter::CONSTANT_VELOCITY], 0.4);
+}
+
+
+TEST(ImmFilter, coordinatedTurnFollowsCircle)
+{
+  // Noise free circle of radius 1.2 m at 1.2 m/s, the turning model takes over and the
+  // prediction cuts less into the circle than without it
+  imm_filter::ImmParameters without_turn;
+  without_turn.transition.col(imm_filter::COORDINATED_TURN).setZero();
+  without_turn.transition.col(imm_filter::CONSTANT_VELOCITY) += Eigen::Vector3d::Ones() - without_turn.transition.rowwise().sum();
+  without_turn.initial_mode_probabilities(imm_filter::COORDINATED_TURN) = 0.0;
+  imm_filter::ImmFilterBank imm, imm_without_turn(without_turn);
+
+  const double speed = 0.12, turn_rate = 0.1;  // per step
+  double heading = 0.0, x = 0.0, y = 0.0;
+  imm.add(0, Eigen::Vector3d(x, y, 0.3));
+  imm_without_turn.add(0, Eigen::Vector3d(x, y, 0.3));
+  imm_filter::State state;
+  imm_filter::ModeProbabilities mode_probabilities;
+  double error = 0.0, error_without_turn = 0.0;
+  for(int k = 0; k < 100; k++) {
+    x += speed * std::cos(heading + 0.5 * turn_rate) * std::sin(0.5 * turn_rate) / (0.5 * turn_rate);
+    y += speed * std::sin(heading + 0.5 * turn_rate) * std::sin(0.5 * turn_rate) / (0.5 * turn_rate);
+    heading += turn_rate;
+    imm.predict();
+    imm_without_turn.predict();
+    if(k >= 50) {
+      ASSERT_TRUE(imm.get(0, state, mode_probabilities));
+      error += std::hypot(state(0) - x, state(1) - y);
+      ASSERT_TRUE(imm_without_turn.get(0, state, mode_probabilities));
+      EXPECT_EQ(mode_probabilities(imm_filter::COORDINATED_TURN), 0.0);
+      error_without_turn += std::hypot(state(0) - x, state(1) - y);
+    }
+    imm.update(0, Eigen::Vector3d(x, y, 0.3));
+    imm_without_turn.update(0, Eigen::Vector3d(x, y, 0.3));
+  }
+  std::cout << "mean prediction error on the circle: " << error / 50 << " m, without the turning model "
+            << error_without_turn / 50 << " m" << std::endl;
+  EXPECT_LT(error, error_without_turn);
+  ASSERT_TRUE(imm.get(0, state, mode_probabilities));
+  EXPECT_GT(mode_probabilities(imm_filter::COORDINATED_TURN), mode_probabilities(imm_filter::CONSTANT_VELOCITY));
+  EXPECT_GT(state(5), 0.0);
+  EXPECT_NEAR(std::hypot(state(3), state(4)), speed, 0.01);
+}
+
+
+TEST(ImmFilter, bankBookkeeping)
+{
+  imm_filter::ImmFilterBank imm;
+  for(int id = 0; id < 5; id++)
+    imm.add(10 * id, Eigen::Vector3d(id, 0.0, 0.3));
+  EXPECT_EQ(imm.size(), 5);
+  EXPECT_TRUE(imm.remove(10));
+  EXPECT_FALSE(imm.remove(10));
+  EXPECT_FALSE(imm.contains(10));
+  EXPECT_FALSE(imm.update(10, Eigen::Vector3d::Zero()));
+  EXPECT_EQ(imm.size(), 4);
+
+  // The moved track keeps its state
+  imm_filter::State state;
+  imm_filter::ModeProbabilities mode_probabilities;
+  ASSERT_TRUE(imm.get(40, state, mode_probabilities));
+  EXPECT_NEAR(state(0), 4.0, 1e-12);
+  EXPECT_NEAR(mode_probabilities.sum(), 1.0, 1e-12);
+
+  // A stationary track stays put and becomes constant position
+  for(int k = 0; k < 30; k++) {
+    imm.predict();
+    imm.update(20, Eigen::Vector3d(2.0, 0.0, 0.3));
+  }
+  ASSERT_TRUE(imm.get(20, state, mode_probabilities));
+  EXPECT_NEAR(state(0), 2.0, 1e-3);
+  EXPECT_NEAR(std::hypot(state(3), state(4)), 0.0, 1e-3);
+  EXPECT_GT(mode_probabilities(imm_filter::CONSTANT_POSITION), 0.5);
+
+  // A far detection does not break the probabilities
+  imm.update(20, Eigen::Vector3d(500.0, 0.0, 0.3));
+  ASSERT_TRUE(imm.get(20, state, mode_probabilities));
+  EXPECT_TRUE(state.allFinite());
+  EXPECT_NEAR(mode_probabilities.sum(), 1.0, 1e-9);
+}
+
+
+TEST(ImmFilter, timing)
+{
+  // Predict and update of a crowd of tracks
+  for(int num_tracks = 10; num_tracks <= 80; num_tracks *= 2) {
+    imm_filter::ImmFilterBank imm;
+    for(int id = 0; id < num_tracks; id++)
+      imm.add(id, Eigen::Vector3d(0.5 * id, 0.0, 0.3));
+    const int num_steps = 200;
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    for(int k = 0; k < num_steps; k++) {
+      imm.predict();
+      for(int id = 0; id < num_tracks; id++)
+        imm.update(id, Eigen::Vector3d(0.5 * id + 0.1 * k, 0.0, 0.3));
+    }
+    double step_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count() / num_steps;
+    std::cout << num_tracks << " tracks: predict + update " << step_us << " us per step" << std::endl;
+  }
+}
+
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
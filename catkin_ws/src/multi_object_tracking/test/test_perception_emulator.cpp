@@ -0,0 +1,349 @@
+#include <cmath>
+#include <map>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "clear_mot.hpp"
+#include "perception_emulator.hpp"
+
+using perception_emulator::Agent;
+using perception_emulator::Emulator;
+using perception_emulator::EmulatorParameters;
+using perception_emulator::Observation;
+using perception_emulator::SensorPose;
+using perception_emulator::Wall;
+
+
+// No noise, no misses, no false positives, no id switches, the field of view on the x axis of
+// the sensor frame
+static EmulatorParameters ideal_parameters() {
+  EmulatorParameters parameters;
+  parameters.sensor_yaw_offset = 0.0;
+  parameters.position_noise = 0.0;
+  parameters.velocity_noise = 0.0;
+  parameters.miss_rate = 0.0;
+  parameters.false_positive_rate = 0.0;
+  parameters.id_switch_rate = 0.0;
+  return parameters;
+}
+
+
+// People walking side by side in front of the sensor at the origin, 1 m apart
+static std::vector<Agent> crowd(int num_agents, int t) {
+  std::vector<Agent> agents;
+  for(int i = 0; i < num_agents; i++) {
+    const double y = i - 0.5 * (num_agents - 1);
+    agents.push_back({100 + i, 4.0 + 0.05 * std::sin(0.1 * t + i), y, 0.5 * std::cos(0.1 * t + i), 0.0});
+  }
+  return agents;
+}
+
+
+TEST(PerceptionEmulator, FieldOfViewAndRange) {
+  Emulator emulator(ideal_parameters());
+  const SensorPose sensor = {1.0, 1.0, M_PI / 2};
+  const std::vector<Agent> agents = {{1, 1.0, 4.0, 0.0, 0.0},     // in front
+                                     {2, 1.0, -2.0, 0.0, 0.0},    // behind
+                                     {3, 4.0, 1.0, 0.0, 0.0},     // on the side
+                                     {4, 1.0, 10.0, 0.0, 0.0}};   // too far
+  EXPECT_DOUBLE_EQ(emulator.visible_fraction(sensor, agents, 0), 1.0);
+  EXPECT_DOUBLE_EQ(emulator.visible_fraction(sensor, agents, 1), 0.0);
+  EXPECT_DOUBLE_EQ(emulator.visible_fraction(sensor, agents, 2), 0.0);
+  EXPECT_DOUBLE_EQ(emulator.visible_fraction(sensor, agents, 3), 0.0);
+}
+
+
+// Planar pose of a frame of walker.urdf.xacro in the world
+struct FramePose {
+  double x, y, yaw;
+};
+
+
+// Pose of a child frame from its parent and the joint origin
+static FramePose compose(const FramePose &parent, const FramePose &joint) {
+  return {parent.x + std::cos(parent.yaw) * joint.x - std::sin(parent.yaw) * joint.y,
+          parent.y + std::sin(parent.yaw) * joint.x + std::cos(parent.yaw) * joint.y,
+          parent.yaw + joint.yaw};
+}
+
+
+// The node gets the pose of laser_link, which the lidar mount turns by pi: the walker sees the
+// people in front of base_link with the default parameters
+TEST(PerceptionEmulator, WalkerFrames) {
+  EmulatorParameters parameters = ideal_parameters();
+  parameters.sensor_yaw_offset = EmulatorParameters().sensor_yaw_offset;
+  parameters.false_positive_rate = 1.0;
+  parameters.false_positive_frames = 1;
+  Emulator emulator(parameters);
+
+  // ydlidar_mount_joint, the joint of the lidar plugin and webcam_mount_joint
+  const FramePose base_link = {2.0, 1.0, 0.4};
+  const FramePose laser_base = compose(base_link, {0.41, 0.0, 3.1415926});
+  const FramePose laser_link = compose(laser_base, {0.0, 0.0, 0.0});
+  const FramePose camera_link = compose(laser_link, {-0.04, 0.0, 3.1415926});
+  const SensorPose sensor = {laser_link.x, laser_link.y, laser_link.yaw};
+
+  // The field of view is centered on the camera axis, ahead of base_link
+  EXPECT_NEAR(std::remainder(sensor.yaw + parameters.sensor_yaw_offset - camera_link.yaw, 2 * M_PI), 0.0, 1e-6);
+  EXPECT_NEAR(std::remainder(sensor.yaw + parameters.sensor_yaw_offset - base_link.yaw, 2 * M_PI), 0.0, 1e-6);
+
+  const FramePose front = compose(base_link, {3.0, 0.3, 0.0});
+  const FramePose behind = compose(laser_link, {2.5, 0.0, 0.0});     // on the x axis of laser_link
+  const std::vector<Agent> agents = {{1, front.x, front.y, 0.0, 0.0}, {2, behind.x, behind.y, 0.0, 0.0}};
+  EXPECT_DOUBLE_EQ(emulator.visible_fraction(sensor, agents, 0), 1.0);
+  EXPECT_DOUBLE_EQ(emulator.visible_fraction(sensor, agents, 1), 0.0);
+
+  int num_false_positives = 0;
+  for(int t = 0; t < 100; t++) {
+    std::vector<Observation> detections, tracks;
+    emulator.step(sensor, agents, detections, tracks);
+    for(int i = 0; i < detections.size(); i++) {
+      // Every detection, false positives included, is ahead of the lidar in base_link
+      const double dx = detections[i].x - base_link.x, dy = detections[i].y - base_link.y;
+      EXPECT_GT(std::cos(base_link.yaw) * dx + std::sin(base_link.yaw) * dy, 0.41);
+      if(detections[i].agent_id < 0) {
+        num_false_positives++;
+      } else {
+        EXPECT_EQ(detections[i].agent_id, 1);
+      }
+    }
+    if(t + 1 >= parameters.confirm_frames) {
+      ASSERT_EQ(tracks.size(), 1);
+      EXPECT_EQ(tracks[0].agent_id, 1);
+    }
+  }
+  EXPECT_GT(num_false_positives, 0);
+}
+
+
+TEST(PerceptionEmulator, OcclusionByPeople) {
+  Emulator emulator(ideal_parameters());
+  const SensorPose sensor = {0.0, 0.0, 0.0};
+  const std::vector<Agent> agents = {{1, 2.0, 0.0, 0.0, 0.0},
+                                     {2, 4.0, 0.0, 0.0, 0.0},     // right behind the first one
+                                     {3, 4.0, 0.6, 0.0, 0.0},     // behind the edge of the first one
+                                     {4, 4.0, 2.5, 0.0, 0.0}};    // in the clear
+  EXPECT_DOUBLE_EQ(emulator.visible_fraction(sensor, agents, 0), 1.0);
+  EXPECT_DOUBLE_EQ(emulator.visible_fraction(sensor, agents, 1), 0.0);
+  const double partial = emulator.visible_fraction(sensor, agents, 2);
+  EXPECT_GT(partial, 0.0);
+  EXPECT_LT(partial, 1.0);
+  EXPECT_DOUBLE_EQ(emulator.visible_fraction(sensor, agents, 3), 1.0);
+}
+
+
+TEST(PerceptionEmulator, OcclusionByWalls) {
+  Emulator emulator(ideal_parameters());
+  emulator.set_walls({{3.0, -1.0, 3.0, 0.0}});
+  const SensorPose sensor = {0.0, 0.0, 0.0};
+  const std::vector<Agent> agents = {{1, 5.0, -1.0, 0.0, 0.0},   // behind the wall
+                                     {2, 5.0, 1.5, 0.0, 0.0},    // past its end
+                                     {3, 2.0, -0.5, 0.0, 0.0}};  // in front of it
+  EXPECT_DOUBLE_EQ(emulator.visible_fraction(sensor, agents, 0), 0.0);
+  EXPECT_DOUBLE_EQ(emulator.visible_fraction(sensor, agents, 1), 1.0);
+  EXPECT_DOUBLE_EQ(emulator.visible_fraction(sensor, agents, 2), 1.0);
+}
+
+
+TEST(PerceptionEmulator, IdealSensor) {
+  Emulator emulator(ideal_parameters());
+  const SensorPose sensor = {0.0, 0.0, 0.0};
+  std::map<long, long> track_ids;     // by agent id
+  for(int t = 0; t < 20; t++) {
+    const std::vector<Agent> agents = crowd(3, t);
+    std::vector<Observation> detections, tracks;
+    emulator.step(sensor, agents, detections, tracks);
+    ASSERT_EQ(detections.size(), 3);
+    ASSERT_EQ(tracks.size(), t + 1 < emulator.parameters().confirm_frames ? 0 : 3);
+    for(int i = 0; i < detections.size(); i++) {
+      EXPECT_EQ(detections[i].agent_id, agents[i].id);
+      EXPECT_EQ(detections[i].id, 0);
+      EXPECT_DOUBLE_EQ(detections[i].x, agents[i].x);
+      EXPECT_DOUBLE_EQ(detections[i].y, agents[i].y);
+    }
+    for(int i = 0; i < tracks.size(); i++) {
+      EXPECT_DOUBLE_EQ(tracks[i].vx, agents[i].vx);
+      EXPECT_DOUBLE_EQ(tracks[i].vy, agents[i].vy);
+      if(track_ids.count(tracks[i].agent_id) == 0)
+        track_ids[tracks[i].agent_id] = tracks[i].id;
+      EXPECT_EQ(tracks[i].id, track_ids[tracks[i].agent_id]);
+    }
+  }
+  EXPECT_EQ(track_ids.size(), 3);
+}
+
+
+// Hidden for at most max_lost_frames the person keeps the track, longer it gets a new one
+TEST(PerceptionEmulator, LostTracks) {
+  Emulator emulator(ideal_parameters());
+  const int max_lost_frames = emulator.parameters().max_lost_frames;
+  const SensorPose sensor = {0.0, 0.0, 0.0};
+  const std::vector<Agent> visible = {{1, 3.0, 0.0, 0.0, 0.0}}, hidden = {{1, -3.0, 0.0, 0.0, 0.0}};
+  std::vector<Observation> detections, tracks;
+  for(int t = 0; t < 5; t++)
+    emulator.step(sensor, visible, detections, tracks);
+  ASSERT_EQ(tracks.size(), 1);
+  const long id = tracks[0].id;
+
+  for(int t = 0; t < max_lost_frames; t++) {
+    emulator.step(sensor, hidden, detections, tracks);
+    EXPECT_TRUE(tracks.empty());
+  }
+  emulator.step(sensor, visible, detections, tracks);
+  ASSERT_EQ(tracks.size(), 1);
+  EXPECT_EQ(tracks[0].id, id);
+
+  for(int t = 0; t <= max_lost_frames; t++)
+    emulator.step(sensor, hidden, detections, tracks);
+  for(int t = 0; t < emulator.parameters().confirm_frames; t++) {
+    emulator.step(sensor, visible, detections, tracks);
+    EXPECT_EQ(detections.size(), 1);
+  }
+  ASSERT_EQ(tracks.size(), 1);
+  EXPECT_NE(tracks[0].id, id);
+}
+
+
+TEST(PerceptionEmulator, Rates) {
+  EmulatorParameters parameters = ideal_parameters();
+  parameters.position_noise = 0.1;
+  parameters.miss_rate = 0.2;
+  parameters.false_positive_rate = 0.5;
+  parameters.false_positive_frames = 1;
+  Emulator emulator(parameters, 7);
+  const SensorPose sensor = {0.0, 0.0, 0.0};
+  const int num_frames = 4000, num_agents = 3;
+  int num_detected = 0, num_false_positives = 0;
+  double sum_squares = 0.0;
+  for(int t = 0; t < num_frames; t++) {
+    const std::vector<Agent> agents = crowd(num_agents, t);
+    std::vector<Observation> detections, tracks;
+    emulator.step(sensor, agents, detections, tracks);
+    for(int i = 0; i < detections.size(); i++) {
+      if(detections[i].agent_id < 0) {
+        num_false_positives++;
+        EXPECT_LT(std::hypot(detections[i].x, detections[i].y), parameters.max_range + 0.5);
+        continue;
+      }
+      num_detected++;
+      const Agent &agent = agents[detections[i].agent_id - 100];
+      sum_squares += std::pow(detections[i].x - agent.x, 2) + std::pow(detections[i].y - agent.y, 2);
+    }
+  }
+  EXPECT_NEAR((double)num_detected / (num_frames * num_agents), 1.0 - parameters.miss_rate, 0.02);
+  EXPECT_NEAR((double)num_false_positives / num_frames, parameters.false_positive_rate, 0.05);
+  EXPECT_NEAR(std::sqrt(sum_squares / (2 * num_detected)), parameters.position_noise, 0.005);
+}
+
+
+// A switching track swaps ids with a close one, which switches both, or gets a new id when
+// nobody is close
+TEST(PerceptionEmulator, IdSwitches) {
+  EmulatorParameters parameters = ideal_parameters();
+  parameters.id_switch_rate = 0.01;
+  const int num_frames = 5000;
+  for(int close = 0; close < 2; close++) {
+    Emulator emulator(parameters, 11);
+    const SensorPose sensor = {0.0, 0.0, 0.0};
+    const double spacing = close ? 0.7 : 3.0;
+    const std::vector<Agent> agents = {{1, 5.0, -0.5 * spacing, 0.0, 0.0}, {2, 5.0, 0.5 * spacing, 0.0, 0.0}};
+    std::map<long, long> previous;      // track id by agent id
+    int num_switches = 0, num_swaps = 0;
+    for(int t = 0; t < num_frames; t++) {
+      std::vector<Observation> detections, tracks;
+      emulator.step(sensor, agents, detections, tracks);
+      if(tracks.size() != 2)
+        continue;
+      if(!previous.empty()) {
+        num_switches += (tracks[0].id != previous[1]) + (tracks[1].id != previous[2]);
+        num_swaps += tracks[0].id == previous[2] && tracks[1].id == previous[1];
+      }
+      previous[1] = tracks[0].id;
+      previous[2] = tracks[1].id;
+    }
+    const double expected = (close ? 4.0 : 2.0) * num_frames * parameters.id_switch_rate;
+    EXPECT_NEAR(num_switches, expected, 0.3 * expected) << "spacing " << spacing;
+    if(close) {
+      EXPECT_EQ(2 * num_swaps, num_switches);
+    } else {
+      EXPECT_EQ(num_swaps, 0);
+    }
+  }
+}
+
+
+TEST(PerceptionEmulator, Deterministic) {
+  EmulatorParameters parameters;
+  parameters.miss_rate = 0.1;
+  parameters.false_positive_rate = 0.3;
+  parameters.id_switch_rate = 0.05;
+  parameters.sensor_yaw_offset = 0.0;
+  Emulator a(parameters, 3), b(parameters, 3);
+  const SensorPose sensor = {0.0, 0.0, 0.0};
+  std::vector<Observation> first;
+  for(int run = 0; run < 2; run++) {
+    a.reset();
+    for(int t = 0; t < 200; t++) {
+      std::vector<Observation> detections_a, tracks_a, detections_b, tracks_b;
+      a.step(sensor, crowd(4, t), detections_a, tracks_a);
+      if(run == 0) {
+        b.step(sensor, crowd(4, t), detections_b, tracks_b);
+        ASSERT_EQ(tracks_a.size(), tracks_b.size());
+        for(int i = 0; i < tracks_a.size(); i++) {
+          EXPECT_EQ(tracks_a[i].id, tracks_b[i].id);
+          EXPECT_EQ(tracks_a[i].x, tracks_b[i].x);
+        }
+      }
+      if(t == 199 && run == 0)
+        first = tracks_a;
+      if(t == 199 && run == 1) {
+        ASSERT_EQ(tracks_a.size(), first.size());
+        for(int i = 0; i < first.size(); i++)
+          EXPECT_EQ(tracks_a[i].id, first[i].id);
+      }
+    }
+  }
+}
+
+
+// The degradation is controlled: the tracks score worse with every rate that goes up, as
+// mot_evaluation would report on a recorded run
+TEST(PerceptionEmulator, ControlledDegradation) {
+  const SensorPose sensor = {0.0, 0.0, 0.0};
+  double previous_mota = 1.1, previous_idf1 = 1.1;
+  for(int level = 0; level < 4; level++) {
+    EmulatorParameters parameters = ideal_parameters();
+    parameters.miss_rate = 0.1 * level;
+    parameters.false_positive_rate = 0.1 * level;
+    parameters.id_switch_rate = 0.01 * level;
+    Emulator emulator(parameters, 5);
+    clear_mot::Evaluator evaluator(0.5);
+    for(int t = 0; t < 1000; t++) {
+      const std::vector<Agent> agents = crowd(4, t);
+      std::vector<Observation> detections, tracks;
+      emulator.step(sensor, agents, detections, tracks);
+      std::vector<clear_mot::Object> ground_truth, hypotheses;
+      for(int i = 0; i < agents.size(); i++)
+        ground_truth.push_back({agents[i].id, agents[i].x, agents[i].y});
+      for(int i = 0; i < tracks.size(); i++)
+        hypotheses.push_back({tracks[i].id, tracks[i].x, tracks[i].y});
+      evaluator.add_frame(ground_truth, hypotheses);
+    }
+    const clear_mot::Metrics m = evaluator.metrics();
+    if(level == 0) {
+      EXPECT_EQ(m.num_switches, 0);
+      EXPECT_EQ(m.num_false_positives, 0);
+    }
+    EXPECT_LT(m.mota(), previous_mota) << "level " << level;
+    EXPECT_LT(m.idf1(), previous_idf1) << "level " << level;
+    previous_mota = m.mota();
+    previous_idf1 = m.idf1();
+  }
+}
+
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
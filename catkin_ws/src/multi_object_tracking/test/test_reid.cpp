@@ -0,0 +1,337 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "clear_mot.hpp"
+#include "reid.hpp"
+
+static const int kImageWidth = 640;
+static const int kImageHeight = 480;
+
+struct Clothes {
+  unsigned char shirt[3], pants[3];
+};
+
+
+// Noisy background, then a person in the box: skin colored head, shirt and pants, under a
+// global lighting factor and pixel noise
+class Scene {
+public:
+  explicit Scene(std::mt19937 &rng): rng_(rng), background_(kImageWidth * kImageHeight * 3) {
+    std::uniform_int_distribution<int> background(60, 200);
+    for(int i = 0; i < background_.size(); i++)
+      background_[i] = background(rng_);
+  }
+
+  void clear() { image_ = background_; }
+
+  void draw(const reid::Box &box, const Clothes &clothes, double lighting) {
+    static const unsigned char skin[3] = {224, 172, 140};
+    std::uniform_int_distribution<int> noise(-15, 15);
+    for(int v = std::max(0, (int)box.y); v < std::min(kImageHeight, (int)(box.y + box.height)); v++) {
+      const double height = (v - box.y) / box.height;
+      const unsigned char *color = (height < 0.15) ? skin : (height < 0.55) ? clothes.shirt : clothes.pants;
+      for(int u = std::max(0, (int)box.x); u < std::min(kImageWidth, (int)(box.x + box.width)); u++)
+        for(int c = 0; c < 3; c++)
+          image_[(v * kImageWidth + u) * 3 + c] = std::max(0, std::min(255, (int)(lighting * color[c]) + noise(rng_)));
+    }
+  }
+
+  bool descriptor(const reid::Box &box, reid::Descriptor &descriptor) const {
+    return reid::compute_descriptor(image_.data(), kImageWidth, kImageHeight, kImageWidth * 3, box, descriptor);
+  }
+
+private:
+  std::mt19937 &rng_;
+  std::vector<unsigned char> background_, image_;
+};
+
+
+static Clothes random_clothes(std::mt19937 &rng) {
+  std::uniform_int_distribution<int> channel(0, 255);
+  Clothes clothes;
+  for(int c = 0; c < 3; c++) {
+    clothes.shirt[c] = channel(rng);
+    clothes.pants[c] = channel(rng);
+  }
+  return clothes;
+}
+
+
+// Descriptor of a person crop seen in a new frame: moved box, new lighting and noise
+static reid::Descriptor observe(Scene &scene, std::mt19937 &rng, const Clothes &clothes) {
+  std::uniform_real_distribution<double> position(0.0, 400.0), size(0.9, 1.1), lighting(0.85, 1.15);
+  const reid::Box box = {position(rng), 60.0, 120.0 * size(rng), 360.0 * size(rng)};
+  scene.clear();
+  scene.draw(box, clothes, lighting(rng));
+  reid::Descriptor descriptor;
+  EXPECT_TRUE(scene.descriptor(box, descriptor));
+  return descriptor;
+}
+
+
+TEST(Reid, Descriptor) {
+  std::mt19937 rng(5);
+  Scene scene(rng);
+  const Clothes red = {{200, 30, 30}, {30, 30, 30}};
+  scene.clear();
+  scene.draw({100, 50, 100, 300}, red, 1.0);
+  reid::Descriptor descriptor;
+  ASSERT_TRUE(scene.descriptor({100, 50, 100, 300}, descriptor));
+
+  double sum = 0.0;
+  for(int i = 0; i < reid::kHistogramSize; i++)
+    sum += descriptor[i];
+  EXPECT_NEAR(sum, 1.0, 1e-5);
+  // Red shirt in the first hue bins, dark pants in the darkest gray bin
+  double red_mass = 0.0;
+  for(int s = 0; s < reid::kSaturationBins; s++)
+    red_mass += descriptor[s];
+  EXPECT_GT(red_mass, 0.4);
+  EXPECT_GT(descriptor[reid::kHueBins * reid::kSaturationBins], 0.45);
+  // Stripe moments: the top stripe is the shirt, the bottom one the pants
+  EXPECT_NEAR(descriptor[reid::kHistogramSize + 0], 200.0 / 255.0, 0.03);
+  EXPECT_NEAR(descriptor[reid::kHistogramSize + 6 * (reid::kNumStripes - 1)], 30.0 / 255.0, 0.03);
+  EXPECT_LT(descriptor[reid::kHistogramSize + 3], 0.05);
+
+  EXPECT_FALSE(scene.descriptor({700, 50, 100, 300}, descriptor));
+  EXPECT_FALSE(scene.descriptor({100, 50, 1, 300}, descriptor));
+}
+
+
+TEST(Reid, DistanceSeparatesPeople) {
+  std::mt19937 rng(7);
+  Scene scene(rng);
+  std::vector<Clothes> people(20);
+  for(int i = 0; i < people.size(); i++)
+    people[i] = random_clothes(rng);
+
+  int num_same_below = 0, num_different_below = 0, num_same = 0, num_different = 0;
+  const double threshold = reid::GalleryParameters().max_appearance_distance;
+  for(int i = 0; i < people.size(); i++) {
+    const reid::Descriptor a = observe(scene, rng, people[i]);
+    for(int j = 0; j < people.size(); j++) {
+      const double distance = reid::descriptor_distance(a, observe(scene, rng, people[j]));
+      if(i == j) {
+        num_same++;
+        num_same_below += distance < threshold;
+      }
+      else {
+        num_different++;
+        num_different_below += distance < threshold;
+      }
+    }
+  }
+  std::cout << "Same person within the threshold: " << num_same_below << " / " << num_same
+            << ", different people: " << num_different_below << " / " << num_different << std::endl;
+  EXPECT_GE(num_same_below, 0.9 * num_same);
+  EXPECT_LT(num_different_below, 0.05 * num_different);
+  const reid::Descriptor a = observe(scene, rng, people[0]);
+  EXPECT_NEAR(reid::descriptor_distance(a, a), 0.0, 1e-3);
+}
+
+
+TEST(Reid, CostPerCrop) {
+  std::mt19937 rng(9);
+  Scene scene(rng);
+  scene.clear();
+  const reid::Box box = {200, 60, 160, 400};
+  scene.draw(box, random_clothes(rng), 1.0);
+  reid::Descriptor descriptor;
+  const int num_crops = 2000;
+  std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+  for(int i = 0; i < num_crops; i++)
+    scene.descriptor(box, descriptor);
+  const double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count() / num_crops;
+  std::cout << "Descriptor of a 160 x 400 crop: " << us << " us" << std::endl;
+  EXPECT_LT(us, 1000.0);
+}
+
+
+TEST(Reid, Gallery) {
+  reid::Gallery gallery;
+  reid::Descriptor a, b;
+  a.fill(0.0f);
+  b.fill(0.0f);
+  a[0] = 1.0f;
+  b[reid::kHueBins * reid::kSaturationBins] = 1.0f;
+
+  // Lost at (0, 0) walking 0.1 per frame along x, seen again 5 frames later
+  gallery.add(3, 0.0, 0.0, 0.1, 0.0, a);
+  for(int i = 0; i < 5; i++)
+    gallery.step();
+  EXPECT_EQ(gallery.match(0.5, 0.0, b), -1);      // other appearance
+  EXPECT_EQ(gallery.match(3.0, 0.0, a), -1);      // out of the gate
+  EXPECT_EQ(gallery.match(0.55, 0.05, a), 3);
+  EXPECT_EQ(gallery.size(), 0);
+
+  gallery.add(4, 0.0, 0.0, 0.0, 0.0, a);
+  for(int i = 0; i <= gallery.parameters().max_lost_frames; i++)
+    gallery.step();
+  EXPECT_EQ(gallery.size(), 0);
+}
+
+
+// AB3DMOT bookkeeping (max_age 2, min_hits 3) with a nearest neighbour association and an
+// alpha-beta filter in place of the Kalman filter, with or without the gallery
+class Tracker {
+public:
+  explicit Tracker(bool use_gallery): use_gallery_(use_gallery), next_id_(0) {}
+
+  struct Detection {
+    double x, y;
+    reid::Descriptor descriptor;
+  };
+
+  void update(const std::vector<Detection> &detections, std::vector<clear_mot::Object> &output) {
+    gallery_.step();
+    for(int i = 0; i < tracks_.size(); i++) {
+      tracks_[i].x += tracks_[i].vx;
+      tracks_[i].y += tracks_[i].vy;
+      tracks_[i].time_since_update++;
+    }
+
+    // Greedy nearest neighbour, about the circle IoU > 0.01 gate of the tracker
+    std::vector<bool> detection_used(detections.size(), false), track_used(tracks_.size(), false);
+    while(true) {
+      int best_d = -1, best_t = -1;
+      double best_distance = 0.6;
+      for(int d = 0; d < detections.size(); d++)
+        for(int t = 0; t < tracks_.size(); t++) {
+          const double distance = std::hypot(detections[d].x - tracks_[t].x, detections[d].y - tracks_[t].y);
+          if(!detection_used[d] && !track_used[t] && distance < best_distance) {
+            best_d = d;
+            best_t = t;
+            best_distance = distance;
+          }
+        }
+      if(best_d < 0)
+        break;
+      detection_used[best_d] = track_used[best_t] = true;
+      Track &track = tracks_[best_t];
+      const double ex = detections[best_d].x - track.x, ey = detections[best_d].y - track.y;
+      track.x += 0.6 * ex;
+      track.y += 0.6 * ey;
+      track.vx += 0.3 * ex;
+      track.vy += 0.3 * ey;
+      track.time_since_update = 0;
+      track.hits++;
+      for(int i = 0; i < reid::kDescriptorSize; i++)
+        track.descriptor[i] = 0.8f * track.descriptor[i] + 0.2f * detections[best_d].descriptor[i];
+    }
+
+    for(int d = 0; d < detections.size(); d++) {
+      if(detection_used[d])
+        continue;
+      Track track = {-1, detections[d].x, detections[d].y, 0.0, 0.0, 1, 0, detections[d].descriptor};
+      if(use_gallery_)
+        track.id = gallery_.match(track.x, track.y, track.descriptor);
+      if(track.id >= 0)
+        track.hits = 3;     // confirmed already
+      else
+        track.id = next_id_++;
+      tracks_.push_back(track);
+    }
+
+    output.clear();
+    int n = 0;
+    for(int i = 0; i < tracks_.size(); i++) {
+      const Track &track = tracks_[i];
+      if(track.time_since_update < 2 && track.hits >= 3)
+        output.push_back({track.id, track.x, track.y});
+      if(track.time_since_update < 2)
+        tracks_[n++] = track;
+      else if(use_gallery_ && track.hits >= 3)
+        gallery_.add(track.id, track.x, track.y, track.vx, track.vy, track.descriptor);
+    }
+    tracks_.resize(n);
+  }
+
+private:
+  struct Track {
+    long id;
+    double x, y, vx, vy;
+    int hits, time_since_update;
+    reid::Descriptor descriptor;
+  };
+
+  bool use_gallery_;
+  long next_id_;
+  std::vector<Track> tracks_;
+  reid::Gallery gallery_;
+};
+
+
+// People walking in a 10 m square at 10 Hz, each one regularly occluded for 3 to 15 frames
+TEST(Reid, OcclusionReplay) {
+  std::mt19937 rng(11);
+  Scene scene(rng);
+  std::normal_distribution<double> noise(0.0, 0.05);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  std::uniform_int_distribution<int> occlusion_length(3, 15);
+
+  struct Person {
+    double x, y, vx, vy;
+    int occluded_frames;
+    Clothes clothes;
+  };
+  const int num_people = 8, num_frames = 600;
+  std::vector<Person> people(num_people);
+  for(int i = 0; i < num_people; i++) {
+    const double heading = 2.0 * M_PI * uniform(rng), speed = 0.08 + 0.06 * uniform(rng);
+    people[i] = {10.0 * uniform(rng), 10.0 * uniform(rng), speed * std::cos(heading), speed * std::sin(heading),
+                 0, random_clothes(rng)};
+  }
+
+  Tracker baseline(false), reidentifying(true);
+  clear_mot::Evaluator baseline_evaluator, reid_evaluator;
+  for(int t = 0; t < num_frames; t++) {
+    std::vector<clear_mot::Object> ground_truth;
+    std::vector<Tracker::Detection> detections;
+    for(int i = 0; i < num_people; i++) {
+      Person &p = people[i];
+      p.x += p.vx;
+      p.y += p.vy;
+      if(p.x < 0.0 || p.x > 10.0) p.vx = -p.vx;
+      if(p.y < 0.0 || p.y > 10.0) p.vy = -p.vy;
+      ground_truth.push_back({i, p.x, p.y});
+
+      if(p.occluded_frames > 0) {
+        p.occluded_frames--;
+        continue;
+      }
+      if(uniform(rng) < 0.02) {
+        p.occluded_frames = occlusion_length(rng);
+        continue;
+      }
+      detections.push_back({p.x + noise(rng), p.y + noise(rng), observe(scene, rng, p.clothes)});
+    }
+
+    std::vector<clear_mot::Object> output;
+    baseline.update(detections, output);
+    baseline_evaluator.add_frame(ground_truth, output);
+    reidentifying.update(detections, output);
+    reid_evaluator.add_frame(ground_truth, output);
+  }
+
+  const clear_mot::Metrics b = baseline_evaluator.metrics(), r = reid_evaluator.metrics();
+  std::cout << "ID switches " << b.num_switches << " -> " << r.num_switches
+            << ", IDF1 " << b.idf1() << " -> " << r.idf1()
+            << ", MOTA " << b.mota() << " -> " << r.mota()
+            << ", track ids " << b.num_hypothesis_ids << " -> " << r.num_hypothesis_ids << std::endl;
+  EXPECT_GT(b.num_switches, 20);
+  EXPECT_LT(r.num_switches, 0.5 * b.num_switches);
+  EXPECT_GT(r.idf1(), b.idf1() + 0.1);
+  EXPECT_GE(r.mota(), b.mota());
+}
+
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -18,7 +18,7 @@ import matplotlib.pyplot as plt
 import sys
 import time
 import copy
-from CubicSpline import cubic_spline_planner
+import cubic_spline_cpp as cubic_spline_planner
 from walker_msgs.srv import pathsmoothing, pathsmoothingResponse
 
 
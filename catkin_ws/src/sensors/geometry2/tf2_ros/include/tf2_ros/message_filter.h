@@ -41,6 +41,7 @@
 #include <boost/bind.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/thread.hpp>
+#include <boost/unordered_map.hpp>
 
 #include <message_filters/connection.h>
 #include <message_filters/simple_filter.h>
@@ -285,6 +286,7 @@ public:
     callback_handle_ = bc_.addTransformableCallback(boost::bind(&MessageFilter::transformable, this, _1, _2, _3, _4, _5));
 
     messages_.clear();
+    handle_to_message_.clear();
     message_count_ = 0;
 
     // remove pending callbacks in callback queue as well
@@ -386,6 +388,7 @@ public:
         for (; it != end; ++it)
         {
           bc_.cancelTransformableRequest(*it);
+          handle_to_message_.erase(*it);
         }
 
         messageDropped(front.event, filter_failure_reasons::Unknown);
@@ -397,6 +400,15 @@ public:
       info.event = evt;
       messages_.push_back(info);
       ++message_count_;
+
+      // and map its pending requests to it, list iterators stay valid until the message is erased
+      typename L_MessageInfo::iterator msg_it = --messages_.end();
+      V_TransformableRequestHandle::const_iterator it = msg_it->handles.begin();
+      V_TransformableRequestHandle::const_iterator end = msg_it->handles.end();
+      for (; it != end; ++it)
+      {
+        handle_to_message_[*it] = msg_it;
+      }
     }
 
     TF2_ROS_MESSAGEFILTER_DEBUG("Added message in frame %s at time %.3f, count now %d", frame_id.c_str(), stamp.toSec(), message_count_);
@@ -456,35 +468,30 @@ private:
     callback_handle_ = bc_.addTransformableCallback(boost::bind(&MessageFilter::transformable, this, _1, _2, _3, _4, _5));
   }
 
-  void transformable(tf2::TransformableRequestHandle request_handle, const std::string& /* target_frame */, const std::string& /* source_frame */,
-                     ros::Time /* time */, tf2::TransformableResult result)
+  void transformable(tf2::TransformableRequestHandle request_handle, const std::string& target_frame, const std::string& /* source_frame */,
+                     ros::Time time, tf2::TransformableResult result)
   {
     namespace mt = ros::message_traits;
 
     boost::upgrade_lock< boost::shared_mutex > lock(messages_mutex_);
 
     // find the message this request is associated with
-    typename L_MessageInfo::iterator msg_it = messages_.begin();
-    typename L_MessageInfo::iterator msg_end = messages_.end();
-    for (; msg_it != msg_end; ++msg_it)
+    typename M_HandleToMessage::iterator handle_it = handle_to_message_.find(request_handle);
+    if (handle_it == handle_to_message_.end())
     {
-      MessageInfo& info = *msg_it;
-      V_TransformableRequestHandle::const_iterator handle_it = std::find(info.handles.begin(), info.handles.end(), request_handle);
-      if (handle_it != info.handles.end())
-      {
-        // found msg_it
-        ++info.success_count;
-        break;
-      }
+      return;
     }
 
-    if (msg_it == msg_end)
+    typename L_MessageInfo::iterator msg_it = handle_it->second;
+    MessageInfo& info = *msg_it;
     {
-      return;
+      boost::upgrade_to_unique_lock< boost::shared_mutex > uniqueLock(lock);
+      handle_to_message_.erase(handle_it);
+      ++info.success_count;
     }
 
-    const MessageInfo& info = *msg_it;
-    if (info.success_count < expected_success_count_)
+    // Wait for the other requests, unless this one can never be satisfied
+    if (result == tf2::TransformAvailable && info.success_count < expected_success_count_)
     {
       return;
     }
@@ -497,13 +504,15 @@ private:
     if (result == tf2::TransformAvailable)
     {
       boost::mutex::scoped_lock frames_lock(target_frames_mutex_);
-      // make sure we can still perform all the necessary transforms
+      // make sure we can still perform all the other necessary transforms, the one of this request has just been
+      // reported available
       typename V_string::iterator it = target_frames_.begin();
       typename V_string::iterator end = target_frames_.end();
       for (; it != end; ++it)
       {
         const std::string& target = *it;
-        if (!bc_.canTransform(target, frame_id, stamp))
+        const bool is_reported_target = (target == target_frame);
+        if (!(is_reported_target && time == stamp) && !bc_.canTransform(target, frame_id, stamp))
         {
           can_transform = false;
           break;
@@ -511,7 +520,9 @@ private:
 
         if (!time_tolerance_.isZero())
         {
-          if (!bc_.canTransform(target, frame_id, stamp + time_tolerance_))
+          const ros::Time tolerance_stamp = stamp + time_tolerance_;
+          if (!(is_reported_target && time == tolerance_stamp) &&
+              !bc_.canTransform(target, frame_id, tolerance_stamp))
           {
             can_transform = false;
             break;
@@ -541,6 +552,17 @@ private:
 
       TF2_ROS_MESSAGEFILTER_DEBUG("Discarding message in frame %s at time %.3f, count now %d", frame_id.c_str(), stamp.toSec(), message_count_ - 1);
       messageDropped(info.event, filter_failure_reasons::Unknown);
+
+      // the message is gone, so are the requests still waiting for it
+      V_TransformableRequestHandle::const_iterator it = info.handles.begin();
+      V_TransformableRequestHandle::const_iterator end = info.handles.end();
+      for (; it != end; ++it)
+      {
+        if (handle_to_message_.erase(*it))
+        {
+          bc_.cancelTransformableRequest(*it);
+        }
+      }
     }
 
     messages_.erase(msg_it);
@@ -684,6 +706,8 @@ private:
   };
   typedef std::list<MessageInfo> L_MessageInfo;
   L_MessageInfo messages_;
+  typedef boost::unordered_map<tf2::TransformableRequestHandle, typename L_MessageInfo::iterator> M_HandleToMessage;
+  M_HandleToMessage handle_to_message_; ///< The queued message of each pending request, so transformable() does not search the queue
   uint32_t message_count_; ///< The number of messages in the list.  Used because \<container\>.size() may have linear cost
   boost::shared_mutex messages_mutex_; ///< The mutex used for locking message list operations
   uint32_t expected_success_count_;
@@ -37,6 +37,7 @@
 #include <tf2_ros/transform_listener.h>
 
 #include <gtest/gtest.h>
+#include <iostream>
 #include <thread>
 #include <chrono>
 
@@ -118,6 +119,54 @@ TEST(tf2_ros_message_filter, multiple_frames_and_time_tolerance)
   ASSERT_TRUE(filter_callback_fired);
 }
 
+uint32_t queued_callback_count = 0;
+void queued_callback(const geometry_msgs::PointStamped::ConstPtr& msg)
+{
+  ++queued_callback_count;
+}
+
+TEST(tf2_ros_message_filter, queue_throughput)
+{
+  const uint32_t queue_sizes[] = {10, 100, 1000};
+  for (size_t i = 0; i < sizeof(queue_sizes) / sizeof(queue_sizes[0]); ++i)
+  {
+    const uint32_t queue_size = queue_sizes[i];
+    tf2::BufferCore bc;
+    tf2_ros::MessageFilter<geometry_msgs::PointStamped> filter(bc, "map", queue_size, (ros::CallbackQueueInterface*)NULL);
+    filter.registerCallback(&queued_callback);
+    queued_callback_count = 0;
+
+    geometry_msgs::TransformStamped map_to_base;
+    map_to_base.header.frame_id = "map";
+    map_to_base.child_frame_id = "base";
+    map_to_base.transform.rotation.w = 1.0;
+    map_to_base.header.stamp = ros::Time(1, 0);
+    bc.setTransform(map_to_base, "me");
+
+    // fill the queue with messages waiting for a newer transform
+    for (uint32_t j = 0; j < queue_size; ++j)
+    {
+      geometry_msgs::PointStamped::Ptr point(new geometry_msgs::PointStamped);
+      point->header.frame_id = "base";
+      point->header.stamp = ros::Time(2 + j, 0);
+      filter.add(point);
+    }
+    EXPECT_EQ(queued_callback_count, 0u);
+
+    // every transform update releases one message
+    ros::WallTime start = ros::WallTime::now();
+    for (uint32_t j = 0; j < queue_size; ++j)
+    {
+      map_to_base.header.stamp = ros::Time(2 + j, 0);
+      bc.setTransform(map_to_base, "me");
+    }
+    double seconds = (ros::WallTime::now() - start).toSec();
+
+    EXPECT_EQ(queued_callback_count, queue_size);
+    std::cout << "queue size " << queue_size << ": " << queue_size / seconds << " messages/s" << std::endl;
+  }
+}
+
 int main(int argc, char **argv){
   testing::InitGoogleTest(&argc, argv);
   ros::init(argc, argv, "tf2_ros_message_filter");
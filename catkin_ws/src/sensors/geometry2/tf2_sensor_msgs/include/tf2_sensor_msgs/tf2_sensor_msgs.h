@@ -35,6 +35,10 @@
 #include <sensor_msgs/point_cloud2_iterator.h>
 #include <Eigen/Eigen>
 #include <Eigen/Geometry>
+#include <cstring>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 namespace tf2
 {
@@ -63,18 +67,129 @@ template <>
 inline
 const std::string& getFrameId(const sensor_msgs::PointCloud2 &p) {return p.header.frame_id;}
 
+namespace impl
+{
+
+/** \brief Find the x, y and z fields of a cloud whose points can be transformed without iterators.
+ * \param cloud The cloud to inspect.
+ * \return The byte offset of x in a point if x, y and z are consecutive float32 fields and the points are evenly
+ * strided over all rows (as in the XYZ and XYZI clouds of projectLaser), -1 otherwise.
+ */
+inline
+int getPackedXYZOffset(const sensor_msgs::PointCloud2 &cloud)
+{
+  int offsets[3] = {-1, -1, -1};
+  static const char* names[3] = {"x", "y", "z"};
+  for (size_t i = 0; i < cloud.fields.size(); ++i)
+  {
+    const sensor_msgs::PointField& field = cloud.fields[i];
+    for (int j = 0; j < 3; ++j)
+    {
+      if (field.name == names[j])
+      {
+        if (field.datatype != sensor_msgs::PointField::FLOAT32 || field.count != 1)
+          return -1;
+        offsets[j] = field.offset;
+      }
+    }
+  }
+
+  const size_t num_points = static_cast<size_t>(cloud.width) * cloud.height;
+  if (offsets[0] < 0 || offsets[1] != offsets[0] + 4 || offsets[2] != offsets[0] + 8 ||
+      cloud.point_step < static_cast<uint32_t>(offsets[0] + 12) || cloud.row_step != cloud.width * cloud.point_step ||
+      cloud.data.size() < num_points * cloud.point_step)
+    return -1;
+  return offsets[0];
+}
+
+/** \brief Apply an affine transform to strided xyz float triplets.
+ * \param in Pointer to x of the first input point.
+ * \param out Pointer to x of the first output point, may be equal to in.
+ * \param num_points The number of points.
+ * \param point_step The distance between two points in bytes.
+ * \param m The rotation and translation of the transform.
+ * Only the 12 bytes of x, y and z are written, the other fields of the points are left untouched.
+ */
+inline
+void transformPackedXYZ(const uint8_t* in, uint8_t* out, size_t num_points, uint32_t point_step,
+                        const Eigen::Matrix<float, 3, 4>& m)
+{
+#ifdef __SSE2__
+  const __m128 c0 = _mm_setr_ps(m(0, 0), m(1, 0), m(2, 0), 0.0f);
+  const __m128 c1 = _mm_setr_ps(m(0, 1), m(1, 1), m(2, 1), 0.0f);
+  const __m128 c2 = _mm_setr_ps(m(0, 2), m(1, 2), m(2, 2), 0.0f);
+  const __m128 c3 = _mm_setr_ps(m(0, 3), m(1, 3), m(2, 3), 0.0f);
+  // Every point but the last is followed by at least 4 more bytes, so x, y, z can be read with one 16 byte load
+  for (; num_points > 1; --num_points, in += point_step, out += point_step)
+  {
+    const __m128 p = _mm_loadu_ps(reinterpret_cast<const float*>(in));
+    const __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, _mm_shuffle_ps(p, p, 0x00)),
+                                           _mm_mul_ps(c1, _mm_shuffle_ps(p, p, 0x55))),
+                                _mm_add_ps(_mm_mul_ps(c2, _mm_shuffle_ps(p, p, 0xaa)), c3));
+    _mm_storel_pi(reinterpret_cast<__m64*>(out), r);
+    _mm_store_ss(reinterpret_cast<float*>(out + 8), _mm_movehl_ps(r, r));
+  }
+#endif
+  for (; num_points > 0; --num_points, in += point_step, out += point_step)
+  {
+    float p[3], r[3];
+    std::memcpy(p, in, sizeof(p));
+    for (int i = 0; i < 3; ++i)
+      r[i] = m(i, 0) * p[0] + m(i, 1) * p[1] + m(i, 2) * p[2] + m(i, 3);
+    std::memcpy(out, r, sizeof(r));
+  }
+}
+
+} // namespace impl
+
 // this method needs to be implemented by client library developers
+/** \brief Transform the points of a PointCloud2 message.
+ * Clouds with consecutive float32 x, y and z fields (see impl::getPackedXYZOffset) are transformed directly on the
+ * data buffer, other layouts through PointCloud2Iterator. p_out may be p_in to transform in place, and the data
+ * buffer of p_out is reused if it is large enough.
+ * \param p_in The cloud to transform.
+ * \param p_out The transformed cloud.
+ * \param t_in The transform, with the target frame as frame_id.
+ */
 template <>
 inline
 void doTransform(const sensor_msgs::PointCloud2 &p_in, sensor_msgs::PointCloud2 &p_out, const geometry_msgs::TransformStamped& t_in)
 {
-  p_out = p_in;
-  p_out.header = t_in.header;
   Eigen::Transform<float,3,Eigen::Isometry> t = Eigen::Translation3f(t_in.transform.translation.x, t_in.transform.translation.y,
                                                                      t_in.transform.translation.z) * Eigen::Quaternion<float>(
                                                                      t_in.transform.rotation.w, t_in.transform.rotation.x,
                                                                      t_in.transform.rotation.y, t_in.transform.rotation.z);
 
+  const int xyz_offset = impl::getPackedXYZOffset(p_in);
+  if (xyz_offset >= 0)
+  {
+    if (&p_out != &p_in)
+    {
+      p_out.height = p_in.height;
+      p_out.width = p_in.width;
+      p_out.fields = p_in.fields;
+      p_out.is_bigendian = p_in.is_bigendian;
+      p_out.point_step = p_in.point_step;
+      p_out.row_step = p_in.row_step;
+      p_out.is_dense = p_in.is_dense;
+      // points with nothing but x, y, z are fully overwritten, there is nothing to copy
+      if (p_in.point_step == 12 && p_in.data.size() == static_cast<size_t>(p_in.width) * p_in.height * 12)
+        p_out.data.resize(p_in.data.size());
+      else
+        p_out.data = p_in.data;
+    }
+    p_out.header = t_in.header;
+
+    const size_t num_points = static_cast<size_t>(p_in.width) * p_in.height;
+    if (num_points > 0)
+      impl::transformPackedXYZ(&p_in.data[xyz_offset], &p_out.data[xyz_offset], num_points, p_in.point_step,
+                               t.matrix().topRows<3>());
+    return;
+  }
+
+  p_out = p_in;
+  p_out.header = t_in.header;
+
   sensor_msgs::PointCloud2ConstIterator<float> x_in(p_in, "x");
   sensor_msgs::PointCloud2ConstIterator<float> y_in(p_in, "y");
   sensor_msgs::PointCloud2ConstIterator<float> z_in(p_in, "z");
@@ -34,6 +34,8 @@
 #include <ros/ros.h>
 #include <gtest/gtest.h>
 #include <tf2_ros/buffer.h>
+#include <cmath>
+#include <iostream>
 
 tf2_ros::Buffer* tf_buffer;
 static const double EPS = 1e-3;
@@ -77,6 +79,142 @@ TEST(Tf2Sensor, PointCloud2)
   EXPECT_NEAR(*iter_z_advanced, 27, EPS);
 }
 
+// Fill x, y, z with distinct values and the other bytes with a pattern
+void fillCloud(sensor_msgs::PointCloud2& cloud)
+{
+  for (size_t i = 0; i < cloud.data.size(); ++i)
+    cloud.data[i] = i % 251;
+  sensor_msgs::PointCloud2Iterator<float> iter_x(cloud, "x");
+  sensor_msgs::PointCloud2Iterator<float> iter_y(cloud, "y");
+  sensor_msgs::PointCloud2Iterator<float> iter_z(cloud, "z");
+  for (int i = 0; iter_x != iter_x.end(); ++iter_x, ++iter_y, ++iter_z, ++i)
+  {
+    *iter_x = 0.1 * i;
+    *iter_y = -0.2 * i;
+    *iter_z = 1.0 + 0.05 * i;
+  }
+}
+
+// Check the xyz of out against the transformed xyz of in, and that every other byte is unchanged
+void expectTransformed(const sensor_msgs::PointCloud2& in, const sensor_msgs::PointCloud2& out,
+                       const geometry_msgs::TransformStamped& t)
+{
+  Eigen::Transform<float,3,Eigen::Isometry> e = Eigen::Translation3f(t.transform.translation.x, t.transform.translation.y,
+                                                                     t.transform.translation.z) * Eigen::Quaternion<float>(
+                                                                     t.transform.rotation.w, t.transform.rotation.x,
+                                                                     t.transform.rotation.y, t.transform.rotation.z);
+  EXPECT_EQ(out.header.frame_id, t.header.frame_id);
+  ASSERT_EQ(out.data.size(), in.data.size());
+  ASSERT_EQ(out.point_step, in.point_step);
+
+  sensor_msgs::PointCloud2ConstIterator<float> x_in(in, "x"), y_in(in, "y"), z_in(in, "z");
+  sensor_msgs::PointCloud2ConstIterator<float> x_out(out, "x"), y_out(out, "y"), z_out(out, "z");
+  for (; x_in != x_in.end(); ++x_in, ++y_in, ++z_in, ++x_out, ++y_out, ++z_out)
+  {
+    Eigen::Vector3f expected = e * Eigen::Vector3f(*x_in, *y_in, *z_in);
+    EXPECT_NEAR(*x_out, expected.x(), EPS);
+    EXPECT_NEAR(*y_out, expected.y(), EPS);
+    EXPECT_NEAR(*z_out, expected.z(), EPS);
+  }
+
+  std::vector<bool> is_xyz(in.point_step, false);
+  for (size_t i = 0; i < in.fields.size(); ++i)
+  {
+    if (in.fields[i].name == "x" || in.fields[i].name == "y" || in.fields[i].name == "z")
+      std::fill(is_xyz.begin() + in.fields[i].offset, is_xyz.begin() + in.fields[i].offset + 4, true);
+  }
+  for (size_t i = 0; i < in.data.size(); ++i)
+  {
+    if (!is_xyz[i % in.point_step])
+      ASSERT_EQ(out.data[i], in.data[i]) << "byte " << i;
+  }
+}
+
+TEST(Tf2Sensor, PointCloud2Layouts)
+{
+  geometry_msgs::TransformStamped t;
+  t.header.frame_id = "B";
+  t.transform.translation.x = 10;
+  t.transform.translation.y = 20;
+  t.transform.translation.z = 30;
+  t.transform.rotation.x = 0.2;
+  t.transform.rotation.y = 0.3;
+  t.transform.rotation.z = 0.1;
+  t.transform.rotation.w = std::sqrt(1.0 - 0.14);
+
+  std::vector<sensor_msgs::PointCloud2> clouds(5);
+  // xyz only, xyz + intensity as from projectLaser, and xyz padded to 16 bytes + rgb: packed
+  sensor_msgs::PointCloud2Modifier(clouds[0]).setPointCloud2Fields(3,
+      "x", 1, sensor_msgs::PointField::FLOAT32, "y", 1, sensor_msgs::PointField::FLOAT32,
+      "z", 1, sensor_msgs::PointField::FLOAT32);
+  sensor_msgs::PointCloud2Modifier(clouds[1]).setPointCloud2Fields(4,
+      "x", 1, sensor_msgs::PointField::FLOAT32, "y", 1, sensor_msgs::PointField::FLOAT32,
+      "z", 1, sensor_msgs::PointField::FLOAT32, "intensity", 1, sensor_msgs::PointField::FLOAT32);
+  sensor_msgs::PointCloud2Modifier(clouds[2]).setPointCloud2FieldsByString(2, "xyz", "rgb");
+  // xyz after another field: packed with an offset
+  sensor_msgs::PointCloud2Modifier(clouds[3]).setPointCloud2Fields(4,
+      "index", 1, sensor_msgs::PointField::INT32, "x", 1, sensor_msgs::PointField::FLOAT32,
+      "y", 1, sensor_msgs::PointField::FLOAT32, "z", 1, sensor_msgs::PointField::FLOAT32);
+  // z, y, x order: iterator fallback
+  sensor_msgs::PointCloud2Modifier(clouds[4]).setPointCloud2Fields(3,
+      "z", 1, sensor_msgs::PointField::FLOAT32, "y", 1, sensor_msgs::PointField::FLOAT32,
+      "x", 1, sensor_msgs::PointField::FLOAT32);
+
+  for (size_t i = 0; i < clouds.size(); ++i)
+  {
+    sensor_msgs::PointCloud2Modifier(clouds[i]).resize(101);
+    fillCloud(clouds[i]);
+  }
+  EXPECT_EQ(tf2::impl::getPackedXYZOffset(clouds[0]), 0);
+  EXPECT_EQ(tf2::impl::getPackedXYZOffset(clouds[1]), 0);
+  EXPECT_EQ(tf2::impl::getPackedXYZOffset(clouds[2]), 0);
+  EXPECT_EQ(tf2::impl::getPackedXYZOffset(clouds[3]), 4);
+  EXPECT_EQ(tf2::impl::getPackedXYZOffset(clouds[4]), -1);
+
+  for (size_t i = 0; i < clouds.size(); ++i)
+  {
+    // new output, reused output buffer and in place
+    sensor_msgs::PointCloud2 out;
+    tf2::doTransform(clouds[i], out, t);
+    expectTransformed(clouds[i], out, t);
+    tf2::doTransform(clouds[i], out, t);
+    expectTransformed(clouds[i], out, t);
+
+    sensor_msgs::PointCloud2 in_place = clouds[i];
+    tf2::doTransform(in_place, in_place, t);
+    expectTransformed(clouds[i], in_place, t);
+  }
+}
+
+TEST(Tf2Sensor, PointCloud2Benchmark)
+{
+  geometry_msgs::TransformStamped t;
+  t.transform.translation.x = 1;
+  t.transform.rotation.z = std::sin(0.25);
+  t.transform.rotation.w = std::cos(0.25);
+
+  const uint32_t sizes[] = {10000, 100000, 500000};
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+  {
+    sensor_msgs::PointCloud2 cloud, out;
+    sensor_msgs::PointCloud2Modifier(cloud).setPointCloud2Fields(4,
+        "x", 1, sensor_msgs::PointField::FLOAT32, "y", 1, sensor_msgs::PointField::FLOAT32,
+        "z", 1, sensor_msgs::PointField::FLOAT32, "intensity", 1, sensor_msgs::PointField::FLOAT32);
+    sensor_msgs::PointCloud2Modifier(cloud).resize(sizes[i]);
+    fillCloud(cloud);
+
+    ros::WallTime start = ros::WallTime::now();
+    tf2::doTransform(cloud, out, t);
+    ros::WallDuration copy = ros::WallTime::now() - start;
+    start = ros::WallTime::now();
+    tf2::doTransform(cloud, cloud, t);
+    ros::WallDuration in_place = ros::WallTime::now() - start;
+
+    std::cout << sizes[i] << " points: " << copy.toSec() * 1e3 << " ms, in place " << in_place.toSec() * 1e3
+              << " ms" << std::endl;
+  }
+}
+
 int main(int argc, char **argv){
   testing::InitGoogleTest(&argc, argv);
   ros::init(argc, argv, "test");
@@ -241,6 +241,35 @@ CvImageConstPtr toCvShare(const sensor_msgs::Image& source,
                           const boost::shared_ptr<void const>& tracked_object,
                           const std::string& encoding = std::string());
 
+/**
+ * \brief Convert an immutable sensor_msgs::Image message to an OpenCV-compatible CvImage, sharing
+ * the image data if possible and converting it straight into \a buffer otherwise.
+ *
+ * If the source encoding and desired encoding are the same, this is the same as toCvShare().
+ * Otherwise the conversion reads the message data directly, without copying it first, and writes
+ * the result into \a buffer. If \a buffer already has the size and type of the converted image
+ * its memory is reused, so converting a stream of images with the same buffer does not allocate.
+ * rgb8 <-> bgr8 and rgba8 <-> bgra8 are done with a SIMD channel shuffle.
+ *
+ * The returned CvImage shares the data of \a buffer, which must not be modified (or reused for
+ * another conversion) while the returned image is in use.
+ *
+ * \param source   A shared_ptr to a sensor_msgs::Image message
+ * \param encoding The desired encoding of the image data, see toCvCopy()
+ * \param buffer   Destination of the converted image data
+ */
+CvImageConstPtr toCvShareOrConvert(const sensor_msgs::ImageConstPtr& source,
+                                   const std::string& encoding,
+                                   cv::Mat& buffer);
+
+/**
+ * \brief Same as above, sharing ownership with \a tracked_object when the data is shared.
+ */
+CvImageConstPtr toCvShareOrConvert(const sensor_msgs::Image& source,
+                                   const boost::shared_ptr<void const>& tracked_object,
+                                   const std::string& encoding,
+                                   cv::Mat& buffer);
+
 /**
  * \brief Convert a CvImage to another encoding using the same rules as toCvCopy
  */
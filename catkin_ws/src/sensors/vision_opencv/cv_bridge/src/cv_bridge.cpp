@@ -40,6 +40,7 @@
 #include <boost/make_shared.hpp>
 #include <boost/regex.hpp>
 
+#include <opencv2/core/hal/intrin.hpp>
 #include <opencv2/imgcodecs.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
 
@@ -278,7 +279,8 @@ cv::Mat matFromImage(const sensor_msgs::Image& source)
   // Otherwise, reinterpret the data as bytes and switch the channels accordingly
   mat = cv::Mat(source.height, source.width, CV_MAKETYPE(CV_8U, num_channels*byte_depth),
                 const_cast<uchar*>(&source.data[0]), source.step);
-  cv::Mat mat_swap(source.height, source.width, mat.type());
+  cv::Mat mat_swap(source.height, source.width, source_type);
+  cv::Mat mat_swap_bytes(source.height, source.width, mat.type(), mat_swap.data, mat_swap.step);
 
   std::vector<int> fromTo;
   fromTo.reserve(num_channels*byte_depth);
@@ -288,14 +290,103 @@ cv::Mat matFromImage(const sensor_msgs::Image& source)
       fromTo.push_back(byte_depth*i + j);
       fromTo.push_back(byte_depth*i + byte_depth - 1 - j);
     }
-  cv::mixChannels(std::vector<cv::Mat>(1, mat), std::vector<cv::Mat>(1, mat_swap), fromTo);
-
-  // Interpret mat_swap back as the proper type
-  mat_swap.reshape(num_channels);
+  cv::mixChannels(std::vector<cv::Mat>(1, mat), std::vector<cv::Mat>(1, mat_swap_bytes), fromTo);
 
+  // mat_swap already has the proper type, mat_swap_bytes is a byte view of its data
   return mat_swap;
 }
 
+// Swap the first and third channels of a row of 8 bit RGB(A) pixels, in place if src == dst
+static void swapRedBlue8u(const uchar* src, uchar* dst, int width, int num_channels)
+{
+  int x = 0;
+#if CV_SIMD128
+  if (num_channels == 3) {
+    for (; x <= width - 16; x += 16) {
+      cv::v_uint8x16 c0, c1, c2;
+      cv::v_load_deinterleave(src + 3*x, c0, c1, c2);
+      cv::v_store_interleave(dst + 3*x, c2, c1, c0);
+    }
+  }
+  else {
+    for (; x <= width - 16; x += 16) {
+      cv::v_uint8x16 c0, c1, c2, c3;
+      cv::v_load_deinterleave(src + 4*x, c0, c1, c2, c3);
+      cv::v_store_interleave(dst + 4*x, c2, c1, c0, c3);
+    }
+  }
+#endif
+  for (; x < width; ++x) {
+    const uchar* s = src + num_channels*x;
+    uchar* d = dst + num_channels*x;
+    uchar c0 = s[0];
+    d[0] = s[2];
+    d[1] = s[1];
+    d[2] = c0;
+    if (num_channels == 4)
+      d[3] = s[3];
+  }
+}
+
+// rgb8 <-> bgr8 and rgba8 <-> bgra8 only reorder bytes, do them with a channel shuffle
+// instead of the generic cvtColor. Returns false if the conversion is not a swizzle.
+static bool swizzleChannels(const cv::Mat& source, cv::Mat& dst, int conversion_code)
+{
+  int num_channels;
+  if ((conversion_code == cv::COLOR_RGB2BGR || conversion_code == cv::COLOR_BGR2RGB) &&
+      source.type() == CV_8UC3)
+    num_channels = 3;
+  else if ((conversion_code == cv::COLOR_RGBA2BGRA || conversion_code == cv::COLOR_BGRA2RGBA) &&
+           source.type() == CV_8UC4)
+    num_channels = 4;
+  else
+    return false;
+
+  dst.create(source.size(), source.type());
+  for (int y = 0; y < source.rows; ++y)
+    swapRedBlue8u(source.ptr<uchar>(y), dst.ptr<uchar>(y), source.cols, num_channels);
+  return true;
+}
+
+// Internal, converts the source data to dst_encoding. The source is read directly (never
+// copied first) and the last conversion step writes into dst, reusing its buffer if it
+// already has the right size and type. Only multi-step conversions use a temporary image.
+void convertImage(const cv::Mat& source,
+                  const std::string& src_encoding,
+                  const std::string& dst_encoding,
+                  cv::Mat& dst)
+{
+  const std::vector<int> conversion_codes = getConversionCode(src_encoding, dst_encoding);
+  cv::Mat image1 = source;
+  for(size_t i=0; i<conversion_codes.size(); ++i) {
+    int conversion_code = conversion_codes[i];
+    cv::Mat image2 = (i + 1 == conversion_codes.size()) ? dst : cv::Mat();
+    if (conversion_code == SAME_FORMAT)
+    {
+      // Same number of channels, but different bit depth
+      int src_depth = enc::bitDepth(src_encoding);
+      int dst_depth = enc::bitDepth(dst_encoding);
+      // Keep the number of channels for now but changed to the final depth
+      int image2_type = CV_MAKETYPE(CV_MAT_DEPTH(getCvType(dst_encoding)), image1.channels());
+
+      // Do scaling between CV_8U [0,255] and CV_16U [0,65535] images.
+      if (src_depth == 8 && dst_depth == 16)
+        image1.convertTo(image2, image2_type, 65535. / 255.);
+      else if (src_depth == 16 && dst_depth == 8)
+        image1.convertTo(image2, image2_type, 255. / 65535.);
+      else
+        image1.convertTo(image2, image2_type);
+    }
+    else if (!swizzleChannels(image1, image2, conversion_code))
+    {
+      // Perform color conversion
+      cv::cvtColor(image1, image2, conversion_code);
+    }
+    image1 = image2;
+  }
+  dst = image1;
+}
+
 // Internal, used by toCvCopy and cvtColor
 CvImagePtr toCvCopyImpl(const cv::Mat& source,
                         const std_msgs::Header& src_header,
@@ -315,35 +406,7 @@ CvImagePtr toCvCopyImpl(const cv::Mat& source,
   else
   {
     // Convert the source data to the desired encoding
-    const std::vector<int> conversion_codes = getConversionCode(src_encoding, dst_encoding);
-    cv::Mat image1 = source;
-    cv::Mat image2;
-    for(size_t i=0; i<conversion_codes.size(); ++i) {
-      int conversion_code = conversion_codes[i];
-      if (conversion_code == SAME_FORMAT)
-      {
-        // Same number of channels, but different bit depth
-        int src_depth = enc::bitDepth(src_encoding);
-        int dst_depth = enc::bitDepth(dst_encoding);
-        // Keep the number of channels for now but changed to the final depth
-        int image2_type = CV_MAKETYPE(CV_MAT_DEPTH(getCvType(dst_encoding)), image1.channels());
-
-        // Do scaling between CV_8U [0,255] and CV_16U [0,65535] images.
-        if (src_depth == 8 && dst_depth == 16)
-          image1.convertTo(image2, image2_type, 65535. / 255.);
-        else if (src_depth == 16 && dst_depth == 8)
-          image1.convertTo(image2, image2_type, 255. / 65535.);
-        else
-          image1.convertTo(image2, image2_type);
-      }
-      else
-      {
-        // Perform color conversion
-        cv::cvtColor(image1, image2, conversion_code);
-      }
-      image1 = image2;
-    }
-    ptr->image = image2;
+    convertImage(source, src_encoding, dst_encoding, ptr->image);
     ptr->encoding = dst_encoding;
   }
 
@@ -399,7 +462,15 @@ CvImagePtr toCvCopy(const sensor_msgs::Image& source,
                     const std::string& encoding)
 {
   // Construct matrix pointing to source data
-  return toCvCopyImpl(matFromImage(source), source.header, source.encoding, encoding);
+  cv::Mat mat = matFromImage(source);
+  if ((encoding.empty() || encoding == source.encoding) && !source.data.empty() &&
+      mat.data != &source.data[0])
+  {
+    // The endianness was swapped into a new buffer, which can be handed over as is
+    CvImagePtr ptr = boost::make_shared<CvImage>(source.header, source.encoding, mat);
+    return ptr;
+  }
+  return toCvCopyImpl(mat, source.header, source.encoding, encoding);
 }
 
 // Share const data, returnee is immutable
@@ -426,6 +497,30 @@ CvImageConstPtr toCvShare(const sensor_msgs::Image& source,
   return ptr;
 }
 
+CvImageConstPtr toCvShareOrConvert(const sensor_msgs::ImageConstPtr& source,
+                                   const std::string& encoding,
+                                   cv::Mat& buffer)
+{
+  return toCvShareOrConvert(*source, source, encoding, buffer);
+}
+
+CvImageConstPtr toCvShareOrConvert(const sensor_msgs::Image& source,
+                                   const boost::shared_ptr<void const>& tracked_object,
+                                   const std::string& encoding,
+                                   cv::Mat& buffer)
+{
+  // Nothing to convert, share the message data (or take the byte-swapped copy)
+  if (encoding.empty() || source.encoding == encoding)
+    return toCvShare(source, tracked_object, encoding);
+
+  CvImagePtr ptr = boost::make_shared<CvImage>();
+  ptr->header = source.header;
+  ptr->encoding = encoding;
+  convertImage(matFromImage(source), source.encoding, encoding, buffer);
+  ptr->image = buffer;
+  return ptr;
+}
+
 CvImagePtr cvtColor(const CvImageConstPtr& source,
                     const std::string& encoding)
 {
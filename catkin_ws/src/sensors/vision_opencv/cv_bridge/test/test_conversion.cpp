@@ -0,0 +1,102 @@
+#include <boost/make_shared.hpp>
+#include <cv_bridge/cv_bridge.h>
+#include <sensor_msgs/image_encodings.h>
+#include <gtest/gtest.h>
+
+namespace enc = sensor_msgs::image_encodings;
+
+// Widths which are not multiples of the SIMD block size, to go through the scalar tail too
+static const int kWidths[] = {1, 15, 16, 17, 33, 640};
+
+static sensor_msgs::ImagePtr randomImage(int width, int height, const std::string& encoding)
+{
+  cv::Mat mat(height, width, cv_bridge::getCvType(encoding));
+  cv::randu(mat, cv::Scalar::all(0), cv::Scalar::all(255));
+  return cv_bridge::CvImage(std_msgs::Header(), encoding, mat).toImageMsg();
+}
+
+TEST(CvBridgeTest, swizzleMatchesCvtColor)
+{
+  const char* conversions[][2] = {{"rgb8", "bgr8"}, {"bgr8", "rgb8"},
+                                  {"rgba8", "bgra8"}, {"bgra8", "rgba8"}};
+  const int codes[] = {cv::COLOR_RGB2BGR, cv::COLOR_BGR2RGB, cv::COLOR_RGBA2BGRA, cv::COLOR_BGRA2RGBA};
+  for (size_t c = 0; c < 4; ++c) {
+    for (size_t w = 0; w < sizeof(kWidths) / sizeof(kWidths[0]); ++w) {
+      sensor_msgs::ImagePtr msg = randomImage(kWidths[w], 3, conversions[c][0]);
+      cv_bridge::CvImageConstPtr src = cv_bridge::toCvShare(msg);
+      cv::Mat expected;
+      cv::cvtColor(src->image, expected, codes[c]);
+
+      cv_bridge::CvImagePtr copy = cv_bridge::toCvCopy(msg, conversions[c][1]);
+      EXPECT_EQ(copy->encoding, conversions[c][1]);
+      ASSERT_EQ(copy->image.type(), expected.type());
+      EXPECT_EQ(cv::norm(copy->image, expected, cv::NORM_INF), 0) << conversions[c][0] << " width " << kWidths[w];
+    }
+  }
+}
+
+TEST(CvBridgeTest, toCvShareOrConvert)
+{
+  sensor_msgs::ImagePtr msg = randomImage(37, 21, enc::RGB8);
+  cv::Mat buffer;
+
+  // Same encoding: the message data is shared and the buffer is untouched
+  cv_bridge::CvImageConstPtr shared = cv_bridge::toCvShareOrConvert(msg, enc::RGB8, buffer);
+  EXPECT_EQ(shared->image.data, &msg->data[0]);
+  EXPECT_TRUE(buffer.empty());
+
+  // Different encoding: converted into the buffer
+  cv_bridge::CvImageConstPtr converted = cv_bridge::toCvShareOrConvert(msg, enc::BGR8, buffer);
+  EXPECT_EQ(converted->encoding, enc::BGR8);
+  EXPECT_EQ(converted->image.data, buffer.data);
+  cv::Mat expected;
+  cv::cvtColor(shared->image, expected, cv::COLOR_RGB2BGR);
+  EXPECT_EQ(cv::norm(converted->image, expected, cv::NORM_INF), 0);
+
+  // Same result as toCvCopy
+  cv_bridge::CvImagePtr copy = cv_bridge::toCvCopy(msg, enc::BGR8);
+  EXPECT_EQ(cv::norm(converted->image, copy->image, cv::NORM_INF), 0);
+
+  // A buffer of the right size and type is reused
+  const uchar* data = buffer.data;
+  converted.reset();
+  converted = cv_bridge::toCvShareOrConvert(msg, enc::BGR8, buffer);
+  EXPECT_EQ(buffer.data, data);
+  EXPECT_EQ(converted->image.data, data);
+
+  // Multi-step and non-swizzle conversions go through the same path
+  const char* encodings[] = {"mono8", "bgra8", "rgb16", "mono16"};
+  for (size_t i = 0; i < 4; ++i) {
+    cv::Mat other;
+    converted = cv_bridge::toCvShareOrConvert(msg, encodings[i], other);
+    copy = cv_bridge::toCvCopy(msg, encodings[i]);
+    EXPECT_EQ(converted->encoding, encodings[i]);
+    ASSERT_EQ(converted->image.type(), copy->image.type());
+    EXPECT_EQ(converted->image.data, other.data);
+    EXPECT_EQ(cv::norm(converted->image, copy->image, cv::NORM_INF), 0) << encodings[i];
+  }
+}
+
+TEST(CvBridgeTest, yuv422ToCvShareOrConvert)
+{
+  sensor_msgs::ImagePtr msg = randomImage(64, 8, enc::YUV422);
+  cv::Mat buffer;
+  cv_bridge::CvImageConstPtr converted = cv_bridge::toCvShareOrConvert(msg, enc::BGR8, buffer);
+  cv::Mat expected;
+  cv::cvtColor(cv_bridge::toCvShare(msg)->image, expected, cv::COLOR_YUV2BGR_UYVY);
+  ASSERT_EQ(converted->image.type(), CV_8UC3);
+  EXPECT_EQ(cv::norm(converted->image, expected, cv::NORM_INF), 0);
+}
+
+TEST(CvBridgeTest, cvtColorSwizzleNonContinuous)
+{
+  // cvtColor on a CvImage whose data is a sub-matrix
+  cv::Mat full(10, 40, CV_8UC3);
+  cv::randu(full, cv::Scalar::all(0), cv::Scalar::all(255));
+  cv_bridge::CvImagePtr src = boost::make_shared<cv_bridge::CvImage>(std_msgs::Header(), enc::BGR8,
+                                                                     full.colRange(3, 30));
+  cv_bridge::CvImagePtr dst = cv_bridge::cvtColor(src, enc::RGB8);
+  cv::Mat expected;
+  cv::cvtColor(src->image, expected, cv::COLOR_BGR2RGB);
+  EXPECT_EQ(cv::norm(dst->image, expected, cv::NORM_INF), 0);
+}
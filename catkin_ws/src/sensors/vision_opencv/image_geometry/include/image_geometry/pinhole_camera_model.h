@@ -7,6 +7,7 @@
 #include <opencv2/calib3d/calib3d.hpp>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 namespace image_geometry {
 
@@ -95,6 +96,17 @@ public:
    */
   cv::Point2d project3dToPixel(const cv::Point3d& xyz) const;
 
+  /**
+   * \brief Project many 3d points to rectified pixel coordinates.
+   *
+   * Same as calling project3dToPixel() on each point.
+   *
+   * \param xyz 3d points in the camera coordinate frame
+   * \param uv_rect Output (u,v) in rectified pixel coordinates, resized to xyz.size()
+   */
+  void project3dToPixels(const std::vector<cv::Point3d>& xyz,
+                         std::vector<cv::Point2d>& uv_rect) const;
+
   /**
    * \brief Project a rectified pixel to a 3d ray.
    *
@@ -116,6 +128,10 @@ public:
 
   /**
    * \brief Apply camera distortion to a rectified image.
+   *
+   * The inverse maps (raw->rectified) are built on the first call and cached
+   * until the calibration, binning or ROI changes. Raw pixels which fall
+   * outside the rectified image are left black (NaN for floating point images).
    */
   void unrectifyImage(const cv::Mat& rectified, cv::Mat& raw,
                       int interpolation = cv::INTER_LINEAR) const;
@@ -130,6 +146,23 @@ public:
    */
   cv::Point2d unrectifyPoint(const cv::Point2d& uv_rect) const;
 
+  /**
+   * \brief Compute the rectified image coordinates of many pixels in the raw image.
+   *
+   * Same as rectifyPoint() on each pixel, but with a single undistortion pass
+   * and in double precision.
+   */
+  void rectifyPoints(const std::vector<cv::Point2d>& uv_raw,
+                     std::vector<cv::Point2d>& uv_rect) const;
+
+  /**
+   * \brief Compute the raw image coordinates of many pixels in the rectified image.
+   *
+   * Same as unrectifyPoint() on each pixel, but with a single projection pass.
+   */
+  void unrectifyPoints(const std::vector<cv::Point2d>& uv_rect,
+                       std::vector<cv::Point2d>& uv_raw) const;
+
   /**
    * \brief Compute the rectified ROI best fitting a raw ROI.
    */
@@ -277,7 +310,10 @@ protected:
   std::shared_ptr<Cache> cache_; // Holds cached data for internal use
 #endif
 
+  // Resolution and camera matrices of the full image with binning applied
+  void binnedCamera(cv::Size& binned_resolution, cv::Matx33d& K_binned, cv::Matx34d& P_binned) const;
   void initRectificationMaps() const;
+  void initUnrectificationMaps() const;
 
   friend class StereoCameraModel;
 };
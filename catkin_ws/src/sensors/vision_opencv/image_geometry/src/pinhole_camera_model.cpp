@@ -23,10 +23,19 @@ struct PinholeCameraModel::Cache
   mutable bool rectified_roi_dirty;
   mutable cv::Rect rectified_roi;
 
+  // Inverse maps (raw->rectified) for unrectifyImage
+  mutable bool full_inverse_maps_dirty;
+  mutable cv::Mat full_inverse_map1, full_inverse_map2;
+
+  mutable bool reduced_inverse_maps_dirty;
+  mutable cv::Mat reduced_inverse_map1, reduced_inverse_map2;
+
   Cache()
     : full_maps_dirty(true),
       reduced_maps_dirty(true),
-      rectified_roi_dirty(true)
+      rectified_roi_dirty(true),
+      full_inverse_maps_dirty(true),
+      reduced_inverse_maps_dirty(true)
   {
   }
 };
@@ -129,6 +138,9 @@ bool PinholeCameraModel::fromCameraInfo(const sensor_msgs::CameraInfo& msg)
   reduced_dirty |= update(roi.do_rectify, cam_info_.roi.do_rectify);
   // As is the rectified ROI
   cache_->rectified_roi_dirty = reduced_dirty;
+  // And the inverse maps, which are only built on demand by unrectifyImage
+  cache_->full_inverse_maps_dirty |= full_dirty;
+  cache_->reduced_inverse_maps_dirty |= reduced_dirty;
 
   // Figure out how to handle the distortion
   if (cam_info_.distortion_model == sensor_msgs::distortion_models::PLUMB_BOB ||
@@ -279,6 +291,19 @@ cv::Point2d PinholeCameraModel::project3dToPixel(const cv::Point3d& xyz) const
   return uv_rect;
 }
 
+void PinholeCameraModel::project3dToPixels(const std::vector<cv::Point3d>& xyz,
+                                           std::vector<cv::Point2d>& uv_rect) const
+{
+  assert( initialized() );
+  assert(P_(2, 3) == 0.0); // Calibrated stereo cameras should be in the same plane
+
+  uv_rect.resize(xyz.size());
+  for (size_t i = 0; i < xyz.size(); ++i) {
+    uv_rect[i].x = (fx()*xyz[i].x + Tx()) / xyz[i].z + cx();
+    uv_rect[i].y = (fy()*xyz[i].y + Ty()) / xyz[i].z + cy();
+  }
+}
+
 cv::Point3d PinholeCameraModel::projectPixelTo3dRay(const cv::Point2d& uv_rect) const
 {
   assert( initialized() );
@@ -318,14 +343,24 @@ void PinholeCameraModel::unrectifyImage(const cv::Mat& rectified, cv::Mat& raw,
 {
   assert( initialized() );
 
-  throw Exception("PinholeCameraModel::unrectifyImage is unimplemented.");
-  /// @todo Implement unrectifyImage()
-  // Similar to rectifyImage, but need to build separate set of inverse maps (raw->rectified)...
-  // - Build src_pt Mat with all the raw pixel coordinates (or do it one row at a time)
-  // - Do cv::undistortPoints(src_pt, dst_pt, K_, D_, R_, P_)
-  // - Use convertMaps() to convert dst_pt to fast fixed-point maps
-  // - cv::remap(rectified, raw, ...)
-  // Need interpolation argument. Same caching behavior?
+  switch (cache_->distortion_state) {
+    case NONE:
+      rectified.copyTo(raw);
+      break;
+    case CALIBRATED:
+      initUnrectificationMaps();
+      if (rectified.depth() == CV_32F || rectified.depth() == CV_64F)
+      {
+        cv::remap(rectified, raw, cache_->reduced_inverse_map1, cache_->reduced_inverse_map2, interpolation, cv::BORDER_CONSTANT, std::numeric_limits<float>::quiet_NaN());
+      }
+      else {
+        cv::remap(rectified, raw, cache_->reduced_inverse_map1, cache_->reduced_inverse_map2, interpolation);
+      }
+      break;
+    default:
+      assert(cache_->distortion_state == UNKNOWN);
+      throw Exception("Cannot call unrectifyImage when distortion is unknown.");
+  }
 }
 
 cv::Point2d PinholeCameraModel::rectifyPoint(const cv::Point2d& uv_raw) const
@@ -368,18 +403,70 @@ cv::Point2d PinholeCameraModel::unrectifyPoint(const cv::Point2d& uv_rect) const
   return image_point[0];
 }
 
+void PinholeCameraModel::rectifyPoints(const std::vector<cv::Point2d>& uv_raw,
+                                       std::vector<cv::Point2d>& uv_rect) const
+{
+  assert( initialized() );
+
+  if (cache_->distortion_state == NONE) {
+    uv_rect = uv_raw;
+    return;
+  }
+  if (cache_->distortion_state == UNKNOWN)
+    throw Exception("Cannot call rectifyPoints when distortion is unknown.");
+  assert(cache_->distortion_state == CALIBRATED);
+
+  if (uv_raw.empty()) {
+    uv_rect.clear();
+    return;
+  }
+  // cv::undistortPoints accepts CV_64FC2 point arrays, no float round trip needed
+  cv::undistortPoints(uv_raw, uv_rect, K_, D_, R_, P_);
+}
+
+void PinholeCameraModel::unrectifyPoints(const std::vector<cv::Point2d>& uv_rect,
+                                         std::vector<cv::Point2d>& uv_raw) const
+{
+  assert( initialized() );
+
+  if (cache_->distortion_state == NONE) {
+    uv_raw = uv_rect;
+    return;
+  }
+  if (cache_->distortion_state == UNKNOWN)
+    throw Exception("Cannot call unrectifyPoints when distortion is unknown.");
+  assert(cache_->distortion_state == CALIBRATED);
+
+  if (uv_rect.empty()) {
+    uv_raw.clear();
+    return;
+  }
+
+  // Convert to rays
+  std::vector<cv::Point3d> rays(uv_rect.size());
+  for (size_t i = 0; i < uv_rect.size(); ++i)
+    rays[i] = projectPixelTo3dRay(uv_rect[i]);
+
+  // Project all the rays on the image at once
+  cv::Mat r_vec, t_vec = cv::Mat_<double>::zeros(3, 1);
+  cv::Rodrigues(R_.t(), r_vec);
+  cv::projectPoints(rays, r_vec, t_vec, K_, D_, uv_raw);
+}
+
 cv::Rect PinholeCameraModel::rectifyRoi(const cv::Rect& roi_raw) const
 {
   assert( initialized() );
 
   /// @todo Actually implement "best fit" as described by REP 104.
   
-  // For now, just unrectify the four corners and take the bounding box.
-  cv::Point2d rect_tl = rectifyPoint(cv::Point2d(roi_raw.x, roi_raw.y));
-  cv::Point2d rect_tr = rectifyPoint(cv::Point2d(roi_raw.x + roi_raw.width, roi_raw.y));
-  cv::Point2d rect_br = rectifyPoint(cv::Point2d(roi_raw.x + roi_raw.width,
-                                                 roi_raw.y + roi_raw.height));
-  cv::Point2d rect_bl = rectifyPoint(cv::Point2d(roi_raw.x, roi_raw.y + roi_raw.height));
+  // For now, just rectify the four corners and take the bounding box.
+  std::vector<cv::Point2d> corners(4), rect;
+  corners[0] = cv::Point2d(roi_raw.x, roi_raw.y);
+  corners[1] = cv::Point2d(roi_raw.x + roi_raw.width, roi_raw.y);
+  corners[2] = cv::Point2d(roi_raw.x + roi_raw.width, roi_raw.y + roi_raw.height);
+  corners[3] = cv::Point2d(roi_raw.x, roi_raw.y + roi_raw.height);
+  rectifyPoints(corners, rect);
+  const cv::Point2d &rect_tl = rect[0], &rect_tr = rect[1], &rect_br = rect[2], &rect_bl = rect[3];
 
   cv::Point roi_tl(std::ceil (std::min(rect_tl.x, rect_bl.x)),
                    std::ceil (std::min(rect_tl.y, rect_tr.y)));
@@ -396,11 +483,13 @@ cv::Rect PinholeCameraModel::unrectifyRoi(const cv::Rect& roi_rect) const
   /// @todo Actually implement "best fit" as described by REP 104.
   
   // For now, just unrectify the four corners and take the bounding box.
-  cv::Point2d raw_tl = unrectifyPoint(cv::Point2d(roi_rect.x, roi_rect.y));
-  cv::Point2d raw_tr = unrectifyPoint(cv::Point2d(roi_rect.x + roi_rect.width, roi_rect.y));
-  cv::Point2d raw_br = unrectifyPoint(cv::Point2d(roi_rect.x + roi_rect.width,
-                                                  roi_rect.y + roi_rect.height));
-  cv::Point2d raw_bl = unrectifyPoint(cv::Point2d(roi_rect.x, roi_rect.y + roi_rect.height));
+  std::vector<cv::Point2d> corners(4), raw;
+  corners[0] = cv::Point2d(roi_rect.x, roi_rect.y);
+  corners[1] = cv::Point2d(roi_rect.x + roi_rect.width, roi_rect.y);
+  corners[2] = cv::Point2d(roi_rect.x + roi_rect.width, roi_rect.y + roi_rect.height);
+  corners[3] = cv::Point2d(roi_rect.x, roi_rect.y + roi_rect.height);
+  unrectifyPoints(corners, raw);
+  const cv::Point2d &raw_tl = raw[0], &raw_tr = raw[1], &raw_br = raw[2], &raw_bl = raw[3];
 
   cv::Point roi_tl(std::floor(std::min(raw_tl.x, raw_bl.x)),
                    std::floor(std::min(raw_tl.y, raw_tr.y)));
@@ -410,6 +499,33 @@ cv::Rect PinholeCameraModel::unrectifyRoi(const cv::Rect& roi_rect) const
   return cv::Rect(roi_tl.x, roi_tl.y, roi_br.x - roi_tl.x, roi_br.y - roi_tl.y);
 }
 
+void PinholeCameraModel::binnedCamera(cv::Size& binned_resolution, cv::Matx33d& K_binned,
+                                      cv::Matx34d& P_binned) const
+{
+  binned_resolution = fullResolution();
+  binned_resolution.width  /= binningX();
+  binned_resolution.height /= binningY();
+
+  K_binned = K_full_;
+  P_binned = P_full_;
+  if (binningX() > 1) {
+    double scale_x = 1.0 / binningX();
+    K_binned(0,0) *= scale_x;
+    K_binned(0,2) *= scale_x;
+    P_binned(0,0) *= scale_x;
+    P_binned(0,2) *= scale_x;
+    P_binned(0,3) *= scale_x;
+  }
+  if (binningY() > 1) {
+    double scale_y = 1.0 / binningY();
+    K_binned(1,1) *= scale_y;
+    K_binned(1,2) *= scale_y;
+    P_binned(1,1) *= scale_y;
+    P_binned(1,2) *= scale_y;
+    P_binned(1,3) *= scale_y;
+  }
+}
+
 void PinholeCameraModel::initRectificationMaps() const
 {
   /// @todo For large binning settings, can drop extra rows/cols at bottom/right boundary.
@@ -418,37 +534,11 @@ void PinholeCameraModel::initRectificationMaps() const
   if (cache_->full_maps_dirty) {
     // Create the full-size map at the binned resolution
     /// @todo Should binned resolution, K, P be part of public API?
-    cv::Size binned_resolution = fullResolution();
-    binned_resolution.width  /= binningX();
-    binned_resolution.height /= binningY();
-
+    cv::Size binned_resolution;
     cv::Matx33d K_binned;
     cv::Matx34d P_binned;
-    if (binningX() == 1 && binningY() == 1) {
-      K_binned = K_full_;
-      P_binned = P_full_;
-    }
-    else {
-      K_binned = K_full_;
-      P_binned = P_full_;
-      if (binningX() > 1) {
-        double scale_x = 1.0 / binningX();
-        K_binned(0,0) *= scale_x;
-        K_binned(0,2) *= scale_x;
-        P_binned(0,0) *= scale_x;
-        P_binned(0,2) *= scale_x;
-        P_binned(0,3) *= scale_x;
-      }
-      if (binningY() > 1) {
-        double scale_y = 1.0 / binningY();
-        K_binned(1,1) *= scale_y;
-        K_binned(1,2) *= scale_y;
-        P_binned(1,1) *= scale_y;
-        P_binned(1,2) *= scale_y;
-        P_binned(1,3) *= scale_y;
-      }
-    }
-    
+    binnedCamera(binned_resolution, K_binned, P_binned);
+
     // Note: m1type=CV_16SC2 to use fast fixed-point maps (see cv::remap)
     cv::initUndistortRectifyMap(K_binned, D_, R_, P_binned, binned_resolution,
                                 CV_16SC2, cache_->full_map1, cache_->full_map2);
@@ -481,4 +571,52 @@ void PinholeCameraModel::initRectificationMaps() const
   }
 }
 
+void PinholeCameraModel::initUnrectificationMaps() const
+{
+  if (cache_->full_inverse_maps_dirty) {
+    cv::Size binned_resolution;
+    cv::Matx33d K_binned;
+    cv::Matx34d P_binned;
+    binnedCamera(binned_resolution, K_binned, P_binned);
+
+    // Rectified coordinates of every raw pixel, one row at a time to bound
+    // the temporary memory. cv::undistortPoints iterates per point, so this
+    // is slower than initUndistortRectifyMap but only done once.
+    cv::Mat_<cv::Point2f> map(binned_resolution);
+    // raw_row has the same 1xW shape as a map row, so undistortPoints writes in place
+    cv::Mat_<cv::Point2f> raw_row(1, binned_resolution.width);
+    for (int v = 0; v < binned_resolution.height; ++v) {
+      for (int u = 0; u < binned_resolution.width; ++u)
+        raw_row(0, u) = cv::Point2f(u, v);
+      cv::Mat rect_row = map.row(v);
+      cv::undistortPoints(raw_row, rect_row, K_binned, D_, R_, P_binned);
+    }
+
+    // Convert to fast fixed-point maps, as initRectificationMaps does
+    cv::convertMaps(map, cv::Mat(), cache_->full_inverse_map1, cache_->full_inverse_map2, CV_16SC2);
+    cache_->full_inverse_maps_dirty = false;
+  }
+
+  if (cache_->reduced_inverse_maps_dirty) {
+    /// @todo Use rectified ROI, same as initRectificationMaps
+    cv::Rect roi(cam_info_.roi.x_offset, cam_info_.roi.y_offset,
+                 cam_info_.roi.width, cam_info_.roi.height);
+    if (roi.x != 0 || roi.y != 0 ||
+        roi.height != (int)cam_info_.height ||
+        roi.width  != (int)cam_info_.width) {
+      roi.x /= binningX();
+      roi.y /= binningY();
+      roi.width  /= binningX();
+      roi.height /= binningY();
+      cache_->reduced_inverse_map1 = cache_->full_inverse_map1(roi) - cv::Scalar(roi.x, roi.y);
+      cache_->reduced_inverse_map2 = cache_->full_inverse_map2(roi);
+    }
+    else {
+      cache_->reduced_inverse_map1 = cache_->full_inverse_map1;
+      cache_->reduced_inverse_map2 = cache_->full_inverse_map2;
+    }
+    cache_->reduced_inverse_maps_dirty = false;
+  }
+}
+
 } //namespace image_geometry
@@ -0,0 +1,104 @@
+#include "image_geometry/pinhole_camera_model.h"
+#include <sensor_msgs/distortion_models.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+// Reports the throughput of the single and batch point functions of
+// PinholeCameraModel, and the cost of unrectifyImage.
+// Usage: image_geometry-benchmark [num_points]
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double seconds(const Clock::time_point& begin)
+{
+  return std::chrono::duration<double>(Clock::now() - begin).count();
+}
+
+void report(const std::string& name, size_t num_points, double elapsed)
+{
+  std::cout << name << ": " << num_points / elapsed << " points/s" << std::endl;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  const size_t num_points = (argc > 1) ? std::atoi(argv[1]) : 100000;
+
+  // Same calibration as utest.cpp
+  double D[] = {-0.363528858080088, 0.16117037733986861, -8.1109585007538829e-05, -0.00044776712298447841, 0.0};
+  double K[] = {430.15433020105519,                0.0, 311.71339830549732,
+                               0.0, 430.60920415473657, 221.06824942698509,
+                               0.0,                0.0,                1.0};
+  double R[] = {0.99806560714807102, 0.0068562422224214027, 0.061790256276695904,
+                -0.0067522959054715113, 0.99997541519165112, -0.0018909025066874664,
+                -0.061801701660692349, 0.0014700186639396652, 0.99808736527268516};
+  double P[] = {295.53402059708782, 0.0, 285.55760765075684, 0.0,
+                0.0, 295.53402059708782, 223.29617881774902, 0.0,
+                0.0, 0.0, 1.0, 0.0};
+  sensor_msgs::CameraInfo cam_info;
+  cam_info.height = 480;
+  cam_info.width  = 640;
+  cam_info.D.assign(D, D+5);
+  std::copy(K, K+9, cam_info.K.begin());
+  std::copy(R, R+9, cam_info.R.begin());
+  std::copy(P, P+12, cam_info.P.begin());
+  cam_info.distortion_model = sensor_msgs::distortion_models::PLUMB_BOB;
+
+  image_geometry::PinholeCameraModel model;
+  model.fromCameraInfo(cam_info);
+
+  std::vector<cv::Point2d> uv_raw(num_points), uv_rect, uv_unrect;
+  std::vector<cv::Point3d> xyz(num_points);
+  cv::RNG rng(0);
+  for (size_t i = 0; i < num_points; ++i) {
+    uv_raw[i] = cv::Point2d(rng.uniform(0.0, (double)cam_info.width), rng.uniform(0.0, (double)cam_info.height));
+    xyz[i] = cv::Point3d(rng.uniform(-1.0, 1.0), rng.uniform(-1.0, 1.0), rng.uniform(0.5, 5.0));
+  }
+
+  Clock::time_point begin = Clock::now();
+  uv_rect.resize(num_points);
+  for (size_t i = 0; i < num_points; ++i)
+    uv_rect[i] = model.rectifyPoint(uv_raw[i]);
+  report("rectifyPoint", num_points, seconds(begin));
+
+  begin = Clock::now();
+  model.rectifyPoints(uv_raw, uv_rect);
+  report("rectifyPoints", num_points, seconds(begin));
+
+  begin = Clock::now();
+  uv_unrect.resize(num_points);
+  for (size_t i = 0; i < num_points; ++i)
+    uv_unrect[i] = model.unrectifyPoint(uv_rect[i]);
+  report("unrectifyPoint", num_points, seconds(begin));
+
+  begin = Clock::now();
+  model.unrectifyPoints(uv_rect, uv_unrect);
+  report("unrectifyPoints", num_points, seconds(begin));
+
+  std::vector<cv::Point2d> uv(num_points);
+  begin = Clock::now();
+  for (size_t i = 0; i < num_points; ++i)
+    uv[i] = model.project3dToPixel(xyz[i]);
+  report("project3dToPixel", num_points, seconds(begin));
+
+  begin = Clock::now();
+  model.project3dToPixels(xyz, uv);
+  report("project3dToPixels", num_points, seconds(begin));
+
+  // The first call builds the inverse maps
+  cv::Mat rectified(cam_info.height, cam_info.width, CV_8UC3, cv::Scalar(128, 128, 128)), raw;
+  begin = Clock::now();
+  model.unrectifyImage(rectified, raw);
+  std::cout << "unrectifyImage (building maps): " << seconds(begin) * 1000.0 << " ms" << std::endl;
+  const int repeat = 100;
+  begin = Clock::now();
+  for (int k = 0; k < repeat; ++k)
+    model.unrectifyImage(rectified, raw);
+  std::cout << "unrectifyImage: " << seconds(begin) * 1000.0 / repeat << " ms" << std::endl;
+  return 0;
+}
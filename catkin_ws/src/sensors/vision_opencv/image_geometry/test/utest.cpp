@@ -4,7 +4,7 @@
 
 /// @todo Tests with simple values (R = identity, D = 0, P = K or simple scaling)
 /// @todo Test projection functions for right stereo values, P(:,3) != 0
-/// @todo Tests for [un]rectifyImage
+/// @todo Tests for rectifyImage against a reference image
 /// @todo Tests using ROI, needs support from PinholeCameraModel
 /// @todo Tests for StereoCameraModel
 
@@ -132,6 +132,106 @@ TEST_F(PinholeTest, rectifyPoint)
   }
 }
 
+TEST_F(PinholeTest, rectifyPoints)
+{
+  // Batch versions agree with the single point versions
+  std::vector<cv::Point2d> uv_raw, uv_rect, uv_unrect;
+  for (size_t row = 0; row <= cam_info_.height; row += 20)
+    for (size_t col = 0; col <= cam_info_.width; col += 20)
+      uv_raw.push_back(cv::Point2d(col, row));
+
+  model_.rectifyPoints(uv_raw, uv_rect);
+  ASSERT_EQ(uv_raw.size(), uv_rect.size());
+  for (size_t i = 0; i < uv_raw.size(); ++i) {
+    cv::Point2d single = model_.rectifyPoint(uv_raw[i]);
+    // rectifyPoint goes through float
+    EXPECT_NEAR(single.x, uv_rect[i].x, 1e-3) << "at " << uv_raw[i];
+    EXPECT_NEAR(single.y, uv_rect[i].y, 1e-3) << "at " << uv_raw[i];
+  }
+
+  model_.unrectifyPoints(uv_rect, uv_unrect);
+  ASSERT_EQ(uv_rect.size(), uv_unrect.size());
+  for (size_t i = 0; i < uv_rect.size(); ++i) {
+    cv::Point2d single = model_.unrectifyPoint(uv_rect[i]);
+    EXPECT_NEAR(single.x, uv_unrect[i].x, 1e-9) << "at " << uv_rect[i];
+    EXPECT_NEAR(single.y, uv_unrect[i].y, 1e-9) << "at " << uv_rect[i];
+  }
+
+  // Round trip over most of the image, same border as the rectifyPoint test
+  const double border = 65;
+  for (size_t i = 0; i < uv_raw.size(); ++i) {
+    if (uv_raw[i].x < border || uv_raw[i].x > cam_info_.width - border ||
+        uv_raw[i].y < border || uv_raw[i].y > cam_info_.height - border)
+      continue;
+    EXPECT_NEAR(uv_raw[i].x, uv_unrect[i].x, 1.0) << "at " << uv_raw[i];
+    EXPECT_NEAR(uv_raw[i].y, uv_unrect[i].y, 1.0) << "at " << uv_raw[i];
+  }
+
+  // Empty input
+  std::vector<cv::Point2d> empty, out(3);
+  model_.rectifyPoints(empty, out);
+  EXPECT_TRUE(out.empty());
+  out.resize(3);
+  model_.unrectifyPoints(empty, out);
+  EXPECT_TRUE(out.empty());
+}
+
+TEST_F(PinholeTest, project3dToPixels)
+{
+  std::vector<cv::Point3d> xyz;
+  for (double x = -1.0; x <= 1.0; x += 0.25)
+    for (double y = -1.0; y <= 1.0; y += 0.25)
+      xyz.push_back(cv::Point3d(x, y, 1.0 + x*x + y));
+
+  std::vector<cv::Point2d> uv;
+  model_.project3dToPixels(xyz, uv);
+  ASSERT_EQ(xyz.size(), uv.size());
+  for (size_t i = 0; i < xyz.size(); ++i) {
+    cv::Point2d single = model_.project3dToPixel(xyz[i]);
+    EXPECT_DOUBLE_EQ(single.x, uv[i].x);
+    EXPECT_DOUBLE_EQ(single.y, uv[i].y);
+  }
+}
+
+TEST_F(PinholeTest, unrectifyImage)
+{
+  // A smooth floating point image, so that the interpolation error stays small
+  cv::Mat_<float> raw(cam_info_.height, cam_info_.width);
+  for (int v = 0; v < raw.rows; ++v)
+    for (int u = 0; u < raw.cols; ++u)
+      raw(v, u) = 0.25f*u + 0.5f*v;
+
+  cv::Mat rectified, unrectified;
+  model_.rectifyImage(raw, rectified);
+  model_.unrectifyImage(rectified, unrectified);
+  ASSERT_EQ(raw.size(), unrectified.size());
+  ASSERT_EQ(raw.type(), unrectified.type());
+
+  // Round trip over most of the image, same border as the rectifyPoint test
+  const int border = 65;
+  cv::Rect center(border, border, cam_info_.width - 2*border, cam_info_.height - 2*border);
+  cv::Mat diff = cv::abs(raw(center) - unrectified(center));
+  double max_error;
+  cv::minMaxLoc(diff, NULL, &max_error);
+  // Fixed point maps are accurate to 1/32 pixel, the gradient is < 0.6 per pixel
+  EXPECT_LT(max_error, 0.5);
+
+  // Second call uses the cached maps
+  cv::Mat unrectified_again;
+  model_.unrectifyImage(rectified, unrectified_again);
+  EXPECT_EQ(cv::norm(unrectified(center), unrectified_again(center), cv::NORM_L1), 0);
+
+  // Without distortion the image is unchanged
+  sensor_msgs::CameraInfo cam_info_2 = cam_info_;
+  cam_info_2.D.assign(cam_info_2.D.size(), 0);
+  model_.fromCameraInfo(cam_info_2);
+  model_.unrectifyImage(raw, unrectified);
+  EXPECT_EQ(cv::norm(raw, unrectified, cv::NORM_L1), 0);
+
+  // restore original distortion
+  model_.fromCameraInfo(cam_info_);
+}
+
 TEST_F(PinholeTest, getDeltas)
 {
   double u = 100.0, v = 200.0, du = 17.0, dv = 23.0, Z = 2.0;
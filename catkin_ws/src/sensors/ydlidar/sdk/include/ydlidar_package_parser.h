@@ -0,0 +1,97 @@
+
+#pragma once
+#include "v8stdint.h"
+#include "ydlidar_protocol.h"
+#include <vector>
+
+namespace ydlidar{
+
+	/**
+	* @brief 批量解包激光数据 \n
+	* 一次处理整块串口数据, 按完整数据包(包头, LSN 个采样点, 插值角度, 校验)解码到输出缓冲区.
+	* 解码结果与 YDlidarDriver::waitPackage 逐点解包一致, 不足一包的尾部数据会缓存到下一次调用.
+	*/
+	class PackageParser
+	{
+	public:
+		/**
+		* @brief 构造函数 \n
+		* @param[in] intensities    是否带信号质量(每个采样点 3 字节)
+		* @param[in] multipleRate   是否开启采样倍频
+		*/
+		explicit PackageParser(bool intensities = false, bool multipleRate = false);
+
+		/**
+		* @brief 设置雷达是否带信号质量 \n
+		* @note 会清空缓存的不完整数据包
+		*/
+		void setIntensities(bool isintensities);
+
+		/**
+		* @brief 设置雷达采样倍频 \n
+		*/
+		void setMultipleRate(bool enable);
+
+		/**
+		* @brief 清空缓存数据与统计信息 \n
+		*/
+		void reset();
+
+		/**
+		* @brief 解析一块串口数据 \n
+		* @param[in] data       串口数据
+		* @param[in] size       数据大小
+		* @param[out] nodes     激光点输出缓冲区
+		* @param[in] capacity   输出缓冲区大小
+		* @param[out] count     本次输出的激光点数
+		* @return 返回已消耗的字节数
+		* @note 只输出完整数据包; 当输出缓冲区放不下下一个数据包时停止,
+		* 未消耗的数据需要在下一次调用时重新传入
+		*/
+		size_t parse(const uint8_t * data, size_t size, node_info * nodes, size_t capacity, size_t & count);
+
+		/**
+		* @brief 单个数据包最大字节数 \n
+		*/
+		size_t maxPackageSize() const;
+
+		/**
+		* @brief 当前扫描频率, 来自最近的起始包 \n
+		*/
+		uint8_t scanFrequence() const { return scan_frequence; }
+
+		uint64_t packageCount() const { return package_count; }				///< 已解码数据包数
+		uint64_t checksumErrorCount() const { return checksum_errors; }		///< 校验失败数据包数
+		uint64_t droppedByteCount() const { return dropped_bytes; }			///< 同步时丢弃的字节数
+
+	private:
+		/**
+		* @brief 检查包头 \n
+		* @return 返回包头有效时的整包字节数, 无效时返回 0
+		*/
+		size_t packageSize(const uint8_t * header) const;
+
+		/**
+		* @brief 解码一个完整数据包 \n
+		* @return 返回输出的激光点数
+		*/
+		size_t decodePackage(const uint8_t * package, node_info * nodes);
+
+		/**
+		* @brief 在连续数据中解码尽可能多的完整数据包 \n
+		* @return 返回已消耗的字节数
+		*/
+		size_t parseContiguous(const uint8_t * data, size_t size, node_info * nodes, size_t capacity, size_t & count);
+
+		bool m_intensities;					///< 信号质量状体
+		bool isMultipleRate;				///< 采样倍频
+		int PackageSampleBytes;				///< 一个采样点字节数
+		uint8_t scan_frequence;				///< 扫描频率
+
+		std::vector<uint8_t> m_pending;		///< 不完整数据包缓存
+
+		uint64_t package_count;
+		uint64_t checksum_errors;
+		uint64_t dropped_bytes;
+	};
+}
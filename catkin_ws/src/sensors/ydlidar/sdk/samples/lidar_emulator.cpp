@@ -0,0 +1,164 @@
+
+#include "lidar_package_generator.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/select.h>
+#include <string>
+
+using namespace ydlidar;
+
+/**
+* 伪终端雷达模拟器, 不需要雷达即可运行驱动和 ydlidar_test:
+*   ./ydlidar_emulator [G4|X4] [bit_flip_rate] [byte_drop_rate] [garbage_rate]
+* 启动后打印伪终端路径, 驱动连接该路径即可. 支持获取设备信息, 健康状态, 采样频率,
+* 扫描频率, 开始和停止扫描命令, 扫描数据按雷达的实际转速发送.
+*/
+
+static volatile sig_atomic_t running = 1;
+
+static void onSignal(int) {
+    running = 0;
+}
+
+static void writeAll(int fd, const uint8_t * data, size_t size) {
+    while (size && running) {
+        ssize_t r = write(fd, data, size);
+        if (r < 0) {
+            if (errno == EAGAIN || errno == EINTR) {
+                usleep(1000);
+                continue;
+            }
+            return;
+        }
+        size -= r;
+        data += r;
+    }
+}
+
+static void sendResponse(int fd, uint8_t type, const void * payload, uint32_t size, bool continuous = false) {
+    lidar_ans_header header;
+    header.syncByte1 = LIDAR_ANS_SYNC_BYTE1;
+    header.syncByte2 = LIDAR_ANS_SYNC_BYTE2;
+    header.size = size;
+    header.subType = continuous ? 1 : 0;
+    header.type = type;
+    writeAll(fd, reinterpret_cast<uint8_t *>(&header), sizeof(header));
+    if (payload && !continuous) {
+        writeAll(fd, reinterpret_cast<const uint8_t *>(payload), size);
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    std::string name = argc > 1 ? argv[1] : "G4";
+    int model = (name == "X4") ? YDlidarDriver::YDLIDAR_X4 : YDlidarDriver::YDLIDAR_G4;
+    LidarPackageGenerator generator(model, false, (unsigned int)time(NULL));
+    generator.setCorruption(argc > 2 ? atof(argv[2]) : 0,
+                            argc > 3 ? atof(argv[3]) : 0,
+                            argc > 4 ? atof(argv[4]) : 0);
+
+    int fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (fd < 0 || grantpt(fd) != 0 || unlockpt(fd) != 0) {
+        fprintf(stderr, "[YDLIDAR] failed to create pseudo terminal: %s\n", strerror(errno));
+        return 1;
+    }
+    struct termios tio;
+    tcgetattr(fd, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(fd, TCSANOW, &tio);
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    printf("[YDLIDAR] %s emulator on %s (baudrate %u)\n", name.c_str(), ptsname(fd), generator.baudrate());
+    fflush(stdout);
+
+    bool scanning = false;
+    uint8_t command[2];
+    size_t commandPos = 0;
+    std::vector<uint8_t> stream;
+    const useconds_t period = (useconds_t)(1e6/generator.scanFrequency());
+
+    while (running) {
+        fd_set rfds;
+        FD_ZERO(&rfds);
+        FD_SET(fd, &rfds);
+        struct timeval tv;
+        tv.tv_sec = 0;
+        tv.tv_usec = scanning ? 0 : 100000;
+        if (select(fd + 1, &rfds, NULL, NULL, &tv) > 0) {
+            uint8_t byte;
+            while (read(fd, &byte, 1) == 1) {
+                if (commandPos == 0 && byte != LIDAR_CMD_SYNC_BYTE) {
+                    continue;
+                }
+                command[commandPos++] = byte;
+                if (commandPos < 2) {
+                    continue;
+                }
+                commandPos = 0;
+
+                switch (command[1]) {
+                case LIDAR_CMD_GET_DEVICE_INFO: {
+                    device_info info;
+                    memset(&info, 0, sizeof(info));
+                    info.model = (uint8_t)model;
+                    info.firmware_version = 0x0102;
+                    info.hardware_version = 1;
+                    sendResponse(fd, LIDAR_ANS_TYPE_DEVINFO, &info, sizeof(info));
+                    break;
+                }
+                case LIDAR_CMD_GET_DEVICE_HEALTH: {
+                    device_health health;
+                    memset(&health, 0, sizeof(health));
+                    sendResponse(fd, LIDAR_ANS_TYPE_DEVHEALTH, &health, sizeof(health));
+                    break;
+                }
+                case LIDAR_CMD_GET_SAMPLING_RATE: {
+                    sampling_rate rate;
+                    rate.rate = YDlidarDriver::YDLIDAR_RATE_9K;
+                    sendResponse(fd, LIDAR_ANS_TYPE_DEVINFO, &rate, sizeof(rate));
+                    break;
+                }
+                case LIDAR_CMD_GET_AIMSPEED: {
+                    scan_frequency frequency;
+                    frequency.frequency = (uint32_t)(generator.scanFrequency()*100);
+                    sendResponse(fd, LIDAR_ANS_TYPE_DEVINFO, &frequency, sizeof(frequency));
+                    break;
+                }
+                case LIDAR_CMD_SCAN:
+                case LIDAR_CMD_FORCE_SCAN:
+                    sendResponse(fd, LIDAR_ANS_TYPE_MEASUREMENT, NULL, 5, true);
+                    scanning = true;
+                    printf("[YDLIDAR] start scanning\n");
+                    break;
+                case LIDAR_CMD_STOP:
+                case LIDAR_CMD_FORCE_STOP:
+                    if (scanning) {
+                        printf("[YDLIDAR] stop scanning\n");
+                    }
+                    scanning = false;
+                    break;
+                default:
+                    break;
+                }
+                fflush(stdout);
+            }
+        }
+
+        if (scanning) {
+            stream.clear();
+            generator.generateRevolution(stream, NULL);
+            writeAll(fd, &stream[0], stream.size());
+            usleep(period);
+        }
+    }
+
+    close(fd);
+    return 0;
+}
@@ -0,0 +1,204 @@
+
+#pragma once
+#include "ydlidar_protocol.h"
+#include "ydlidar_driver.h"
+#include <math.h>
+#include <stdlib.h>
+#include <vector>
+#include <algorithm>
+
+namespace ydlidar{
+
+	/**
+	* @brief 生成 G4/X4 激光数据包流 \n
+	* 模拟一个矩形房间中的扫描, 可注入比特翻转, 丢字节和随机噪声字节, 用于无雷达时测试解包.
+	*/
+	class LidarPackageGenerator
+	{
+	public:
+		/**
+		* @brief 一个真值激光点 \n
+		*/
+		struct Truth {
+			uint16_t distance_q2;
+			uint16_t angle_q6;
+			bool sync;
+		};
+
+		LidarPackageGenerator(int model, bool intensities, unsigned int seed = 1):
+		m_model(model),
+		m_intensities(intensities),
+		m_seed(seed),
+		m_bitFlipRate(0),
+		m_byteDropRate(0),
+		m_garbageRate(0) {
+			if (model == YDlidarDriver::YDLIDAR_X4) {
+				m_sampleRate = 5000;
+				m_maxPackageSamples = 40;
+			} else {
+				m_sampleRate = 9000;
+				m_maxPackageSamples = 80;
+			}
+			m_scanFrequency = 7.0;
+		}
+
+		/**
+		* @brief 设置数据损坏概率(每个数据包) \n
+		* @param[in] bitFlip    采样数据中翻转一个比特
+		* @param[in] byteDrop   丢失一个字节
+		* @param[in] garbage    在数据包之间插入随机字节
+		*/
+		void setCorruption(double bitFlip, double byteDrop, double garbage) {
+			m_bitFlipRate = bitFlip;
+			m_byteDropRate = byteDrop;
+			m_garbageRate = garbage;
+		}
+
+		void setScanFrequency(double frequency) { m_scanFrequency = frequency; }
+		double scanFrequency() const { return m_scanFrequency; }
+		size_t samplesPerRevolution() const { return (size_t)(m_sampleRate/m_scanFrequency); }
+		uint32_t baudrate() const {
+			return m_model == YDlidarDriver::YDLIDAR_X4 ? YDlidarDriver::YDLIDAR_X4_BAUD : YDlidarDriver::YDLIDAR_G4_BAUD;
+		}
+
+		/**
+		* @brief 生成一圈数据 \n
+		* @param[out] stream   追加的串口字节流
+		* @param[out] truth    追加的未损坏激光点真值, 可以为 NULL
+		*/
+		void generateRevolution(std::vector<uint8_t> & stream, std::vector<Truth> * truth) {
+			const size_t samples = samplesPerRevolution();
+			const double step = 360.0*64.0/samples;
+
+			//起始包: 一个采样点, CT 高位为扫描频率
+			uint8_t ct = CT_RingStart | (((uint8_t)(m_scanFrequency*10))<<1);
+			std::vector<uint16_t> distances(1, 0);
+			emitPackage(stream, truth, ct, 0, 0, distances);
+
+			size_t index = 0;
+			while (index < samples) {
+				size_t count = std::min(m_maxPackageSamples, samples - index);
+				distances.resize(count);
+				for (size_t i = 0; i < count; ++i) {
+					distances[i] = distanceAt((index + i)*step/64.0);
+				}
+				double first = index*step;
+				double last = (index + count - 1)*step;
+				emitPackage(stream, truth, CT_Normal, (uint16_t)first, (uint16_t)last, distances);
+				index += count;
+			}
+		}
+
+		/**
+		* @brief 与驱动一致的角度补偿, 用于计算真值 \n
+		*/
+		static int32_t angleCorrection(uint16_t distance_q2) {
+			if (distance_q2 == 0) {
+				return 0;
+			}
+			double distance = distance_q2/4.0;
+			return (int32_t)(((atan(((21.8*(155.3 - distance))/155.3)/distance))*180.0/3.1415) * 64.0);
+		}
+
+	private:
+		double random() {
+			return rand_r(&m_seed)/(double)RAND_MAX;
+		}
+
+		/**
+		* @brief 4m x 6m 房间加两个行人的距离(q2) \n
+		*/
+		uint16_t distanceAt(double degree) {
+			double theta = DEG2RAD(degree);
+			double c = cos(theta), s = sin(theta);
+			double range = 1e9;
+			if (fabs(c) > 1e-6) range = std::min(range, (c > 0 ? 3500.0 : 2500.0)/fabs(c));
+			if (fabs(s) > 1e-6) range = std::min(range, 2000.0/fabs(s));
+			if (degree > 40 && degree < 48) range = std::min(range, 1200.0);
+			if (degree > 200 && degree < 205) range = std::min(range, 2500.0);
+			if (random() < 0.02) {
+				return 0;
+			}
+			return (uint16_t)(range*4) & 0xfffc;
+		}
+
+		void emitPackage(std::vector<uint8_t> & stream, std::vector<Truth> * truth, uint8_t ct,
+			uint16_t firstAngle, uint16_t lastAngle, const std::vector<uint16_t> & distances) {
+			const size_t sampleBytes = m_intensities ? 3 : 2;
+			const uint8_t lsn = (uint8_t)distances.size();
+			uint16_t fsa = (firstAngle<<1) | LIDAR_RESP_MEASUREMENT_CHECKBIT;
+			uint16_t lsa = (lastAngle<<1) | LIDAR_RESP_MEASUREMENT_CHECKBIT;
+
+			std::vector<uint8_t> package(PackagePaidBytes + lsn*sampleBytes);
+			package[0] = PH&0xFF;
+			package[1] = PH>>8;
+			package[2] = ct;
+			package[3] = lsn;
+			package[4] = fsa&0xFF;
+			package[5] = fsa>>8;
+			package[6] = lsa&0xFF;
+			package[7] = lsa>>8;
+
+			uint16_t checksum = PH ^ fsa;
+			for (size_t i = 0; i < lsn; ++i) {
+				uint8_t *s = &package[PackagePaidBytes + i*sampleBytes];
+				if (m_intensities) {
+					s[0] = (uint8_t)(rand_r(&m_seed)&0xFF);
+					s[1] = distances[i]&0xFF;
+					s[2] = distances[i]>>8;
+					checksum ^= s[0];
+				} else {
+					s[0] = distances[i]&0xFF;
+					s[1] = distances[i]>>8;
+				}
+				checksum ^= distances[i];
+			}
+			checksum ^= (uint16_t)(ct | (lsn<<8));
+			checksum ^= lsa;
+			package[8] = checksum&0xFF;
+			package[9] = checksum>>8;
+
+			bool damaged = false;
+			if (random() < m_bitFlipRate) {
+				size_t byte = PackagePaidBytes + rand_r(&m_seed)%(lsn*sampleBytes);
+				package[byte] ^= (uint8_t)(1 << (rand_r(&m_seed)%8));
+				damaged = true;
+			}
+			if (random() < m_byteDropRate) {
+				package.erase(package.begin() + rand_r(&m_seed)%package.size());
+				damaged = true;
+			}
+			if (random() < m_garbageRate) {
+				size_t n = 1 + rand_r(&m_seed)%16;
+				for (size_t i = 0; i < n; ++i) {
+					stream.push_back((uint8_t)(rand_r(&m_seed)&0xFF));
+				}
+			}
+			stream.insert(stream.end(), package.begin(), package.end());
+
+			if (truth && !damaged) {
+				float interval = lsn > 1 ? (float)((lastAngle - firstAngle)/((lsn - 1)*1.0)) : 0;
+				for (size_t i = 0; i < lsn; ++i) {
+					Truth t;
+					t.distance_q2 = distances[i];
+					float angle = firstAngle + interval*i + angleCorrection(distances[i]);
+					if (angle < 0) angle += 360*64;
+					else if (angle > 360*64) angle -= 360*64;
+					t.angle_q6 = (uint16_t)angle;
+					t.sync = ct != CT_Normal;
+					truth->push_back(t);
+				}
+			}
+		}
+
+		int m_model;
+		bool m_intensities;
+		unsigned int m_seed;
+		double m_sampleRate;
+		double m_scanFrequency;
+		size_t m_maxPackageSamples;
+		double m_bitFlipRate;
+		double m_byteDropRate;
+		double m_garbageRate;
+	};
+}
@@ -0,0 +1,127 @@
+
+#include "ydlidar_package_parser.h"
+#include "lidar_package_generator.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <string>
+
+using namespace ydlidar;
+
+/**
+* 解包正确性与性能测试, 不需要雷达:
+*   ./ydlidar_parser_benchmark [G4|X4] [revolutions] [bit_flip_rate] [byte_drop_rate] [garbage_rate]
+* 无损坏时要求解包结果与真值完全一致; 有损坏时统计误接受的激光点(应为 0)和召回率.
+*/
+
+static double cpuSeconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+static bool truthLess(const LidarPackageGenerator::Truth & a, const LidarPackageGenerator::Truth & b) {
+    if (a.distance_q2 != b.distance_q2) return a.distance_q2 < b.distance_q2;
+    return a.angle_q6 < b.angle_q6;
+}
+
+int main(int argc, char * argv[])
+{
+    std::string name = argc > 1 ? argv[1] : "G4";
+    int revolutions = argc > 2 ? atoi(argv[2]) : 1000;
+    double bitFlip = argc > 3 ? atof(argv[3]) : 0;
+    double byteDrop = argc > 4 ? atof(argv[4]) : 0;
+    double garbage = argc > 5 ? atof(argv[5]) : 0;
+    int model = (name == "X4") ? YDlidarDriver::YDLIDAR_X4 : YDlidarDriver::YDLIDAR_G4;
+    bool corrupted = bitFlip > 0 || byteDrop > 0 || garbage > 0;
+
+    LidarPackageGenerator generator(model, false);
+    generator.setCorruption(bitFlip, byteDrop, garbage);
+    std::vector<uint8_t> stream;
+    std::vector<LidarPackageGenerator::Truth> truth;
+    for (int i = 0; i < revolutions; i++) {
+        generator.generateRevolution(stream, &truth);
+    }
+
+    printf("[YDLIDAR] %s, %d revolutions, %zu points/rev, %zu bytes\n",
+           name.c_str(), revolutions, generator.samplesPerRevolution(), stream.size());
+
+    const size_t chunkSizes[] = {32, 256, 4096};
+    node_info nodes[YDlidarDriver::MAX_SCAN_NODES];
+    std::vector<node_info> output;
+    bool ok = true;
+
+    for (size_t c = 0; c < _countof(chunkSizes); c++) {
+        PackageParser parser(false, false);
+        output.clear();
+        output.reserve(truth.size() + 1024);
+
+        double start = cpuSeconds();
+        size_t offset = 0;
+        while (offset < stream.size()) {
+            size_t chunk = std::min(chunkSizes[c], stream.size() - offset);
+            size_t used = 0;
+            while (used < chunk) {
+                size_t count = 0;
+                used += parser.parse(&stream[offset + used], chunk - used, nodes, _countof(nodes), count);
+                output.insert(output.end(), nodes, nodes + count);
+            }
+            offset += chunk;
+        }
+        double elapsed = cpuSeconds() - start;
+
+        //校验
+        size_t valid = 0, mismatched = 0;
+        if (!corrupted) {
+            if (output.size() != truth.size()) {
+                mismatched = std::max(output.size(), truth.size());
+            } else {
+                for (size_t i = 0; i < output.size(); i++) {
+                    bool sync = output[i].sync_flag & LIDAR_RESP_MEASUREMENT_SYNCBIT;
+                    if (output[i].distance_q2 != truth[i].distance_q2 ||
+                        (output[i].angle_q6_checkbit >> LIDAR_RESP_MEASUREMENT_ANGLE_SHIFT) != truth[i].angle_q6 ||
+                        sync != truth[i].sync) {
+                        mismatched++;
+                    } else if (output[i].distance_q2) {
+                        valid++;
+                    }
+                }
+            }
+        } else {
+            std::vector<LidarPackageGenerator::Truth> sorted(truth);
+            std::sort(sorted.begin(), sorted.end(), truthLess);
+            for (size_t i = 0; i < output.size(); i++) {
+                if (output[i].distance_q2 == 0) {
+                    continue;
+                }
+                LidarPackageGenerator::Truth key;
+                key.distance_q2 = output[i].distance_q2;
+                key.angle_q6 = output[i].angle_q6_checkbit >> LIDAR_RESP_MEASUREMENT_ANGLE_SHIFT;
+                if (std::binary_search(sorted.begin(), sorted.end(), key, truthLess)) {
+                    valid++;
+                } else {
+                    mismatched++;
+                }
+            }
+        }
+
+        size_t truthValid = 0;
+        for (size_t i = 0; i < truth.size(); i++) {
+            if (truth[i].distance_q2) truthValid++;
+        }
+
+        printf("chunk %5zu bytes: %8.2f us CPU/rev, %6.1f MB/s, packages %llu, checksum errors %llu, dropped bytes %llu, "
+               "recall %.4f, mismatched %zu\n",
+               chunkSizes[c], elapsed*1e6/revolutions, stream.size()/elapsed/1e6,
+               (unsigned long long)parser.packageCount(), (unsigned long long)parser.checksumErrorCount(),
+               (unsigned long long)parser.droppedByteCount(),
+               truthValid ? (double)valid/truthValid : 1.0, mismatched);
+        if (mismatched) {
+            ok = false;
+        }
+    }
+
+    printf(ok ? "[YDLIDAR] parser output matches\n" : "[YDLIDAR] parser output mismatched!\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,250 @@
+/*
+*  YDLIDAR SYSTEM
+*  YDLIDAR PACKAGE PARSER
+*
+*  Copyright 2015 - 2018 EAI TEAM
+*  http://www.eaibot.com
+*
+*/
+#include "ydlidar_package_parser.h"
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+namespace ydlidar{
+
+	PackageParser::PackageParser(bool intensities, bool multipleRate):
+	m_intensities(intensities),
+	isMultipleRate(multipleRate),
+	PackageSampleBytes(intensities ? 3 : 2),
+	scan_frequence(0),
+	package_count(0),
+	checksum_errors(0),
+	dropped_bytes(0) {
+		m_pending.reserve(maxPackageSize());
+	}
+
+	void PackageParser::setIntensities(bool isintensities) {
+		m_intensities = isintensities;
+		PackageSampleBytes = m_intensities ? 3 : 2;
+		m_pending.clear();
+		m_pending.reserve(maxPackageSize());
+	}
+
+	void PackageParser::setMultipleRate(bool enable) {
+		isMultipleRate = enable;
+	}
+
+	void PackageParser::reset() {
+		m_pending.clear();
+		scan_frequence = 0;
+		package_count = 0;
+		checksum_errors = 0;
+		dropped_bytes = 0;
+	}
+
+	size_t PackageParser::maxPackageSize() const {
+		return PackagePaidBytes + 0xFF*PackageSampleBytes;
+	}
+
+	size_t PackageParser::packageSize(const uint8_t * header) const {
+		if (header[0] != (PH&0xFF) || header[1] != (PH>>8)) {
+			return 0;
+		}
+		//起始角与结束角的校验位
+		if (!(header[4] & LIDAR_RESP_MEASUREMENT_CHECKBIT) || !(header[6] & LIDAR_RESP_MEASUREMENT_CHECKBIT)) {
+			return 0;
+		}
+		if (header[3] == 0) {
+			return 0;
+		}
+		return PackagePaidBytes + header[3]*PackageSampleBytes;
+	}
+
+	size_t PackageParser::decodePackage(const uint8_t * package, node_info * nodes) {
+		const uint8_t  package_CT = package[2];
+		const uint8_t  package_Sample_Num = package[3];
+		const uint16_t FirstSampleAngleRaw = package[4] | (package[5] << 8);
+		const uint16_t LastSampleAngleRaw = package[6] | (package[7] << 8);
+		const uint16_t CheckSun = package[8] | (package[9] << 8);
+		const uint8_t *sample = package + PackagePaidBytes;
+
+		uint16_t CheckSunCal = PH ^ FirstSampleAngleRaw;
+		for (size_t i = 0; i < package_Sample_Num; ++i) {
+			const uint8_t *s = sample + i*PackageSampleBytes;
+			if (m_intensities) {
+				CheckSunCal ^= s[0];
+				CheckSunCal ^= (uint16_t)(s[1] | (s[2] << 8));
+			} else {
+				CheckSunCal ^= (uint16_t)(s[0] | (s[1] << 8));
+			}
+		}
+		CheckSunCal ^= (uint16_t)(package_CT | (package_Sample_Num << 8));
+		CheckSunCal ^= LastSampleAngleRaw;
+
+		package_count++;
+		if (CheckSunCal != CheckSun) {
+			checksum_errors++;
+			scan_frequence = 0;
+			for (size_t i = 0; i < package_Sample_Num; ++i) {
+				nodes[i].sync_flag = Node_NotSync;
+				nodes[i].sync_quality = Node_Default_Quality;
+				nodes[i].angle_q6_checkbit = LIDAR_RESP_MEASUREMENT_CHECKBIT;
+				nodes[i].distance_q2 = 0;
+				nodes[i].stamp = 0;
+				nodes[i].scan_frequence = 0;
+			}
+			return package_Sample_Num;
+		}
+
+		if ((package_CT&0x01) == CT_RingStart) {
+			scan_frequence = (package_CT&0xFE)>>1;
+		}
+
+		//与 waitPackage 相同的角度插值
+		uint16_t FirstSampleAngle = FirstSampleAngleRaw>>1;
+		uint16_t LastSampleAngle = LastSampleAngleRaw>>1;
+		float IntervalSampleAngle = 0;
+		if (package_Sample_Num > 1) {
+			if (LastSampleAngle < FirstSampleAngle) {
+				if ((FirstSampleAngle >= 180*64) && (LastSampleAngle <= 180*64)) {//实际雷达跨度不超过60度
+					IntervalSampleAngle = (float)((360*64 + LastSampleAngle - FirstSampleAngle)/((package_Sample_Num-1)*1.0));
+				} else {//这里不应该发生
+					if (FirstSampleAngle > 360) {///< 负数
+						IntervalSampleAngle = ((float)(LastSampleAngle - ((int16_t)FirstSampleAngle)))/(package_Sample_Num-1);
+					} else {//起始角大于结束角
+						std::swap(FirstSampleAngle, LastSampleAngle);
+						IntervalSampleAngle = (float)((LastSampleAngle - FirstSampleAngle)/((package_Sample_Num-1)*1.0));
+					}
+				}
+			} else {
+				IntervalSampleAngle = (float)((LastSampleAngle - FirstSampleAngle)/((package_Sample_Num-1)*1.0));
+			}
+		}
+
+		const uint8_t sync_flag = (package_CT == CT_Normal) ? Node_NotSync : Node_Sync;
+		const double distance_scale = isMultipleRate ? 2.0 : 4.0;
+		for (size_t i = 0; i < package_Sample_Num; ++i) {
+			const uint8_t *s = sample + i*PackageSampleBytes;
+			node_info &node = nodes[i];
+			node.sync_flag = sync_flag;
+			node.sync_quality = Node_Default_Quality;
+			if (m_intensities) {
+				uint16_t distance = s[1] | (s[2] << 8);
+				if (isMultipleRate) {
+					node.sync_quality = ((distance&0x01)<<LIDAR_RESP_MEASUREMENT_SYNC_QUALITY_SHIFT) | s[0];
+					node.distance_q2 = distance&0xfffe;
+				} else {
+					node.sync_quality = ((distance&0x03)<<LIDAR_RESP_MEASUREMENT_SYNC_QUALITY_SHIFT) | s[0];
+					node.distance_q2 = distance&0xfffc;
+				}
+			} else {
+				node.distance_q2 = s[0] | (s[1] << 8);
+			}
+
+			int32_t AngleCorrectForDistance = 0;
+			if (node.distance_q2 != 0) {
+				double distance = node.distance_q2/distance_scale;
+				AngleCorrectForDistance = (int32_t)(((atan(((21.8*(155.3 - distance))/155.3)/distance))*180.0/3.1415) * 64.0);
+			}
+
+			float angle = FirstSampleAngle + IntervalSampleAngle*i + AngleCorrectForDistance;
+			if (angle < 0) {
+				angle += 360*64;
+			} else if (angle > 360*64) {
+				angle -= 360*64;
+			}
+			node.angle_q6_checkbit = (((uint16_t)angle)<<1) + LIDAR_RESP_MEASUREMENT_CHECKBIT;
+			node.stamp = 0;
+			node.scan_frequence = scan_frequence;
+		}
+		return package_Sample_Num;
+	}
+
+	size_t PackageParser::parseContiguous(const uint8_t * data, size_t size, node_info * nodes, size_t capacity, size_t & count) {
+		size_t pos = 0;
+		count = 0;
+		while (pos < size) {
+			if (data[pos] != (PH&0xFF)) {
+				const uint8_t *next = (const uint8_t *)memchr(data + pos, PH&0xFF, size - pos);
+				size_t skip = next ? (size_t)(next - (data + pos)) : size - pos;
+				dropped_bytes += skip;
+				pos += skip;
+				continue;
+			}
+			if (size - pos < PackagePaidBytes) {
+				break;
+			}
+			size_t package_size = packageSize(data + pos);
+			if (package_size == 0) {
+				dropped_bytes++;
+				pos++;
+				continue;
+			}
+			if (size - pos < package_size) {
+				break;
+			}
+			if (count + data[pos + 3] > capacity) {
+				break;
+			}
+			count += decodePackage(data + pos, nodes + count);
+			pos += package_size;
+		}
+		return pos;
+	}
+
+	size_t PackageParser::parse(const uint8_t * data, size_t size, node_info * nodes, size_t capacity, size_t & count) {
+		size_t consumed = 0;
+		count = 0;
+
+		//先补全上一次缓存的不完整数据包
+		while (!m_pending.empty()) {
+			if (m_pending.size() < PackagePaidBytes) {
+				size_t take = std::min(PackagePaidBytes - m_pending.size(), size - consumed);
+				m_pending.insert(m_pending.end(), data + consumed, data + consumed + take);
+				consumed += take;
+				if (m_pending.size() < PackagePaidBytes) {
+					return consumed;
+				}
+			}
+
+			size_t package_size = packageSize(&m_pending[0]);
+			if (package_size == 0) {
+				//包头无效, 在缓存中重新同步
+				std::vector<uint8_t>::iterator next = std::find(m_pending.begin() + 1, m_pending.end(), (uint8_t)(PH&0xFF));
+				dropped_bytes += next - m_pending.begin();
+				m_pending.erase(m_pending.begin(), next);
+				continue;
+			}
+
+			if (m_pending.size() < package_size) {
+				size_t take = std::min(package_size - m_pending.size(), size - consumed);
+				m_pending.insert(m_pending.end(), data + consumed, data + consumed + take);
+				consumed += take;
+				if (m_pending.size() < package_size) {
+					return consumed;
+				}
+			}
+
+			if (m_pending[3] > capacity) {
+				return consumed;
+			}
+			count += decodePackage(&m_pending[0], nodes);
+			m_pending.clear();
+		}
+
+		size_t decoded = 0;
+		size_t used = parseContiguous(data + consumed, size - consumed, nodes + count, capacity - count, decoded);
+		count += decoded;
+		consumed += used;
+
+		if (consumed < size) {
+			//输出缓冲区已满时由调用者重新传入剩余数据, 否则缓存不完整的尾部
+			if (size - consumed < PackagePaidBytes || packageSize(data + consumed) > size - consumed) {
+				m_pending.insert(m_pending.end(), data + consumed, data + size);
+				consumed = size;
+			}
+		}
+		return consumed;
+	}
+}
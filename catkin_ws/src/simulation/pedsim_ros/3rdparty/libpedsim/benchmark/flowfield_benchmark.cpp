@@ -0,0 +1,139 @@
+//
+// pedsim - A microscopic pedestrian simulation system.
+// Copyright (c) 2003 - 2012 by Christian Gloor
+//
+// Cost of the waypoint navigation fields (Tflowfield) and their effect on
+// agents walking around a concave obstacle. Build with -DSHALL_BENCHMARK=ON.
+//
+
+#include "ped_includes.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace std;
+
+/// Agent walking to a single waypoint
+class BenchmarkAgent : public Ped::Tagent {
+ public:
+  BenchmarkAgent(Ped::Twaypoint* waypointIn) : waypoint(waypointIn) {}
+  Ped::Twaypoint* getCurrentWaypoint() const override { return waypoint; }
+  bool arrived() const {
+    return (getPosition() - waypoint->getPosition()).length() <
+           waypoint->getRadius();
+  }
+
+ protected:
+  Ped::Twaypoint* waypoint;
+};
+
+static double elapsedMs(chrono::steady_clock::time_point begin) {
+  return chrono::duration<double, milli>(chrono::steady_clock::now() - begin)
+      .count();
+}
+
+/// Square grid of rooms of 10 m with a door in every wall
+static void addRooms(Ped::Tscene& scene, double size) {
+  const double room = 10.0, door = 2.0;
+  for (double a = 0; a <= size; a += room) {
+    for (double b = 0; b < size; b += room) {
+      scene.addObstacle(new Ped::Tobstacle(a, b, a, b + (room - door) / 2));
+      scene.addObstacle(
+          new Ped::Tobstacle(a, b + (room + door) / 2, a, b + room));
+      scene.addObstacle(new Ped::Tobstacle(b, a, b + (room - door) / 2, a));
+      scene.addObstacle(
+          new Ped::Tobstacle(b + (room + door) / 2, a, b + room, a));
+    }
+  }
+}
+
+/// Run agents starting inside a U-shaped obstacle toward a goal behind it
+static void runConcaveScenario(bool useFlowField, int numAgents) {
+  Ped::Tscene scene;
+  // U opening toward -x, the goal is behind its bottom
+  scene.addObstacle(new Ped::Tobstacle(0, -6, 10, -6));
+  scene.addObstacle(new Ped::Tobstacle(10, -6, 10, 6));
+  scene.addObstacle(new Ped::Tobstacle(10, 6, 0, 6));
+  Ped::Twaypoint* goal = new Ped::Twaypoint(20, 0);
+  goal->setRadius(1.5);
+  scene.addWaypoint(goal);
+  if (useFlowField) scene.setFlowFieldResolution(0.25, 0.4);
+
+  srand(0);
+  vector<BenchmarkAgent*> agents;
+  for (int i = 0; i < numAgents; ++i) {
+    BenchmarkAgent* agent = new BenchmarkAgent(goal);
+    agent->setPosition(2 + 6.0 * rand() / RAND_MAX,
+                       -4.5 + 9.0 * rand() / RAND_MAX);
+    agent->setVmax(1.3);
+    scene.addAgent(agent);
+    agents.push_back(agent);
+  }
+
+  // the agents leave the scene once they arrived
+  const double h = 0.04;
+  const int maxSteps = 5000;
+  int step, stepsTo90 = -1, numArrived = 0;
+  chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+  for (step = 1; step <= maxSteps; ++step) {
+    scene.moveAgents(h);
+    for (size_t i = 0; i < agents.size();) {
+      if (agents[i]->arrived()) {
+        scene.removeAgent(agents[i]);
+        agents.erase(agents.begin() + i);
+        ++numArrived;
+      } else {
+        ++i;
+      }
+    }
+    if (numArrived >= 0.9 * numAgents) {
+      stepsTo90 = step;
+      break;
+    }
+  }
+  double ms = elapsedMs(begin);
+  printf("concave obstacle, %3d agents, %-9s: 90%% arrived after %5d steps "
+         "(%s), %.3f ms/step\n",
+         numAgents, useFlowField ? "flowfield" : "straight", stepsTo90,
+         stepsTo90 < 0 ? "never" : "ok", ms / min(step, maxSteps));
+}
+
+int main(int argc, char** argv) {
+  // field cost for rooms of increasing size
+  for (double size = 50; size <= 400; size *= 2) {
+    Ped::Tscene scene;
+    addRooms(scene, size);
+    Ped::Twaypoint* goal = new Ped::Twaypoint(size - 5, size - 5);
+    goal->setRadius(1.0);
+    scene.addWaypoint(goal);
+    scene.setFlowFieldResolution(0.2, 0.3);
+
+    chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+    const Ped::Tflowfield* field = scene.getFlowField(goal);
+    double buildMs = elapsedMs(begin);
+
+    const int numQueries = 100000;
+    Ped::Tvector direction;
+    int numValid = 0;
+    begin = chrono::steady_clock::now();
+    for (int i = 0; i < numQueries; ++i) {
+      Ped::Tvector p(size * (i % 317) / 317.0, size * (i % 331) / 331.0);
+      numValid += field->getDirection(p, direction);
+    }
+    double queryNs = elapsedMs(begin) * 1e6 / numQueries;
+
+    printf("rooms %3.0f x %3.0f m, %4d x %4d cells: build %8.1f ms, "
+           "%7.2f MB per waypoint, %.0f ns per query (%d%% valid)\n",
+           size, size, field->getWidth(), field->getHeight(), buildMs,
+           field->getMemoryUsage() / 1e6, queryNs,
+           100 * numValid / numQueries);
+  }
+
+  for (int numAgents = 50; numAgents <= 200; numAgents *= 2) {
+    runConcaveScenario(false, numAgents);
+    runConcaveScenario(true, numAgents);
+  }
+  return 0;
+}
@@ -93,6 +93,7 @@ class LIBEXPORT Tagent {
   virtual void setForceFactorObstacle(double f);
 
   void assignScene(Tscene* sceneIn);
+  const Tscene* getScene() const { return scene; }
   void removeAgentFromNeighbors(const Tagent* agentIn);
 
  protected:
@@ -0,0 +1,70 @@
+//
+// pedsim - A microscopic pedestrian simulation system.
+// Copyright (c) 2003 - 2012 by Christian Gloor
+//
+
+#ifndef _ped_flowfield_h_
+#define _ped_flowfield_h_ 1
+
+#ifdef WIN32
+#define LIBEXPORT __declspec(dllexport)
+#else
+#define LIBEXPORT
+#endif
+
+#include <cstddef>
+#include <vector>
+
+#include "ped_vector.h"
+
+using namespace std;
+
+namespace Ped {
+class Tobstacle;
+
+/// Navigation field toward one goal on a grid over the obstacles of a scene.
+/// The geodesic distance to the goal is computed with Dijkstra on the
+/// 8-connected grid (cells closer than the clearance to a wall are blocked),
+/// and the desired walking direction is its negative gradient. Agents
+/// therefore walk around obstacles instead of pushing into them on the
+/// straight line to the goal.
+class LIBEXPORT Tflowfield {
+ public:
+  Tflowfield(const vector<Tobstacle*>& obstacles, const Tvector& goalIn,
+             double goalRadiusIn, double resolutionIn, double clearanceIn,
+             double marginIn = 2.0);
+
+  bool getDirection(const Tvector& p, Tvector& directionOut) const;
+  double getDistance(const Tvector& p) const;
+
+  const Tvector& getGoal() const { return goal; };
+  double getGoalRadius() const { return goalRadius; };
+  double getResolution() const { return resolution; };
+  int getWidth() const { return width; };
+  int getHeight() const { return height; };
+  size_t getMemoryUsage() const;
+
+ protected:
+  void blockObstacles(const vector<Tobstacle*>& obstacles);
+  void computeDistances();
+  void computeDirections();
+  bool getCell(double x, double y, int& ix, int& iy) const;
+  int index(int ix, int iy) const { return iy * width + ix; };
+
+  Tvector goal;       ///< goal position
+  double goalRadius;  ///< cells within this distance of the goal are targets
+  double resolution;  ///< cell size
+  double clearance;   ///< minimal distance of a walkable cell to a wall
+  double originX;     ///< position of the center of the cell (0, 0)
+  double originY;
+  int width;
+  int height;
+
+  vector<bool> blocked;         ///< cell too close to an obstacle
+  vector<float> distance;       ///< geodesic distance to the goal, or -1
+  vector<float> directionX;     ///< unit descent direction, 0 if none
+  vector<float> directionY;
+};
+}
+
+#endif
@@ -2,6 +2,7 @@
 #define _ped_includes_h_ 1
 
 #include "ped_agent.h"
+#include "ped_flowfield.h"
 #include "ped_obstacle.h"
 #include "ped_scene.h"
 #include "ped_waypoint.h"
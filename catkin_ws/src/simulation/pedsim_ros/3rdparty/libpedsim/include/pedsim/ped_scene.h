@@ -22,6 +22,7 @@ using namespace std;
 namespace Ped {
 
 class Tagent;
+class Tflowfield;
 class Tobstacle;
 class Twaypoint;
 class Ttree;
@@ -60,6 +61,7 @@ class Ttree;
 class LIBEXPORT Tscene {
   friend class Ped::Tagent;
   friend class Ped::Ttree;
+  friend class Ped::Twaypoint;
 
  public:
   Tscene();
@@ -81,6 +83,11 @@ class LIBEXPORT Tscene {
   set<const Ped::Tagent*> getNeighbors(double x, double y, double dist) const;
   const vector<Tagent*>& getAllAgents() const { return agents; };
 
+  virtual void setFlowFieldResolution(double resolutionIn,
+                                      double clearanceIn);
+  const Tflowfield* getFlowField(const Twaypoint* waypoint) const;
+  void invalidateFlowFields();
+
  protected:
   vector<Tagent*> agents;
   vector<Tobstacle*> obstacles;
@@ -88,6 +95,11 @@ class LIBEXPORT Tscene {
   map<const Ped::Tagent*, Ttree*> treehash;
   Ttree* tree;
 
+  double flowFieldResolution;  ///< flow field cell size, <= 0 disables them
+  double flowFieldClearance;   ///< distance kept from the walls
+  mutable map<const Twaypoint*, Tflowfield*> flowFields;  ///< per waypoint
+
+  void dropFlowField(const Twaypoint* w);
   void placeAgent(const Ped::Tagent* a);
   void moveAgent(const Ped::Tagent* a);
   void getNeighbors(std::vector<const Ped::Tagent*>& neighborList, double x,
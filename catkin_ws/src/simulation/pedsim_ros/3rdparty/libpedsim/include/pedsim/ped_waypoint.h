@@ -20,10 +20,13 @@ using namespace std;
 namespace Ped {
 // Forward Declarations
 class Tagent;
+class Tscene;
 
 /// The waypoint class
 /// \author  chgloor
 class LIBEXPORT Twaypoint {
+  friend class Ped::Tscene;
+
  public:
   enum WaypointType { AreaWaypoint = 0, PointWaypoint = 1 };
   enum Behavior { SIMPLE = 0, SOURCE = 1, SINK = 2 };
@@ -66,7 +69,10 @@ class LIBEXPORT Twaypoint {
   Tvector position;                      ///< position of the waypoint
   WaypointType type;                     ///< type of the waypoint
   Behavior behavior = Behavior::SIMPLE;  ///< behavior of the waypoint
-  double radius;                          ///< radius of the waypoint
+  double radius = 0;                      ///< radius of the waypoint
+
+ private:
+  Tscene* scene = NULL;  ///< scene the waypoint is registered in, if any
 };
 }
 
@@ -0,0 +1,243 @@
+//
+// pedsim - A microscopic pedestrian simulation system.
+// Copyright (c) 2003 - 2012 by Christian Gloor
+//
+
+#include "ped_flowfield.h"
+#include "ped_obstacle.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <utility>
+
+using namespace std;
+
+/// Builds the navigation field toward a goal.
+/// \param   obstacles The walls of the scene, the grid covers them and the goal
+/// \param   goalIn The goal position
+/// \param   goalRadiusIn Cells within this distance of the goal are targets
+/// \param   resolutionIn The cell size
+/// \param   clearanceIn Minimal distance of the walkable cells to the walls
+/// \param   marginIn Extra space around the obstacles covered by the grid
+Ped::Tflowfield::Tflowfield(const vector<Tobstacle*>& obstacles,
+                            const Tvector& goalIn, double goalRadiusIn,
+                            double resolutionIn, double clearanceIn,
+                            double marginIn)
+    : goal(goalIn),
+      goalRadius(goalRadiusIn),
+      resolution(resolutionIn),
+      clearance(clearanceIn) {
+  // bounding box of the obstacles and the goal
+  double minX = goal.x, maxX = goal.x, minY = goal.y, maxY = goal.y;
+  for (const Tobstacle* obstacle : obstacles) {
+    minX = min(minX, min(obstacle->getax(), obstacle->getbx()));
+    maxX = max(maxX, max(obstacle->getax(), obstacle->getbx()));
+    minY = min(minY, min(obstacle->getay(), obstacle->getby()));
+    maxY = max(maxY, max(obstacle->getay(), obstacle->getby()));
+  }
+  originX = minX - marginIn;
+  originY = minY - marginIn;
+  width = (int)ceil((maxX - minX + 2 * marginIn) / resolution) + 1;
+  height = (int)ceil((maxY - minY + 2 * marginIn) / resolution) + 1;
+
+  blockObstacles(obstacles);
+  computeDistances();
+  computeDirections();
+}
+
+/// Blocks the cells closer than the clearance to a wall. A wall always blocks
+/// the cells it crosses, so that thin walls cannot be passed diagonally.
+void Ped::Tflowfield::blockObstacles(const vector<Tobstacle*>& obstacles) {
+  blocked.assign(width * height, false);
+  const double blockRadius = max(clearance, resolution * M_SQRT1_2);
+  for (const Tobstacle* obstacle : obstacles) {
+    int ix0 = max(0, (int)floor((min(obstacle->getax(), obstacle->getbx()) -
+                                 blockRadius - originX) / resolution));
+    int ix1 = min(width - 1, (int)ceil((max(obstacle->getax(), obstacle->getbx()) +
+                                        blockRadius - originX) / resolution));
+    int iy0 = max(0, (int)floor((min(obstacle->getay(), obstacle->getby()) -
+                                 blockRadius - originY) / resolution));
+    int iy1 = min(height - 1, (int)ceil((max(obstacle->getay(), obstacle->getby()) +
+                                         blockRadius - originY) / resolution));
+    for (int iy = iy0; iy <= iy1; ++iy) {
+      for (int ix = ix0; ix <= ix1; ++ix) {
+        Tvector center(originX + ix * resolution, originY + iy * resolution);
+        if ((obstacle->closestPoint(center) - center).lengthSquared() <
+            blockRadius * blockRadius)
+          blocked[index(ix, iy)] = true;
+      }
+    }
+  }
+}
+
+/// Dijkstra from the goal cells over the 8-connected free cells. Diagonal
+/// steps between two blocked cells are not allowed.
+void Ped::Tflowfield::computeDistances() {
+  distance.assign(width * height, -1.0f);
+  typedef pair<float, int> QueueEntry;
+  priority_queue<QueueEntry, vector<QueueEntry>, greater<QueueEntry> > queue;
+
+  // seed the free cells around the goal, at least the goal cell itself
+  const double seedRadius = max(goalRadius, resolution * M_SQRT1_2);
+  int gx, gy;
+  bool goalInGrid = getCell(goal.x, goal.y, gx, gy);
+  int range = (int)ceil(seedRadius / resolution);
+  for (int iy = gy - range; iy <= gy + range; ++iy) {
+    for (int ix = gx - range; ix <= gx + range; ++ix) {
+      if (ix < 0 || iy < 0 || ix >= width || iy >= height) continue;
+      double d = Tvector(originX + ix * resolution - goal.x,
+                         originY + iy * resolution - goal.y).length();
+      bool isGoalCell = goalInGrid && ix == gx && iy == gy;
+      if (d > seedRadius && !isGoalCell) continue;
+      if (blocked[index(ix, iy)] && !isGoalCell) continue;
+      // a goal close to a wall stays reachable
+      blocked[index(ix, iy)] = false;
+      float seedDistance = (float)max(0.0, d - goalRadius);
+      distance[index(ix, iy)] = seedDistance;
+      queue.push(QueueEntry(seedDistance, index(ix, iy)));
+    }
+  }
+
+  static const int dx[8] = {1, -1, 0, 0, 1, 1, -1, -1};
+  static const int dy[8] = {0, 0, 1, -1, 1, -1, 1, -1};
+  const float straightCost = (float)resolution;
+  const float diagonalCost = (float)(resolution * M_SQRT2);
+  while (!queue.empty()) {
+    QueueEntry entry = queue.top();
+    queue.pop();
+    int current = entry.second;
+    if (entry.first > distance[current]) continue;  // outdated entry
+    int ix = current % width;
+    int iy = current / width;
+    for (int k = 0; k < 8; ++k) {
+      int nx = ix + dx[k];
+      int ny = iy + dy[k];
+      if (nx < 0 || ny < 0 || nx >= width || ny >= height) continue;
+      int neighbor = index(nx, ny);
+      if (blocked[neighbor]) continue;
+      if (k >= 4 && (blocked[index(nx, iy)] || blocked[index(ix, ny)]))
+        continue;
+      float d = entry.first + (k < 4 ? straightCost : diagonalCost);
+      if (distance[neighbor] < 0 || d < distance[neighbor]) {
+        distance[neighbor] = d;
+        queue.push(QueueEntry(d, neighbor));
+      }
+    }
+  }
+}
+
+/// Unit direction of the negative distance gradient in every reachable cell.
+/// Central differences are used where both neighbors are reachable, one-sided
+/// differences next to walls, and the steepest descent neighbor on plateaus.
+void Ped::Tflowfield::computeDirections() {
+  directionX.assign(width * height, 0.0f);
+  directionY.assign(width * height, 0.0f);
+  for (int iy = 0; iy < height; ++iy) {
+    for (int ix = 0; ix < width; ++ix) {
+      int current = index(ix, iy);
+      float d = distance[current];
+      if (d <= 0) continue;
+
+      float left = (ix > 0) ? distance[index(ix - 1, iy)] : -1.0f;
+      float right = (ix < width - 1) ? distance[index(ix + 1, iy)] : -1.0f;
+      float down = (iy > 0) ? distance[index(ix, iy - 1)] : -1.0f;
+      float up = (iy < height - 1) ? distance[index(ix, iy + 1)] : -1.0f;
+
+      float gx = 0.0f, gy = 0.0f;
+      if (left >= 0 && right >= 0)
+        gx = (right - left) / 2;
+      else if (right >= 0)
+        gx = min(0.0f, right - d);
+      else if (left >= 0)
+        gx = max(0.0f, d - left);
+      if (down >= 0 && up >= 0)
+        gy = (up - down) / 2;
+      else if (up >= 0)
+        gy = min(0.0f, up - d);
+      else if (down >= 0)
+        gy = max(0.0f, d - down);
+
+      float norm = sqrt(gx * gx + gy * gy);
+      if (norm < 1e-6f) {
+        // plateau, walk toward the lowest neighbor
+        float lowest = d;
+        for (int ny = max(0, iy - 1); ny <= min(height - 1, iy + 1); ++ny) {
+          for (int nx = max(0, ix - 1); nx <= min(width - 1, ix + 1); ++nx) {
+            float nd = distance[index(nx, ny)];
+            if (nd >= 0 && nd < lowest) {
+              lowest = nd;
+              gx = (float)(ix - nx);
+              gy = (float)(iy - ny);
+            }
+          }
+        }
+        norm = sqrt(gx * gx + gy * gy);
+        if (norm < 1e-6f) continue;
+      }
+      directionX[current] = -gx / norm;
+      directionY[current] = -gy / norm;
+    }
+  }
+}
+
+/// Returns the cell closest to x/y.
+/// \return  false if x/y is outside of the grid
+bool Ped::Tflowfield::getCell(double x, double y, int& ix, int& iy) const {
+  ix = (int)floor((x - originX) / resolution + 0.5);
+  iy = (int)floor((y - originY) / resolution + 0.5);
+  bool inside = ix >= 0 && iy >= 0 && ix < width && iy < height;
+  ix = max(0, min(ix, width - 1));
+  iy = max(0, min(iy, height - 1));
+  return inside;
+}
+
+/// Returns the desired walking direction at p, bilinearly interpolated
+/// between the directions of the surrounding cells.
+/// \return  false if p is outside of the grid, unreachable or already at the
+/// goal. The straight line to the goal should be used then.
+bool Ped::Tflowfield::getDirection(const Tvector& p,
+                                   Tvector& directionOut) const {
+  if ((p - goal).length() <= goalRadius + resolution) return false;
+
+  double fx = (p.x - originX) / resolution;
+  double fy = (p.y - originY) / resolution;
+  int ix = (int)floor(fx);
+  int iy = (int)floor(fy);
+  if (ix < 0 || iy < 0 || ix >= width - 1 || iy >= height - 1) return false;
+  double tx = fx - ix;
+  double ty = fy - iy;
+
+  double sumX = 0.0, sumY = 0.0, sumWeight = 0.0;
+  for (int k = 0; k < 4; ++k) {
+    int cx = ix + (k & 1);
+    int cy = iy + (k >> 1);
+    int cell = index(cx, cy);
+    if (directionX[cell] == 0.0f && directionY[cell] == 0.0f) continue;
+    double weight = ((k & 1) ? tx : 1.0 - tx) * ((k >> 1) ? ty : 1.0 - ty);
+    sumX += weight * directionX[cell];
+    sumY += weight * directionY[cell];
+    sumWeight += weight;
+  }
+  double norm = sqrt(sumX * sumX + sumY * sumY);
+  if (sumWeight <= 0.0 || norm < 1e-6) return false;
+
+  directionOut = Tvector(sumX / norm, sumY / norm);
+  return true;
+}
+
+/// Returns the geodesic distance from p to the goal, or -1 if it is
+/// unreachable or outside of the grid.
+double Ped::Tflowfield::getDistance(const Tvector& p) const {
+  int ix, iy;
+  if (!getCell(p.x, p.y, ix, iy)) return -1;
+  return distance[index(ix, iy)];
+}
+
+/// Returns the approximate memory used by the grid, in bytes.
+size_t Ped::Tflowfield::getMemoryUsage() const {
+  return sizeof(*this) + blocked.size() / 8 +
+         (distance.size() + directionX.size() + directionY.size()) *
+             sizeof(float);
+}
@@ -5,6 +5,7 @@
 
 #include "ped_scene.h"
 #include "ped_agent.h"
+#include "ped_flowfield.h"
 #include "ped_obstacle.h"
 #include "ped_tree.h"
 #include "ped_waypoint.h"
@@ -18,7 +19,8 @@ using namespace std;
 /// Default constructor. If this constructor is used, there will be no quadtree
 /// created.
 /// This is faster for small scenarios or less than 1000 Tagents.
-Ped::Tscene::Tscene() : tree(NULL) {}
+Ped::Tscene::Tscene()
+    : tree(NULL), flowFieldResolution(0), flowFieldClearance(0) {}
 
 /// Constructor used to create a quadtree statial representation of the Tagents.
 /// Use this
@@ -35,12 +37,19 @@ Ped::Tscene::Tscene() : tree(NULL) {}
 /// right.
 /// \param height is the total height of the boundary. Basically from top to
 /// down.
-Ped::Tscene::Tscene(double left, double top, double width, double height) {
+Ped::Tscene::Tscene(double left, double top, double width, double height)
+    : flowFieldResolution(0), flowFieldClearance(0) {
   tree = new Ped::Ttree(this, 0, left, top, width, height);
 }
 
 /// Destructor
-Ped::Tscene::~Tscene() { delete tree; }
+Ped::Tscene::~Tscene() {
+  // the waypoints may outlive the scene, they must not call back into it
+  for (Ped::Twaypoint* currentWaypoint : waypoints)
+    currentWaypoint->scene = NULL;
+  invalidateFlowFields();
+  delete tree;
+}
 
 void Ped::Tscene::clear() {
   // clear tree
@@ -58,6 +67,8 @@ void Ped::Tscene::clear() {
   // remove all waypoints
   for (Ped::Twaypoint* currentWaypoint : waypoints) delete currentWaypoint;
   waypoints.clear();
+
+  invalidateFlowFields();
 }
 
 /// Used to add a Tagent to the Tscene.
@@ -81,12 +92,14 @@ void Ped::Tscene::addObstacle(Ped::Tobstacle* o) {
   // add obstacle to scene
   // (take responsibility for object deletion)
   obstacles.push_back(o);
+  invalidateFlowFields();
 }
 
 void Ped::Tscene::addWaypoint(Ped::Twaypoint* w) {
   // add waypoint to scene
   // (take responsibility for object deletion)
   waypoints.push_back(w);
+  w->scene = this;
 }
 
 bool Ped::Tscene::removeAgent(Ped::Tagent* a) {
@@ -119,6 +132,7 @@ bool Ped::Tscene::removeObstacle(Ped::Tobstacle* o) {
   // remove obstacle from the scene and delete it, report succesful removal
   obstacles.erase(obstacleIter);
   delete o;
+  invalidateFlowFields();
   return true;
 }
 
@@ -131,6 +145,7 @@ bool Ped::Tscene::removeWaypoint(Ped::Twaypoint* w) {
   if (waypointIter == waypoints.end()) return false;
 
   // remove waypoint from the scene and delete it, report succesful removal
+  // (its destructor drops its navigation field)
   waypoints.erase(waypointIter);
   delete w;
 
@@ -216,3 +231,58 @@ void Ped::Tscene::getNeighbors(vector<const Ped::Tagent*>& neighborList,
     }
   }
 }
+
+/// Enables the navigation fields: agents walk along the gradient of the
+/// geodesic distance to their waypoint around the obstacles, instead of the
+/// straight line. The fields are built on first use and shared by all the
+/// agents heading to the same waypoint.
+/// \param   resolutionIn The grid cell size, 0 disables the fields
+/// \param   clearanceIn The distance kept from the walls
+void Ped::Tscene::setFlowFieldResolution(double resolutionIn,
+                                         double clearanceIn) {
+  if (resolutionIn == flowFieldResolution && clearanceIn == flowFieldClearance)
+    return;
+  flowFieldResolution = resolutionIn;
+  flowFieldClearance = clearanceIn;
+  invalidateFlowFields();
+}
+
+/// Returns the navigation field toward a waypoint, built if it does not exist
+/// yet or if the waypoint has moved since. Only the waypoints added to the
+/// scene have one: the temporary waypoints of the planners would each cost a
+/// new field, so agents walk straight to them.
+/// \return  NULL if the fields are disabled, there are no obstacles or the
+/// waypoint is not in the scene
+const Ped::Tflowfield* Ped::Tscene::getFlowField(
+    const Ped::Twaypoint* waypoint) const {
+  if (flowFieldResolution <= 0 || obstacles.empty() || waypoint == NULL ||
+      waypoint->scene != this)
+    return NULL;
+
+  Tflowfield*& field = flowFields[waypoint];
+  if (field != NULL && (field->getGoal() != waypoint->getPosition() ||
+                        field->getGoalRadius() != waypoint->getRadius())) {
+    delete field;
+    field = NULL;
+  }
+  if (field == NULL)
+    field = new Tflowfield(obstacles, waypoint->getPosition(),
+                           waypoint->getRadius(), flowFieldResolution,
+                           flowFieldClearance);
+  return field;
+}
+
+/// Drops the navigation field of a waypoint, called when it is destroyed.
+void Ped::Tscene::dropFlowField(const Ped::Twaypoint* w) {
+  map<const Twaypoint*, Tflowfield*>::iterator fieldIter = flowFields.find(w);
+  if (fieldIter == flowFields.end()) return;
+  delete fieldIter->second;
+  flowFields.erase(fieldIter);
+}
+
+/// Drops all the navigation fields, e.g. after obstacles have been moved. They
+/// are rebuilt on demand.
+void Ped::Tscene::invalidateFlowFields() {
+  for (auto& entry : flowFields) delete entry.second;
+  flowFields.clear();
+}
@@ -5,6 +5,8 @@
 
 #include "ped_waypoint.h"
 #include "ped_agent.h"
+#include "ped_flowfield.h"
+#include "ped_scene.h"
 
 // initialize static variables
 int Ped::Twaypoint::staticid = 0;
@@ -20,9 +22,12 @@ Ped::Twaypoint::Twaypoint(double xIn, double yIn)
 Ped::Twaypoint::Twaypoint(const Ped::Tvector& posIn)
     : id(staticid++), position(posIn), type(Ped::Twaypoint::AreaWaypoint) {}
 
-/// Destructor
+/// Destructor. Drops the navigation field of the waypoint from its scene, so
+/// that a waypoint allocated later at the same address gets its own.
 /// \author  chgloor
-Ped::Twaypoint::~Twaypoint() {}
+Ped::Twaypoint::~Twaypoint() {
+  if (scene != NULL) scene->dropFlowField(this);
+}
 
 /// Returns the force into the direction of the waypoint
 /// \param   agentPos The current position of the agent
@@ -41,6 +46,15 @@ Ped::Tvector Ped::Twaypoint::getForce(const Ped::Tagent& agent,
   Ped::Tvector diff = destination - agentPos;
 
   Ped::Tvector desiredDirection = diff.normalized();
+
+  // walk around the obstacles along the navigation field of the scene, if any
+  const Ped::Tscene* scene = agent.getScene();
+  const Ped::Tflowfield* field =
+      (scene != NULL) ? scene->getFlowField(this) : NULL;
+  Ped::Tvector fieldDirection;
+  if (field != NULL && field->getDirection(agentPos, fieldDirection))
+    desiredDirection = fieldDirection;
+
   Tvector force = (desiredDirection * agent.getVmax() - agent.getVelocity()) /
                   agent.getRelaxationTime();
 
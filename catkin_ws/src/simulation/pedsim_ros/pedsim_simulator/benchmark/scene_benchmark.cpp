@@ -0,0 +1,220 @@
+// Scenario benchmark of the Scene lookups: the indexed queries against the
+// linear scans they replaced, on the agents of a real scenario, and the Gym
+// reset cycle (removeAllWaypoint and new waypoints for every agent).
+// Build with -DSHALL_BENCHMARK=ON, then
+//   rosrun pedsim_simulator scene_benchmark scenarios/airport.xml [steps]
+// No ROS master is needed.
+
+#include <QCoreApplication>
+
+#include <pedsim_simulator/config.h>
+#include <pedsim_simulator/element/agent.h>
+#include <pedsim_simulator/element/areawaypoint.h>
+#include <pedsim_simulator/element/attractionarea.h>
+#include <pedsim_simulator/scenarioreader.h>
+#include <pedsim_simulator/scene.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace std;
+
+static double elapsedNs(chrono::steady_clock::time_point begin) {
+  return chrono::duration<double, nano>(chrono::steady_clock::now() - begin)
+      .count();
+}
+
+static AttractionArea* closestAttractionLinear(const Ped::Tvector& position,
+                                               double* distanceOut) {
+  double minDistance = INFINITY;
+  AttractionArea* minArg = nullptr;
+  foreach (AttractionArea* attraction, SCENE.getAttractions()) {
+    double distance = (attraction->getPosition() - position).length();
+    if (distance < minDistance) {
+      minDistance = distance;
+      minArg = attraction;
+    }
+  }
+  if (distanceOut != nullptr) *distanceOut = minDistance;
+  return minArg;
+}
+
+static Waypoint* waypointByIdLinear(int id) {
+  foreach (Waypoint* waypoint, SCENE.getWaypoints()) {
+    if (waypoint->getId() == id) return waypoint;
+  }
+  return nullptr;
+}
+
+/// Closest attraction from the position of every agent
+static void benchmarkAttractions(const vector<Ped::Tvector>& positions) {
+  if (SCENE.getAttractions().isEmpty()) {
+    printf("closest attraction: no attractions in the scenario\n");
+    return;
+  }
+
+  int numMismatches = 0;
+  double indexedNs = 0, linearNs = 0;
+  for (const Ped::Tvector& position : positions) {
+    double indexedDistance, linearDistance;
+    chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+    SCENE.getClosestAttraction(position, &indexedDistance);
+    indexedNs += elapsedNs(begin);
+
+    begin = chrono::steady_clock::now();
+    closestAttractionLinear(position, &linearDistance);
+    linearNs += elapsedNs(begin);
+
+    if (fabs(indexedDistance - linearDistance) > 1e-9) ++numMismatches;
+  }
+  printf("closest attraction, %4d attractions: %8.1f ns indexed, %8.1f ns "
+         "linear, %d mismatches\n",
+         SCENE.getAttractions().size(), indexedNs / positions.size(),
+         linearNs / positions.size(), numMismatches);
+}
+
+/// Waypoint lookup by id, the planners' hot path
+static void benchmarkWaypointIds() {
+  vector<int> ids;
+  foreach (Waypoint* waypoint, SCENE.getWaypoints())
+    ids.push_back(waypoint->getId());
+  if (ids.empty()) return;
+
+  const int numQueries = 100000;
+  int numFound = 0;
+  chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+  for (int i = 0; i < numQueries; ++i)
+    numFound += SCENE.getWaypointById(ids[i % ids.size()]) != nullptr;
+  double indexedNs = elapsedNs(begin) / numQueries;
+
+  begin = chrono::steady_clock::now();
+  for (int i = 0; i < numQueries; ++i)
+    numFound += waypointByIdLinear(ids[i % ids.size()]) != nullptr;
+  double linearNs = elapsedNs(begin) / numQueries;
+
+  printf("waypoint by id,     %4d waypoints:   %8.1f ns indexed, %8.1f ns "
+         "linear, %d of %d found\n",
+         (int)ids.size(), indexedNs, linearNs, numFound, 2 * numQueries);
+}
+
+/// Agents close to a sink: neighbor query around the sinks against the test
+/// of every agent of the scene
+static void benchmarkSinks() {
+  QList<Waypoint*> sinks;
+  foreach (Waypoint* waypoint, SCENE.getWaypoints()) {
+    if (waypoint->getBehavior() == Ped::Twaypoint::Behavior::SINK)
+      sinks.append(waypoint);
+  }
+  if (sinks.isEmpty()) {
+    printf("sink test: no sinks in the scenario\n");
+    return;
+  }
+
+  const int numRepeats = 1000;
+  int numIndexed = 0, numLinear = 0;
+  chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+  for (int r = 0; r < numRepeats; ++r) {
+    foreach (Waypoint* sink, sinks) {
+      const double radius = sink->getRadius();
+      for (const Ped::Tagent* neighbor :
+           SCENE.getNeighbors(sink->getx(), sink->gety(), radius)) {
+        if ((neighbor->getPosition() - sink->getPosition()).length() < radius)
+          ++numIndexed;
+      }
+    }
+  }
+  double indexedUs = elapsedNs(begin) / numRepeats / 1000;
+
+  begin = chrono::steady_clock::now();
+  for (int r = 0; r < numRepeats; ++r) {
+    foreach (Agent* agent, SCENE.getAgents()) {
+      foreach (Waypoint* sink, sinks) {
+        if ((agent->getPosition() - sink->getPosition()).length() <
+            sink->getRadius())
+          ++numLinear;
+      }
+    }
+  }
+  double linearUs = elapsedNs(begin) / numRepeats / 1000;
+
+  printf("sink test, %2d sinks, %4d agents:   %8.2f us indexed, %8.2f us "
+         "linear, %d vs %d agents within\n",
+         sinks.size(), SCENE.getAgents().size(), indexedUs, linearUs,
+         numIndexed / numRepeats, numLinear / numRepeats);
+}
+
+/// Replaces all the waypoints by two new ones per agent, as the Gym reset
+/// does, and counts the waypoints actually deleted
+static void benchmarkGymReset(int numResets) {
+  int numRemoved = 0, numDestroyed = 0;
+  double resetUs = 0;
+  for (int r = 0; r < numResets; ++r) {
+    numRemoved += SCENE.getWaypoints().size();
+    foreach (Waypoint* waypoint, SCENE.getWaypoints()) {
+      QObject::connect(waypoint, &QObject::destroyed,
+                       [&numDestroyed]() { ++numDestroyed; });
+    }
+
+    chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+    SCENE.removeAllWaypoint();
+    int i = 0;
+    foreach (Agent* agent, SCENE.getAgents()) {
+      if (agent->getType() == Ped::Tagent::ROBOT) continue;
+      for (int k = 0; k < 2; ++k) {
+        QString name = QString("gym_wp_%1_%2").arg(i).arg(k);
+        Ped::Tvector position =
+            agent->getPosition() + Ped::Tvector(k == 0 ? 5 : -5, 0);
+        Waypoint* waypoint = new AreaWaypoint(name, position, 0.5);
+        SCENE.addWaypoint(waypoint);
+        agent->addWaypoint(waypoint);
+      }
+      agent->updateState();
+      ++i;
+    }
+    resetUs += elapsedNs(begin) / 1000;
+
+    // a few steps with the new waypoints before the next reset
+    for (int s = 0; s < 5; ++s) SCENE.moveAllAgents();
+  }
+  printf("gym reset, %4d agents:              %8.1f us per reset, %d of "
+         "%d removed waypoints deleted\n",
+         SCENE.getAgents().size(), resetUs / numResets, numDestroyed,
+         numRemoved);
+}
+
+int main(int argc, char** argv) {
+  QCoreApplication app(argc, argv);
+  if (argc < 2) {
+    fprintf(stderr, "Usage: scene_benchmark scenario.xml [steps]\n");
+    return 1;
+  }
+  const int numSteps = argc > 2 ? atoi(argv[2]) : 500;
+
+  ScenarioReader scenarioReader;
+  if (!scenarioReader.parseFile(argv[1])) {
+    fprintf(stderr, "Could not load %s: %s\n", argv[1],
+            scenarioReader.getErrorString().toStdString().c_str());
+    return 1;
+  }
+  ScenarioReader::buildScene(scenarioReader.getDescription());
+
+  // the clusters are dissolved into agents at the first step
+  chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+  for (int step = 0; step < numSteps; ++step) SCENE.moveAllAgents();
+  printf("%s: %d agents after %d steps, %.3f ms per step\n", argv[1],
+         SCENE.getAgents().size(), numSteps,
+         elapsedNs(begin) / numSteps / 1e6);
+
+  vector<Ped::Tvector> positions;
+  foreach (Agent* agent, SCENE.getAgents())
+    positions.push_back(agent->getPosition());
+
+  benchmarkAttractions(positions);
+  benchmarkWaypointIds();
+  benchmarkSinks();
+  benchmarkGymReset(20);
+  return 0;
+}
@@ -72,6 +72,7 @@ class AgentStateMachine : public QObject {
   // Methods
  public:
   void doStateTransition();
+  void reset();
   AgentState getCurrentState();
 
  protected:
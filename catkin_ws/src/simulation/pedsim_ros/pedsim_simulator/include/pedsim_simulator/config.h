@@ -107,6 +107,10 @@ class Config : public QObject {
   // enable/disable groups behaviour
   bool groups_enabled;
 
+  // flow field navigation around obstacles, disabled if the resolution is 0
+  double flow_field_resolution;
+  double flow_field_clearance;
+
   // cells
   double cell_width;
   double cell_height;
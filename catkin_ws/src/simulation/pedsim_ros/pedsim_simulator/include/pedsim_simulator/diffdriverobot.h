@@ -0,0 +1,75 @@
+/**
+* Copyright 2014 Social Robotics Lab, University of Freiburg
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+*    # Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*    # Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*    # Neither the name of the University of Freiburg nor the names of its
+*       contributors may be used to endorse or promote products derived from
+*       this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _diffdriverobot_h_
+#define _diffdriverobot_h_
+
+#include <cmath>
+
+/// --------------------------------------
+/// \class DiffDriveRobot
+/// \brief Unicycle model of the simulated robot base
+/// \details Integrates the commanded translational and rotational velocity
+/// with a fixed time step. Shared by simulate_diff_drive_robot, which steps
+/// it at wall-clock rate, and the simulator, which steps it together with the
+/// pedestrians.
+/// --------------------------------------
+class DiffDriveRobot {
+ public:
+  DiffDriveRobot(double xIn = 0, double yIn = 0, double thetaIn = 0)
+      : x(xIn), y(yIn), theta(thetaIn), v(0), omega(0) {}
+
+  void setPose(double xIn, double yIn, double thetaIn) {
+    x = xIn;
+    y = yIn;
+    theta = thetaIn;
+  }
+  void setCommand(double vIn, double omegaIn) {
+    v = vIn;
+    omega = omegaIn;
+  }
+
+  /// Same explicit Euler step as the original simulate_diff_drive_robot
+  void step(double dt) {
+    x += std::cos(theta) * v * dt;
+    y += std::sin(theta) * v * dt;
+    theta += omega * dt;
+  }
+
+  double getx() const { return x; }
+  double gety() const { return y; }
+  double getTheta() const { return theta; }
+  double getvx() const { return std::cos(theta) * v; }
+  double getvy() const { return std::sin(theta) * v; }
+
+ protected:
+  double x, y, theta;
+  double v, omega;
+};
+
+#endif
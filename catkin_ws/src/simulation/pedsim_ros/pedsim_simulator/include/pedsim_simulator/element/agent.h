@@ -125,7 +125,7 @@ class Agent : public ScenarioElement, public Ped::Tagent {
   // samliu 20210814
   inline void RestoreInitPosition(void) {setPosition(last_position_.x, last_position_.y);}
   inline void SaveInitPosition(double xIn, double yIn) {last_position_.x = xIn; last_position_.y = yIn;}
-  inline void removeAllWaypoint() { destinations.clear(); }
+  void removeAllWaypoint();
 
   // → VisibleScenarioElement Overrides/Overloads
  public:
@@ -37,11 +37,14 @@
 
 #ifndef Q_MOC_RUN
 #include <ros/ros.h>
+#include <QHash>
 #include <QPointF>
+#include <QVector>
 #endif
 
 // Forward Declarations
 class Agent;
+class QueueingWaypointPlanner;
 
 class WaitingQueue : public Waypoint {
   Q_OBJECT
@@ -65,7 +68,6 @@ class WaitingQueue : public Waypoint {
   // Slots
  protected slots:
   void onTimeChanged(double timeIn);
-  void onLastAgentPositionChanged(double xIn, double yIn);
 
   // Methods
  public:
@@ -76,17 +78,28 @@ class WaitingQueue : public Waypoint {
 
   // → Queueing behavior
   bool isEmpty() const;
+  int size() const;
+  bool isQueued(const Agent* agentIn) const;
+  const Agent* getAgentAhead(const Agent* agentIn) const;
   Ped::Tvector getQueueEndPosition() const;
   const Agent* enqueueAgent(Agent* agentIn);
   bool dequeueAgent(Agent* agentIn);
   bool hasReachedWaitingPosition();
 
+  // → planners heading to the queue, called in the order they were added
+  void addPlanner(QueueingWaypointPlanner* plannerIn);
+  void removePlanner(QueueingWaypointPlanner* plannerIn);
+  static WaitingQueue* getQueueEndingWith(const Agent* agentIn);
+  void onLastAgentPositionChanged(const Ped::Tvector& positionIn);
+
  protected:
   void resetDequeueTime();
   void startDequeueTime();
 
  protected:
   void informAboutEndPosition();
+  void setBack(int node);
+  void compactPlanners();
 
   // → Waypoint Overrides
  public:
@@ -103,7 +116,30 @@ class WaitingQueue : public Waypoint {
  protected:
   Ped::Tangle direction;
 
-  QList<Agent*> queuedAgents;
+  // → queued agents, a doubly linked list in an array
+  struct QueueNode {
+    Agent* agent;
+    int previous;  ///< index of the agent ahead, or -1
+    int next;      ///< index of the agent behind, or -1
+  };
+  QVector<QueueNode> nodes;
+  QVector<int> freeNodes;
+  QHash<const Agent*, int> nodeOfAgent;
+  int front;  ///< first agent in line, or -1
+  int back;   ///< last agent in line, or -1
+
+  Agent* frontAgent() const;
+  Agent* backAgent() const;
+
+  // → planners informed about the queue, in the order they were added. A
+  // removed planner leaves a null entry, skipped by the calls to the planners,
+  // and the list is compacted between calls once half of it is removed.
+  QVector<QueueingWaypointPlanner*> planners;
+  QHash<const QueueingWaypointPlanner*, int> plannerIndex;
+  int removedPlanners;
+  int plannerCallDepth;
+  // → queue of each last agent in line
+  static QHash<const Agent*, WaitingQueue*> queueEnds;
 
   // → dequeueing
   double waitDurationLambda;
@@ -49,6 +49,10 @@ class RandomNumberGenerator {
  public:
   static RandomNumberGenerator& getInstance();
 
+  // Methods
+ public:
+  void seed(unsigned int seedIn);
+
   // Operators
  public:
   std::default_random_engine& operator()();
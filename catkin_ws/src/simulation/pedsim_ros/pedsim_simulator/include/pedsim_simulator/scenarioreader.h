@@ -34,9 +34,63 @@
 
 #include <pedsim_simulator/scene.h>
 
-#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <QVector>
 #include <QXmlStreamReader>
 
+/// --------------------------------------
+/// \struct ScenarioDescription
+/// \brief Parsed and validated scenario file
+///
+/// Plain values only, the scene elements are created from it by
+/// ScenarioReader::buildScene(). It is kept by the simulator to rebuild the
+/// scene without parsing the file again.
+/// --------------------------------------
+struct ScenarioDescription {
+  struct Obstacle {
+    double x1, y1, x2, y2;
+  };
+  struct Waypoint {
+    QString id;
+    double x, y, r;
+    int behavior;
+  };
+  struct Queue {
+    QString id;
+    double x, y;
+    double direction;  ///< [deg]
+  };
+  struct Attraction {
+    QString id;
+    double x, y;
+    double width, height;
+    double strength;
+  };
+  struct Destination {
+    QString id;
+    bool isQueue;  ///< <addqueue> instead of <addwaypoint>
+    int line;      ///< for diagnostics
+  };
+  struct AgentCluster {
+    double x, y;
+    int n;
+    double dx, dy;
+    int type;
+    bool isSource;  ///< <source>, respawned by the simulator
+    QVector<Destination> destinations;  ///< in the order of the file
+  };
+
+  QVector<Obstacle> obstacles;
+  QVector<Waypoint> waypoints;
+  QVector<Queue> queues;
+  QVector<Attraction> attractions;
+  QVector<AgentCluster> agentClusters;
+
+  int agentCount() const;
+  void clear();
+};
+
 class ScenarioReader {
   // Constructor and Destructor
  public:
@@ -45,16 +99,31 @@ class ScenarioReader {
   // Methods
  public:
   bool readFromFile(const QString& filename);
+  bool parseFile(const QString& filename);
+  static void buildScene(const ScenarioDescription& description);
+
+  const ScenarioDescription& getDescription() const { return description; }
+  const QString& getErrorString() const { return errorString; }
 
  protected:
   void processData();
+  bool requireAttributes(const QXmlStreamAttributes& attributes,
+                         const QStringList& names);
+  double toDouble(const QXmlStreamAttributes& attributes, const QString& name,
+                  double defaultValue = 0.0);
+  int toInt(const QXmlStreamAttributes& attributes, const QString& name,
+            int defaultValue = 0);
+  void raiseError(const QString& message);
+  void checkReferences();
 
   // Attributes
  private:
   QXmlStreamReader xmlReader;
+  ScenarioDescription description;
+  QString filename;
+  QString errorString;
 
-  AgentCluster* currentAgents;
-  SpawnArea* currentSpawnArea;
+  int currentAgents;  ///< index of the open <agent> or <source>, or -1
 };
 
 #endif
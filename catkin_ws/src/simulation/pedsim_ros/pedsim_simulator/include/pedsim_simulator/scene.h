@@ -34,10 +34,12 @@
 
 #include <pedsim/ped_scene.h>
 #include <pedsim/ped_vector.h>
+#include <QHash>
 #include <QMap>
 #include <QObject>
 #include <QRectF>
 
+#include <pedsim_simulator/spatialindex.h>
 #include <pedsim_simulator/utilities.h>
 
 // Forward Declarations
@@ -102,6 +104,7 @@ class Scene : public QObject, protected Ped::Tscene {
   void moveAllAgents();
  protected slots:
   void cleanupScene();
+  void invalidateAttractionIndex();
 
   // Methods
  public:
@@ -133,6 +136,7 @@ class Scene : public QObject, protected Ped::Tscene {
 
  protected:
   void dissolveClusters();
+  void removeAgentsAtSinks();
 
  public:
   virtual void addAgent(Agent* agent);
@@ -165,6 +169,12 @@ class Scene : public QObject, protected Ped::Tscene {
   QList<AgentCluster*> agentClusters;
   QList<AgentGroup*> agentGroups;
 
+  // → indexes for the per step lookups
+  QHash<int, Agent*> agentsById;
+  QHash<int, Waypoint*> waypointsById;
+  mutable SpatialIndex<AttractionArea*> attractionIndex;
+  mutable bool attractionIndexValid;
+
   std::vector<SpawnArea*> spawn_areas;
 
   // → simulated time
@@ -34,6 +34,7 @@
 #include <ros/console.h>
 #include <ros/ros.h>
 
+#include <tf/transform_broadcaster.h>
 #include <tf/transform_listener.h>
 #include <functional>
 #include <memory>
@@ -51,13 +52,16 @@
 #include <geometry_msgs/Point.h>
 #include <geometry_msgs/PoseStamped.h>
 #include <geometry_msgs/PoseWithCovariance.h>
+#include <geometry_msgs/Twist.h>
 #include <geometry_msgs/TwistWithCovariance.h>
 #include <nav_msgs/Odometry.h>
+#include <rosgraph_msgs/Clock.h>
 #include <std_msgs/Header.h>
 #include <std_srvs/Empty.h>
 
 #include <pedsim_simulator/agentstatemachine.h>
 #include <pedsim_simulator/config.h>
+#include <pedsim_simulator/diffdriverobot.h>
 #include <pedsim_simulator/element/agent.h>
 #include <pedsim_simulator/element/agentgroup.h>
 #include <pedsim_simulator/element/attractionarea.h>
@@ -74,6 +78,7 @@
 #include <pedsim_simulator/element/areawaypoint.h>
 #include <geometry_msgs/Pose2D.h>
 #include <pedsim_srvs/GymReset.h>
+#include <pedsim_srvs/StepSimulation.h>
 
 using SimConfig = pedsim_simulator::PedsimSimulatorConfig;
 
@@ -94,6 +99,11 @@ class Simulator {
                            std_srvs::Empty::Response& response);
   bool GymResetCb(pedsim_srvs::GymReset::Request& request,
                   pedsim_srvs::GymReset::Response& response);
+  bool onResetScenario(std_srvs::Empty::Request& request,
+                       std_srvs::Empty::Response& response);
+  bool onStepSimulation(pedsim_srvs::StepSimulation::Request& request,
+                        pedsim_srvs::StepSimulation::Response& response);
+  void onRobotCommand(const geometry_msgs::Twist::ConstPtr& twist);
 
   void spawnCallback(const ros::TimerEvent& event);
 
@@ -102,7 +112,9 @@ class Simulator {
   dynamic_reconfigure::Server<SimConfig> server_;
 
  private:
+  void step();
   void updateRobotPositionFromTF();
+  void updateRobotPositionFromIntegrator();
   void publishAgents();
   void publishGroups();
   void publishObstacles();
@@ -112,6 +124,8 @@ class Simulator {
  private:
   ros::NodeHandle nh_;
   bool paused_;
+  // steps only on request and publishes /clock, instead of wall-clock rate
+  bool lockstep_;
   ros::Timer spawn_timer_;
 
   // publishers
@@ -120,11 +134,17 @@ class Simulator {
   ros::Publisher pub_agent_groups_;
   ros::Publisher pub_robot_position_;
   ros::Publisher pub_waypoints_;
+  ros::Publisher pub_clock_;
 
   // provided services
   ros::ServiceServer srv_pause_simulation_;
   ros::ServiceServer srv_unpause_simulation_;
   ros::ServiceServer srv_gym_reset_;
+  ros::ServiceServer srv_reset_scenario_;
+  ros::ServiceServer srv_step_simulation_;
+
+  // parsed scene file, the scene is rebuilt from it on reset
+  ScenarioDescription scenario_;
 
   // frame ids
   std::string frame_id_;
@@ -136,6 +156,13 @@ class Simulator {
   tf::StampedTransform last_robot_pose_;
   geometry_msgs::Quaternion last_robot_orientation_;
 
+  // robot base integrated in the simulation step instead of read from TF
+  bool internal_robot_;
+  DiffDriveRobot robot_base_;
+  double robot_initial_x_, robot_initial_y_, robot_initial_theta_;
+  ros::Subscriber sub_robot_cmd_;
+  std::unique_ptr<tf::TransformBroadcaster> transform_broadcaster_;
+
   inline std::string agentStateToActivity(
       const AgentStateMachine::AgentState& state) const;
 
@@ -0,0 +1,186 @@
+/**
+* Copyright 2014 Social Robotics Lab, University of Freiburg
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+*    # Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*    # Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*    # Neither the name of the University of Freiburg nor the names of its
+*       contributors may be used to endorse or promote products derived from
+*       this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _spatialindex_h_
+#define _spatialindex_h_
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+/// --------------------------------------
+/// \class SpatialIndex
+/// \brief Uniform grid over static points (attractions, waypoints)
+///
+/// Nearest neighbor and radius queries only visit the cells around the query
+/// position instead of every element. The elements are inserted first, then
+/// build() sizes the grid to about two elements per cell. The index does not
+/// track moving elements, it has to be cleared and built again when one of
+/// them moves.
+/// --------------------------------------
+template <typename T>
+class SpatialIndex {
+ public:
+  SpatialIndex() : cellSize(1.0), originX(0), originY(0), width(0), height(0) {}
+
+  void clear() {
+    entries.clear();
+    cells.clear();
+    width = height = 0;
+  }
+
+  bool isEmpty() const { return entries.empty(); }
+  int size() const { return static_cast<int>(entries.size()); }
+
+  void insert(T element, double x, double y) {
+    entries.push_back(Entry{element, x, y});
+  }
+
+  void build() {
+    cells.clear();
+    width = height = 0;
+    if (entries.empty()) return;
+
+    double minX = entries.front().x, maxX = minX;
+    double minY = entries.front().y, maxY = minY;
+    for (const Entry& entry : entries) {
+      minX = std::min(minX, entry.x);
+      maxX = std::max(maxX, entry.x);
+      minY = std::min(minY, entry.y);
+      maxY = std::max(maxY, entry.y);
+    }
+    const double area = std::max((maxX - minX) * (maxY - minY), 1.0);
+    cellSize = std::max(std::sqrt(2.0 * area / entries.size()), 0.5);
+    originX = minX;
+    originY = minY;
+    width = static_cast<int>((maxX - minX) / cellSize) + 1;
+    height = static_cast<int>((maxY - minY) / cellSize) + 1;
+
+    cells.resize(width * height);
+    for (const Entry& entry : entries)
+      cells[index(cellX(entry.x), cellY(entry.y))].push_back(entry);
+  }
+
+  /// Returns the element closest to x/y, or T() if the index is empty.
+  /// The rings of cells around x/y are searched until no closer element can
+  /// be found.
+  T nearest(double x, double y, double* distanceOut = nullptr) const {
+    double minDistance = INFINITY;
+    T minArg = T();
+    if (!cells.empty()) {
+      const int cx = cellX(x);
+      const int cy = cellY(y);
+      // skip the empty rings between x/y and the grid
+      const int firstRing = std::max(std::max(0, std::max(-cx, cx - width + 1)),
+                                     std::max(-cy, cy - height + 1));
+      const int lastRing = std::max(std::max(cx, width - 1 - cx),
+                                    std::max(cy, height - 1 - cy));
+      for (int ring = firstRing; ring <= lastRing; ++ring) {
+        // every element of the following rings is at least this far away
+        if (minDistance <= (ring - 1) * cellSize) break;
+        visitRing(cx, cy, ring, [&](const Entry& entry) {
+          const double distance = std::hypot(entry.x - x, entry.y - y);
+          if (distance < minDistance) {
+            minDistance = distance;
+            minArg = entry.element;
+          }
+        });
+      }
+    }
+
+    if (distanceOut != nullptr) *distanceOut = minDistance;
+    return minArg;
+  }
+
+  /// Appends the elements within radius of x/y to resultOut.
+  void query(double x, double y, double radius,
+             std::vector<T>& resultOut) const {
+    if (cells.empty()) return;
+    const int ix0 = std::max(0, cellX(x - radius));
+    const int ix1 = std::min(width - 1, cellX(x + radius));
+    const int iy0 = std::max(0, cellY(y - radius));
+    const int iy1 = std::min(height - 1, cellY(y + radius));
+    for (int iy = iy0; iy <= iy1; ++iy) {
+      for (int ix = ix0; ix <= ix1; ++ix) {
+        for (const Entry& entry : cells[index(ix, iy)]) {
+          if (std::hypot(entry.x - x, entry.y - y) <= radius)
+            resultOut.push_back(entry.element);
+        }
+      }
+    }
+  }
+
+ protected:
+  struct Entry {
+    T element;
+    double x;
+    double y;
+  };
+
+  int cellX(double x) const {
+    return static_cast<int>(std::floor((x - originX) / cellSize));
+  }
+  int cellY(double y) const {
+    return static_cast<int>(std::floor((y - originY) / cellSize));
+  }
+  int index(int ix, int iy) const { return iy * width + ix; }
+
+  /// Calls visitor on the entries of the cells at Chebyshev distance ring
+  /// from cx/cy, restricted to the grid.
+  template <typename Visitor>
+  void visitRing(int cx, int cy, int ring, Visitor visitor) const {
+    for (int iy = std::max(0, cy - ring); iy <= std::min(height - 1, cy + ring);
+         ++iy) {
+      if (iy == cy - ring || iy == cy + ring) {
+        // full row
+        for (int ix = std::max(0, cx - ring);
+             ix <= std::min(width - 1, cx + ring); ++ix)
+          visitCell(ix, iy, visitor);
+      } else {
+        // only the left and right border
+        if (cx - ring >= 0) visitCell(cx - ring, iy, visitor);
+        if (cx + ring < width) visitCell(cx + ring, iy, visitor);
+      }
+    }
+  }
+
+  template <typename Visitor>
+  void visitCell(int ix, int iy, Visitor& visitor) const {
+    for (const Entry& entry : cells[index(ix, iy)]) visitor(entry);
+  }
+
+  double cellSize;
+  double originX;  ///< lower left corner of the grid
+  double originY;
+  int width;
+  int height;
+  std::vector<Entry> entries;
+  std::vector<std::vector<Entry>> cells;
+};
+
+#endif
@@ -36,6 +36,8 @@
 #include <pedsim_simulator/rng.h>
 #include <pedsim_simulator/waypointplanner/waypointplanner.h>
 
+#include <QHash>
+
 // Forward Declarations
 class WaitingQueue;
 
@@ -48,18 +50,17 @@ class QueueingWaypointPlanner : public WaypointPlanner {
   // Constructor and Destructor
  public:
   QueueingWaypointPlanner();
-
-  // Slots
- protected slots:
-  void onFollowedAgentPositionChanged(double xIn, double yIn);
-  void onAgentMayPassQueue(int id);
-  void onFollowedAgentLeftQueue();
-  void onQueueEndPositionChanged(double xIn, double yIn);
+  virtual ~QueueingWaypointPlanner();
 
   // Methods
  public:
   void reset();
 
+  // → moves and departures of queued agents, called right after they happen
+  //   in the order the queue's signals used to reach the planners
+  static void onAgentPositionChanged(const Agent* agentIn);
+  static void onAgentDequeued(const Agent* agentIn);
+
   // → Agent
   virtual Agent* getAgent() const;
   virtual bool setAgent(Agent* agentIn);
@@ -72,7 +73,14 @@ class QueueingWaypointPlanner : public WaypointPlanner {
   void activateApproachingMode();
   void activateQueueingMode();
 
+  // → WaitingQueue events
+  void onAgentMayPassQueue(const Agent* passingAgent);
+  void onQueueEndPositionChanged(const Ped::Tvector& queueEnd);
+
  protected:
+  void onFollowedAgentPositionChanged(const Ped::Tvector& followedPosition);
+  void onFollowedAgentLeftQueue();
+
   void addPrivateSpace(Ped::Tvector& queueEndIn) const;
   QString createWaypointName() const;
 
@@ -96,6 +104,9 @@ class QueueingWaypointPlanner : public WaypointPlanner {
   Waypoint* currentWaypoint;
   const Agent* followedAgent;
   QueueingStatus status;
+
+  // → planner following each queued agent
+  static QHash<const Agent*, QueueingWaypointPlanner*> followers;
 };
 
 #endif
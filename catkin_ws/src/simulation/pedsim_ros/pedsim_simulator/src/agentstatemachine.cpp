@@ -313,6 +313,18 @@ QString AgentStateMachine::stateToName(AgentState stateIn) const {
   }
 }
 
+/// Forgets the destination of the agent, e.g. before its waypoints are
+/// deleted. The next transition picks a new one.
+void AgentStateMachine::reset() {
+  activateState(StateNone);
+
+  // the idle planners must not keep pointers to the old destinations
+  if (individualPlanner != nullptr) individualPlanner->setDestination(nullptr);
+  if (queueingPlanner != nullptr) queueingPlanner->setWaitingQueue(nullptr);
+  if (groupWaypointPlanner != nullptr)
+    groupWaypointPlanner->setDestination(nullptr);
+}
+
 AgentStateMachine::AgentState AgentStateMachine::getCurrentState() {
   return state;
 }
@@ -56,6 +56,9 @@ Config::Config(QObject* parent) {
   max_robot_speed = 2.0;
 
   groups_enabled = true;
+
+  flow_field_resolution = 0.0;
+  flow_field_clearance = 0.3;
   group_size_lambda = 1.1;
   wait_time_beta = 0.2;
 
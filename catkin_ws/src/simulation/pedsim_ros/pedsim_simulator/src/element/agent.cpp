@@ -35,6 +35,7 @@
 #include <pedsim_simulator/element/waypoint.h>
 #include <pedsim_simulator/force/force.h>
 #include <pedsim_simulator/scene.h>
+#include <pedsim_simulator/waypointplanner/queueingplanner.h>
 #include <pedsim_simulator/waypointplanner/waypointplanner.h>
 
 Agent::Agent() {
@@ -58,6 +59,8 @@ Agent::Agent() {
 Agent::~Agent() {
   // clean up
   foreach (Force* currentForce, forces) { delete currentForce; }
+  // → the planners leave their waiting queue
+  delete stateMachine;
 }
 
 /// Calculates the desired force. Same as in lib, but adds graphical
@@ -201,6 +204,7 @@ void Agent::move(double h) {
 
   // inform users
   emit positionChanged(getx(), gety());
+  QueueingWaypointPlanner::onAgentPositionChanged(this);
   emit velocityChanged(getvx(), getvy());
   emit accelerationChanged(getax(), getay());
 }
@@ -223,6 +227,14 @@ bool Agent::removeWaypoint(Waypoint* waypointIn) {
   return (removeCount > 0);
 }
 
+void Agent::removeAllWaypoint() {
+  destinations.clear();
+  currentDestination = nullptr;
+
+  // the waypoint planners must not keep the old destinations either
+  stateMachine->reset();
+}
+
 bool Agent::needNewDestination() const {
   if (waypointplanner == nullptr)
     return (!destinations.isEmpty());
@@ -304,6 +316,7 @@ void Agent::setPosition(double xIn, double yIn) {
 
   // inform users
   emit positionChanged(xIn, yIn);
+  QueueingWaypointPlanner::onAgentPositionChanged(this);
 }
 
 void Agent::setX(double xIn) { setPosition(xIn, gety()); }
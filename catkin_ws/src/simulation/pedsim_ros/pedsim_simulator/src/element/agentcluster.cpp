@@ -34,6 +34,11 @@
 #include <pedsim_simulator/rng.h>
 #include <pedsim_simulator/scene.h>
 
+#include <QHash>
+#include <QPair>
+#include <QVector>
+#include <cmath>
+
 AgentCluster::AgentCluster(double xIn, double yIn, int countIn) {
   static int lastID = 0;
 
@@ -50,6 +55,13 @@ AgentCluster::~AgentCluster() {}
 
 QList<Agent*> AgentCluster::dissolve() {
   QList<Agent*> agents;
+  agents.reserve(count);
+
+  // spawned positions bucketed by cells of the collision distance, so that a
+  // candidate is only compared with the agents of the neighboring cells
+  typedef QPair<int, int> Cell;
+  QHash<Cell, QVector<Ped::Tvector>> spawned;
+  spawned.reserve(count);
 
   std::uniform_real_distribution<double> randomX(-distribution.width() / 2,
                                                  distribution.width() / 2);
@@ -67,17 +79,29 @@ QList<Agent*> AgentCluster::dissolve() {
       bool flag_collision;
       double distance_threshold = std::min(std::min(distribution.width(), distribution.height()) / 2,
                                            0.5);
+      auto cellOf = [distance_threshold](double x, double y) {
+        return Cell(static_cast<int>(std::floor(x / distance_threshold)),
+                    static_cast<int>(std::floor(y / distance_threshold)));
+      };
       // Check if collision occur, re-generate agent spawn position
       do{
         randomizedX = position.x + randomX(RNG()) * 2;
         randomizedY = position.y + randomY(RNG()) * 2;
         flag_collision = false;
-        for(auto agent : agents) {
-          double distance = std::hypot(randomizedX - agent->getx(),
-                                       randomizedY - agent->gety());
-          if(distance < distance_threshold) { flag_collision = true; break;}
+        const Cell cell = cellOf(randomizedX, randomizedY);
+        for (int cx = cell.first - 1; cx <= cell.first + 1; ++cx) {
+          for (int cy = cell.second - 1; cy <= cell.second + 1; ++cy) {
+            if (flag_collision) break;
+            for (const Ped::Tvector& other : spawned.value(Cell(cx, cy))) {
+              double distance = std::hypot(randomizedX - other.x,
+                                           randomizedY - other.y);
+              if(distance < distance_threshold) { flag_collision = true; break;}
+            }
+          }
         }
       }while(flag_collision);
+      spawned[cellOf(randomizedX, randomizedY)].append(
+          Ped::Tvector(randomizedX, randomizedY));
     }else{
       // Original pedsim code
       if (distribution.width() != 0) randomizedX += randomX(RNG());
@@ -34,6 +34,9 @@
 #include <pedsim_simulator/element/waitingqueue.h>
 #include <pedsim_simulator/rng.h>
 #include <pedsim_simulator/scene.h>
+#include <pedsim_simulator/waypointplanner/queueingplanner.h>
+
+QHash<const Agent*, WaitingQueue*> WaitingQueue::queueEnds;
 
 WaitingQueue::WaitingQueue(const QString& nameIn, Ped::Tvector positionIn,
                            Ped::Tangle directionIn)
@@ -41,21 +44,38 @@ WaitingQueue::WaitingQueue(const QString& nameIn, Ped::Tvector positionIn,
   // initialize values
   dequeueTime = INFINITY;
   waitDurationLambda = CONFIG.wait_time_beta;
+  front = -1;
+  back = -1;
+  removedPlanners = 0;
+  plannerCallDepth = 0;
 
   // connect signals
   connect(&SCENE, SIGNAL(sceneTimeChanged(double)), this,
           SLOT(onTimeChanged(double)));
 }
 
-WaitingQueue::~WaitingQueue() {}
+WaitingQueue::~WaitingQueue() {
+  // forget the queued agents, then send the planners elsewhere
+  setBack(-1);
+  front = -1;
+  nodes.clear();
+  freeNodes.clear();
+  nodeOfAgent.clear();
+
+  const QVector<QueueingWaypointPlanner*> currentPlanners = planners;
+  planners.clear();
+  plannerIndex.clear();
+  for (QueueingWaypointPlanner* planner : currentPlanners)
+    if (planner != nullptr) planner->setWaitingQueue(nullptr);
+}
 
 void WaitingQueue::onTimeChanged(double timeIn) {
   // skip when there is none
-  if (queuedAgents.empty()) {
+  if (isEmpty()) {
     return;
   }
 
-  Agent* firstInLine = queuedAgents.first();
+  Agent* firstInLine = frontAgent();
 
   // check whether waiting started
   if (std::isinf(dequeueTime)) {
@@ -69,14 +89,19 @@ void WaitingQueue::onTimeChanged(double timeIn) {
   if (dequeueTime <= timeIn) {
     // dequeue agent and inform users
     emit agentMayPass(firstInLine->getId());
+    // skip the planners removed by a previous one and leave out the ones
+    // added meanwhile, as a signal would
+    ++plannerCallDepth;
+    const int plannerCount = planners.size();
+    for (int i = 0; i < plannerCount; ++i) {
+      if (planners[i] != nullptr) planners[i]->onAgentMayPassQueue(firstInLine);
+    }
+    --plannerCallDepth;
+    compactPlanners();
     dequeueAgent(firstInLine);
   }
 }
 
-void WaitingQueue::onLastAgentPositionChanged(double xIn, double yIn) {
-  emit queueEndPositionChanged(xIn, yIn);
-}
-
 Ped::Tangle WaitingQueue::getDirection() const { return direction; }
 
 void WaitingQueue::setDirection(const Ped::Tangle& angleIn) {
@@ -97,37 +122,62 @@ void WaitingQueue::setDirection(const Ped::Tvector& directionIn) {
   emit directionChanged(direction.toRadian());
 }
 
-bool WaitingQueue::isEmpty() const { return queuedAgents.isEmpty(); }
+bool WaitingQueue::isEmpty() const { return front < 0; }
+
+int WaitingQueue::size() const { return nodeOfAgent.size(); }
+
+bool WaitingQueue::isQueued(const Agent* agentIn) const {
+  return nodeOfAgent.contains(agentIn);
+}
+
+const Agent* WaitingQueue::getAgentAhead(const Agent* agentIn) const {
+  const int node = nodeOfAgent.value(agentIn, -1);
+  if (node < 0 || nodes[node].previous < 0) return nullptr;
+  return nodes[nodes[node].previous].agent;
+}
+
+Agent* WaitingQueue::frontAgent() const {
+  return (front < 0) ? nullptr : nodes[front].agent;
+}
+
+Agent* WaitingQueue::backAgent() const {
+  return (back < 0) ? nullptr : nodes[back].agent;
+}
 
 Ped::Tvector WaitingQueue::getQueueEndPosition() const {
-  if (queuedAgents.isEmpty())
+  if (isEmpty())
     return position;
   else
-    return queuedAgents.last()->getPosition();
+    return backAgent()->getPosition();
 }
 
 const Agent* WaitingQueue::enqueueAgent(Agent* agentIn) {
   // determine output
-  const Agent* aheadAgent =
-      (queuedAgents.isEmpty()) ? nullptr : queuedAgents.last();
+  const Agent* aheadAgent = backAgent();
 
-  // add agent to queue
-  queuedAgents.append(agentIn);
+  // add agent to queue, reusing a free node
+  int node;
+  if (freeNodes.isEmpty()) {
+    node = nodes.size();
+    nodes.append(QueueNode());
+  } else {
+    node = freeNodes.takeLast();
+  }
+  nodes[node].agent = agentIn;
+  nodes[node].previous = back;
+  nodes[node].next = -1;
+  if (back >= 0)
+    nodes[back].next = node;
+  else
+    front = node;
+  setBack(node);
+  nodeOfAgent.insert(agentIn, node);
 
   // inform about new first in line
   if (aheadAgent == nullptr) {
     emit queueLeaderChanged(agentIn->getId());
   }
 
-  // stay informed about updates on queue end
-  connect(agentIn, SIGNAL(positionChanged(double, double)), this,
-          SLOT(onLastAgentPositionChanged(double, double)));
-  // ignore updates from previous queue end
-  if (aheadAgent != nullptr) {
-    disconnect(aheadAgent, SIGNAL(positionChanged(double, double)), this,
-               SLOT(onLastAgentPositionChanged(double, double)));
-  }
-
   // inform users
   emit queueEndChanged();
   informAboutEndPosition();
@@ -138,40 +188,49 @@ const Agent* WaitingQueue::enqueueAgent(Agent* agentIn) {
 
 bool WaitingQueue::dequeueAgent(Agent* agentIn) {
   // sanity checks
-  if (queuedAgents.isEmpty()) {
+  if (isEmpty()) {
     ROS_DEBUG("Cannot dequeue agent from empty waiting queue!");
     return false;
   }
 
-  // remove agent from queue
-  bool dequeueSuccess;
-  bool dequeuedWasFirst = (queuedAgents.first() == agentIn);
-  bool dequeuedWasLast = (queuedAgents.last() == agentIn);
-  if (dequeuedWasFirst) {
-    queuedAgents.removeFirst();
-    dequeueSuccess = true;
-  } else {
+  const int node = nodeOfAgent.value(agentIn, -1);
+  if (node < 0) {
+    ROS_DEBUG("Agent isn't waiting in queue! (Agent: %s, Queue: %s)",
+              agentIn->toString().toStdString().c_str(),
+              this->toString().toStdString().c_str());
+    return false;
+  }
+
+  // remove agent from queue by unlinking its node
+  bool dequeueSuccess = true;
+  bool dequeuedWasFirst = (node == front);
+  bool dequeuedWasLast = (node == back);
+  if (!dequeuedWasFirst) {
     ROS_DEBUG("Dequeueing agent from queue (%s), not in front of the queue",
               agentIn->toString().toStdString().c_str());
-    int removedCount = queuedAgents.removeAll(agentIn);
-    dequeueSuccess = (removedCount >= 1);
-
-    if (dequeueSuccess == false) {
-      ROS_DEBUG("Agent isn't waiting in queue! (Agent: %s, Queue: %s)",
-                agentIn->toString().toStdString().c_str(),
-                this->toString().toStdString().c_str());
-      return false;
-    }
   }
+  const int previous = nodes[node].previous;
+  const int next = nodes[node].next;
+  if (previous >= 0)
+    nodes[previous].next = next;
+  else
+    front = next;
+  if (next >= 0)
+    nodes[next].previous = previous;
+  else
+    setBack(previous);
+  nodes[node].agent = nullptr;
+  freeNodes.append(node);
+  nodeOfAgent.remove(agentIn);
 
   // inform other agents
   emit agentDequeued(agentIn->getId());
+  QueueingWaypointPlanner::onAgentDequeued(agentIn);
 
   // update leading position
   if (dequeuedWasFirst) {
     // determine new first agent in line
-    const Agent* newFront =
-        (queuedAgents.isEmpty()) ? nullptr : queuedAgents.first();
+    const Agent* newFront = frontAgent();
 
     // reset time for next agent
     resetDequeueTime();
@@ -183,9 +242,6 @@ bool WaitingQueue::dequeueAgent(Agent* agentIn) {
 
   // update queue end
   if (dequeuedWasLast) {
-    disconnect(agentIn, SIGNAL(positionChanged(double, double)), this,
-               SLOT(onLastAgentPositionChanged(double, double)));
-
     emit queueEndChanged();
     informAboutEndPosition();
   }
@@ -194,13 +250,13 @@ bool WaitingQueue::dequeueAgent(Agent* agentIn) {
 }
 
 bool WaitingQueue::hasReachedWaitingPosition() {
-  if (queuedAgents.isEmpty()) return false;
+  if (isEmpty()) return false;
 
   // const double waitingRadius = 0.7;
   const double waitingRadius = 0.3;
 
   // compute distance from where queue starts
-  const Agent* leadingAgent = queuedAgents.first();
+  const Agent* leadingAgent = frontAgent();
   Ped::Tvector diff = leadingAgent->getPosition() - position;
   return (diff.length() < waitingRadius);
 }
@@ -222,15 +278,70 @@ void WaitingQueue::startDequeueTime() {
 
 void WaitingQueue::informAboutEndPosition() {
   // inform users
-  if (queuedAgents.isEmpty()) {
-    emit queueEndPositionChanged(position.x, position.y);
+  if (isEmpty()) {
+    onLastAgentPositionChanged(position);
   } else {
-    Agent* lastAgent = queuedAgents.last();
-    Ped::Tvector endPosition = lastAgent->getPosition();
-    emit queueEndPositionChanged(endPosition.x, endPosition.y);
+    Agent* lastAgent = backAgent();
+    onLastAgentPositionChanged(lastAgent->getPosition());
   }
 }
 
+void WaitingQueue::onLastAgentPositionChanged(const Ped::Tvector& positionIn) {
+  emit queueEndPositionChanged(positionIn.x, positionIn.y);
+
+  // the planners react right away, in the order they were added
+  ++plannerCallDepth;
+  const int plannerCount = planners.size();
+  for (int i = 0; i < plannerCount; ++i) {
+    if (planners[i] != nullptr)
+      planners[i]->onQueueEndPositionChanged(positionIn);
+  }
+  --plannerCallDepth;
+  compactPlanners();
+}
+
+void WaitingQueue::addPlanner(QueueingWaypointPlanner* plannerIn) {
+  if (plannerIndex.contains(plannerIn)) return;
+  plannerIndex.insert(plannerIn, planners.size());
+  planners.append(plannerIn);
+}
+
+void WaitingQueue::removePlanner(QueueingWaypointPlanner* plannerIn) {
+  const int index = plannerIndex.value(plannerIn, -1);
+  if (index < 0) return;
+  plannerIndex.remove(plannerIn);
+  planners[index] = nullptr;
+  ++removedPlanners;
+  compactPlanners();
+}
+
+void WaitingQueue::compactPlanners() {
+  // the calls to the planners running iterate by index; compacting once half
+  // of the entries are removed keeps a removal O(1) amortized
+  if (plannerCallDepth > 0 || 2 * removedPlanners <= planners.size()) return;
+
+  int count = 0;
+  for (int i = 0; i < planners.size(); ++i) {
+    if (planners[i] == nullptr) continue;
+    planners[count] = planners[i];
+    plannerIndex[planners[count]] = count;
+    ++count;
+  }
+  planners.resize(count);
+  removedPlanners = 0;
+}
+
+WaitingQueue* WaitingQueue::getQueueEndingWith(const Agent* agentIn) {
+  return queueEnds.value(agentIn, nullptr);
+}
+
+void WaitingQueue::setBack(int node) {
+  if (back >= 0 && queueEnds.value(nodes[back].agent) == this)
+    queueEnds.remove(nodes[back].agent);
+  back = node;
+  if (back >= 0) queueEnds.insert(nodes[back].agent, this);
+}
+
 Ped::Tvector WaitingQueue::closestPoint(const Ped::Tvector& p,
                                         bool* withinWaypoint) const {
   return getQueueEndPosition();
@@ -246,8 +357,8 @@ void WaitingQueue::setVisiblePosition(const QPointF& positionIn) {
 
 QString WaitingQueue::toString() const {
   QStringList waitingIDs;
-  foreach (const Agent* agent, queuedAgents)
-    waitingIDs.append(QString::number(agent->getId()));
+  for (int node = front; node >= 0; node = nodes[node].next)
+    waitingIDs.append(QString::number(nodes[node].agent->getId()));
   QString waitingString = waitingIDs.join(",");
 
   return tr("WaitingQueue '%1' (@%2,%3; queue: %4)")
@@ -45,6 +45,10 @@ RandomNumberGenerator& RandomNumberGenerator::getInstance() {
   return *instance;
 }
 
+void RandomNumberGenerator::seed(unsigned int seedIn) {
+  randomEngine.seed(seedIn);
+}
+
 std::default_random_engine& RandomNumberGenerator::operator()() {
   return randomEngine;
 }
@@ -38,27 +38,59 @@
 #include <pedsim_simulator/scenarioreader.h>
 
 #include <QFile>
+#include <QSet>
 #include <iostream>
 
 #include <ros/ros.h>
 
+int ScenarioDescription::agentCount() const {
+  int count = 0;
+  for (const AgentCluster& cluster : agentClusters) count += cluster.n;
+  return count;
+}
+
+void ScenarioDescription::clear() {
+  obstacles.clear();
+  waypoints.clear();
+  queues.clear();
+  attractions.clear();
+  agentClusters.clear();
+}
+
 ScenarioReader::ScenarioReader() {
   // initialize values
-  currentAgents = nullptr;
-  currentSpawnArea = nullptr;
+  currentAgents = -1;
 }
 
 bool ScenarioReader::readFromFile(const QString& filename) {
-  ROS_DEBUG("Loading scenario file '%s'.", filename.toStdString().c_str());
+  if (!parseFile(filename)) return false;
+
+  // create the scene elements
+  buildScene(description);
+
+  // report success
+  return true;
+}
+
+bool ScenarioReader::parseFile(const QString& filenameIn) {
+  ROS_DEBUG("Loading scenario file '%s'.", filenameIn.toStdString().c_str());
+
+  // reset previous results
+  filename = filenameIn;
+  description.clear();
+  errorString.clear();
+  currentAgents = -1;
 
   // open file
   QFile file(filename);
   if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-    ROS_DEBUG("Couldn't open scenario file!");
+    errorString = QString("%1: couldn't open scenario file").arg(filename);
+    ROS_ERROR_STREAM(errorString.toStdString());
     return false;
   }
 
   // read input
+  xmlReader.clear();
   xmlReader.setDevice(&file);
 
   while (!xmlReader.atEnd()) {
@@ -66,17 +98,83 @@ bool ScenarioReader::readFromFile(const QString& filename) {
     processData();
   }
 
-  // check for errors
+  // check for errors, with the position of the offending element
   if (xmlReader.hasError()) {
-    // TODO - fix qstring and std string issues here to show error lines
-    ROS_DEBUG("Error while reading scenario file");
+    errorString = QString("%1:%2:%3: %4")
+                      .arg(filename)
+                      .arg(xmlReader.lineNumber())
+                      .arg(xmlReader.columnNumber())
+                      .arg(xmlReader.errorString());
+    ROS_ERROR_STREAM(errorString.toStdString());
+    description.clear();
     return false;
   }
 
+  checkReferences();
+
+  ROS_DEBUG("Scenario with %d obstacles, %d waypoints and %d agents.",
+            description.obstacles.size(),
+            description.waypoints.size() + description.queues.size(),
+            description.agentCount());
+
   // report success
   return true;
 }
 
+void ScenarioReader::buildScene(const ScenarioDescription& description) {
+  // obstacles, waypoints and attractions first, the agents refer to them
+  for (const ScenarioDescription::Obstacle& o : description.obstacles)
+    SCENE.addObstacle(new Obstacle(o.x1, o.y1, o.x2, o.y2));
+
+  for (const ScenarioDescription::Waypoint& w : description.waypoints) {
+    AreaWaypoint* waypoint = new AreaWaypoint(w.id, w.x, w.y, w.r);
+    waypoint->setBehavior(static_cast<Ped::Twaypoint::Behavior>(w.behavior));
+    SCENE.addWaypoint(waypoint);
+  }
+
+  for (const ScenarioDescription::Queue& q : description.queues) {
+    const Ped::Tvector position(q.x, q.y);
+    const Ped::Tangle direction = Ped::Tangle::fromDegree(q.direction);
+    SCENE.addWaitingQueue(new WaitingQueue(q.id, position, direction));
+  }
+
+  for (const ScenarioDescription::Attraction& a : description.attractions) {
+    AttractionArea* attraction = new AttractionArea(a.id);
+    attraction->setPosition(a.x, a.y);
+    attraction->setSize(a.width, a.height);
+    attraction->setStrength(a.strength);
+    SCENE.addAttraction(attraction);
+  }
+
+  for (const ScenarioDescription::AgentCluster& c :
+       description.agentClusters) {
+    AgentCluster* agentCluster = new AgentCluster(c.x, c.y, c.n);
+    agentCluster->setDistribution(c.dx, c.dy);
+
+    /// TODO - change agents Vmax distribution based on agent type
+    /// and other force parameters to realize different behaviours
+    agentCluster->setType(static_cast<Ped::Tagent::AgentType>(c.type));
+
+    SpawnArea* spawnArea = nullptr;
+    if (c.isSource) spawnArea = new SpawnArea(c.x, c.y, c.n, c.dx, c.dy);
+
+    for (const ScenarioDescription::Destination& d : c.destinations) {
+      if (d.isQueue) {
+        WaitingQueue* queue = SCENE.getWaitingQueueByName(d.id);
+        if (queue != nullptr) agentCluster->addWaitingQueue(queue);
+      } else {
+        Waypoint* waypoint = SCENE.getWaypointByName(d.id);
+        if (waypoint == nullptr) continue;
+        agentCluster->addWaypoint(waypoint);
+        if (spawnArea != nullptr) spawnArea->waypoints.emplace_back(d.id);
+      }
+    }
+
+    SCENE.addAgentCluster(agentCluster);
+    if (spawnArea != nullptr) SCENE.addSpawnArea(spawnArea);
+  }
+}
+
 void ScenarioReader::processData() {
   if (xmlReader.isStartElement()) {
     const QString elementName = xmlReader.name().toString();
@@ -85,113 +183,173 @@ void ScenarioReader::processData() {
     if ((elementName == "scenario") || (elementName == "welcome")) {
       // nothing to do
     } else if (elementName == "obstacle") {
-      const double x1 = elementAttributes.value("x1").toString().toDouble();
-      const double y1 = elementAttributes.value("y1").toString().toDouble();
-      const double x2 = elementAttributes.value("x2").toString().toDouble();
-      const double y2 = elementAttributes.value("y2").toString().toDouble();
-      Obstacle* obs = new Obstacle(x1, y1, x2, y2);
-      SCENE.addObstacle(obs);
+      if (!requireAttributes(elementAttributes, {"x1", "y1", "x2", "y2"}))
+        return;
+      ScenarioDescription::Obstacle obstacle;
+      obstacle.x1 = toDouble(elementAttributes, "x1");
+      obstacle.y1 = toDouble(elementAttributes, "y1");
+      obstacle.x2 = toDouble(elementAttributes, "x2");
+      obstacle.y2 = toDouble(elementAttributes, "y2");
+      description.obstacles.append(obstacle);
     } else if (elementName == "waypoint") {
-      const QString id = elementAttributes.value("id").toString();
-      const double x = elementAttributes.value("x").toString().toDouble();
-      const double y = elementAttributes.value("y").toString().toDouble();
-      const double r = elementAttributes.value("r").toString().toDouble();
-      // TODO - make the setting of waypoint behavior optional, 
-      // and default to SIMPLE.
-      const int b = elementAttributes.value("b").toString().toInt();
-      AreaWaypoint* w = new AreaWaypoint(id, x, y, r);
-      w->setBehavior(static_cast<Ped::Twaypoint::Behavior>(b));
-      SCENE.addWaypoint(w);
+      if (!requireAttributes(elementAttributes, {"id", "x", "y", "r"})) return;
+      ScenarioDescription::Waypoint waypoint;
+      waypoint.id = elementAttributes.value("id").toString();
+      waypoint.x = toDouble(elementAttributes, "x");
+      waypoint.y = toDouble(elementAttributes, "y");
+      waypoint.r = toDouble(elementAttributes, "r");
+      // the behavior is optional and defaults to SIMPLE
+      waypoint.behavior =
+          toInt(elementAttributes, "b", Ped::Twaypoint::Behavior::SIMPLE);
+      if (waypoint.r < 0)
+        raiseError(QString("negative radius of waypoint '%1'").arg(waypoint.id));
+      if (waypoint.behavior < Ped::Twaypoint::Behavior::SIMPLE ||
+          waypoint.behavior > Ped::Twaypoint::Behavior::SINK)
+        raiseError(QString("invalid behavior %1 of waypoint '%2'")
+                       .arg(waypoint.behavior)
+                       .arg(waypoint.id));
+      description.waypoints.append(waypoint);
     } else if (elementName == "queue") {
-      const QString id = elementAttributes.value("id").toString();
-      const double x = elementAttributes.value("x").toString().toDouble();
-      const double y = elementAttributes.value("y").toString().toDouble();
-      const double directionValue =
-          elementAttributes.value("direction").toString().toDouble();
-
-      const Ped::Tvector position(x, y);
-      const Ped::Tangle direction = Ped::Tangle::fromDegree(directionValue);
-
-      WaitingQueue* queue = new WaitingQueue(id, position, direction);
-      SCENE.addWaitingQueue(queue);
+      if (!requireAttributes(elementAttributes, {"id", "x", "y"})) return;
+      ScenarioDescription::Queue queue;
+      queue.id = elementAttributes.value("id").toString();
+      queue.x = toDouble(elementAttributes, "x");
+      queue.y = toDouble(elementAttributes, "y");
+      queue.direction = toDouble(elementAttributes, "direction");
+      description.queues.append(queue);
     } else if (elementName == "attraction") {
-      const QString id = elementAttributes.value("id").toString();
-      const double x = elementAttributes.value("x").toString().toDouble();
-      const double y = elementAttributes.value("y").toString().toDouble();
-      const double width =
-          elementAttributes.value("width").toString().toDouble();
-      const double height =
-          elementAttributes.value("height").toString().toDouble();
-      const double strength =
-          elementAttributes.value("strength").toString().toDouble();
-
-      AttractionArea* attraction = new AttractionArea(id);
-      attraction->setPosition(x, y);
-      attraction->setSize(width, height);
-      attraction->setStrength(strength);
-      SCENE.addAttraction(attraction);
-    } else if (elementName == "agent") {
-      const double x = elementAttributes.value("x").toString().toDouble();
-      const double y = elementAttributes.value("y").toString().toDouble();
-      const int n = elementAttributes.value("n").toString().toInt();
-      const double dx = elementAttributes.value("dx").toString().toDouble();
-      const double dy = elementAttributes.value("dy").toString().toDouble();
-      const int type = elementAttributes.value("type").toString().toInt();
-      AgentCluster* agentCluster = new AgentCluster(x, y, n);
-      agentCluster->setDistribution(dx, dy);
-
-      /// TODO - change agents Vmax distribution based on agent type
-      /// and other force parameters to realize different behaviours
-      agentCluster->setType(static_cast<Ped::Tagent::AgentType>(type));
-      SCENE.addAgentCluster(agentCluster);
-      currentAgents = agentCluster;
-    } else if (elementName == "source") {
-      const double x = elementAttributes.value("x").toString().toDouble();
-      const double y = elementAttributes.value("y").toString().toDouble();
-      const int n = elementAttributes.value("n").toString().toInt();
-      const double dx = elementAttributes.value("dx").toString().toDouble();
-      const double dy = elementAttributes.value("dy").toString().toDouble();
-      const int type = elementAttributes.value("type").toString().toInt();
-      AgentCluster* agentCluster = new AgentCluster(x, y, n);
-      agentCluster->setDistribution(dx, dy);
-      agentCluster->setType(static_cast<Ped::Tagent::AgentType>(type));
-      SCENE.addAgentCluster(agentCluster);
-      currentAgents = agentCluster;
-
-      SpawnArea* spawn_area = new SpawnArea(x, y, n, dx, dy);
-      SCENE.addSpawnArea(spawn_area);
-      currentSpawnArea = spawn_area;
-    } else if (elementName == "addwaypoint") {
-      if (currentAgents == nullptr) {
-        ROS_DEBUG("Invalid <addwaypoint> element outside of agent element!");
+      if (!requireAttributes(elementAttributes, {"id", "x", "y"})) return;
+      ScenarioDescription::Attraction attraction;
+      attraction.id = elementAttributes.value("id").toString();
+      attraction.x = toDouble(elementAttributes, "x");
+      attraction.y = toDouble(elementAttributes, "y");
+      attraction.width = toDouble(elementAttributes, "width");
+      attraction.height = toDouble(elementAttributes, "height");
+      attraction.strength = toDouble(elementAttributes, "strength");
+      description.attractions.append(attraction);
+    } else if ((elementName == "agent") || (elementName == "source")) {
+      if (currentAgents >= 0) {
+        raiseError(QString("<%1> inside of another agent element")
+                       .arg(elementName));
         return;
       }
-
-      // add waypoints to current <agent> element
-      QString id = elementAttributes.value("id").toString();
-      currentAgents->addWaypoint(SCENE.getWaypointByName(id));
-
-      if (currentSpawnArea != nullptr) {
-        currentSpawnArea->waypoints.emplace_back(id);
-      }
-    } else if (elementName == "addqueue") {
-      if (currentAgents == nullptr) {
-        ROS_DEBUG("Invalid <addqueue> element outside of agent element!");
+      if (!requireAttributes(elementAttributes, {"x", "y", "n"})) return;
+      ScenarioDescription::AgentCluster cluster;
+      cluster.x = toDouble(elementAttributes, "x");
+      cluster.y = toDouble(elementAttributes, "y");
+      cluster.n = toInt(elementAttributes, "n");
+      cluster.dx = toDouble(elementAttributes, "dx");
+      cluster.dy = toDouble(elementAttributes, "dy");
+      cluster.type = toInt(elementAttributes, "type", Ped::Tagent::ADULT);
+      cluster.isSource = (elementName == "source");
+      if (cluster.n < 0)
+        raiseError(QString("negative agent count %1").arg(cluster.n));
+      if (cluster.type < Ped::Tagent::ADULT ||
+          cluster.type > Ped::Tagent::ELDER)
+        raiseError(QString("invalid agent type %1").arg(cluster.type));
+      description.agentClusters.append(cluster);
+      currentAgents = description.agentClusters.size() - 1;
+    } else if ((elementName == "addwaypoint") ||
+               (elementName == "addqueue")) {
+      if (currentAgents < 0) {
+        raiseError(
+            QString("<%1> outside of an agent element").arg(elementName));
         return;
       }
+      if (!requireAttributes(elementAttributes, {"id"})) return;
 
-      // add waiting queue to current <agent> element
-      QString id = elementAttributes.value("id").toString();
-      currentAgents->addWaitingQueue(SCENE.getWaitingQueueByName(id));
+      // add waypoints to current <agent> element, resolved in buildScene()
+      ScenarioDescription::Destination destination;
+      destination.id = elementAttributes.value("id").toString();
+      destination.isQueue = (elementName == "addqueue");
+      destination.line = static_cast<int>(xmlReader.lineNumber());
+      description.agentClusters[currentAgents].destinations.append(
+          destination);
     } else {
-      // inform the user about invalid elements
-      ROS_DEBUG("Unknown element: <%s>", elementName.toStdString().c_str());
+      raiseError(QString("unknown element <%1>").arg(elementName));
     }
   } else if (xmlReader.isEndElement()) {
     const QString elementName = xmlReader.name().toString();
 
-    if (elementName == "agent") {
-      currentAgents = nullptr;
+    if ((elementName == "agent") || (elementName == "source")) {
+      currentAgents = -1;
+    }
+  }
+}
+
+/// Raises an error if one of the attributes is missing.
+bool ScenarioReader::requireAttributes(const QXmlStreamAttributes& attributes,
+                                       const QStringList& names) {
+  for (const QString& name : names) {
+    if (!attributes.hasAttribute(name)) {
+      raiseError(QString("missing attribute '%1' of <%2>")
+                     .arg(name)
+                     .arg(xmlReader.name().toString()));
+      return false;
+    }
+  }
+  return true;
+}
+
+double ScenarioReader::toDouble(const QXmlStreamAttributes& attributes,
+                                const QString& name, double defaultValue) {
+  if (!attributes.hasAttribute(name)) return defaultValue;
+  const QString text = attributes.value(name).toString();
+  bool ok = false;
+  const double value = text.toDouble(&ok);
+  if (!ok) {
+    raiseError(QString("attribute '%1' of <%2> is not a number: '%3'")
+                   .arg(name)
+                   .arg(xmlReader.name().toString())
+                   .arg(text));
+    return defaultValue;
+  }
+  return value;
+}
+
+int ScenarioReader::toInt(const QXmlStreamAttributes& attributes,
+                          const QString& name, int defaultValue) {
+  if (!attributes.hasAttribute(name)) return defaultValue;
+  const QString text = attributes.value(name).toString();
+  bool ok = false;
+  const int value = text.toInt(&ok);
+  if (!ok) {
+    raiseError(QString("attribute '%1' of <%2> is not an integer: '%3'")
+                   .arg(name)
+                   .arg(xmlReader.name().toString())
+                   .arg(text));
+    return defaultValue;
+  }
+  return value;
+}
+
+/// Stops the parsing, the error is reported with the current line.
+void ScenarioReader::raiseError(const QString& message) {
+  // keep the first error
+  if (!xmlReader.hasError()) xmlReader.raiseError(message);
+}
+
+/// Warns about destinations of agents which are not defined in the file,
+/// they are skipped when the scene is built.
+void ScenarioReader::checkReferences() {
+  QSet<QString> waypointIds, queueIds;
+  for (const ScenarioDescription::Waypoint& w : description.waypoints)
+    waypointIds.insert(w.id);
+  for (const ScenarioDescription::Queue& q : description.queues) {
+    waypointIds.insert(q.id);
+    queueIds.insert(q.id);
+  }
+
+  for (const ScenarioDescription::AgentCluster& c :
+       description.agentClusters) {
+    for (const ScenarioDescription::Destination& d : c.destinations) {
+      const QSet<QString>& ids = d.isQueue ? queueIds : waypointIds;
+      if (!ids.contains(d.id)) {
+        ROS_WARN_STREAM(filename.toStdString()
+                        << ":" << d.line << ": unknown "
+                        << (d.isQueue ? "queue" : "waypoint") << " '"
+                        << d.id.toStdString() << "', skipped");
+      }
     }
   }
 }
@@ -54,6 +54,7 @@ Scene* Scene::Scene::instance = nullptr;
 Scene::Scene(QObject* parent) {
   // initialize values
   sceneTime = 0;
+  attractionIndexValid = false;
 
   // TODO: create this dynamically according to scenario
   QRect area(-500, -500, 1000, 1000);
@@ -83,10 +84,12 @@ void Scene::clear() {
   // remove all agents
   // note: we don't need to delete them, because Ped::Tscene did so already
   agents.clear();
+  agentsById.clear();
 
   // remove all waypoints
   // note: we don't need to delete them, because Ped::Tscene did so already
   waypoints.clear();
+  waypointsById.clear();
 
   // remove all obstacles
   // note: we don't need to delete them, because Ped::Tscene did so already
@@ -96,6 +99,7 @@ void Scene::clear() {
   foreach (AttractionArea* attraction, attractions)
     delete attraction;
   attractions.clear();
+  invalidateAttractionIndex();
 
   // remove all agents clusters
   foreach (AgentCluster* agentCluster, agentClusters)
@@ -107,6 +111,10 @@ void Scene::clear() {
     delete group;
   agentGroups.clear();
 
+  // remove all spawn areas
+  for (SpawnArea* spawnArea : spawn_areas) delete spawnArea;
+  spawn_areas.clear();
+
   // don't clear the grid, because we can reuse it
 
   // reset time
@@ -180,11 +188,7 @@ QList<AgentGroup*> Scene::getGroups() { return agentGroups; }
 QMap<QString, AttractionArea*> Scene::getAttractions() { return attractions; }
 
 Agent* Scene::getAgentById(int idIn) const {
-  foreach (Agent* currentAgent, agents) {
-    if (idIn == currentAgent->getId()) return currentAgent;
-  }
-
-  return nullptr;
+  return agentsById.value(idIn, nullptr);
 }
 
 const QList<Obstacle*>& Scene::getObstacles() const { return obstacles; }
@@ -198,11 +202,7 @@ const QMap<QString, AttractionArea*>& Scene::getAttractions() const {
 }
 
 Waypoint* Scene::getWaypointById(int idIn) const {
-  foreach (Waypoint* currentWaypoint, waypoints) {
-    if (idIn == currentWaypoint->getId()) return currentWaypoint;
-  }
-
-  return nullptr;
+  return waypointsById.value(idIn, nullptr);
 }
 
 Waypoint* Scene::getWaypointByName(const QString& nameIn) const {
@@ -224,22 +224,19 @@ AttractionArea* Scene::getAttractionByName(const QString& nameIn) const {
 
 AttractionArea* Scene::getClosestAttraction(const Ped::Tvector& positionIn,
                                             double* distanceOut) const {
-  double minDistance = INFINITY;
-  AttractionArea* minArg = nullptr;
-
-  // find the attraction with minimal distance
-  foreach (AttractionArea* attraction, attractions) {
-    double distance = (attraction->getPosition() - positionIn).length();
-    if (distance < minDistance) {
-      minDistance = distance;
-      minArg = attraction;
+  // rebuild the index after attractions have been added, removed or moved
+  if (!attractionIndexValid) {
+    attractionIndex.clear();
+    foreach (AttractionArea* attraction, attractions) {
+      Ped::Tvector position = attraction->getPosition();
+      attractionIndex.insert(attraction, position.x, position.y);
     }
+    attractionIndex.build();
+    attractionIndexValid = true;
   }
 
-  // additionally return distance
-  if (distanceOut != nullptr) *distanceOut = minDistance;
-
-  return minArg;
+  // find the attraction with minimal distance
+  return attractionIndex.nearest(positionIn.x, positionIn.y, distanceOut);
 }
 
 double Scene::getTime() const { return sceneTime; }
@@ -299,6 +296,7 @@ void Scene::dissolveClusters() {
 void Scene::addAgent(Agent* agent) {
   // keep track of the agent
   agents.append(agent);
+  agentsById.insert(agent->getId(), agent);
 
   // add the agent to the PedSim scene
   Ped::Tscene::addAgent(agent);
@@ -329,6 +327,7 @@ void Scene::addObstacle(Obstacle* obstacle) {
 void Scene::addWaypoint(Waypoint* waypoint) {
   // keep track of the waypoints
   waypoints.insert(waypoint->getName(), waypoint);
+  waypointsById.insert(waypoint->getId(), waypoint);
 
   // add the obstacle to the PedSim scene
   Ped::Tscene::addWaypoint(waypoint);
@@ -368,6 +367,9 @@ void Scene::addAttraction(AttractionArea* attractionIn) {
 
   // add attraction to the scene
   attractions.insert(attractionIn->getName(), attractionIn);
+  connect(attractionIn, SIGNAL(positionChanged(double, double)), this,
+          SLOT(invalidateAttractionIndex()));
+  invalidateAttractionIndex();
 
   // inform users
   emit attractionAdded(attractionIn->getName());
@@ -376,6 +378,7 @@ void Scene::addAttraction(AttractionArea* attractionIn) {
 bool Scene::removeAgent(Agent* agent) {
   // don't keep track of agent anymore
   agents.removeAll(agent);
+  agentsById.remove(agent->getId());
 
   // remove agent from all groups
   QList<AgentGroup*> groupsToRemove;
@@ -415,6 +418,7 @@ bool Scene::removeObstacle(Obstacle* obstacle) {
 bool Scene::removeWaypoint(Waypoint* waypoint) {
   // don't keep track of waypoint anymore
   waypoints.remove(waypoint->getName());
+  waypointsById.remove(waypoint->getId());
 
   // remove waypoint from all agent clusters
   // (it is also removed from all agents in Ped::Tscene::removeWaypoint())
@@ -457,6 +461,7 @@ bool Scene::removeWaitingQueue(WaitingQueue* queueIn) {
 
   // check whether the queue was removed
   if (removedCount == 0) return false;
+  waypointsById.remove(queueIn->getId());
 
   // inform users
   emit waitingQueueRemoved(queueIn->getName());
@@ -480,6 +485,7 @@ bool Scene::removeAttraction(AttractionArea* attractionInIn) {
 
   // check whether the queue was removed
   if (removedCount == 0) return false;
+  invalidateAttractionIndex();
 
   // inform users
   emit attractionRemoved(attractionInIn->getName());
@@ -535,50 +541,62 @@ void Scene::moveAllAgents() {
   emit sceneTimeChanged(sceneTime);
 
   // move the agents
+  Ped::Tscene::setFlowFieldResolution(CONFIG.flow_field_resolution,
+                                      CONFIG.flow_field_clearance);
   Ped::Tscene::moveAgents(CONFIG.getTimeStepSize());
 
-  auto Dist = [](const double ax, const double ay, const double bx,
-                 const double by) -> double {
-    return std::hypot(ax - bx, ay - by);
-  };
-
-  // For every agents, if next WP is sink and 'close', call removeAgent.
-  for (auto agent : getAgents()) {
-    const auto agent_next_wp = agent->getCurrentWaypoint();
-    // skip agents without any waypoint
-    if (!agent_next_wp) {
-      continue;
-    }
+  // remove the agents which reached their sink
+  removeAgentsAtSinks();
 
-    if (agent_next_wp->getBehavior() != Ped::Twaypoint::Behavior::SINK) {
-      continue;
-    }
+  // inform users
+  emit movedAgents();
+}
 
-    const double d = Dist(agent_next_wp->getx(), agent_next_wp->gety(),
-                          agent->getx(), agent->gety());
-    if (d < agent_next_wp->getRadius()) {
-      // At sink waypoint.
-      ROS_DEBUG_STREAM("Killing agent: " << agent->getId());
-      removeAgent(agent);
+void Scene::removeAgentsAtSinks() {
+  // only the agents close to a sink are candidates, they are found with the
+  // neighbor tree instead of testing every agent of the scene
+  QList<Agent*> agentsToRemove;
+  foreach (Waypoint* waypoint, waypoints) {
+    if (waypoint->getBehavior() != Ped::Twaypoint::Behavior::SINK) continue;
+
+    const double radius = waypoint->getRadius();
+    for (const Ped::Tagent* neighbor :
+         getNeighbors(waypoint->getx(), waypoint->gety(), radius)) {
+      // skip agents walking to another waypoint
+      if (neighbor->getCurrentWaypoint() != waypoint) continue;
+
+      const double d =
+          (neighbor->getPosition() - waypoint->getPosition()).length();
+      Agent* agent = agentsById.value(neighbor->getId(), nullptr);
+      if (d < radius && agent != nullptr) agentsToRemove.append(agent);
     }
   }
 
-  // inform users
-  emit movedAgents();
+  foreach (Agent* agent, agentsToRemove) {
+    // At sink waypoint.
+    ROS_DEBUG_STREAM("Killing agent: " << agent->getId());
+    removeAgent(agent);
+  }
 }
 
+void Scene::invalidateAttractionIndex() { attractionIndexValid = false; }
+
 void Scene::cleanupScene() { Ped::Tscene::cleanup(); }
 
 
 void Scene::removeAllWaypoint() {
-  foreach(const auto& key, waypoints.keys()) {
-    foreach (AgentCluster* cluster, agentClusters){
-      Waypoint* wp = waypoints[key];
+  // detach the agents from their destinations first, nothing may reference
+  // the waypoints once they are deleted
+  foreach (Agent* agent, agents) agent->removeAllWaypoint();
+
+  // single pass over the waypoints, each one is removed from every cluster
+  // and deleted by Ped::Tscene together with its navigation field
+  foreach (Waypoint* wp, waypoints) {
+    foreach (AgentCluster* cluster, agentClusters)
       cluster->removeWaypoint(wp);
-      waypoints.remove(key);
-      emit waypointRemoved(wp->getId());  // inform users
-      Ped::Tscene::removeWaypoint(wp);
-    }
+    emit waypointRemoved(wp->getId());  // inform users
+    Ped::Tscene::removeWaypoint(wp);
   }
   waypoints.clear();
-}
\ No newline at end of file
+  waypointsById.clear();
+}
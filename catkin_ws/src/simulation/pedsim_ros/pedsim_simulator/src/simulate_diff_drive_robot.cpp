@@ -3,13 +3,15 @@
 
 #include <tf/transform_broadcaster.h>
 
+#include <pedsim_simulator/diffdriverobot.h>
+
 #include <boost/thread.hpp>
 #include <boost/thread/mutex.hpp>
 
 double g_updateRate, g_simulationFactor;
 std::string g_worldFrame, g_robotFrame;
 geometry_msgs::Twist g_currentTwist;
-tf::Transform g_currentPose;
+DiffDriveRobot g_robot;
 boost::shared_ptr<tf::TransformBroadcaster> g_transformBroadcaster;
 boost::mutex mutex;
 
@@ -24,32 +26,24 @@ void updateLoop() {
   const double dt = g_simulationFactor / g_updateRate;
 
   while (true) {
-    // Get current pose
-    double x = g_currentPose.getOrigin().x();
-    double y = g_currentPose.getOrigin().y();
-    double theta = tf::getYaw(g_currentPose.getRotation());
-
     // Get requested translational and rotational velocity
-    double v, omega;
     {
       boost::mutex::scoped_lock lock(mutex);
-      v = g_currentTwist.linear.x;
-      omega = g_currentTwist.angular.z;
+      g_robot.setCommand(g_currentTwist.linear.x, g_currentTwist.angular.z);
     }
 
     // Simulate robot movement
-    x += cos(theta) * v * dt;
-    y += sin(theta) * v * dt;
-    theta += omega * dt;
+    g_robot.step(dt);
 
     // Update pose
-    g_currentPose.getOrigin().setX(x);
-    g_currentPose.getOrigin().setY(y);
-    g_currentPose.setRotation(tf::createQuaternionFromRPY(0, 0, theta));
+    tf::Transform currentPose;
+    currentPose.setOrigin(tf::Vector3(g_robot.getx(), g_robot.gety(), 0));
+    currentPose.setRotation(
+        tf::createQuaternionFromRPY(0, 0, g_robot.getTheta()));
 
     // Broadcast transform
     g_transformBroadcaster->sendTransform(tf::StampedTransform(
-        g_currentPose, ros::Time::now(), g_worldFrame, g_robotFrame));
+        currentPose, ros::Time::now(), g_worldFrame, g_robotFrame));
 
     rate.sleep();
   }
@@ -79,9 +73,7 @@ int main(int argc, char** argv) {
   privateHandle.param<double>("pose_initial_y", initialY, 0.0);
   privateHandle.param<double>("pose_initial_theta", initialTheta, 0.0);
 
-  g_currentPose.getOrigin().setX(initialX);
-  g_currentPose.getOrigin().setY(initialY);
-  g_currentPose.setRotation(tf::createQuaternionFromRPY(0, 0, initialTheta));
+  g_robot.setPose(initialX, initialY, initialTheta);
 
   // Create ROS subscriber and TF broadcaster
   g_transformBroadcaster.reset(new tf::TransformBroadcaster());
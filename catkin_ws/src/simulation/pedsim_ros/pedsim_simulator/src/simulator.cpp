@@ -35,6 +35,7 @@
 #include <pedsim_simulator/element/agentcluster.h>
 #include <pedsim_simulator/scene.h>
 #include <pedsim_simulator/simulator.h>
+#include <ros/callback_queue.h>
 
 #include <pedsim_utils/geometry.h>
 
@@ -53,9 +54,11 @@ Simulator::~Simulator() {
   pub_agent_groups_.shutdown();
   pub_robot_position_.shutdown();
   pub_waypoints_.shutdown();
+  pub_clock_.shutdown();
 
   srv_pause_simulation_.shutdown();
   srv_unpause_simulation_.shutdown();
+  srv_step_simulation_.shutdown();
 
   delete robot_;
   QCoreApplication::exit(0);
@@ -89,6 +92,8 @@ bool Simulator::initializeSimulation() {
       "unpause_simulation", &Simulator::onUnpauseSimulation, this);
   srv_gym_reset_ = nh_.advertiseService(
       "gym_reset", &Simulator::GymResetCb, this);
+  srv_reset_scenario_ = nh_.advertiseService(
+      "reset_scenario", &Simulator::onResetScenario, this);
 
   // setup TF listener and other pointers
   transform_listener_.reset(new tf::TransformListener());
@@ -106,18 +111,28 @@ bool Simulator::initializeSimulation() {
 
   const QString scenefile = QString::fromStdString(scene_file_param);
   ScenarioReader scenario_reader;
-  if (scenario_reader.readFromFile(scenefile) == false) {
+  if (scenario_reader.parseFile(scenefile) == false) {
     ROS_ERROR_STREAM(
         "Could not load the scene file, please check the paths and param "
         "names : "
-        << scene_file_param);
+        << scenario_reader.getErrorString().toStdString());
     return false;
   }
+  scenario_ = scenario_reader.getDescription();
 
   nh_.param<bool>("enable_groups", CONFIG.groups_enabled, true);
   nh_.param<double>("max_robot_speed", CONFIG.max_robot_speed, 1.5);
   nh_.param<double>("update_rate", CONFIG.updateRate, 25.0);
   nh_.param<double>("simulation_factor", CONFIG.simulationFactor, 1.0);
+  nh_.param<double>("flow_field_resolution", CONFIG.flow_field_resolution,
+                    0.0);
+  nh_.param<double>("flow_field_clearance", CONFIG.flow_field_clearance, 0.3);
+
+  // fixed seed for reproducible runs, negative for a random one
+  int random_seed;
+  nh_.param<int>("random_seed", random_seed, -1);
+  if (random_seed >= 0) RNG.seed(static_cast<unsigned int>(random_seed));
+  ScenarioReader::buildScene(scenario_);
 
   int op_mode = 1;
   nh_.param<int>("robot_mode", op_mode, 1);
@@ -131,6 +146,33 @@ bool Simulator::initializeSimulation() {
 
   paused_ = false;
 
+  // lockstep: the simulator drives /clock and steps on request
+  nh_.param<bool>("lockstep", lockstep_, false);
+  if (lockstep_) {
+    pub_clock_ = nh_.advertise<rosgraph_msgs::Clock>("/clock", 1);
+    srv_step_simulation_ = nh_.advertiseService(
+        "step_simulation", &Simulator::onStepSimulation, this);
+    ros::Time::setNow(ros::Time(SCENE.getTime()));
+  }
+
+  // robot base integrated with the pedestrians instead of by
+  // simulate_diff_drive_robot
+  nh_.param<bool>("internal_robot", internal_robot_, false);
+  if (internal_robot_) {
+    nh_.param<double>("pose_initial_x", robot_initial_x_, 0.0);
+    nh_.param<double>("pose_initial_y", robot_initial_y_, 0.0);
+    nh_.param<double>("pose_initial_theta", robot_initial_theta_, 0.0);
+    robot_base_.setPose(robot_initial_x_, robot_initial_y_,
+                        robot_initial_theta_);
+
+    std::string cmd_vel_topic;
+    nh_.param<std::string>("robot_cmd_vel_topic", cmd_vel_topic,
+                           "/pedbot/control/cmd_vel");
+    sub_robot_cmd_ =
+        nh_.subscribe(cmd_vel_topic, 3, &Simulator::onRobotCommand, this);
+    transform_broadcaster_.reset(new tf::TransformBroadcaster());
+  }
+
   spawn_timer_ =
       nh_.createTimer(ros::Duration(spawn_period), &Simulator::spawnCallback, this);
 
@@ -141,32 +183,62 @@ void Simulator::runSimulation() {
   ros::Rate r(CONFIG.updateRate);
 
   while (ros::ok()) {
-    if (!robot_) {
-      // setup the robot
-      for (Agent* agent : SCENE.getAgents()) {
-        if (agent->getType() == Ped::Tagent::ROBOT) {
-          robot_ = agent;
-          last_robot_orientation_ =
-              poseFrom2DVelocity(robot_->getvx(), robot_->getvy());
-        }
-      }
+    if (lockstep_) {
+      // the steps are done in the step_simulation callback
+      ros::getGlobalCallbackQueue()->callAvailable(ros::WallDuration(0.1));
+      continue;
     }
 
-    if (!paused_) {
-      updateRobotPositionFromTF();
-      SCENE.moveAllAgents();
-
-      publishAgents();
-      publishGroups();
-      publishRobotPosition();
-      publishObstacles();
-      publishWaypoints();
-    }
+    if (!paused_) step();
     ros::spinOnce();
     r.sleep();
   }
 }
 
+void Simulator::step() {
+  if (!robot_) {
+    // setup the robot
+    for (Agent* agent : SCENE.getAgents()) {
+      if (agent->getType() == Ped::Tagent::ROBOT) {
+        robot_ = agent;
+        last_robot_orientation_ =
+            poseFrom2DVelocity(robot_->getvx(), robot_->getvy());
+      }
+    }
+  }
+
+  if (internal_robot_)
+    updateRobotPositionFromIntegrator();
+  else
+    updateRobotPositionFromTF();
+  SCENE.moveAllAgents();
+
+  // advance the time of the whole system with the scene
+  if (lockstep_) {
+    const ros::Time now(SCENE.getTime());
+    ros::Time::setNow(now);
+    rosgraph_msgs::Clock clock;
+    clock.clock = now;
+    pub_clock_.publish(clock);
+  }
+
+  if (internal_robot_) {
+    tf::Transform robot_pose;
+    robot_pose.setOrigin(
+        tf::Vector3(robot_base_.getx(), robot_base_.gety(), 0.0));
+    robot_pose.setRotation(
+        tf::createQuaternionFromRPY(0, 0, robot_base_.getTheta()));
+    transform_broadcaster_->sendTransform(tf::StampedTransform(
+        robot_pose, ros::Time::now(), frame_id_, robot_base_frame_id_));
+  }
+
+  publishAgents();
+  publishGroups();
+  publishRobotPosition();
+  publishObstacles();
+  publishWaypoints();
+}
+
 void Simulator::reconfigureCB(pedsim_simulator::PedsimSimulatorConfig& config,
                               uint32_t level) {
   CONFIG.updateRate = config.update_rate;
@@ -221,15 +293,22 @@ bool Simulator::GymResetCb(pedsim_srvs::GymReset::Request& request,
     return false;
   }
 
+  // SOP
+  // 1. Let agent arrive waypoint --> 2. Remove all waypoints -->
+  // 3. Add new waypoint          --> 4. Update agent state --> Done
+  // The current waypoints are read before they are deleted with the others.
+  QList<Ped::Tvector> arrival_positions;
+  for(auto const & tmp_agent_ptr : scene_agents){
+    Ped::Twaypoint* cur_wp_ptr1 = tmp_agent_ptr->getCurrentWaypoint();
+    arrival_positions.push_back(cur_wp_ptr1 != nullptr ? cur_wp_ptr1->getPosition()
+                                                       : tmp_agent_ptr->getPosition());
+  }
   SCENE.removeAllWaypoint();
+
   uint8_t idx_req_agent = 0;
   for(auto const & req_agent : request.agents_list){
-    // SOP
-    // 1. Let agent arrive waypoint --> 2. Remove all waypoints -->
-    // 3. Add new waypoint          --> 4. Update agent state --> Done
-    Ped::Twaypoint* cur_wp_ptr1 = scene_agents[idx_req_agent]->getCurrentWaypoint();
-    scene_agents[idx_req_agent]->setPosition(cur_wp_ptr1->getx(), cur_wp_ptr1->gety());
-    scene_agents[idx_req_agent]->removeAllWaypoint();
+    scene_agents[idx_req_agent]->setPosition(arrival_positions[idx_req_agent].x,
+                                            arrival_positions[idx_req_agent].y);
 
     uint8_t idx_wp = 0;
     for(auto const & wp : req_agent.waypoints_list){
@@ -267,6 +346,48 @@ bool Simulator::GymResetCb(pedsim_srvs::GymReset::Request& request,
   return true;
 }
 
+bool Simulator::onResetScenario(std_srvs::Empty::Request& request,
+                                std_srvs::Empty::Response& response) {
+  // rebuild the scene from the parsed scene file instead of reading it again
+  const ros::WallTime start = ros::WallTime::now();
+  SCENE.clear();
+  robot_ = nullptr;
+  ScenarioReader::buildScene(scenario_);
+
+  // the next episode starts from the initial pose, at rest
+  if (internal_robot_)
+    robot_base_ = DiffDriveRobot(robot_initial_x_, robot_initial_y_,
+                                 robot_initial_theta_);
+
+  ROS_INFO_STREAM("Reset scenario with " << scenario_.agentCount()
+                                         << " agents in "
+                                         << (ros::WallTime::now() - start)
+                                                    .toSec() * 1000.0
+                                         << " ms");
+  return true;
+}
+
+bool Simulator::onStepSimulation(
+    pedsim_srvs::StepSimulation::Request& request,
+    pedsim_srvs::StepSimulation::Response& response) {
+  if (!lockstep_) {
+    ROS_WARN("step_simulation is only available in lockstep mode");
+    response.success = false;
+    return true;
+  }
+
+  for (uint32_t i = 0; i < request.num_steps && ros::ok(); ++i) step();
+
+  response.success = true;
+  response.time = SCENE.getTime();
+  return true;
+}
+
+void Simulator::onRobotCommand(const geometry_msgs::Twist::ConstPtr& twist) {
+  // applied from the next step on
+  robot_base_.setCommand(twist->linear.x, twist->angular.z);
+}
+
 void Simulator::spawnCallback(const ros::TimerEvent& event) {
   ROS_DEBUG_STREAM("Spawning new agents.");
 
@@ -329,6 +450,22 @@ void Simulator::updateRobotPositionFromTF() {
   }
 }
 
+void Simulator::updateRobotPositionFromIntegrator() {
+  // same time step as the pedestrians, so they cannot drift apart
+  robot_base_.step(CONFIG.getTimeStepSize());
+  if (!robot_) return;
+
+  if (CONFIG.robot_mode == RobotMode::TELEOPERATION ||
+      CONFIG.robot_mode == RobotMode::CONTROLLED) {
+    robot_->setTeleop(true);
+    robot_->setVmax(2 * CONFIG.max_robot_speed);
+    robot_->setX(robot_base_.getx());
+    robot_->setY(robot_base_.gety());
+    robot_->setvx(robot_base_.getvx());
+    robot_->setvy(robot_base_.getvy());
+  }
+}
+
 void Simulator::publishRobotPosition() {
   if (robot_ == nullptr) return;
 
@@ -35,6 +35,9 @@
 #include <pedsim_simulator/utilities.h>
 #include <pedsim_simulator/waypointplanner/queueingplanner.h>
 
+QHash<const Agent*, QueueingWaypointPlanner*>
+    QueueingWaypointPlanner::followers;
+
 QueueingWaypointPlanner::QueueingWaypointPlanner() {
   // initialize values
   agent = nullptr;
@@ -44,8 +47,33 @@ QueueingWaypointPlanner::QueueingWaypointPlanner() {
   status = QueueingWaypointPlanner::Unknown;
 }
 
-void QueueingWaypointPlanner::onFollowedAgentPositionChanged(double xIn,
-                                                             double yIn) {
+QueueingWaypointPlanner::~QueueingWaypointPlanner() {
+  // leave the queue, nothing may keep a pointer to the removed agent
+  reset();
+}
+
+/// Called by the agents whenever they move, instead of connecting the queues
+/// and the planners to their positionChanged signal. The queue ending with
+/// the agent is informed first, then the planner following it.
+void QueueingWaypointPlanner::onAgentPositionChanged(const Agent* agentIn) {
+  WaitingQueue* queue = WaitingQueue::getQueueEndingWith(agentIn);
+  if (queue != nullptr)
+    queue->onLastAgentPositionChanged(agentIn->getPosition());
+
+  QueueingWaypointPlanner* follower = followers.value(agentIn, nullptr);
+  if (follower != nullptr)
+    follower->onFollowedAgentPositionChanged(agentIn->getPosition());
+}
+
+/// Called by the waiting queues when an agent leaves them, either because it
+/// may pass or because it is removed from the scene.
+void QueueingWaypointPlanner::onAgentDequeued(const Agent* agentIn) {
+  QueueingWaypointPlanner* follower = followers.value(agentIn, nullptr);
+  if (follower != nullptr) follower->onFollowedAgentLeftQueue();
+}
+
+void QueueingWaypointPlanner::onFollowedAgentPositionChanged(
+    const Ped::Tvector& followedPositionIn) {
   // sanity checks
   if (currentWaypoint == nullptr) {
     ROS_DEBUG(
@@ -54,7 +82,7 @@ void QueueingWaypointPlanner::onFollowedAgentPositionChanged(double xIn,
     return;
   }
 
-  Ped::Tvector followedPosition(xIn, yIn);
+  Ped::Tvector followedPosition = followedPositionIn;
   addPrivateSpace(followedPosition);
 
   // HACK: don't update minor changes (prevent over-correcting)
@@ -66,19 +94,16 @@ void QueueingWaypointPlanner::onFollowedAgentPositionChanged(double xIn,
   currentWaypoint->setPosition(followedPosition);
 }
 
-void QueueingWaypointPlanner::onAgentMayPassQueue(int id) {
+void QueueingWaypointPlanner::onAgentMayPassQueue(const Agent* passingAgent) {
   // check who will leave queue
-  if ((agent != nullptr) && (id == agent->getId())) {
+  if ((agent != nullptr) && (passingAgent == agent)) {
     // the agent may pass
     // → update waypoint
     status = QueueingWaypointPlanner::MayPass;
 
     // remove references to old queue
-    disconnect(waitingQueue, SIGNAL(agentMayPass(int)), this,
-               SLOT(onAgentMayPassQueue(int)));
-    disconnect(waitingQueue, SIGNAL(queueEndPositionChanged(double, double)),
-               this, SLOT(onQueueEndPositionChanged(double, double)));
-  } else if ((followedAgent != nullptr) && (id == followedAgent->getId())) {
+    waitingQueue->removePlanner(this);
+  } else if ((followedAgent != nullptr) && (passingAgent == followedAgent)) {
     // followed agent leaves queue
     onFollowedAgentLeftQueue();
   }
@@ -86,9 +111,9 @@ void QueueingWaypointPlanner::onAgentMayPassQueue(int id) {
 
 void QueueingWaypointPlanner::onFollowedAgentLeftQueue() {
   // followed agent leaves queue
-  // → remove all connections to old followed agent
-  disconnect(followedAgent, SIGNAL(positionChanged(double, double)), this,
-             SLOT(onFollowedAgentPositionChanged(double, double)));
+  // → stop following it
+  if (followers.value(followedAgent) == this) followers.remove(followedAgent);
+  followedAgent = nullptr;
 
   // → move to queue's front
   // HACK: actually we have to check our position and eventually bind to a new
@@ -97,8 +122,8 @@ void QueueingWaypointPlanner::onFollowedAgentLeftQueue() {
   currentWaypoint->setPosition(queueingPosition);
 }
 
-void QueueingWaypointPlanner::onQueueEndPositionChanged(double xIn,
-                                                        double yIn) {
+void QueueingWaypointPlanner::onQueueEndPositionChanged(
+    const Ped::Tvector& queueEnd) {
   // there's nothing to do when the agent is already enqueued
   if (status != QueueingWaypointPlanner::Approaching) return;
 
@@ -110,23 +135,22 @@ void QueueingWaypointPlanner::onQueueEndPositionChanged(double xIn,
     if (currentWaypoint == nullptr) return;
 
     // update destination
-    Ped::Tvector newDestination(xIn, yIn);
+    Ped::Tvector newDestination = queueEnd;
     if (!waitingQueue->isEmpty()) addPrivateSpace(newDestination);
     currentWaypoint->setPosition(newDestination);
   }
 }
 
 void QueueingWaypointPlanner::reset() {
-  // disconnect signals
-  if (followedAgent != nullptr) {
-    disconnect(followedAgent, SIGNAL(positionChanged(double, double)), this,
-               SLOT(onFollowedAgentPositionChanged(double, double)));
-  }
+  // remove references to the old queue and followed agent
+  if (followedAgent != nullptr && followers.value(followedAgent) == this)
+    followers.remove(followedAgent);
   if (waitingQueue != nullptr) {
-    disconnect(waitingQueue, SIGNAL(agentMayPass(int)), this,
-               SLOT(onAgentMayPassQueue(int)));
-    disconnect(waitingQueue, SIGNAL(queueEndPositionChanged(double, double)),
-               this, SLOT(onQueueEndPositionChanged(double, double)));
+    waitingQueue->removePlanner(this);
+
+    // the agents behind must not follow an agent which may be removed
+    if (agent != nullptr && waitingQueue->isQueued(agent))
+      waitingQueue->dequeueAgent(agent);
   }
 
   // unset variables
@@ -168,11 +192,7 @@ void QueueingWaypointPlanner::setWaitingQueue(WaitingQueue* queueIn) {
   waitingQueue = queueIn;
   if (waitingQueue != nullptr) {
     status = QueueingWaypointPlanner::Approaching;
-    // connect signals
-    connect(waitingQueue, SIGNAL(agentMayPass(int)), this,
-            SLOT(onAgentMayPassQueue(int)));
-    connect(waitingQueue, SIGNAL(queueEndPositionChanged(double, double)), this,
-            SLOT(onQueueEndPositionChanged(double, double)));
+    waitingQueue->addPlanner(this);
   }
 }
 
@@ -226,8 +246,7 @@ void QueueingWaypointPlanner::activateQueueingMode() {
     addPrivateSpace(queueingPosition);
 
     // keep updating the waypoint
-    connect(followedAgent, SIGNAL(positionChanged(double, double)), this,
-            SLOT(onFollowedAgentPositionChanged(double, double)));
+    followers.insert(followedAgent, this);
   } else {
     queueingPosition = waitingQueue->getPosition();
   }
@@ -188,8 +188,9 @@ Ped::Tvector ShoppingPlanner::createRandomOffset() const {
   std::normal_distribution<double> radiusDistribution(0, radiusStd);
   double radius = radiusDistribution(RNG());
 
-  std::discrete_distribution<int> angleDistribution{0,   45,  90,  135, 180,
-                                                    225, 270, 315, 360};
+  // built once, the distribution has no state between draws
+  static std::discrete_distribution<int> angleDistribution{
+      0, 45, 90, 135, 180, 225, 270, 315, 360};
   double angle = angleDistribution(RNG());
 
   Ped::Tvector randomOffset =